@@ -0,0 +1,656 @@
+/**
+ * @file signal_proc_bench.c
+ * @brief Benchmark driver of libsignalproc, built and run by 'make bench'.
+ *
+ *        Every case is timed over a sweep of lengths: the call is repeated, doubling
+ *        the number of calls, until a run lasts at least --min-time milliseconds.
+ *        The driver is linked against the library objects with malloc, calloc and
+ *        realloc wrapped (-Wl,--wrap), so the allocations made inside the library
+ *        are counted too. One line (CSV) or object (JSON) is printed per measurement:
+ *
+ *        case, backend, n, threads, calls, ns/call, samples/s, allocs/call, bytes/call
+ *
+ *        Usage: signal_proc_bench [--format csv|json] [--sizes n1,n2,...]
+ *                                 [--min-time ms] [--threads max] [--filter substring]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "fft.h"
+#include "signal_generator.h"
+#include "thread_pool.h"
+
+#define BENCH_MAX_SIZES 32
+#define BENCH_DEFAULT_SIZES "64,128,220,256,500,512,1000,1024,2048,4096,8192"
+#define BENCH_DEFAULT_MIN_TIME_MS 50
+/*channels of the batched and multithreaded cases*/
+#define BENCH_CHANNELS 64
+/*bins of abs_dft_interval, a typical EEG band*/
+#define BENCH_INTERVAL_BINS 32
+/*taps of the FIR filter case*/
+#define BENCH_FIR_TAPS 63
+/*decimation factor of the resampler case*/
+#define BENCH_DECIMATION 4
+/*sampling frequency of the feature case, with the theta, alpha and beta bands of EEG*/
+#define BENCH_FEATURES_FS 250.0
+
+#define BENCH_FORMAT_CSV 0
+#define BENCH_FORMAT_JSON 1
+
+/*
+ * Allocation counters, updated by the wrappers of the allocator.
+ */
+static volatile size_t bench_nb_allocs = 0;
+static volatile size_t bench_alloc_bytes = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+int __real_posix_memalign(void **ptr, size_t alignment, size_t size);
+
+void *__wrap_malloc(size_t size){
+	__sync_fetch_and_add(&bench_nb_allocs, 1);
+	__sync_fetch_and_add(&bench_alloc_bytes, size);
+	return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size){
+	__sync_fetch_and_add(&bench_nb_allocs, 1);
+	__sync_fetch_and_add(&bench_alloc_bytes, nmemb*size);
+	return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size){
+	__sync_fetch_and_add(&bench_nb_allocs, 1);
+	__sync_fetch_and_add(&bench_alloc_bytes, size);
+	return __real_realloc(ptr, size);
+}
+
+/*fft_malloc, behind the plans, their tables and the workspaces*/
+int __wrap_posix_memalign(void **ptr, size_t alignment, size_t size){
+	__sync_fetch_and_add(&bench_nb_allocs, 1);
+	__sync_fetch_and_add(&bench_alloc_bytes, size);
+	return __real_posix_memalign(ptr, alignment, size);
+}
+
+/**
+ * struct bench_ctx_s
+ * @brief buffers and objects shared by the cases of one length
+ */
+struct bench_ctx_s{
+
+	size_t n;
+	int threads;
+
+	/*pristine inputs, and the buffers the calls work in*/
+	double *input_1;
+	double *input_2;
+	double *real;
+	double *imag;
+	double *out_1;
+	double *out_2;
+	float *real_f;
+	float *imag_f;
+	double *frame;          /*BENCH_CHANNELS x n*/
+	double *frame_out;      /*BENCH_CHANNELS x (n/2+1)*/
+	int16_t *input_q15;
+	int32_t *out_fixed;
+
+	fft_plan_t *plan;
+	fft_plan_f_t *plan_f;
+	void *workspace;
+	fft_pool_t *pool;
+	thread_pool_t *threads_pool;
+	dft_interval_plan_t *interval;
+	fft_fixed_plan_t *plan_fixed;
+	dft_interval_fixed_plan_t *interval_fixed;
+	band_power_t *bands;
+	fir_filter_t *fir;
+	resampler_t *resampler;
+	stft_t *stft;
+	dwt_stream_t *dwt_stream;
+	fft_features_t *features;
+	pink_generator_t *pink;
+	sinus_generator_t *sinus;
+	signal_mix_t *mix;
+};
+
+typedef void (*bench_fn)(struct bench_ctx_s *ctx);
+
+/**
+ * struct bench_options_s
+ * @brief command line of the driver
+ */
+struct bench_options_s{
+	int format;
+	size_t sizes[BENCH_MAX_SIZES];
+	int nb_sizes;
+	double min_time;        /*seconds*/
+	int max_threads;
+	const char *filter;
+};
+
+static struct bench_options_s options;
+static int nb_printed = 0;
+
+static double now(void);
+static int is_power_of_2(size_t n);
+static int parse_options(int argc, char **argv);
+static void bench_case(const char *name, const char *backend, struct bench_ctx_s *ctx,
+                       size_t samples_per_call, bench_fn fn);
+static int ctx_init(struct bench_ctx_s *ctx, size_t n);
+static void ctx_free(struct bench_ctx_s *ctx);
+static void bench_length(size_t n);
+
+/*
+ * The cases. The in-place transforms restart from the pristine input on every
+ * call, so that the values do not grow from one call to the next.
+ */
+static void run_transform_radix2(struct bench_ctx_s *ctx){
+	memcpy(ctx->real, ctx->input_1, ctx->n*sizeof(double));
+	memset(ctx->imag, 0, ctx->n*sizeof(double));
+	transform_radix2(ctx->real, ctx->imag, ctx->n);
+}
+
+static void run_transform_bluestein(struct bench_ctx_s *ctx){
+	memcpy(ctx->real, ctx->input_1, ctx->n*sizeof(double));
+	memset(ctx->imag, 0, ctx->n*sizeof(double));
+	transform_bluestein(ctx->real, ctx->imag, ctx->n);
+}
+
+static void run_transform(struct bench_ctx_s *ctx){
+	memcpy(ctx->real, ctx->input_1, ctx->n*sizeof(double));
+	memset(ctx->imag, 0, ctx->n*sizeof(double));
+	transform(ctx->real, ctx->imag, ctx->n);
+}
+
+static void run_transform_plan(struct bench_ctx_s *ctx){
+	memcpy(ctx->real, ctx->input_1, ctx->n*sizeof(double));
+	memset(ctx->imag, 0, ctx->n*sizeof(double));
+	transform_plan(ctx->plan, ctx->real, ctx->imag);
+}
+
+static void run_transform_plan_f(struct bench_ctx_s *ctx){
+	size_t i;
+	for(i=0;i<ctx->n;i++){
+		ctx->real_f[i] = (float)ctx->input_1[i];
+		ctx->imag_f[i] = 0.0f;
+	}
+	transform_plan_f(ctx->plan_f, ctx->real_f, ctx->imag_f);
+}
+
+static void run_abs_fft(struct bench_ctx_s *ctx){
+	abs_fft(ctx->input_1, ctx->out_1, ctx->n);
+}
+
+static void run_abs_fft_ws(struct bench_ctx_s *ctx){
+	abs_fft_ws(ctx->plan, ctx->input_1, ctx->out_1, ctx->workspace);
+}
+
+static void run_abs_fft_2signals(struct bench_ctx_s *ctx){
+	abs_fft_2signals(ctx->input_1, ctx->input_2, ctx->out_1, ctx->out_2, ctx->n);
+}
+
+static void run_abs_fft_2signals_ws(struct bench_ctx_s *ctx){
+	abs_fft_2signals_ws(ctx->plan, ctx->input_1, ctx->input_2, ctx->out_1, ctx->out_2, ctx->workspace);
+}
+
+static void run_abs_dft_interval(struct bench_ctx_s *ctx){
+	abs_dft_interval(ctx->input_1, ctx->out_1, (int)ctx->n, 1, 1 + BENCH_INTERVAL_BINS);
+}
+
+static void run_abs_dft_interval_plan(struct bench_ctx_s *ctx){
+	abs_dft_interval_plan(ctx->interval, ctx->input_1, ctx->out_1);
+}
+
+static void run_abs_fft_q15(struct bench_ctx_s *ctx){
+	int exponent;
+	abs_fft_q15(ctx->plan_fixed, ctx->input_q15, ctx->out_fixed, &exponent);
+}
+
+static void run_abs_dft_interval_q15(struct bench_ctx_s *ctx){
+	int exponent;
+	abs_dft_interval_q15(ctx->interval_fixed, ctx->input_q15, ctx->out_fixed, &exponent);
+}
+
+static void run_convolve_real(struct bench_ctx_s *ctx){
+	convolve_real(ctx->input_1, ctx->input_2, ctx->out_1, ctx->n);
+}
+
+static void run_convolve_real_ws(struct bench_ctx_s *ctx){
+	convolve_real_ws(ctx->plan, ctx->input_1, ctx->input_2, ctx->out_1, ctx->workspace);
+}
+
+static void run_convolve_complex_inplace_ws(struct bench_ctx_s *ctx){
+	memcpy(ctx->real, ctx->input_1, ctx->n*sizeof(double));
+	memcpy(ctx->imag, ctx->input_2, ctx->n*sizeof(double));
+	memcpy(ctx->out_1, ctx->input_2, ctx->n*sizeof(double));
+	memcpy(ctx->out_2, ctx->input_1, ctx->n*sizeof(double));
+	convolve_complex_inplace_ws(ctx->plan, ctx->real, ctx->imag, ctx->out_1, ctx->out_2, ctx->workspace);
+}
+
+static void run_convolve_complex(struct bench_ctx_s *ctx){
+	convolve_complex(ctx->input_1, ctx->input_2, ctx->input_2, ctx->input_1,
+	                 ctx->out_1, ctx->out_2, ctx->n);
+}
+
+static void run_fir_filter(struct bench_ctx_s *ctx){
+	fir_filter_process(ctx->fir, ctx->input_1, ctx->out_1, ctx->n);
+}
+
+static void run_resampler(struct bench_ctx_s *ctx){
+	resampler_process(ctx->resampler, ctx->input_1, ctx->n, ctx->out_1);
+}
+
+static void run_band_power(struct bench_ctx_s *ctx){
+	band_power_push(ctx->bands, ctx->frame, (int)ctx->n, FFT_LAYOUT_CHANNEL_MAJOR);
+}
+
+static void run_stft(struct bench_ctx_s *ctx){
+	stft_push(ctx->stft, ctx->input_1, ctx->n, NULL, NULL);
+}
+
+static void run_dwt(struct bench_ctx_s *ctx){
+	memcpy(ctx->real, ctx->input_1, ctx->n*sizeof(double));
+	dwt(ctx->real, ctx->n, FFT_WAVELET_DB2, 0);
+	dwt_band_energy(ctx->real, ctx->n, dwt_max_levels(ctx->n), ctx->out_1);
+}
+
+static void run_dwt_stream(struct bench_ctx_s *ctx){
+	dwt_stream_push(ctx->dwt_stream, ctx->input_1, ctx->n, NULL, NULL);
+}
+
+static void run_abs_fft_batch_ws(struct bench_ctx_s *ctx){
+	abs_fft_batch(ctx->plan, ctx->frame, BENCH_CHANNELS, FFT_LAYOUT_CHANNEL_MAJOR, ctx->frame_out);
+}
+
+static void run_features_batch(struct bench_ctx_s *ctx){
+	fft_features_batch(ctx->features, ctx->frame, BENCH_CHANNELS, FFT_LAYOUT_CHANNEL_MAJOR, ctx->frame_out);
+}
+
+static void run_abs_fft_batch(struct bench_ctx_s *ctx){
+	fft_pool_abs_fft_batch(ctx->pool, ctx->frame, BENCH_CHANNELS, FFT_LAYOUT_CHANNEL_MAJOR, ctx->frame_out);
+}
+
+static void run_get_pink_signal(struct bench_ctx_s *ctx){
+	get_pink_signal(ctx->out_1, (int)ctx->n);
+}
+
+static void run_get_sinus_signal(struct bench_ctx_s *ctx){
+	get_sinus_signal(ctx->out_1, (int)ctx->n, 0.1, 0);
+}
+
+static void run_get_sinus_signal_dispersed(struct bench_ctx_s *ctx){
+	get_sinus_signal(ctx->out_1, (int)ctx->n, 0.1, 0.025);
+}
+
+static void run_pink_generator(struct bench_ctx_s *ctx){
+	pink_generator_next(ctx->pink, ctx->out_1, (int)ctx->n);
+}
+
+static void run_sinus_generator(struct bench_ctx_s *ctx){
+	sinus_generator_next(ctx->sinus, ctx->out_1, (int)ctx->n);
+}
+
+static void run_signal_mix(struct bench_ctx_s *ctx){
+	signal_mix_next_parallel(ctx->threads_pool, ctx->mix, ctx->frame, (int)ctx->n);
+}
+
+int main(int argc, char **argv){
+
+	int i;
+
+	if(!parse_options(argc, argv)){
+		fprintf(stderr, "usage: %s [--format csv|json] [--sizes n1,n2,...] [--min-time ms]"
+		                " [--threads max] [--filter substring]\n", argv[0]);
+		return 1;
+	}
+
+	if(options.format == BENCH_FORMAT_JSON)
+		printf("[\n");
+	else
+		printf("case,backend,n,threads,calls,ns_per_call,samples_per_s,allocs_per_call,bytes_per_call\n");
+
+	for(i=0;i<options.nb_sizes;i++)
+		bench_length(options.sizes[i]);
+
+	if(options.format == BENCH_FORMAT_JSON)
+		printf("\n]\n");
+
+	return 0;
+}
+
+/*
+ * Runs all the cases of one length.
+ */
+static void bench_length(size_t n){
+
+	struct bench_ctx_s ctx;
+	int kernel, threads;
+	double freq = 0.1;
+
+	if(!ctx_init(&ctx, n)){
+		fprintf(stderr, "out of memory for n = %zu\n", n);
+		return;
+	}
+
+	/*one-shot legacy wrappers*/
+	if(is_power_of_2(n))
+		bench_case("transform_radix2", "default", &ctx, n, run_transform_radix2);
+	bench_case("transform_bluestein", "default", &ctx, n, run_transform_bluestein);
+	bench_case("transform", "default", &ctx, n, run_transform);
+	fft_plan_cache_set_limit(0);
+	bench_case("transform", "uncached", &ctx, n, run_transform);
+	fft_plan_cache_set_limit(FFT_PLAN_CACHE_DEFAULT_LIMIT);
+	bench_case("abs_fft", "default", &ctx, n, run_abs_fft);
+	bench_case("abs_fft_2signals", "default", &ctx, 2*n, run_abs_fft_2signals);
+	bench_case("abs_dft_interval", "goertzel", &ctx, n, run_abs_dft_interval);
+	bench_case("convolve_real", "default", &ctx, n, run_convolve_real);
+	bench_case("convolve_complex", "default", &ctx, n, run_convolve_complex);
+
+	/*plans, for every butterfly kernel of this CPU*/
+	for(kernel=FFT_KERNEL_SCALAR;kernel<=FFT_KERNEL_NEON;kernel++){
+
+		if(!fft_kernel_available(kernel))
+			continue;
+
+		fft_set_kernel(kernel);
+		fft_plan_destroy(ctx.plan);
+		ctx.plan = fft_plan_create(n, 0);
+		if(ctx.plan == NULL)
+			continue;
+
+		bench_case("transform_plan", fft_kernel_name(kernel), &ctx, n, run_transform_plan);
+		bench_case("abs_fft_ws", fft_kernel_name(kernel), &ctx, n, run_abs_fft_ws);
+		bench_case("abs_fft_2signals_ws", fft_kernel_name(kernel), &ctx, 2*n, run_abs_fft_2signals_ws);
+		bench_case("convolve_real_ws", fft_kernel_name(kernel), &ctx, n, run_convolve_real_ws);
+		bench_case("convolve_complex_inplace_ws", fft_kernel_name(kernel), &ctx, n, run_convolve_complex_inplace_ws);
+	}
+	fft_set_kernel(FFT_KERNEL_AUTO);
+	fft_plan_destroy(ctx.plan);
+	ctx.plan = fft_plan_create(n, 0);
+
+	if(ctx.plan_f != NULL)
+		bench_case("transform_plan_f", "scalar", &ctx, n, run_transform_plan_f);
+	if(ctx.interval != NULL)
+		bench_case("abs_dft_interval_plan", "goertzel", &ctx, n, run_abs_dft_interval_plan);
+	if(ctx.plan_fixed != NULL)
+		bench_case("abs_fft_q15", "block-fp", &ctx, n, run_abs_fft_q15);
+	if(ctx.interval_fixed != NULL)
+		bench_case("abs_dft_interval_q15", "goertzel", &ctx, n, run_abs_dft_interval_q15);
+
+	/*streaming*/
+	ctx.fir = fir_filter_create(ctx.input_2, BENCH_FIR_TAPS, 0);
+	if(ctx.fir != NULL)
+		bench_case("fir_filter_process", "overlap-save", &ctx, n, run_fir_filter);
+	ctx.resampler = resampler_create(1, BENCH_DECIMATION, 0);
+	if(ctx.resampler != NULL)
+		bench_case("resampler_process", "polyphase-1/4", &ctx, n, run_resampler);
+	ctx.stft = stft_create(256, 128, FFT_WINDOW_HANN, FFT_OUTPUT_POWER, 1);
+	if(ctx.stft != NULL)
+		bench_case("stft_push", "hann-256-128", &ctx, n, run_stft);
+	if(n > BENCH_INTERVAL_BINS){
+		int band_start = 1, band_stop = 1 + BENCH_INTERVAL_BINS;
+		ctx.bands = band_power_create((int)n, BENCH_CHANNELS, 1, &band_start, &band_stop);
+	}
+	if(ctx.bands != NULL)
+		bench_case("band_power_push", "sliding-dft", &ctx, BENCH_CHANNELS*n, run_band_power);
+	if(dwt_max_levels(n) > 0)
+		bench_case("dwt + dwt_band_energy", "db2", &ctx, n, run_dwt);
+	ctx.dwt_stream = dwt_stream_create(FFT_WAVELET_DB2, 5, 32);
+	if(ctx.dwt_stream != NULL)
+		bench_case("dwt_stream_push", "db2-5-32", &ctx, n, run_dwt_stream);
+
+	/*features of a frame, against its spectra alone*/
+	{
+		double band_low[3] = {4, 8, 13};
+		double band_high[3] = {8, 13, 30};
+		ctx.features = fft_features_create(n, BENCH_FEATURES_FS, 3, band_low, band_high, FFT_FEATURE_ALL);
+	}
+	if(ctx.features != NULL && fft_features_add_ratio(ctx.features, 1, 0)){
+		bench_case("abs_fft_batch", "default", &ctx, BENCH_CHANNELS*n, run_abs_fft_batch_ws);
+		bench_case("fft_features_batch", "bands+ratio+entropy+peak", &ctx, BENCH_CHANNELS*n, run_features_batch);
+	}
+
+	/*batches over the worker pool*/
+	for(threads=1;threads<=options.max_threads;threads*=2){
+
+		ctx.threads = threads;
+		ctx.pool = fft_pool_create(n, threads);
+		ctx.threads_pool = thread_pool_create(threads);
+		ctx.mix = signal_mix_create(BENCH_CHANNELS, 1);
+
+		if(ctx.pool != NULL)
+			bench_case("fft_pool_abs_fft_batch", "default", &ctx, BENCH_CHANNELS*n, run_abs_fft_batch);
+		if(ctx.threads_pool != NULL && ctx.mix != NULL
+				&& signal_mix_add(ctx.mix, SIGNAL_SOURCE_PINK, 1.0, 0, 0)
+				&& signal_mix_add(ctx.mix, SIGNAL_SOURCE_SINUS, 0.5, 0.09, 0)
+				&& signal_mix_add(ctx.mix, SIGNAL_SOURCE_WHITE, 0.1, 0, 0))
+			bench_case("signal_mix_next_parallel", "pink+sinus+white", &ctx, BENCH_CHANNELS*n, run_signal_mix);
+
+		fft_pool_destroy(ctx.pool);
+		thread_pool_destroy(ctx.threads_pool);
+		signal_mix_destroy(ctx.mix);
+		ctx.pool = NULL;
+		ctx.threads_pool = NULL;
+		ctx.mix = NULL;
+	}
+	ctx.threads = 1;
+
+	/*generators*/
+	bench_case("get_pink_signal", "rand", &ctx, n, run_get_pink_signal);
+	bench_case("get_sinus_signal", "pure", &ctx, n, run_get_sinus_signal);
+	bench_case("get_sinus_signal", "dispersed", &ctx, n, run_get_sinus_signal_dispersed);
+	ctx.pink = pink_generator_create(PINK_MAX_ROWS, NULL);
+	if(ctx.pink != NULL)
+		bench_case("pink_generator_next", "xoshiro", &ctx, n, run_pink_generator);
+	ctx.sinus = sinus_generator_create(1, &freq, NULL, NULL);
+	if(ctx.sinus != NULL)
+		bench_case("sinus_generator_next", "recurrence", &ctx, n, run_sinus_generator);
+
+	ctx_free(&ctx);
+}
+
+/*
+ * Times one case and prints its line. The number of calls doubles until the
+ * run lasts options.min_time, after one warm-up call (plans, caches, pages).
+ */
+static void bench_case(const char *name, const char *backend, struct bench_ctx_s *ctx,
+                       size_t samples_per_call, bench_fn fn){
+
+	size_t calls = 1, i;
+	size_t allocs, bytes;
+	double elapsed, ns_per_call;
+
+	if(options.filter != NULL && strstr(name, options.filter) == NULL)
+		return;
+
+	fn(ctx);
+
+	for(;;){
+		double start;
+		size_t allocs_start = bench_nb_allocs;
+		size_t bytes_start = bench_alloc_bytes;
+
+		start = now();
+		for(i=0;i<calls;i++)
+			fn(ctx);
+		elapsed = now() - start;
+
+		allocs = bench_nb_allocs - allocs_start;
+		bytes = bench_alloc_bytes - bytes_start;
+
+		if(elapsed >= options.min_time || calls > ((size_t)-1)/4)
+			break;
+		calls *= 2;
+	}
+
+	ns_per_call = elapsed*1e9/calls;
+
+	if(options.format == BENCH_FORMAT_JSON){
+		printf("%s  {\"case\": \"%s\", \"backend\": \"%s\", \"n\": %zu, \"threads\": %d, \"calls\": %zu,"
+		       " \"ns_per_call\": %.1f, \"samples_per_s\": %.6g, \"allocs_per_call\": %.2f, \"bytes_per_call\": %.1f}",
+		       nb_printed ? ",\n" : "", name, backend, ctx->n, ctx->threads, calls,
+		       ns_per_call, samples_per_call*calls/elapsed,
+		       (double)allocs/calls, (double)bytes/calls);
+	}else{
+		printf("%s,%s,%zu,%d,%zu,%.1f,%.6g,%.2f,%.1f\n",
+		       name, backend, ctx->n, ctx->threads, calls,
+		       ns_per_call, samples_per_call*calls/elapsed,
+		       (double)allocs/calls, (double)bytes/calls);
+	}
+	fflush(stdout);
+	nb_printed++;
+}
+
+static int ctx_init(struct bench_ctx_s *ctx, size_t n){
+
+	size_t i;
+
+	memset(ctx, 0, sizeof(struct bench_ctx_s));
+	ctx->n = n;
+	ctx->threads = 1;
+
+	ctx->input_1 = (double*)malloc(n*sizeof(double));
+	ctx->input_2 = (double*)malloc((n > BENCH_FIR_TAPS ? n : BENCH_FIR_TAPS)*sizeof(double));
+	ctx->real = (double*)malloc(n*sizeof(double));
+	ctx->imag = (double*)malloc(n*sizeof(double));
+	ctx->out_1 = (double*)malloc(n*sizeof(double));
+	ctx->out_2 = (double*)malloc(n*sizeof(double));
+	ctx->real_f = (float*)malloc(n*sizeof(float));
+	ctx->imag_f = (float*)malloc(n*sizeof(float));
+	ctx->frame = (double*)malloc(BENCH_CHANNELS*n*sizeof(double));
+	ctx->frame_out = (double*)malloc(BENCH_CHANNELS*(n/2+1)*sizeof(double));
+	ctx->input_q15 = (int16_t*)malloc(n*sizeof(int16_t));
+	ctx->out_fixed = (int32_t*)malloc((n/2+1)*sizeof(int32_t));
+	ctx->plan = fft_plan_create(n, 0);
+	ctx->plan_f = fft_plan_f_create(n, 0);
+	ctx->workspace = malloc(fft_workspace_size(n));
+	if(n > BENCH_INTERVAL_BINS)
+		ctx->interval = dft_interval_plan_create((int)n, 1, 1 + BENCH_INTERVAL_BINS);
+	if(is_power_of_2(n))
+		ctx->plan_fixed = fft_fixed_plan_create(n);
+	if(n > BENCH_INTERVAL_BINS)
+		ctx->interval_fixed = dft_interval_fixed_plan_create((int)n, 1, 1 + BENCH_INTERVAL_BINS);
+
+	if(ctx->input_1 == NULL || ctx->input_2 == NULL || ctx->real == NULL || ctx->imag == NULL
+			|| ctx->out_1 == NULL || ctx->out_2 == NULL
+			|| ctx->real_f == NULL || ctx->imag_f == NULL
+			|| ctx->frame == NULL || ctx->frame_out == NULL
+			|| ctx->input_q15 == NULL || ctx->out_fixed == NULL
+			|| ctx->plan == NULL || ctx->workspace == NULL){
+		ctx_free(ctx);
+		return 0;
+	}
+
+	srand(1);
+	for(i=0;i<n;i++){
+		ctx->input_1[i] = rand()/(double)RAND_MAX - 0.5;
+		ctx->input_2[i] = rand()/(double)RAND_MAX - 0.5;
+		ctx->input_q15[i] = (int16_t)(ctx->input_1[i]*32767);
+	}
+	for(i=n;i<BENCH_FIR_TAPS;i++)
+		ctx->input_2[i] = rand()/(double)RAND_MAX - 0.5;
+	for(i=0;i<BENCH_CHANNELS*n;i++)
+		ctx->frame[i] = rand()/(double)RAND_MAX - 0.5;
+
+	return 1;
+}
+
+static void ctx_free(struct bench_ctx_s *ctx){
+
+	free(ctx->input_1);
+	free(ctx->input_2);
+	free(ctx->real);
+	free(ctx->imag);
+	free(ctx->out_1);
+	free(ctx->out_2);
+	free(ctx->real_f);
+	free(ctx->imag_f);
+	free(ctx->frame);
+	free(ctx->frame_out);
+	free(ctx->input_q15);
+	free(ctx->out_fixed);
+	fft_plan_destroy(ctx->plan);
+	fft_plan_f_destroy(ctx->plan_f);
+	free(ctx->workspace);
+	dft_interval_plan_destroy(ctx->interval);
+	fft_fixed_plan_destroy(ctx->plan_fixed);
+	dft_interval_fixed_plan_destroy(ctx->interval_fixed);
+	fir_filter_destroy(ctx->fir);
+	resampler_destroy(ctx->resampler);
+	stft_destroy(ctx->stft);
+	dwt_stream_destroy(ctx->dwt_stream);
+	fft_features_destroy(ctx->features);
+	band_power_destroy(ctx->bands);
+	pink_generator_destroy(ctx->pink);
+	sinus_generator_destroy(ctx->sinus);
+}
+
+static int parse_options(int argc, char **argv){
+
+	const char *sizes = BENCH_DEFAULT_SIZES;
+	long nb_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	int i;
+
+	options.format = BENCH_FORMAT_CSV;
+	options.min_time = BENCH_DEFAULT_MIN_TIME_MS*1e-3;
+	options.max_threads = (nb_cpus > 0) ? (int)nb_cpus : 1;
+	options.filter = NULL;
+
+	for(i=1;i<argc;i++){
+		if(strcmp(argv[i], "--format") == 0 && i+1 < argc){
+			i++;
+			if(strcmp(argv[i], "csv") == 0)
+				options.format = BENCH_FORMAT_CSV;
+			else if(strcmp(argv[i], "json") == 0)
+				options.format = BENCH_FORMAT_JSON;
+			else
+				return 0;
+		}else if(strcmp(argv[i], "--sizes") == 0 && i+1 < argc){
+			sizes = argv[++i];
+		}else if(strcmp(argv[i], "--min-time") == 0 && i+1 < argc){
+			options.min_time = atof(argv[++i])*1e-3;
+		}else if(strcmp(argv[i], "--threads") == 0 && i+1 < argc){
+			options.max_threads = atoi(argv[++i]);
+			if(options.max_threads < 1)
+				return 0;
+		}else if(strcmp(argv[i], "--filter") == 0 && i+1 < argc){
+			options.filter = argv[++i];
+		}else{
+			return 0;
+		}
+	}
+
+	options.nb_sizes = 0;
+	while(*sizes != '\0' && options.nb_sizes < BENCH_MAX_SIZES){
+		char *end;
+		unsigned long n = strtoul(sizes, &end, 10);
+		if(end == sizes || n == 0)
+			return 0;
+		options.sizes[options.nb_sizes++] = (size_t)n;
+		sizes = (*end == ',') ? end + 1 : end;
+		if(*end != ',' && *end != '\0')
+			return 0;
+	}
+
+	return options.nb_sizes > 0;
+}
+
+static double now(void){
+
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+static int is_power_of_2(size_t n){
+	return n != 0 && (n & (n - 1)) == 0;
+}
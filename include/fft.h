@@ -22,6 +22,12 @@
  *   Software.
  */
 
+#ifndef FFT_H
+#define FFT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
 /**
  * int fft_2signals(int n)
  * 
@@ -102,7 +108,9 @@ void naive_dft(const double *inreal, const double *inimag, double *outreal, doub
 
 /* 
  * Computes the discrete Fourier transform (DFT) of the given complex vector, storing the result back into the vector.
- * The vector can have any length. This is a wrapper function. Returns 1 (true) if successful, 0 (false) otherwise (out of memory).
+ * The vector can have any length. This is a wrapper function, it uses the straight-line kernels generated for the CODELET_SIZES
+ * of the Makefile, and otherwise a plan of the plan cache: radix-2 for the powers of 2, mixed radix for lengths with small
+ * prime factors and Bluestein otherwise. Returns 1 (true) if successful, 0 (false) otherwise (out of memory).
  */
 int transform(double real[], double imag[], size_t n);
 
@@ -120,6 +128,13 @@ int inverse_transform(double real[], double imag[], size_t n);
  */
 int transform_radix2(double real[], double imag[], size_t n);
 
+/* 
+ * Computes the discrete Fourier transform (DFT) of the given complex vector, storing the result back into the vector.
+ * The vector's length must only have 2, 3, 5, 7 and 11 as prime factors (e.g. 220 = 4*5*11). Uses a mixed-radix
+ * Cooley-Tukey decimation in time. Returns 1 (true) if successful, 0 (false) otherwise (n has other prime factors, or out of memory).
+ */
+int transform_mixed_radix(double real[], double imag[], size_t n);
+
 /* 
  * Computes the discrete Fourier transform (DFT) of the given complex vector, storing the result back into the vector.
  * The vector can have any length. This requires the convolution function, which in turn requires the radix-2 FFT function.
@@ -127,6 +142,15 @@ int transform_radix2(double real[], double imag[], size_t n);
  */
 int transform_bluestein(double real[], double imag[], size_t n);
 
+/* 
+ * Same as transform and inverse_transform over an interleaved complex vector of length n, element k
+ * at data[2k] (real part) and data[2k+1] (imaginary part). Power-of-2 lengths run directly on the
+ * interleaved data with the scalar kernel, the others go through split vectors.
+ * Returns 1 (true) if successful, 0 (false) otherwise (out of memory).
+ */
+int transform_interleaved(double data[], size_t n);
+int inverse_transform_interleaved(double data[], size_t n);
+
 /* 
  * Computes the circular convolution of the given real vectors. Each vector's length must be the same.
  * Returns 1 (true) if successful, 0 (false) otherwise (out of memory).
@@ -140,10 +164,1380 @@ int convolve_real(const double x[], const double y[], double out[], size_t n);
 int convolve_complex(const double xreal[], const double ximag[], const double yreal[], const double yimag[], double outreal[], double outimag[], size_t n);
 
 
+/*
+ * Aligned allocations. The blocks are aligned on FFT_ALIGNMENT bytes, a cache line and
+ * the widest vector register, and are released with free(). memdup, zero_reals and the
+ * tables of the plans use them.
+ */
+#define FFT_ALIGNMENT 64
+
+/**
+ * void* fft_malloc(size_t size)
+ * 
+ * @brief allocates size bytes aligned on FFT_ALIGNMENT.
+ * @return the block, to release with free(), NULL if out of memory
+ */
+void* fft_malloc(size_t size);
+
+/**
+ * double* fft_alloc_reals(size_t n)
+ * 
+ * @brief allocates n doubles set to 0, aligned on FFT_ALIGNMENT.
+ * @return the vector, to release with free(), NULL if out of memory
+ */
+double* fft_alloc_reals(size_t n);
+
 double *zero_reals(int n);
 void *memdup(const void *src, size_t n);
 
 /*
  * This function is called from preprocess_core.c in preprocess-daemon
+ * abs value of the fourier coefficients k in [interval_start, interval_stop) of an n-long signal,
+ * 2*|X(k)|/n, computed with the Goertzel recurrence.
  */
 void abs_dft_interval(const double *signal, double *abs_power_interval, int n, int interval_start, int interval_stop);
+
+/*
+ * Goertzel plans, with the coefficients of an interval of bins precomputed for a given n.
+ */
+typedef struct dft_interval_plan_s dft_interval_plan_t;
+
+/**
+ * dft_interval_plan_t* dft_interval_plan_create(int n, int interval_start, int interval_stop)
+ * 
+ * @brief precomputes the Goertzel coefficients of the bins [interval_start, interval_stop) for an n-long signal
+ * @return the plan, NULL if out of memory or if the interval is empty
+ */
+dft_interval_plan_t* dft_interval_plan_create(int n, int interval_start, int interval_stop);
+
+/**
+ * void dft_interval_plan_destroy(dft_interval_plan_t* plan)
+ * 
+ * @brief releases the memory held by a plan. NULL is accepted.
+ */
+void dft_interval_plan_destroy(dft_interval_plan_t* plan);
+
+/**
+ * void abs_dft_interval_plan(const dft_interval_plan_t* plan, const double *signal, double *abs_power_interval)
+ * 
+ * @brief same as abs_dft_interval, with the coefficients taken from the plan.
+ * @param signal (in), the n-long signal
+ * @param abs_power_interval (out), one value per bin of the interval
+ */
+void abs_dft_interval_plan(const dft_interval_plan_t* plan, const double *signal, double *abs_power_interval);
+
+/*
+ * Sliding DFT, streaming version of abs_dft_interval.
+ * The window of the last n samples advances on every new sample, and the bins of
+ * the interval are updated in O(1) each, so the cost is O(nb of bins) per sample.
+ * The bins are recomputed exactly once every n samples to keep round-off in check.
+ */
+typedef struct sliding_dft_s sliding_dft_t;
+
+/**
+ * sliding_dft_t* sliding_dft_create(int n, int interval_start, int interval_stop)
+ * 
+ * @brief creates a sliding DFT over a window of n samples, tracking the bins [interval_start, interval_stop).
+ *        The window is initially filled with zeros.
+ * @return the sliding DFT, NULL if out of memory or if the interval is empty
+ */
+sliding_dft_t* sliding_dft_create(int n, int interval_start, int interval_stop);
+
+/**
+ * void sliding_dft_destroy(sliding_dft_t* sdft)
+ * 
+ * @brief releases the memory held by a sliding DFT. NULL is accepted.
+ */
+void sliding_dft_destroy(sliding_dft_t* sdft);
+
+/**
+ * void sliding_dft_reset(sliding_dft_t* sdft)
+ * 
+ * @brief fills the window with zeros.
+ */
+void sliding_dft_reset(sliding_dft_t* sdft);
+
+/**
+ * void sliding_dft_push(sliding_dft_t* sdft, const double *samples, int count)
+ * 
+ * @brief advances the window by count samples.
+ * @param samples (in), the new samples, oldest first
+ * @param count (in), number of new samples, any value is accepted
+ */
+void sliding_dft_push(sliding_dft_t* sdft, const double *samples, int count);
+
+/**
+ * void sliding_dft_abs(const sliding_dft_t* sdft, double *abs_power_interval)
+ * 
+ * @brief returns the abs value of the bins over the current window, as abs_dft_interval would.
+ * @param abs_power_interval (out), one value per bin of the interval
+ */
+void sliding_dft_abs(const sliding_dft_t* sdft, double *abs_power_interval);
+
+/*
+ * Band power tracker, multichannel version of the sliding DFT.
+ * Each channel keeps the window of its last n samples and the sliding DFT of the bins
+ * of a set of bands [band_start, band_stop), the same bin being tracked once when the
+ * bands overlap. A push costs O(nb of bins) per sample and channel, the band powers can
+ * be read at any time in O(nb of channels x nb of bins).
+ */
+typedef struct band_power_s band_power_t;
+
+/**
+ * band_power_t* band_power_create(int n, int nb_channels, int nb_bands, const int* band_start, const int* band_stop)
+ * 
+ * @brief creates a tracker of nb_bands bands for nb_channels channels, over a window of n samples.
+ *        The windows are initially filled with zeros.
+ * @param band_start, band_stop (in), the band b covers the bins [band_start[b], band_stop[b]), 0 <= start < stop <= n
+ * @return the tracker, NULL if out of memory or if a band is empty or out of range
+ */
+band_power_t* band_power_create(int n, int nb_channels, int nb_bands, const int* band_start, const int* band_stop);
+
+/**
+ * void band_power_destroy(band_power_t* tracker)
+ * 
+ * @brief releases the memory held by a tracker. NULL is accepted.
+ */
+void band_power_destroy(band_power_t* tracker);
+
+/**
+ * void band_power_reset(band_power_t* tracker)
+ * 
+ * @brief fills the windows of all the channels with zeros.
+ */
+void band_power_reset(band_power_t* tracker);
+
+/**
+ * int band_power_nb_bins(const band_power_t* tracker)
+ * 
+ * @brief returns the number of bins tracked per channel, the size of the union of the bands.
+ */
+int band_power_nb_bins(const band_power_t* tracker);
+
+/**
+ * int band_power_push(band_power_t* tracker, const double* data, int count, int layout)
+ * 
+ * @brief advances the windows of all the channels by count samples.
+ * @param data (in), nb_channels x count samples, oldest first, in the FFT_LAYOUT_xxx layout
+ * @param layout, FFT_LAYOUT_CHANNEL_MAJOR or FFT_LAYOUT_INTERLEAVED
+ * @return 1 if success, 0 otherwise (unknown layout)
+ */
+int band_power_push(band_power_t* tracker, const double* data, int count, int layout);
+
+/**
+ * void band_power_get(const band_power_t* tracker, double* power)
+ * 
+ * @brief returns the power of the bands over the current windows: the sum over the bins
+ *        of a band of (2*|X(k)|/n)^2, as the FFT_OUTPUT_POWER spectrum of the window.
+ * @param power (out), nb_channels x nb_bands values, band b of channel c at power[c*nb_bands+b]
+ */
+void band_power_get(const band_power_t* tracker, double* power);
+
+
+/*
+ * Reusable fft plans.
+ * A plan is created once for a given length and direction and executed many times.
+ * It holds the twiddle tables, the bit-reversal permutation, and for lengths that
+ * are not a power of 2, the padded length and the transform of the Bluestein chirp.
+ * A plan owns a workspace written by the xxx_plan wrappers: they take the plan non-const,
+ * and must not be called on the same plan by two threads at once. The xxx_ws functions
+ * take the workspace from the caller instead, and only read the plan.
+ */
+typedef struct fft_plan_s fft_plan_t;
+
+/*
+ * inverse argument of fft_plan_create and fft_plan_f_create for a true inverse: the
+ * 1/n scaling rides on the first pass over the data (the permutation or copy of the
+ * input, or the product with the chirp for Bluestein), no extra pass is made.
+ */
+#define FFT_INVERSE_SCALED 2
+
+/*
+ * Real-input plans, see rfft_plan_create.
+ */
+typedef struct rfft_plan_s rfft_plan_t;
+
+/**
+ * fft_plan_t* fft_plan_create(size_t n, int inverse)
+ * 
+ * @brief creates a plan for the transform of length n, along with a workspace
+ *        used by the xxx_plan wrappers and abs_fft_batch.
+ * @param n, the length of the transform, any length is supported.
+ * @param inverse, 1 for the inverse transform (unscaled, as inverse_transform), FFT_INVERSE_SCALED
+ *        for the inverse transform scaled by 1/n, 0 for the forward transform
+ * @return the plan, NULL if out of memory
+ */
+fft_plan_t* fft_plan_create(size_t n, int inverse);
+
+/**
+ * void fft_plan_destroy(fft_plan_t* plan)
+ * 
+ * @brief releases the memory held by a plan. NULL is accepted.
+ * @param plan, the plan to release
+ */
+void fft_plan_destroy(fft_plan_t* plan);
+
+/**
+ * size_t fft_plan_length(const fft_plan_t* plan)
+ * 
+ * @brief returns the length of the transform computed by the plan.
+ */
+size_t fft_plan_length(const fft_plan_t* plan);
+
+/**
+ * int transform_plan(fft_plan_t* plan, double real[], double imag[])
+ * 
+ * @brief computes the transform described by the plan over the complex vector, in place.
+ * @param plan, a plan created with fft_plan_create
+ * @param real, imag, complex vector of length fft_plan_length(plan)
+ * @return 1 if success, 0 otherwise
+ */
+int transform_plan(fft_plan_t* plan, double real[], double imag[]);
+
+/**
+ * int transform_interleaved_plan(fft_plan_t* plan, double data[])
+ * 
+ * @brief same as transform_plan over an interleaved complex vector, element k at data[2k], data[2k+1].
+ * @param data, 2*fft_plan_length(plan) values
+ * @return 1 if success, 0 otherwise
+ */
+int transform_interleaved_plan(fft_plan_t* plan, double data[]);
+
+/**
+ * int fft_2signals_plan(fft_plan_t* plan, ...)
+ * 
+ * @brief same as fft_2signals, running against a forward plan of length n.
+ * @return 1 if success, 0 otherwise (inverse plan)
+ */
+int fft_2signals_plan(fft_plan_t* plan,
+                      double* signal_1, double* signal_2,
+                      double* X1_real, double* X1_imag,
+                      double* X2_real, double* X2_imag);
+
+/**
+ * int abs_fft_plan(fft_plan_t* plan, double* signal, double* abs_onesided_fft)
+ * 
+ * @brief same as abs_fft, running against a forward plan of length n.
+ * @return 1 if success, 0 otherwise (inverse plan)
+ */
+int abs_fft_plan(fft_plan_t* plan,
+                 double* signal,
+                 double* abs_onesided_fft);
+
+/**
+ * int abs_fft_2signals_plan(fft_plan_t* plan, ...)
+ * 
+ * @brief same as abs_fft_2signals, running against a forward plan of length n.
+ * @return 1 if success, 0 otherwise (inverse plan)
+ */
+int abs_fft_2signals_plan(fft_plan_t* plan,
+                          double* signal_1, double* signal_2,
+                          double* X1,
+                          double* X2);
+
+/*
+ * Plan cache.
+ * transform, inverse_transform, transform_interleaved, transform_mixed_radix, abs_fft,
+ * convolve_real, convolve_complex, fft_2signals, abs_fft_2signals, transform_f,
+ * fft_2signals_f, abs_fft_f and abs_fft_2signals_f take their plans from a process-wide
+ * cache instead of rebuilding the tables on every call.
+ * The plans are keyed by length, direction, precision and butterfly kernel, and shared by
+ * all the threads: looking a plan up takes no lock, only building a missing one does.
+ * When a new plan would take the cache over its memory limit, the least recently used
+ * plans that no call is running are released first; a plan that still does not fit is
+ * built for the call only, as without the cache. transform_radix2 and transform_bluestein
+ * are the reference implementations and keep computing their tables. When the cache is
+ * disabled, transform and inverse_transform run transform_radix2 for the powers of 2,
+ * transform_mixed_radix for the lengths it supports and transform_bluestein otherwise.
+ */
+#define FFT_PLAN_CACHE_DEFAULT_LIMIT (32 << 20)
+
+#define FFT_PRECISION_DOUBLE 0
+#define FFT_PRECISION_FLOAT 1
+
+/**
+ * int fft_plan_cache_prewarm(size_t n, int inverse, int precision)
+ *
+ * @brief builds the cached plan of a length ahead of time, so that the first call does not pay
+ *        for it. Call it at startup for the lengths of the real-time paths.
+ * @param inverse, 1 for inverse_transform_interleaved, 0 for everything else (the other inverse
+ *        transforms swap the real and imaginary parts around a forward plan)
+ * @param precision, FFT_PRECISION_DOUBLE or FFT_PRECISION_FLOAT
+ * @return 1 if the plan is in the cache, 0 otherwise (out of memory, or larger than the limit)
+ */
+int fft_plan_cache_prewarm(size_t n, int inverse, int precision);
+
+/**
+ * void fft_plan_cache_set_limit(size_t bytes)
+ *
+ * @brief caps the memory held by the cached plans, FFT_PLAN_CACHE_DEFAULT_LIMIT by default,
+ *        releasing the least recently used plans over the new limit. 0 disables the cache.
+ */
+void fft_plan_cache_set_limit(size_t bytes);
+
+/**
+ * size_t fft_plan_cache_memory(void)
+ *
+ * @brief returns the bytes held by the cached plans.
+ */
+size_t fft_plan_cache_memory(void);
+
+/**
+ * void fft_plan_cache_clear(void)
+ *
+ * @brief releases the cached plans, except the ones a call is running at the moment.
+ */
+void fft_plan_cache_clear(void);
+
+/*
+ * Allocation-free variants.
+ * They run against a forward plan of length n and keep all their intermediate
+ * arrays in a caller-owned workspace of fft_workspace_size(n) bytes (fft_malloc'ed,
+ * or at least aligned for double). They never allocate, and since the plan is
+ * only read, one plan can be shared by threads that each own a workspace.
+ */
+
+/**
+ * size_t fft_workspace_size(size_t n)
+ * 
+ * @brief returns the size in bytes of the workspace needed by the xxx_ws functions for length n.
+ * @param n, the length of the transform
+ * @return the size of the workspace, in bytes
+ */
+size_t fft_workspace_size(size_t n);
+
+/**
+ * int transform_ws(const fft_plan_t* plan, double real[], double imag[], void* workspace)
+ * 
+ * @brief computes the transform described by the plan (forward or inverse) over the complex vector, in place.
+ * @return 1 if success, 0 otherwise
+ */
+int transform_ws(const fft_plan_t* plan, double real[], double imag[], void* workspace);
+
+/**
+ * int transform_interleaved_ws(const fft_plan_t* plan, double data[], void* workspace)
+ * 
+ * @brief same as transform_ws over an interleaved complex vector, element k at data[2k], data[2k+1].
+ * @return 1 if success, 0 otherwise
+ */
+int transform_interleaved_ws(const fft_plan_t* plan, double data[], void* workspace);
+
+/**
+ * int fft_2signals_ws(const fft_plan_t* plan, ...)
+ * 
+ * @brief same as fft_2signals.
+ * @return 1 if success, 0 otherwise (inverse plan)
+ */
+int fft_2signals_ws(const fft_plan_t* plan,
+                    const double* signal_1, const double* signal_2,
+                    double* X1_real, double* X1_imag,
+                    double* X2_real, double* X2_imag,
+                    void* workspace);
+
+/**
+ * int abs_fft_ws(const fft_plan_t* plan, const double* signal, double* abs_onesided_fft, void* workspace)
+ * 
+ * @brief same as abs_fft.
+ * @return 1 if success, 0 otherwise (inverse plan)
+ */
+int abs_fft_ws(const fft_plan_t* plan,
+               const double* signal,
+               double* abs_onesided_fft,
+               void* workspace);
+
+/**
+ * int abs_fft_2signals_ws(const fft_plan_t* plan, ...)
+ * 
+ * @brief same as abs_fft_2signals.
+ * @return 1 if success, 0 otherwise (inverse plan)
+ */
+int abs_fft_2signals_ws(const fft_plan_t* plan,
+                        const double* signal_1, const double* signal_2,
+                        double* X1,
+                        double* X2,
+                        void* workspace);
+
+/**
+ * int convolve_real_ws(const fft_plan_t* plan, const double x[], const double y[], double out[], void* workspace)
+ * 
+ * @brief same as convolve_real.
+ * @return 1 if success, 0 otherwise (inverse plan)
+ */
+int convolve_real_ws(const fft_plan_t* plan,
+                     const double x[], const double y[], double out[],
+                     void* workspace);
+
+/**
+ * int convolve_complex_ws(const fft_plan_t* plan, ...)
+ * 
+ * @brief same as convolve_complex. outreal/outimag may be the arrays of x or y.
+ * @return 1 if success, 0 otherwise (inverse plan)
+ */
+int convolve_complex_ws(const fft_plan_t* plan,
+                        const double xreal[], const double ximag[],
+                        const double yreal[], const double yimag[],
+                        double outreal[], double outimag[],
+                        void* workspace);
+
+/**
+ * int convolve_complex_inplace_ws(const fft_plan_t* plan, double xreal[], double ximag[],
+ *                                 double yreal[], double yimag[], void* workspace)
+ * 
+ * @brief circular convolution of x and y, written over x: no copy of the vectors.
+ *        y is overwritten with its transform.
+ * @param workspace, fft_workspace_size(n) bytes of memory
+ * @return 1 if success, 0 otherwise (inverse plan)
+ */
+int convolve_complex_inplace_ws(const fft_plan_t* plan,
+                                double xreal[], double ximag[],
+                                double yreal[], double yimag[],
+                                void* workspace);
+
+/*
+ * Spectrum output modes.
+ * The one-sided spectrum of a real signal, in the format the caller needs, written
+ * straight from the last stage of the transform (the real-input post-twiddle or the
+ * split of a packed pair): no intermediate spectrum, and no sqrt unless asked for.
+ */
+#define FFT_OUTPUT_MAGNITUDE 0  /*2*|X(k)|/n, as abs_fft*/
+#define FFT_OUTPUT_POWER 1      /*(2*|X(k)|/n)^2*/
+#define FFT_OUTPUT_DB 2         /*10*log10 of the power, floored at FFT_DB_FLOOR*/
+#define FFT_OUTPUT_COMPLEX 3    /*X(k) as (real, imag) pairs, 2*(n/2+1) values*/
+
+/*dB value of a null bin*/
+#define FFT_DB_FLOOR (-300.0)
+
+/**
+ * size_t fft_output_length(size_t n, int mode)
+ * 
+ * @brief returns the number of values of the one-sided spectrum of an n-long signal in a given mode,
+ *        n/2+1, or 2*(n/2+1) for FFT_OUTPUT_COMPLEX. 0 for an unknown mode.
+ */
+size_t fft_output_length(size_t n, int mode);
+
+/**
+ * int spectrum_ws(const fft_plan_t* plan, const double* signal, int mode, double* out, void* workspace)
+ * 
+ * @brief computes the one-sided spectrum of a real signal.
+ * @param plan, a forward plan of length n
+ * @param signal (in), the n-long signal
+ * @param mode, one of FFT_OUTPUT_xxx
+ * @param out (out), fft_output_length(n, mode) values
+ * @param workspace, fft_workspace_size(n) bytes of memory
+ * @return 1 if success, 0 otherwise (inverse plan, unknown mode)
+ */
+int spectrum_ws(const fft_plan_t* plan,
+                const double* signal, int mode,
+                double* out,
+                void* workspace);
+
+/**
+ * int spectrum_2signals_ws(const fft_plan_t* plan, const double* signal_1, const double* signal_2, int mode,
+ *                          double* out_1, double* out_2, void* workspace)
+ * 
+ * @brief computes the one-sided spectra of two real signals with one complex transform.
+ *        Only the one-sided bins are computed, the mirrored half is never written.
+ * @param out_1, out_2 (out), fft_output_length(n, mode) values each
+ * @return 1 if success, 0 otherwise (inverse plan, unknown mode)
+ */
+int spectrum_2signals_ws(const fft_plan_t* plan,
+                         const double* signal_1, const double* signal_2, int mode,
+                         double* out_1, double* out_2,
+                         void* workspace);
+
+/**
+ * int spectrum_plan(fft_plan_t* plan, const double* signal, int mode, double* out)
+ * 
+ * @brief same as spectrum_ws, using the workspace owned by the plan.
+ */
+int spectrum_plan(fft_plan_t* plan,
+                  const double* signal, int mode,
+                  double* out);
+
+/**
+ * int spectrum_2signals_plan(fft_plan_t* plan, const double* signal_1, const double* signal_2, int mode,
+ *                            double* out_1, double* out_2)
+ * 
+ * @brief same as spectrum_2signals_ws, using the workspace owned by the plan.
+ */
+int spectrum_2signals_plan(fft_plan_t* plan,
+                           const double* signal_1, const double* signal_2, int mode,
+                           double* out_1, double* out_2);
+
+/*
+ * Batched multichannel spectra.
+ * A frame holds nb_channels x n samples, either channel after channel or interleaved
+ * (one sample of every channel, then the next sample...). All the channels share
+ * one plan and are transformed two at a time, packed as in fft_2signals.
+ */
+#define FFT_LAYOUT_CHANNEL_MAJOR 0  /*sample t of channel c at data[c*n+t]*/
+#define FFT_LAYOUT_INTERLEAVED 1    /*sample t of channel c at data[t*nb_channels+c]*/
+
+/**
+ * size_t fft_batch_workspace_size(size_t n)
+ * 
+ * @brief returns the size in bytes of the workspace needed by abs_fft_batch_ws for length n.
+ */
+size_t fft_batch_workspace_size(size_t n);
+
+/**
+ * int abs_fft_batch_ws(const fft_plan_t* plan, const double* data, size_t nb_channels, int layout,
+ *                      double* abs_onesided_fft, void* workspace)
+ * 
+ * @brief computes the abs value of the one-sided fft of each channel of a frame, as abs_fft would.
+ * @param plan, a forward plan of length n
+ * @param data (in), nb_channels x n samples, in the FFT_LAYOUT_xxx layout
+ * @param nb_channels, number of channels in the frame
+ * @param layout, FFT_LAYOUT_CHANNEL_MAJOR or FFT_LAYOUT_INTERLEAVED
+ * @param abs_onesided_fft (out), nb_channels x (n/2+1) values, channel after channel
+ * @param workspace, fft_batch_workspace_size(n) bytes of memory
+ * @return 1 if success, 0 otherwise (inverse plan, unknown layout)
+ */
+int abs_fft_batch_ws(const fft_plan_t* plan,
+                     const double* data, size_t nb_channels, int layout,
+                     double* abs_onesided_fft,
+                     void* workspace);
+
+/**
+ * int abs_fft_batch(fft_plan_t* plan, const double* data, size_t nb_channels, int layout,
+ *                   double* abs_onesided_fft)
+ * 
+ * @brief same as abs_fft_batch_ws, using the workspace owned by the plan.
+ * @return 1 if success, 0 otherwise
+ */
+int abs_fft_batch(fft_plan_t* plan,
+                  const double* data, size_t nb_channels, int layout,
+                  double* abs_onesided_fft);
+
+/**
+ * int spectrum_batch_ws(const fft_plan_t* plan, const double* data, size_t nb_channels, int layout,
+ *                       int mode, double* out, void* workspace)
+ * 
+ * @brief same as abs_fft_batch_ws, with the spectra in the FFT_OUTPUT_xxx format.
+ * @param out (out), nb_channels x fft_output_length(n, mode) values, channel after channel
+ * @param workspace, fft_batch_workspace_size(n) bytes of memory
+ * @return 1 if success, 0 otherwise (inverse plan, unknown layout or mode)
+ */
+int spectrum_batch_ws(const fft_plan_t* plan,
+                      const double* data, size_t nb_channels, int layout,
+                      int mode, double* out,
+                      void* workspace);
+
+/*
+ * Spectral features.
+ * An extractor maps the one-sided bins of signals of n samples at rate fs to a set of
+ * frequency bands once, at creation. It then computes the requested features of each
+ * channel in the output stage of its transform, in a single pass over the bins: the
+ * spectrum is never written to memory. The power of bin k is (2*|X(k)|/n)^2 as in
+ * FFT_OUTPUT_POWER, bin k being at frequency k*fs/n as in get_fft_infos.
+ * The features of a channel are, in this order:
+ * - FFT_FEATURE_BANDS: the power of each band, the sum of the powers of its bins
+ * - the ratios added with fft_features_add_ratio, 0 when the denominator band is null
+ * - FFT_FEATURE_ENTROPY: the spectral entropy of the bins 1..n/2 (the mean excluded),
+ *   -sum q*log(q) with q the share of each bin in their power, divided by log(n/2):
+ *   0 for a pure tone on a bin, 1 for a flat spectrum
+ * - FFT_FEATURE_PEAK: the frequency of the bin of highest power among 1..n/2, and its
+ *   magnitude (2*|X(k)|/n as abs_fft)
+ */
+#define FFT_FEATURE_BANDS 1
+#define FFT_FEATURE_ENTROPY 2
+#define FFT_FEATURE_PEAK 4
+#define FFT_FEATURE_ALL 7
+
+typedef struct fft_features_s fft_features_t;
+
+/**
+ * fft_features_t* fft_features_create(size_t n, double fs, int nb_bands, const double* band_low,
+ *                                     const double* band_high, int flags)
+ * 
+ * @brief creates an extractor of the features of real signals of n samples at rate fs.
+ * @param nb_bands, band_low, band_high (in), the band b covers the bins of frequency in
+ *        [band_low[b], band_high[b]) Hz, cut at fs/2. The bands may overlap
+ * @param flags, a combination of FFT_FEATURE_xxx
+ * @return the extractor, NULL if out of memory or if a parameter is invalid (empty band)
+ */
+fft_features_t* fft_features_create(size_t n, double fs, int nb_bands, const double* band_low,
+                                    const double* band_high, int flags);
+
+/**
+ * void fft_features_destroy(fft_features_t* features)
+ * 
+ * @brief releases the memory held by an extractor. NULL is accepted.
+ */
+void fft_features_destroy(fft_features_t* features);
+
+/**
+ * int fft_features_add_ratio(fft_features_t* features, int numerator, int denominator)
+ * 
+ * @brief adds the ratio of the powers of two bands (alpha/theta...) to the features.
+ *        Changes fft_features_length, not to be called while the extractor is in use.
+ * @param numerator, denominator, indices of the bands
+ * @return 1 if success, 0 otherwise (out of memory, or unknown band)
+ */
+int fft_features_add_ratio(fft_features_t* features, int numerator, int denominator);
+
+/**
+ * size_t fft_features_length(const fft_features_t* features)
+ * 
+ * @brief returns the number of values of the features of one channel.
+ */
+size_t fft_features_length(const fft_features_t* features);
+
+/**
+ * size_t fft_features_workspace_size(const fft_features_t* features)
+ * 
+ * @brief returns the size in bytes of the workspace needed by fft_features_batch_ws.
+ */
+size_t fft_features_workspace_size(const fft_features_t* features);
+
+/**
+ * int fft_features_batch_ws(const fft_features_t* features, const double* data, size_t nb_channels,
+ *                           int layout, double* out, void* workspace)
+ * 
+ * @brief computes the features of each channel of a frame, the channels transformed two
+ *        at a time as in spectrum_batch_ws. An extractor can be shared by several threads,
+ *        each one with its own workspace.
+ * @param data (in), nb_channels x n samples, in the FFT_LAYOUT_xxx layout
+ * @param out (out), nb_channels x fft_features_length values, channel after channel
+ * @param workspace, fft_features_workspace_size bytes of memory
+ * @return 1 if success, 0 otherwise (unknown layout)
+ */
+int fft_features_batch_ws(const fft_features_t* features,
+                          const double* data, size_t nb_channels, int layout,
+                          double* out,
+                          void* workspace);
+
+/**
+ * int fft_features_batch(fft_features_t* features, const double* data, size_t nb_channels,
+ *                        int layout, double* out)
+ * 
+ * @brief same as fft_features_batch_ws, using the workspace owned by the extractor.
+ * @return 1 if success, 0 otherwise (unknown layout)
+ */
+int fft_features_batch(fft_features_t* features,
+                       const double* data, size_t nb_channels, int layout,
+                       double* out);
+
+/**
+ * int fft_features(fft_features_t* features, const double* signal, double* out)
+ * 
+ * @brief same as fft_features_batch for a single signal of n samples.
+ * @param out (out), fft_features_length values
+ * @return 1 if success, 0 otherwise
+ */
+int fft_features(fft_features_t* features, const double* signal, double* out);
+
+/*
+ * Real-input transform.
+ * The even and odd samples of a real signal are packed into a complex signal of half
+ * the length, which is transformed and post-twiddled. Only the n/2+1 bins of the
+ * one-sided spectrum are written, for about half the cost of a complex transform.
+ * Forward plans of even length created by fft_plan_create carry one, so abs_fft_ws
+ * and convolve_real_ws use it automatically.
+ */
+
+/**
+ * rfft_plan_t* rfft_plan_create(size_t n)
+ * 
+ * @brief creates a plan for the real-input transform of length n.
+ * @param n, the length of the real signal, any length is supported (odd lengths run a full complex transform)
+ * @return the plan, NULL if out of memory
+ */
+rfft_plan_t* rfft_plan_create(size_t n);
+
+/**
+ * void rfft_plan_destroy(rfft_plan_t* plan)
+ * 
+ * @brief releases the memory held by a plan. NULL is accepted.
+ */
+void rfft_plan_destroy(rfft_plan_t* plan);
+
+/**
+ * size_t rfft_workspace_size(size_t n)
+ * 
+ * @brief returns the size in bytes of the workspace needed by rfft_ws and irfft_ws for length n.
+ */
+size_t rfft_workspace_size(size_t n);
+
+/**
+ * int rfft_ws(const rfft_plan_t* plan, const double* signal, double* out_real, double* out_imag, void* workspace)
+ * 
+ * @brief computes the one-sided fourier transform of a real signal.
+ * @param signal (in), the n-long signal
+ * @param out_real, out_imag (out), bins 0..n/2 of the transform (n/2+1 values each)
+ * @param workspace, rfft_workspace_size(n) bytes of memory
+ * @return 1 if success, 0 otherwise
+ */
+int rfft_ws(const rfft_plan_t* plan, const double* signal,
+            double* out_real, double* out_imag,
+            void* workspace);
+
+/**
+ * int irfft_ws(const rfft_plan_t* plan, const double* in_real, const double* in_imag, double* signal, void* workspace)
+ * 
+ * @brief computes the inverse of rfft_ws. As inverse_transform, it does not perform
+ *        scaling, so the output is n times the original signal.
+ * @param in_real, in_imag (in), bins 0..n/2 of the transform of a real signal
+ * @param signal (out), the n-long signal
+ * @param workspace, rfft_workspace_size(n) bytes of memory
+ * @return 1 if success, 0 otherwise
+ */
+int irfft_ws(const rfft_plan_t* plan,
+             const double* in_real, const double* in_imag,
+             double* signal,
+             void* workspace);
+
+/**
+ * int rfft(rfft_plan_t* plan, const double* signal, double* out_real, double* out_imag)
+ * 
+ * @brief same as rfft_ws, using the workspace owned by the plan, which is written:
+ *        a plan is used by one thread at a time.
+ */
+int rfft(rfft_plan_t* plan, const double* signal,
+         double* out_real, double* out_imag);
+
+/**
+ * int irfft(rfft_plan_t* plan, const double* in_real, const double* in_imag, double* signal)
+ * 
+ * @brief same as irfft_ws, using the workspace owned by the plan, as rfft.
+ */
+int irfft(rfft_plan_t* plan,
+          const double* in_real, const double* in_imag,
+          double* signal);
+
+/*
+ * Streaming FIR filter.
+ * Linear convolution of an unbounded stream with a fixed kernel, by overlap-save over
+ * real-input transforms: the spectrum of the kernel is computed once, each block of
+ * new samples costs one rfft, one product and one irfft. The output is delayed by one
+ * block, fir_filter_latency samples, so that any chunk of input gives as many output
+ * samples; out[t] is the filtered sample t - latency (0 for t < latency).
+ */
+typedef struct fir_filter_s fir_filter_t;
+
+/**
+ * fir_filter_t* fir_filter_create(const double* kernel, size_t kernel_length, size_t block_length)
+ *
+ * @brief creates a streaming filter, y[t] = sum kernel[j]*x[t-j] for j in [0, kernel_length).
+ * @param kernel (in), the kernel_length coefficients of the FIR filter, copied
+ * @param block_length, minimum number of new samples per block, rounded up so that the
+ *        transform length is a power of 2. 0 to pick the one with the lowest cost per sample
+ * @return the filter, NULL if out of memory or if the kernel is empty
+ */
+fir_filter_t* fir_filter_create(const double* kernel, size_t kernel_length, size_t block_length);
+
+/**
+ * void fir_filter_destroy(fir_filter_t* filter)
+ *
+ * @brief releases the memory held by a filter. NULL is accepted.
+ */
+void fir_filter_destroy(fir_filter_t* filter);
+
+/**
+ * void fir_filter_reset(fir_filter_t* filter)
+ *
+ * @brief clears the history of the filter, as if only zeros had been pushed.
+ */
+void fir_filter_reset(fir_filter_t* filter);
+
+/**
+ * size_t fir_filter_latency(const fir_filter_t* filter)
+ *
+ * @brief returns the delay of the output, in samples (the block length).
+ */
+size_t fir_filter_latency(const fir_filter_t* filter);
+
+/**
+ * void fir_filter_process(fir_filter_t* filter, const double* in, double* out, size_t count)
+ *
+ * @brief filters count new samples.
+ * @param in (in), the new samples, oldest first
+ * @param out (out), count filtered samples, delayed by fir_filter_latency. May be in
+ * @param count, any value is accepted
+ */
+void fir_filter_process(fir_filter_t* filter, const double* in, double* out, size_t count);
+
+/*
+ * Windows, periodic (DFT-even) as used for spectral analysis.
+ */
+#define FFT_WINDOW_RECTANGULAR 0
+#define FFT_WINDOW_HANN 1
+#define FFT_WINDOW_HAMMING 2
+#define FFT_WINDOW_BLACKMAN 3
+
+/**
+ * int fft_window(double* window, size_t n, int type)
+ *
+ * @brief fills window with the n-long periodic window of the given type.
+ * @param window (out), n values
+ * @param type, one of FFT_WINDOW_xxx
+ * @return 1 if success, 0 otherwise (unknown type)
+ */
+int fft_window(double* window, size_t n, int type);
+
+/*
+ * Short-time Fourier transform.
+ * Samples are pushed in chunks of any size into a ring buffer of the last n samples.
+ * Once the buffer is full, a spectrum of the windowed buffer is computed every hop
+ * samples: the samples are never moved, the overlap costs nothing, and the window,
+ * the plan and all the buffers are allocated once at creation.
+ * Frames can be handed to a callback, in the FFT_OUTPUT_xxx format, scaled as abs_fft
+ * for FFT_OUTPUT_MAGNITUDE, and/or averaged into a Welch power spectral density.
+ */
+typedef struct stft_s stft_t;
+
+/*
+ * Frame callback: spectrum holds the fft_output_length(n, mode) values of the frame,
+ * frame is the index of the frame since the creation (or the last reset).
+ * spectrum is only valid during the call.
+ */
+typedef void (*stft_frame_fn)(void *context, const double *spectrum, size_t frame);
+
+/**
+ * stft_t* stft_create(size_t n, size_t hop, int window, int mode, int welch)
+ *
+ * @brief creates a short-time Fourier transform over frames of n samples.
+ * @param n, length of the frames
+ * @param hop, number of samples between the start of two frames (n/2 for a 50% overlap)
+ * @param window, one of FFT_WINDOW_xxx
+ * @param mode, one of FFT_OUTPUT_xxx, format of the spectra passed to the callback
+ * @param welch, 1 to accumulate the Welch power spectral density of the frames, 0 otherwise
+ * @return the stft, NULL if out of memory or if a parameter is invalid
+ */
+stft_t* stft_create(size_t n, size_t hop, int window, int mode, int welch);
+
+/**
+ * void stft_destroy(stft_t* stft)
+ *
+ * @brief releases the memory held by a stft. NULL is accepted.
+ */
+void stft_destroy(stft_t* stft);
+
+/**
+ * void stft_reset(stft_t* stft)
+ *
+ * @brief empties the ring buffer, restarts the frame count and clears the Welch average.
+ */
+void stft_reset(stft_t* stft);
+
+/**
+ * size_t stft_push(stft_t* stft, const double* samples, size_t count, stft_frame_fn fn, void* context)
+ *
+ * @brief pushes count new samples, and computes the frames completed by them.
+ * @param samples (in), the new samples, oldest first
+ * @param count (in), number of new samples, any value is accepted
+ * @param fn, called once per frame, in order. NULL if only the Welch average is needed
+ * @param context, passed to fn
+ * @return the number of frames computed
+ */
+size_t stft_push(stft_t* stft, const double* samples, size_t count,
+                 stft_frame_fn fn, void* context);
+
+/**
+ * size_t stft_psd(const stft_t* stft, double* psd)
+ *
+ * @brief returns the one-sided Welch power spectral density averaged over the frames
+ *        since the last stft_psd_reset, for a sampling frequency of 1 (divide by fs
+ *        for a density per Hz). The sum of the n/2+1 values over n is the mean power.
+ * @param psd (out), n/2+1 values, left untouched if no frame was averaged
+ * @return the number of frames averaged, 0 if none or if the stft was created without welch
+ */
+size_t stft_psd(const stft_t* stft, double* psd);
+
+/**
+ * void stft_psd_reset(stft_t* stft)
+ *
+ * @brief clears the Welch average, the ring buffer is kept.
+ */
+void stft_psd_reset(stft_t* stft);
+
+/*
+ * Polyphase resampler.
+ * Changes the rate of an unbounded stream from fs to fs*up/down (decimation for up = 1),
+ * computing only the outputs that are kept, each one from a single phase of the
+ * anti-alias kernel: a decimation by down costs kernel_length/down products per input
+ * sample. The kernel is a Kaiser-windowed sinc (80 dB) cut at the lower of the two Nyquist
+ * frequencies, its transition band is 5/half_width of that frequency wide, so the band
+ * below (1 - 2.5/half_width)*Nyquist passes and is free of aliasing. The output can be
+ * handed to abs_fft and the other transforms, or pushed into a stft with
+ * resampler_push_stft, with transform lengths and compute divided by down/up.
+ */
+typedef struct resampler_s resampler_t;
+
+/**
+ * resampler_t* resampler_create(int up, int down, size_t half_width)
+ *
+ * @brief creates a resampler from rate fs to rate fs*up/down, with a Kaiser-windowed sinc kernel.
+ * @param up, down, the factors, reduced to lowest terms
+ * @param half_width, zero crossings of the sinc on each side, at the lower of the two rates:
+ *        the kernel has 2*half_width*max(up, down)+1 taps. 0 for the default, 16
+ * @return the resampler, NULL if out of memory or if a factor is not positive
+ */
+resampler_t* resampler_create(int up, int down, size_t half_width);
+
+/**
+ * void resampler_destroy(resampler_t* resampler)
+ *
+ * @brief releases the memory held by a resampler. NULL is accepted.
+ */
+void resampler_destroy(resampler_t* resampler);
+
+/**
+ * void resampler_reset(resampler_t* resampler)
+ *
+ * @brief clears the history of the resampler, as if only zeros had been pushed.
+ */
+void resampler_reset(resampler_t* resampler);
+
+/**
+ * double resampler_delay(const resampler_t* resampler)
+ *
+ * @brief returns the group delay of the kernel, in output samples: output m is the
+ *        filtered signal at input time (m - delay)*down/up.
+ */
+double resampler_delay(const resampler_t* resampler);
+
+/**
+ * size_t resampler_output_length(const resampler_t* resampler, size_t count)
+ *
+ * @brief returns the number of outputs the next resampler_process of count samples gives,
+ *        at most ceil(count*up/down).
+ */
+size_t resampler_output_length(const resampler_t* resampler, size_t count);
+
+/**
+ * size_t resampler_process(resampler_t* resampler, const double* in, size_t count, double* out)
+ *
+ * @brief resamples count new samples.
+ * @param in (in), the new samples, oldest first
+ * @param out (out), resampler_output_length(resampler, count) outputs, must not overlap in
+ * @param count, any value is accepted
+ * @return the number of outputs written
+ */
+size_t resampler_process(resampler_t* resampler, const double* in, size_t count, double* out);
+
+/**
+ * size_t resampler_push_stft(resampler_t* resampler, stft_t* stft, const double* in, size_t count,
+ *                            stft_frame_fn fn, void* context)
+ *
+ * @brief resamples count new samples and pushes the outputs into stft, as stft_push does,
+ *        through a buffer of the resampler: no intermediate array is needed.
+ * @param fn, context, passed to stft_push
+ * @return the number of frames computed
+ */
+size_t resampler_push_stft(resampler_t* resampler, stft_t* stft, const double* in, size_t count,
+                           stft_frame_fn fn, void* context);
+
+/*
+ * Discrete wavelet transform.
+ * Orthonormal wavelets computed by lifting, in place and in O(n): a cheaper alternative
+ * to the FFT bands when the time resolution matters more than the frequency resolution
+ * (transients, spikes). Level j splits the band [0, fs/2^j] of the previous
+ * approximation into its detail [fs/2^(j+1), fs/2^j] and the approximation below.
+ * The coefficients stay where the lifting leaves them: after dwt, the detail k of level
+ * j is at data[(2k+1)*2^(j-1)], the approximation k of the last level L at data[k*2^L].
+ * The band energies are scaled as the one-sided spectra: a sinusoid of amplitude A
+ * inside a band gives A^2, as the sum of the FFT_OUTPUT_POWER bins of that band.
+ */
+#define FFT_WAVELET_HAAR 0
+#define FFT_WAVELET_DB2 1     /*Daubechies, 4 taps, 2 vanishing moments*/
+
+/**
+ * int dwt_max_levels(size_t n)
+ *
+ * @brief returns the deepest decomposition of n samples, log2 of the largest power of 2 dividing n.
+ */
+int dwt_max_levels(size_t n);
+
+/**
+ * int dwt(double* data, size_t n, int wavelet, int levels)
+ *
+ * @brief multilevel wavelet transform, in place, periodic at the ends of data.
+ * @param data (in/out), n samples, replaced by the coefficients in the layout above
+ * @param wavelet, one of FFT_WAVELET_xxx
+ * @param levels, number of levels, 0 for dwt_max_levels(n). n must be a multiple of 2^levels
+ * @return 1 if success, 0 otherwise (unknown wavelet, or invalid number of levels)
+ */
+int dwt(double* data, size_t n, int wavelet, int levels);
+
+/**
+ * int idwt(double* data, size_t n, int wavelet, int levels)
+ *
+ * @brief inverse of dwt, in place: a true inverse, the transform is orthonormal.
+ * @return 1 if success, 0 otherwise (unknown wavelet, or invalid number of levels)
+ */
+int idwt(double* data, size_t n, int wavelet, int levels);
+
+/**
+ * int dwt_band_energy(const double* coefficients, size_t n, int levels, double* energy)
+ *
+ * @brief returns the energy of the bands of a dwt, 2/n times the sum of the squared
+ *        coefficients of each band.
+ * @param coefficients (in), the output of dwt with the same n and levels
+ * @param energy (out), levels+1 values ordered by frequency as the bins of abs_fft: the
+ *        approximation first, then the details of level L, L-1, ..., 1
+ * @return 1 if success, 0 otherwise (invalid number of levels)
+ */
+int dwt_band_energy(const double* coefficients, size_t n, int levels, double* energy);
+
+/*
+ * Streaming wavelet band energies.
+ * The lifting steps run on the unbounded stream as the samples arrive, with no block
+ * boundary: a push costs O(1) per sample, and the band energies of the last hop samples
+ * are reported every hop samples. The Daubechies approximations leave a level one pair
+ * late, and each level starts one sample later so that its pairs are those of dwt: the
+ * energies of the deep levels lag by a few samples, and over a hop-periodic signal the
+ * frames give the dwt_band_energy of one period.
+ */
+typedef struct dwt_stream_s dwt_stream_t;
+
+/*
+ * Frame callback: energy holds the levels+1 band energies of the frame, ordered as
+ * dwt_band_energy, frame is the index of the frame since the creation (or the last reset).
+ * energy is only valid during the call.
+ */
+typedef void (*dwt_frame_fn)(void *context, const double *energy, size_t frame);
+
+/**
+ * dwt_stream_t* dwt_stream_create(int wavelet, int levels, size_t hop)
+ *
+ * @brief creates a streaming tracker of the band energies of a decomposition in levels levels.
+ * @param wavelet, one of FFT_WAVELET_xxx
+ * @param levels, number of levels, at least 1
+ * @param hop, number of samples per frame, a multiple of 2^levels
+ * @return the tracker, NULL if out of memory or if a parameter is invalid
+ */
+dwt_stream_t* dwt_stream_create(int wavelet, int levels, size_t hop);
+
+/**
+ * void dwt_stream_destroy(dwt_stream_t* stream)
+ *
+ * @brief releases the memory held by a tracker. NULL is accepted.
+ */
+void dwt_stream_destroy(dwt_stream_t* stream);
+
+/**
+ * void dwt_stream_reset(dwt_stream_t* stream)
+ *
+ * @brief clears the history, as if only zeros had been pushed, and restarts the frame count.
+ */
+void dwt_stream_reset(dwt_stream_t* stream);
+
+/**
+ * size_t dwt_stream_push(dwt_stream_t* stream, const double* samples, size_t count, dwt_frame_fn fn, void* context)
+ *
+ * @brief pushes count new samples, and reports the frames completed by them.
+ * @param samples (in), the new samples, oldest first
+ * @param count (in), number of new samples, any value is accepted
+ * @param fn, called once per frame, in order. May be NULL
+ * @param context, passed to fn
+ * @return the number of frames completed
+ */
+size_t dwt_stream_push(dwt_stream_t* stream, const double* samples, size_t count,
+                       dwt_frame_fn fn, void* context);
+
+/*
+ * Butterfly kernels of the power-of-2 transforms (also used inside Bluestein).
+ * The kernel is picked at run time from the CPU features when a plan is created.
+ * FFT_KERNEL_SCALAR is the radix-2 loop of transform_radix2, kept as the reference,
+ * the others run fused radix-4 stages with contiguous twiddles.
+ */
+#define FFT_KERNEL_AUTO 0    /*fastest kernel available on this CPU (default)*/
+#define FFT_KERNEL_SCALAR 1  /*reference radix-2 loop*/
+#define FFT_KERNEL_RADIX4 2  /*portable radix-4*/
+#define FFT_KERNEL_SSE2 3    /*x86*/
+#define FFT_KERNEL_AVX2 4    /*x86 with AVX2 and FMA*/
+#define FFT_KERNEL_NEON 5    /*aarch64*/
+
+/**
+ * int fft_kernel_available(int kernel)
+ * 
+ * @brief tells if a butterfly kernel can run on this CPU.
+ * @param kernel, one of FFT_KERNEL_xxx
+ * @return 1 if available, 0 otherwise
+ */
+int fft_kernel_available(int kernel);
+
+/**
+ * int fft_set_kernel(int kernel)
+ * 
+ * @brief selects the butterfly kernel used by the plans created from now on.
+ *        Plans that already exist keep their kernel. Not thread-safe, call it at startup.
+ * @param kernel, one of FFT_KERNEL_xxx
+ * @return 1 if success, 0 if the kernel is not available on this CPU
+ */
+int fft_set_kernel(int kernel);
+
+/**
+ * int fft_get_kernel(void)
+ * 
+ * @brief returns the kernel used by the plans created from now on, FFT_KERNEL_AUTO resolved.
+ */
+int fft_get_kernel(void);
+
+/**
+ * const char* fft_kernel_name(int kernel)
+ * 
+ * @brief returns a printable name of the kernel.
+ */
+const char* fft_kernel_name(int kernel);
+
+/*
+ * Single precision.
+ * float versions of the plans and wrappers, for samples which do not need the
+ * precision of a double (24-bit ADC). They run the same kernels as the double
+ * transforms (fft_template.h), with the tables computed in double and rounded.
+ * The float plans always use the scalar butterflies. As a double plan, a float plan
+ * owns the workspace written by the xxx_plan_f functions, which take it non-const.
+ */
+typedef struct fft_plan_f_s fft_plan_f_t;
+
+/**
+ * fft_plan_f_t* fft_plan_f_create(size_t n, int inverse)
+ * 
+ * @brief same as fft_plan_create, in single precision.
+ * @param n, the length of the transform, any length is supported.
+ * @param inverse, 1 for the inverse transform (unscaled), FFT_INVERSE_SCALED for the inverse
+ *        transform scaled by 1/n, 0 for the forward transform
+ * @return the plan, NULL if out of memory
+ */
+fft_plan_f_t* fft_plan_f_create(size_t n, int inverse);
+
+/**
+ * void fft_plan_f_destroy(fft_plan_f_t* plan)
+ * 
+ * @brief releases the memory held by a plan. NULL is accepted.
+ */
+void fft_plan_f_destroy(fft_plan_f_t* plan);
+
+/**
+ * size_t fft_plan_f_length(const fft_plan_f_t* plan)
+ * 
+ * @brief returns the length of the transform computed by the plan.
+ */
+size_t fft_plan_f_length(const fft_plan_f_t* plan);
+
+/**
+ * int transform_plan_f(fft_plan_f_t* plan, float real[], float imag[])
+ * 
+ * @brief same as transform_plan, in single precision.
+ * @return 1 if success, 0 otherwise
+ */
+int transform_plan_f(fft_plan_f_t* plan, float real[], float imag[]);
+
+/**
+ * int fft_2signals_plan_f(fft_plan_f_t* plan, ...)
+ * 
+ * @brief same as fft_2signals_plan, in single precision.
+ * @return 1 if success, 0 otherwise (inverse plan)
+ */
+int fft_2signals_plan_f(fft_plan_f_t* plan,
+                        const float* signal_1, const float* signal_2,
+                        float* X1_real, float* X1_imag,
+                        float* X2_real, float* X2_imag);
+
+/**
+ * int abs_fft_plan_f(fft_plan_f_t* plan, const float* signal, float* abs_onesided_fft)
+ * 
+ * @brief same as abs_fft_plan, in single precision.
+ * @return 1 if success, 0 otherwise (inverse plan)
+ */
+int abs_fft_plan_f(fft_plan_f_t* plan,
+                   const float* signal,
+                   float* abs_onesided_fft);
+
+/**
+ * int abs_fft_2signals_plan_f(fft_plan_f_t* plan, ...)
+ * 
+ * @brief same as abs_fft_2signals_plan, in single precision.
+ * @return 1 if success, 0 otherwise (inverse plan)
+ */
+int abs_fft_2signals_plan_f(fft_plan_f_t* plan,
+                            const float* signal_1, const float* signal_2,
+                            float* X1,
+                            float* X2);
+
+/**
+ * int spectrum_plan_f(fft_plan_f_t* plan, const float* signal, int mode, float* out)
+ * 
+ * @brief same as spectrum_plan, in single precision.
+ * @return 1 if success, 0 otherwise (inverse plan, unknown mode)
+ */
+int spectrum_plan_f(fft_plan_f_t* plan,
+                    const float* signal, int mode,
+                    float* out);
+
+/**
+ * int spectrum_2signals_plan_f(fft_plan_f_t* plan, const float* signal_1, const float* signal_2, int mode,
+ *                              float* out_1, float* out_2)
+ * 
+ * @brief same as spectrum_2signals_plan, in single precision.
+ * @return 1 if success, 0 otherwise (inverse plan, unknown mode)
+ */
+int spectrum_2signals_plan_f(fft_plan_f_t* plan,
+                             const float* signal_1, const float* signal_2, int mode,
+                             float* out_1, float* out_2);
+
+/* 
+ * float versions of transform and inverse_transform, any length.
+ * Returns 1 (true) if successful, 0 (false) otherwise (out of memory).
+ */
+int transform_f(float real[], float imag[], size_t n);
+int inverse_transform_f(float real[], float imag[], size_t n);
+
+/**
+ * int fft_2signals_f(const float* signal_1, const float* signal_2, ..., size_t n)
+ * 
+ * @brief float version of fft_2signals.
+ * @return 1 if success, 0 otherwise (out of memory)
+ */
+int fft_2signals_f(const float* signal_1, const float* signal_2,
+                   float* X1_real, float* X1_imag,
+                   float* X2_real, float* X2_imag,
+                   size_t n);
+
+/**
+ * int abs_fft_f(const float* signal, float* abs_onesided_fft, size_t n)
+ * 
+ * @brief float version of abs_fft.
+ * @return 1 if success, 0 otherwise (out of memory)
+ */
+int abs_fft_f(const float* signal,
+              float* abs_onesided_fft,
+              size_t n);
+
+/**
+ * int abs_fft_2signals_f(const float* signal_1, const float* signal_2, float* X1, float* X2, size_t n)
+ * 
+ * @brief float version of abs_fft_2signals.
+ * @return 1 if success, 0 otherwise (out of memory)
+ */
+int abs_fft_2signals_f(const float* signal_1, const float* signal_2,
+                       float* X1,
+                       float* X2,
+                       size_t n);
+
+/*
+ * Fixed point, for the targets without a double-precision FPU.
+ * The samples are the raw integers of the ADC, 16 bits (q15) or 32 bits (q31), and the
+ * results come as integers and one exponent in block floating point: result[k]*2^exponent
+ * is the value abs_fft or abs_dft_interval return for the same samples as doubles. Only
+ * integer arithmetic runs on the samples, cos() and sin() are called when creating the plans.
+ *
+ * Error bound on every output value, against the exact DFT, with max|x| the largest
+ * absolute sample of the signal and n = 2^levels:
+ *   abs_fft_q15            (levels+2)*2^-13*max|x|
+ *   abs_fft_q31            (levels+2)*2^-29*max|x|
+ *   abs_dft_interval_qxx   (2^-28 + 2^-32*sqrt(n))*max|x|, any n
+ * The transform keeps 13 (q15) or 29 (q31) bits for the largest value of the block at each
+ * stage, and loses about half a bit of it per stage. Goertzel keeps 64-bit states and 31-bit
+ * coefficients whatever the width of the samples, the same bound holds for q15 and q31. On
+ * the bins close to 0 or n/2 of the long signals, it is more accurate than abs_dft_interval.
+ */
+
+/*
+ * Fixed-point plans, see fft_fixed_plan_create. A plan holds its work vectors, which
+ * every call writes: the functions take it non-const, and a plan is used by one thread
+ * at a time. Only the powers of 2 are supported, the block floating-point stages being
+ * radix-2: the other lengths (220, 1000...) have no fixed-point transform.
+ */
+typedef struct fft_fixed_plan_s fft_fixed_plan_t;
+
+/**
+ * fft_fixed_plan_t* fft_fixed_plan_create(size_t n)
+ * 
+ * @brief creates a plan for the fixed-point transforms of length n.
+ * @param n, a power of 2, the other lengths are not supported
+ * @return the plan, NULL if n is not a power of 2 or if out of memory
+ */
+fft_fixed_plan_t* fft_fixed_plan_create(size_t n);
+
+/**
+ * void fft_fixed_plan_destroy(fft_fixed_plan_t* plan)
+ * 
+ * @brief releases the memory held by a plan. NULL is accepted.
+ */
+void fft_fixed_plan_destroy(fft_fixed_plan_t* plan);
+
+/**
+ * int transform_q15(fft_fixed_plan_t* plan, int16_t real[], int16_t imag[], int* exponent)
+ * 
+ * @brief computes the DFT of the complex vector in place, in block floating point.
+ * @param real, imag, complex vector of length n, replaced by X(k) = (real[k] + j*imag[k])*2^(*exponent)
+ * @param exponent (out), the exponent of the result
+ * @return 1 if success, 0 otherwise
+ */
+int transform_q15(fft_fixed_plan_t* plan, int16_t real[], int16_t imag[], int* exponent);
+
+/**
+ * int transform_q31(fft_fixed_plan_t* plan, int32_t real[], int32_t imag[], int* exponent)
+ * 
+ * @brief same as transform_q15 over 32-bit values.
+ * @return 1 if success, 0 otherwise
+ */
+int transform_q31(fft_fixed_plan_t* plan, int32_t real[], int32_t imag[], int* exponent);
+
+/**
+ * int abs_fft_q15(fft_fixed_plan_t* plan, const int16_t* signal, int32_t* abs_onesided_fft, int* exponent)
+ * 
+ * @brief fixed-point abs_fft: abs value of the one-sided fft of the signal, 2*|X(k)|/n.
+ * @param signal (in), the n-long signal
+ * @param abs_onesided_fft (out), n/2+1 values, abs_fft(signal)[k] = abs_onesided_fft[k]*2^(*exponent)
+ * @param exponent (out), the exponent of the result
+ * @return 1 if success, 0 otherwise
+ */
+int abs_fft_q15(fft_fixed_plan_t* plan, const int16_t* signal, int32_t* abs_onesided_fft, int* exponent);
+
+/**
+ * int abs_fft_q31(fft_fixed_plan_t* plan, const int32_t* signal, int32_t* abs_onesided_fft, int* exponent)
+ * 
+ * @brief same as abs_fft_q15 over 32-bit samples.
+ * @return 1 if success, 0 otherwise
+ */
+int abs_fft_q31(fft_fixed_plan_t* plan, const int32_t* signal, int32_t* abs_onesided_fft, int* exponent);
+
+/*
+ * Fixed-point Goertzel plans, with the coefficients of an interval of bins precomputed
+ * for a given n, in Q30, any n. As fft_fixed_plan_t, a plan holds the magnitudes of
+ * the call being computed: it is taken non-const, by one thread at a time.
+ */
+typedef struct dft_interval_fixed_plan_s dft_interval_fixed_plan_t;
+
+/**
+ * dft_interval_fixed_plan_t* dft_interval_fixed_plan_create(int n, int interval_start, int interval_stop)
+ * 
+ * @brief precomputes the fixed-point Goertzel coefficients of the bins [interval_start, interval_stop)
+ *        for an n-long signal.
+ * @return the plan, NULL if out of memory or if the interval is empty
+ */
+dft_interval_fixed_plan_t* dft_interval_fixed_plan_create(int n, int interval_start, int interval_stop);
+
+/**
+ * void dft_interval_fixed_plan_destroy(dft_interval_fixed_plan_t* plan)
+ * 
+ * @brief releases the memory held by a plan. NULL is accepted.
+ */
+void dft_interval_fixed_plan_destroy(dft_interval_fixed_plan_t* plan);
+
+/**
+ * void abs_dft_interval_q15(dft_interval_fixed_plan_t* plan, const int16_t* signal,
+ *                           int32_t* abs_power_interval, int* exponent)
+ * 
+ * @brief fixed-point abs_dft_interval_plan: 2*|X(k)|/n for the bins of the plan.
+ * @param signal (in), the n-long signal
+ * @param abs_power_interval (out), one value per bin, abs_dft_interval(signal)[k] = abs_power_interval[k]*2^(*exponent)
+ * @param exponent (out), the exponent of the result
+ */
+void abs_dft_interval_q15(dft_interval_fixed_plan_t* plan, const int16_t* signal,
+                          int32_t* abs_power_interval, int* exponent);
+
+/**
+ * void abs_dft_interval_q31(dft_interval_fixed_plan_t* plan, const int32_t* signal,
+ *                           int32_t* abs_power_interval, int* exponent)
+ * 
+ * @brief same as abs_dft_interval_q15 over 32-bit samples.
+ */
+void abs_dft_interval_q31(dft_interval_fixed_plan_t* plan, const int32_t* signal,
+                          int32_t* abs_power_interval, int* exponent);
+
+#endif
@@ -0,0 +1,133 @@
+/**
+ * @file fft_stats.h
+ * @brief Instrumentation of the hot paths of libsignalproc: call counts, time and bytes
+ *        allocated per entry point, and the algorithm and length of every transform run.
+ *
+ *        The counters are only compiled in when the library is built with
+ *        SIGNALPROC_STATS defined (make SIGNALPROC_STATS=1). Otherwise the functions
+ *        below are still there, but fft_stats_enabled returns 0, the snapshot is all
+ *        zeros and nothing is added to the transforms.
+ *
+ *        The counters are global and updated with atomic operations, a snapshot can
+ *        be taken from any thread while the others are computing.
+ */
+
+#ifndef FFT_STATS_H
+#define FFT_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Entry points. The time and bytes of an entry point include the ones of the
+ * entry points it calls (abs_fft counts its transform, which counts its plan).
+ */
+#define FFT_STATS_TRANSFORM 0               /*transform*/
+#define FFT_STATS_INVERSE_TRANSFORM 1       /*inverse_transform*/
+#define FFT_STATS_TRANSFORM_RADIX2 2        /*transform_radix2*/
+#define FFT_STATS_TRANSFORM_MIXED_RADIX 3   /*transform_mixed_radix*/
+#define FFT_STATS_TRANSFORM_BLUESTEIN 4     /*transform_bluestein*/
+#define FFT_STATS_CONVOLVE_REAL 5           /*convolve_real*/
+#define FFT_STATS_CONVOLVE_COMPLEX 6        /*convolve_complex*/
+#define FFT_STATS_FFT_2SIGNALS 7            /*fft_2signals*/
+#define FFT_STATS_ABS_FFT 8                 /*abs_fft*/
+#define FFT_STATS_ABS_FFT_2SIGNALS 9        /*abs_fft_2signals*/
+#define FFT_STATS_PLAN_CREATE 10            /*fft_plan_create, and the plans of the functions above*/
+#define FFT_STATS_TRANSFORM_WS 11           /*transform_ws, transform_plan*/
+#define FFT_STATS_SPECTRUM_WS 12            /*spectrum_ws, spectrum_plan, abs_fft_ws, abs_fft_plan*/
+#define FFT_STATS_SPECTRUM_2SIGNALS_WS 13   /*spectrum_2signals_ws and its wrappers*/
+#define FFT_STATS_CONVOLVE_WS 14            /*convolve_real_ws, convolve_complex_ws*/
+#define FFT_STATS_SPECTRUM_BATCH 15         /*spectrum_batch_ws, abs_fft_batch_ws, one call per thread for the pools*/
+#define FFT_STATS_RFFT 16                   /*rfft_ws, rfft*/
+#define FFT_STATS_IRFFT 17                  /*irfft_ws, irfft*/
+#define FFT_STATS_TRANSFORM_PLAN_F 18       /*transform_plan_f*/
+#define FFT_STATS_SPECTRUM_PLAN_F 19        /*spectrum_plan_f, abs_fft_plan_f*/
+#define FFT_STATS_STFT_PUSH 20              /*stft_push*/
+#define FFT_STATS_ABS_DFT_INTERVAL 21       /*abs_dft_interval*/
+#define FFT_STATS_TRANSFORM_INTERLEAVED 22  /*transform_interleaved, inverse_transform_interleaved*/
+#define FFT_STATS_TRANSFORM_FIXED 23        /*transform_q15, transform_q31, abs_fft_q15, abs_fft_q31*/
+#define FFT_STATS_ABS_DFT_INTERVAL_FIXED 24 /*abs_dft_interval_q15, abs_dft_interval_q31*/
+#define FFT_STATS_RESAMPLER_PROCESS 25      /*resampler_process, and the runs of resampler_push_stft*/
+#define FFT_STATS_DWT 26                    /*dwt, idwt, dwt_stream_push*/
+#define FFT_STATS_FEATURES 27               /*fft_features_batch_ws and its wrappers*/
+#define FFT_STATS_NB_ENTRIES 28
+
+/*
+ * Dispatch paths: algorithm that ran a complex transform, in double or single precision.
+ * The real-input transforms are counted as the complex transform they run (of length n/2
+ * for even n). The plans' Bluestein runs its power-of-2 convolutions directly, transform_bluestein
+ * runs them through transform, so they are also counted in FFT_STATS_PATH_RADIX2.
+ */
+#define FFT_STATS_PATH_RADIX2 0
+#define FFT_STATS_PATH_MIXED 1
+#define FFT_STATS_PATH_BLUESTEIN 2
+#define FFT_STATS_PATH_RADIX2_F 3
+#define FFT_STATS_PATH_MIXED_F 4
+#define FFT_STATS_PATH_BLUESTEIN_F 5
+#define FFT_STATS_PATH_CODELET 6
+#define FFT_STATS_NB_PATHS 7
+
+/*size histogram: transforms of length n go to bucket floor(log2(n)), the last one holds the longer ones*/
+#define FFT_STATS_NB_SIZE_BUCKETS 32
+
+/*
+ * Counters of an entry point or a dispatch path.
+ */
+typedef struct fft_stats_counter_s{
+	uint64_t calls;
+	uint64_t ns;       /*cumulative wall-clock time, CLOCK_MONOTONIC*/
+	uint64_t bytes;    /*bytes allocated during the calls, by the calling thread (0 for the paths)*/
+} fft_stats_counter_t;
+
+/*
+ * Snapshot of all the counters since the start of the process or the last fft_stats_reset.
+ */
+typedef struct fft_stats_s{
+	fft_stats_counter_t entry[FFT_STATS_NB_ENTRIES];
+	fft_stats_counter_t path[FFT_STATS_NB_PATHS];
+	uint64_t sizes[FFT_STATS_NB_PATHS][FFT_STATS_NB_SIZE_BUCKETS];
+
+	/*all the allocations of the library, inside an entry point or not*/
+	uint64_t nb_allocs;
+	uint64_t bytes_allocated;
+} fft_stats_t;
+
+/**
+ * int fft_stats_enabled(void)
+ *
+ * @brief tells whether the library was built with the instrumentation.
+ * @return 1 if the counters are maintained, 0 otherwise
+ */
+int fft_stats_enabled(void);
+
+/**
+ * void fft_stats_get(fft_stats_t* stats)
+ *
+ * @brief copies the current value of all the counters. Each counter is read atomically,
+ *        but the snapshot as a whole is not: calls still running may show in some counters only.
+ *        All zeros when the instrumentation is not compiled in.
+ */
+void fft_stats_get(fft_stats_t* stats);
+
+/**
+ * void fft_stats_reset(void)
+ *
+ * @brief sets all the counters back to zero.
+ */
+void fft_stats_reset(void);
+
+/**
+ * const char* fft_stats_entry_name(int entry)
+ *
+ * @brief returns the name of an entry point (FFT_STATS_xxx), NULL if unknown.
+ */
+const char* fft_stats_entry_name(int entry);
+
+/**
+ * const char* fft_stats_path_name(int path)
+ *
+ * @brief returns the name of a dispatch path (FFT_STATS_PATH_xxx), NULL if unknown.
+ */
+const char* fft_stats_path_name(int path);
+
+#endif
@@ -0,0 +1,148 @@
+/**
+ * @file signal_file.h
+ * @brief Multichannel recordings on disk: memory-mapped reader and streaming writer.
+ */
+
+#ifndef SIGNAL_FILE_H
+#define SIGNAL_FILE_H
+
+#include <stddef.h>
+#include "fft.h"
+
+/*
+ * Recording format.
+ * A SIGNAL_FILE_HEADER_SIZE bytes header, then the samples as doubles in the byte order
+ * of the machine that wrote them, frame after frame: sample t of channel c is the double
+ * t*nb_channels + c of the data, the FFT_LAYOUT_INTERLEAVED layout. The number of frames
+ * is given by the size of the file, so a recording that was not closed properly is still
+ * readable up to its last complete frame. The same format holds the outputs of an
+ * analysis, one frame per spectrum or band power vector.
+ *
+ * Header, all fields in the byte order of the data:
+ *   char     magic[8]      "SIGREC\0\1"
+ *   uint32_t byte_order    0x01020304
+ *   uint32_t header_size   SIGNAL_FILE_HEADER_SIZE, offset of the data
+ *   uint32_t nb_channels   values per frame
+ *   uint32_t sample_type   SIGNAL_FILE_FLOAT64
+ *   double   sample_rate   frames per second, 0 if unknown
+ *   then zeros up to header_size
+ */
+#define SIGNAL_FILE_HEADER_SIZE 64
+#define SIGNAL_FILE_FLOAT64 1
+
+/*
+ * Memory-mapped reader.
+ * The whole file is mapped read-only, and the frames are handed out as pointers into
+ * the mapping: nothing is read or copied until the pages are touched. The data starts
+ * SIGNAL_FILE_HEADER_SIZE bytes after the page-aligned mapping, so the windows can go
+ * straight into spectrum_batch_ws, abs_fft_batch_ws, fft_pool_abs_fft_batch or
+ * band_power_push with FFT_LAYOUT_INTERLEAVED.
+ */
+typedef struct signal_file_s signal_file_t;
+
+/**
+ * signal_file_t* signal_file_open(const char* path)
+ *
+ * @brief maps a recording, for sequential reading by default.
+ * @return the file, NULL if it cannot be opened or mapped, or if it is not a recording
+ *         written on a machine of the same byte order
+ */
+signal_file_t* signal_file_open(const char* path);
+
+/**
+ * void signal_file_close(signal_file_t* file)
+ *
+ * @brief unmaps the recording, the pointers returned by signal_file_frames become invalid.
+ *        NULL is accepted.
+ */
+void signal_file_close(signal_file_t* file);
+
+/**
+ * size_t signal_file_nb_channels(const signal_file_t* file)
+ *
+ * @brief returns the number of values per frame.
+ */
+size_t signal_file_nb_channels(const signal_file_t* file);
+
+/**
+ * size_t signal_file_nb_frames(const signal_file_t* file)
+ *
+ * @brief returns the number of complete frames of the recording.
+ */
+size_t signal_file_nb_frames(const signal_file_t* file);
+
+/**
+ * double signal_file_sample_rate(const signal_file_t* file)
+ *
+ * @brief returns the frames per second stored in the header, 0 if unknown.
+ */
+double signal_file_sample_rate(const signal_file_t* file);
+
+/**
+ * const double* signal_file_frames(const signal_file_t* file, size_t first, size_t count)
+ *
+ * @brief returns the frames [first, first+count) of the recording, in place in the mapping.
+ * @return nb_channels x count samples in the FFT_LAYOUT_INTERLEAVED layout, NULL if the
+ *         window goes past the last frame
+ */
+const double* signal_file_frames(const signal_file_t* file, size_t first, size_t count);
+
+/**
+ * int signal_file_advise(const signal_file_t* file, size_t first, size_t count, int will_need)
+ *
+ * @brief tells the kernel that the frames [first, first+count) are needed soon (will_need = 1),
+ *        to read them ahead, or that they are done with (will_need = 0), to drop them from
+ *        the cache of the process. Only a hint, for files larger than the memory.
+ * @return 1 if success, 0 otherwise (window past the last frame)
+ */
+int signal_file_advise(const signal_file_t* file, size_t first, size_t count, int will_need);
+
+/*
+ * Streaming writer.
+ * Frames are appended to a buffer of SIGNAL_WRITER_BUFFER_SIZE bytes, written out with
+ * one large write when it is full; appends larger than the buffer are written directly.
+ * Errors are sticky: once a write fails, the next appends do nothing and
+ * signal_writer_close reports it.
+ */
+#define SIGNAL_WRITER_BUFFER_SIZE (1 << 20)
+
+typedef struct signal_writer_s signal_writer_t;
+
+/**
+ * signal_writer_t* signal_writer_create(const char* path, size_t nb_channels, double sample_rate)
+ *
+ * @brief creates (or truncates) a recording and writes its header.
+ * @param nb_channels, values per frame: channels of a recording, or nb_channels x (n/2+1)
+ *        bins for spectra, nb_channels x nb_bands for band powers...
+ * @param sample_rate, frames per second, 0 if unknown
+ * @return the writer, NULL if the file cannot be created or nb_channels is 0
+ */
+signal_writer_t* signal_writer_create(const char* path, size_t nb_channels, double sample_rate);
+
+/**
+ * int signal_writer_append(signal_writer_t* writer, const double* frames, size_t count)
+ *
+ * @brief appends count frames.
+ * @param frames (in), nb_channels x count values, frame after frame. The whole output of a
+ *        spectrum_batch_ws or band_power_get call is one frame
+ * @return 1 if success, 0 if this or an earlier write failed
+ */
+int signal_writer_append(signal_writer_t* writer, const double* frames, size_t count);
+
+/**
+ * int signal_writer_flush(signal_writer_t* writer)
+ *
+ * @brief writes out the buffered frames.
+ * @return 1 if success, 0 if this or an earlier write failed
+ */
+int signal_writer_flush(signal_writer_t* writer);
+
+/**
+ * int signal_writer_close(signal_writer_t* writer)
+ *
+ * @brief flushes the buffer, closes the file and releases the writer. NULL is accepted.
+ * @return 1 if every frame was written, 0 otherwise
+ */
+int signal_writer_close(signal_writer_t* writer);
+
+#endif
@@ -1,6 +1,15 @@
 #ifndef PINK_NOISE_H
 #define PINK_NOISE_H
 
+#include "signal_rng.h"
+
+/*
+ * The generators below draw from the global rand(), seeded with srand().
+ * The xxx_r versions draw from an explicit signal_rng_t instead: they are reentrant,
+ * so threads with one state each can generate at the same time, and reproducible
+ * from the seed of the state alone.
+ */
+
 /**
  * void get_signal_pink(double* signal, int sample_length)
  * @brief generate a pink noise signal of length n. Wrapper on pink_noise by John Burkardt
@@ -9,6 +18,72 @@
  */ 
 void get_pink_signal(double* signal, int n);
 
+/**
+ * void get_pink_signal_f(float* signal, int n)
+ * @brief float version of get_pink_signal, same sequence of samples rounded to float.
+ */ 
+void get_pink_signal_f(float* signal, int n);
+
+/**
+ * void get_pink_signal_r(signal_rng_t* rng, double* signal, int n)
+ * @brief same as get_pink_signal, drawing from rng.
+ */ 
+void get_pink_signal_r(signal_rng_t* rng, double* signal, int n);
+
+/**
+ * void get_pink_signal_f_r(signal_rng_t* rng, float* signal, int n)
+ * @brief same as get_pink_signal_f, drawing from rng.
+ */ 
+void get_pink_signal_f_r(signal_rng_t* rng, float* signal, int n);
+
+/*
+ * Streaming pink noise.
+ * A pink noise generator keeps the Voss-McCartney rows of get_pink_signal from one
+ * call to the next, so a signal generated in chunks is the same as in one go.
+ * Row i is redrawn every 2^i samples: the rows due at sample t are found from the
+ * trailing zeros of the sample counter, and the sum of the rows is kept up to date,
+ * so a sample costs 2 row updates on average instead of a pass over all the rows.
+ */
+#define PINK_MAX_ROWS 31
+
+typedef struct pink_generator_s pink_generator_t;
+
+/**
+ * pink_generator_t* pink_generator_create(int nb_rows, const signal_rng_t* rng)
+ * @brief creates a pink noise generator.
+ * @param nb_rows (in), number of rows, 1..PINK_MAX_ROWS (PINK_MAX_ROWS as get_pink_signal).
+ *                      The spectrum is 1/f over about nb_rows octaves
+ * @param rng (in), the generator draws from a copy of this state, NULL to seed it from rand()
+ * @return the generator, NULL if out of memory or if nb_rows is out of range
+ */ 
+pink_generator_t* pink_generator_create(int nb_rows, const signal_rng_t* rng);
+
+/**
+ * void pink_generator_destroy(pink_generator_t* gen)
+ * @brief releases the memory held by a generator. NULL is accepted.
+ */ 
+void pink_generator_destroy(pink_generator_t* gen);
+
+/**
+ * void pink_generator_reset(pink_generator_t* gen)
+ * @brief redraws all the rows and restarts the sample counter, the stream is not
+ *        continuous across a reset.
+ */ 
+void pink_generator_reset(pink_generator_t* gen);
+
+/**
+ * void pink_generator_next(pink_generator_t* gen, double* signal, int n)
+ * @brief generates the next n samples of the stream.
+ * @param signal (out), n-long array that will contain the samples
+ */ 
+void pink_generator_next(pink_generator_t* gen, double* signal, int n);
+
+/**
+ * void pink_generator_next_f(pink_generator_t* gen, float* signal, int n)
+ * @brief float version of pink_generator_next, the same stream rounded to float.
+ */ 
+void pink_generator_next_f(pink_generator_t* gen, float* signal, int n);
+
 
 /**
  * void get_signal_sin(double* signal, int sample_length, double norm_frequency, double diff_factor)
@@ -22,6 +97,139 @@ void get_pink_signal(double* signal, int n);
  */ 
 void get_sinus_signal(double* signal, int n, double norm_freq, double phase_disp);
 
+/**
+ * void get_sinus_signal_f(float* signal, int n, double norm_freq, double phase_disp)
+ * @brief float version of get_sinus_signal, same sequence of samples rounded to float.
+ */ 
+void get_sinus_signal_f(float* signal, int n, double norm_freq, double phase_disp);
+
+/**
+ * void get_sinus_signal_r(signal_rng_t* rng, double* signal, int n, double norm_freq, double phase_disp)
+ * @brief same as get_sinus_signal, the phase noise being drawn from rng.
+ */ 
+void get_sinus_signal_r(signal_rng_t* rng, double* signal, int n, double norm_freq, double phase_disp);
+
+/**
+ * void get_sinus_signal_f_r(signal_rng_t* rng, float* signal, int n, double norm_freq, double phase_disp)
+ * @brief same as get_sinus_signal_f, the phase noise being drawn from rng.
+ */ 
+void get_sinus_signal_f_r(signal_rng_t* rng, float* signal, int n, double norm_freq, double phase_disp);
+
+/*
+ * Streaming sinus generator.
+ * A bank of pure tones summed into one signal, with the phase of each tone carried
+ * from one call to the next. Each tone is a rotation recurrence over SINUS_LANES
+ * consecutive samples at a time, so no sin() is computed per sample and the lanes
+ * vectorize. The tones are recomputed exactly every few thousand samples, so the
+ * amplitude and the phase do not drift over long sessions.
+ */
+#define SINUS_LANES 4
+
+typedef struct sinus_generator_s sinus_generator_t;
+
+/**
+ * sinus_generator_t* sinus_generator_create(int nb_tones, const double* norm_freq, const double* amplitude, const double* phase)
+ * @brief creates a generator of the signal sum amplitude[j]*sin(norm_freq[j]*pi*i + phase[j]) over the tones j,
+ *        with norm_freq normalized to nyquist as in get_sinus_signal.
+ * @param nb_tones (in), number of tones, at least 1
+ * @param norm_freq (in), frequency of each tone
+ * @param amplitude (in), amplitude of each tone, NULL for 1
+ * @param phase (in), phase at sample 0 of each tone in radians, NULL for 0
+ * @return the generator, NULL if out of memory or if nb_tones < 1
+ */ 
+sinus_generator_t* sinus_generator_create(int nb_tones, const double* norm_freq,
+                                          const double* amplitude, const double* phase);
+
+/**
+ * void sinus_generator_destroy(sinus_generator_t* gen)
+ * @brief releases the memory held by a generator. NULL is accepted.
+ */ 
+void sinus_generator_destroy(sinus_generator_t* gen);
+
+/**
+ * void sinus_generator_reset(sinus_generator_t* gen)
+ * @brief restarts the signal at sample 0.
+ */ 
+void sinus_generator_reset(sinus_generator_t* gen);
+
+/**
+ * void sinus_generator_next(sinus_generator_t* gen, double* signal, int n)
+ * @brief generates the next n samples of the signal.
+ * @param signal (out), n-long array that will contain the samples
+ */ 
+void sinus_generator_next(sinus_generator_t* gen, double* signal, int n);
+
+/**
+ * void sinus_generator_next_f(sinus_generator_t* gen, float* signal, int n)
+ * @brief float version of sinus_generator_next, the same signal rounded to float.
+ */ 
+void sinus_generator_next_f(sinus_generator_t* gen, float* signal, int n);
+
+/*
+ * Signal mixes.
+ * A mix is a list of sources with a gain each, generated for nb_channels independent
+ * channels and summed into the caller buffer block by block, while each block is still
+ * in cache. Every channel of every source has its own random stream, jumped from the
+ * seed of the mix, so the output only depends on the seed and the calls, not on the
+ * order the channels are generated in (see signal_mix_next_parallel in thread_pool.h).
+ */
+#define SIGNAL_SOURCE_PINK 0             /*pink noise, as get_pink_signal*/
+#define SIGNAL_SOURCE_SINUS 1            /*sinus at norm_freq = param_1, random phase per channel*/
+#define SIGNAL_SOURCE_DISPERSED_SINUS 2  /*sinus at norm_freq = param_1, phase_disp = param_2, as get_sinus_signal*/
+#define SIGNAL_SOURCE_WHITE 3            /*normal white noise, of standard deviation gain*/
+#define SIGNAL_SOURCE_DC 4               /*constant level gain*/
+#define SIGNAL_SOURCE_ARTIFACT 5         /*half-sine bumps of amplitude +-gain (eye blinks), starting with a
+                                           probability param_1 per sample and lasting param_2 samples*/
+
+/*maximum number of sources in a mix*/
+#define SIGNAL_MIX_MAX_SOURCES 16
+
+typedef struct signal_mix_s signal_mix_t;
+
+/**
+ * signal_mix_t* signal_mix_create(int nb_channels, uint64_t seed)
+ * @brief creates an empty mix over nb_channels channels.
+ * @return the mix, NULL if out of memory or if nb_channels < 1
+ */ 
+signal_mix_t* signal_mix_create(int nb_channels, uint64_t seed);
+
+/**
+ * void signal_mix_destroy(signal_mix_t* mix)
+ * @brief releases the memory held by a mix and its sources. NULL is accepted.
+ */ 
+void signal_mix_destroy(signal_mix_t* mix);
+
+/**
+ * int signal_mix_add(signal_mix_t* mix, int type, double gain, double param_1, double param_2)
+ * @brief adds a source to the mix, see SIGNAL_SOURCE_xxx for its parameters.
+ *        The source starts with the next samples generated.
+ * @return 1 if success, 0 otherwise (out of memory, unknown type, invalid parameter
+ *         or SIGNAL_MIX_MAX_SOURCES sources already)
+ */ 
+int signal_mix_add(signal_mix_t* mix, int type, double gain, double param_1, double param_2);
+
+/**
+ * int signal_mix_nb_channels(const signal_mix_t* mix)
+ * @brief returns the number of channels of the mix.
+ */ 
+int signal_mix_nb_channels(const signal_mix_t* mix);
+
+/**
+ * void signal_mix_next(signal_mix_t* mix, double* signal, int n)
+ * @brief generates the next n samples of every channel.
+ * @param signal (out), nb_channels x n samples, channel after channel (signal[c*n+t])
+ */ 
+void signal_mix_next(signal_mix_t* mix, double* signal, int n);
+
+/**
+ * void signal_mix_next_channels(signal_mix_t* mix, double* signal, int n, int first, int count)
+ * @brief same as signal_mix_next over the channels [first, first+count) only, which
+ *        therefore move ahead of the others. Different channels can be generated by
+ *        different threads at the same time.
+ * @param signal (out), written at signal[c*n+t] for the channels of the range
+ */ 
+void signal_mix_next_channels(signal_mix_t* mix, double* signal, int n, int first, int count);
+
 
 
 #endif
@@ -0,0 +1,79 @@
+/**
+ * @file signal_rng.h
+ * @brief Random number generator with an explicit state, for the signal generators.
+ *        xoshiro256** by D. Blackman and S. Vigna (http://prng.di.unimi.it/), seeded
+ *        with splitmix64. Each state is an independent stream: give one to each thread
+ *        (signal_rng_jump spaces out streams of the same seed) and the results do not
+ *        depend on how the threads are scheduled.
+ */
+
+#ifndef SIGNAL_RNG_H
+#define SIGNAL_RNG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * State of a generator. The struct is public so that a state can live on the stack
+ * or inside another object, but its fields must only be touched by the functions below.
+ */
+typedef struct signal_rng_s{
+	uint64_t s[4];
+	double spare;      /*second normal value of the last Box-Muller pair*/
+	int has_spare;
+} signal_rng_t;
+
+/**
+ * void signal_rng_seed(signal_rng_t* rng, uint64_t seed)
+ *
+ * @brief initializes a state from a seed, any value (0 included) is accepted.
+ */
+void signal_rng_seed(signal_rng_t* rng, uint64_t seed);
+
+/**
+ * void signal_rng_jump(signal_rng_t* rng)
+ *
+ * @brief advances the state by 2^128 draws, to get non-overlapping streams from one seed:
+ *        seed once, copy the state for the first thread, jump, copy for the second...
+ */
+void signal_rng_jump(signal_rng_t* rng);
+
+/**
+ * uint64_t signal_rng_next(signal_rng_t* rng)
+ *
+ * @brief returns 64 random bits.
+ */
+uint64_t signal_rng_next(signal_rng_t* rng);
+
+/**
+ * double signal_rng_uniform(signal_rng_t* rng)
+ *
+ * @brief returns a uniform number in [0, 1), with 53 random bits.
+ */
+double signal_rng_uniform(signal_rng_t* rng);
+
+/**
+ * double signal_rng_normal(signal_rng_t* rng)
+ *
+ * @brief returns a normally distributed number (mean 0, variance 1), Box-Muller over
+ *        two independent uniforms. The values come in pairs, the second one is kept
+ *        for the next call.
+ */
+double signal_rng_normal(signal_rng_t* rng);
+
+/**
+ * void signal_rng_uniform_batch(signal_rng_t* rng, double* out, size_t n, double low, double high)
+ *
+ * @brief fills out with n uniform numbers in [low, high).
+ */
+void signal_rng_uniform_batch(signal_rng_t* rng, double* out, size_t n, double low, double high);
+
+/**
+ * void signal_rng_normal_batch(signal_rng_t* rng, double* out, size_t n)
+ *
+ * @brief fills out with n normally distributed numbers, the same sequence as n calls
+ *        to signal_rng_normal.
+ */
+void signal_rng_normal_batch(signal_rng_t* rng, double* out, size_t n);
+
+#endif
@@ -0,0 +1,217 @@
+/**
+ * @file thread_pool.h
+ * @brief Persistent worker pool, and multithreaded versions of the batched fft wrappers.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "fft.h"
+#include "signal_generator.h"
+
+/*
+ * Worker pool.
+ * The threads are created once and sleep between jobs. A job is a number of tasks,
+ * which the workers (the calling thread included) claim one after the other.
+ */
+typedef struct thread_pool_s thread_pool_t;
+
+/*
+ * Task function: runs task 'task' of the job, on worker 'worker' (0..nb_threads-1,
+ * the calling thread is worker 0). The worker index lets a task use per-thread memory.
+ */
+typedef void (*thread_pool_task_fn)(void *context, size_t task, int worker);
+
+/**
+ * thread_pool_t* thread_pool_create(int nb_threads)
+ *
+ * @brief creates a pool of nb_threads workers, the calling thread being one of them.
+ * @param nb_threads, number of workers, <= 0 for one per online CPU
+ * @return the pool, NULL if the threads could not be created
+ */
+thread_pool_t* thread_pool_create(int nb_threads);
+
+/**
+ * void thread_pool_destroy(thread_pool_t* pool)
+ *
+ * @brief stops and joins the workers. NULL is accepted.
+ */
+void thread_pool_destroy(thread_pool_t* pool);
+
+/**
+ * int thread_pool_size(const thread_pool_t* pool)
+ *
+ * @brief returns the number of workers, the calling thread included.
+ */
+int thread_pool_size(const thread_pool_t* pool);
+
+/**
+ * void thread_pool_run(thread_pool_t* pool, thread_pool_task_fn fn, void* context, size_t nb_tasks)
+ *
+ * @brief runs fn(context, task, worker) for task = 0..nb_tasks-1 over the workers,
+ *        and returns once all of them are done. Jobs submitted from several threads
+ *        are run one after the other.
+ */
+void thread_pool_run(thread_pool_t* pool, thread_pool_task_fn fn, void* context, size_t nb_tasks);
+
+/*
+ * Multithreaded fft.
+ * A fft pool owns a worker pool and, for each worker, a forward plan of length n with
+ * its workspace, so the workers never write to shared memory. Batches are split across
+ * the workers by groups of channels; batches too small to be worth the dispatch run
+ * inline on the calling thread.
+ */
+typedef struct fft_pool_s fft_pool_t;
+
+/*default minimum number of channels given to one worker*/
+#define FFT_POOL_MIN_CHANNELS 4
+
+/**
+ * fft_pool_t* fft_pool_create(size_t n, int nb_threads)
+ *
+ * @brief creates a fft pool for signals of length n.
+ * @param n, the length of the signals
+ * @param nb_threads, number of workers, <= 0 for one per online CPU
+ * @return the pool, NULL if out of memory or if the threads could not be created
+ */
+fft_pool_t* fft_pool_create(size_t n, int nb_threads);
+
+/**
+ * void fft_pool_destroy(fft_pool_t* pool)
+ *
+ * @brief releases the pool and the plans of its workers. NULL is accepted.
+ */
+void fft_pool_destroy(fft_pool_t* pool);
+
+/**
+ * void fft_pool_set_min_channels(fft_pool_t* pool, size_t min_channels)
+ *
+ * @brief sets the minimum number of channels given to one worker (FFT_POOL_MIN_CHANNELS by default).
+ *        A batch smaller than twice this runs inline on the calling thread.
+ */
+void fft_pool_set_min_channels(fft_pool_t* pool, size_t min_channels);
+
+/**
+ * int fft_pool_abs_fft_batch(fft_pool_t* pool, const double* data, size_t nb_channels, int layout,
+ *                            double* abs_onesided_fft)
+ *
+ * @brief same as abs_fft_batch_ws, with the channels split across the workers.
+ * @return 1 if success, 0 otherwise
+ */
+int fft_pool_abs_fft_batch(fft_pool_t* pool,
+                           const double* data, size_t nb_channels, int layout,
+                           double* abs_onesided_fft);
+
+/**
+ * int fft_pool_fft_2signals_batch(fft_pool_t* pool, const double* signals_1, const double* signals_2, size_t nb_pairs,
+ *                                 double* X1_real, double* X1_imag, double* X2_real, double* X2_imag)
+ *
+ * @brief runs fft_2signals over nb_pairs pairs of signals, split across the workers.
+ *        Every array holds nb_pairs n-long vectors, one after the other.
+ * @return 1 if success, 0 otherwise
+ */
+int fft_pool_fft_2signals_batch(fft_pool_t* pool,
+                                const double* signals_1, const double* signals_2,
+                                size_t nb_pairs,
+                                double* X1_real, double* X1_imag,
+                                double* X2_real, double* X2_imag);
+
+/*
+ * Asynchronous spectra.
+ * Batches of spectra (spectrum_batch_ws) are queued from one producer thread, typically an
+ * acquisition thread, and run by dedicated workers sharing one plan of length n, each with
+ * its own workspace. The workers are not the ones of a thread_pool_t: thread_pool_run is
+ * fork-join, it makes its caller worker 0 until the whole job is done and runs the jobs of
+ * several callers one after the other, whereas a submission returns at once and the jobs
+ * run while the producer goes on.
+ * Submission never blocks nor allocates: the jobs live in a ring of preallocated slots,
+ * and a submission fails at once when every slot holds a job that is not complete. The
+ * input and output arrays are used in place, they must stay valid until the job completes.
+ * Completion is reported by a callback, run on the worker, and/or by polling the job id.
+ * fft_async_submit must always be called from the same thread (or under a lock); polling
+ * and waiting are allowed from any thread.
+ */
+typedef struct fft_async_s fft_async_t;
+
+/*default number of job slots*/
+#define FFT_ASYNC_DEFAULT_SLOTS 64
+
+/*state of a job*/
+#define FFT_ASYNC_UNKNOWN -1  /*never submitted*/
+#define FFT_ASYNC_PENDING 0   /*queued or running*/
+#define FFT_ASYNC_DONE 1      /*the output is ready*/
+#define FFT_ASYNC_FAILED 2    /*spectrum_batch_ws failed (unknown layout or mode)*/
+#define FFT_ASYNC_RETIRED 3   /*complete, and its slot is running a newer job: the status is lost*/
+
+/*
+ * Completion callback, called on the worker that ran the job once its output is written,
+ * status being FFT_ASYNC_DONE or FFT_ASYNC_FAILED. It must not call fft_async_submit unless
+ * it is the only producer.
+ */
+typedef void (*fft_async_fn)(void *context, uint64_t job, int status);
+
+/**
+ * fft_async_t* fft_async_create(size_t n, int nb_threads, size_t nb_slots)
+ *
+ * @brief creates an asynchronous queue of batched spectra of length n.
+ * @param nb_threads, number of workers, <= 0 for one per online CPU
+ * @param nb_slots, maximum number of jobs not complete at once, rounded up to a power of 2.
+ *        0 for FFT_ASYNC_DEFAULT_SLOTS
+ * @return the queue, NULL if out of memory or if the threads could not be created
+ */
+fft_async_t* fft_async_create(size_t n, int nb_threads, size_t nb_slots);
+
+/**
+ * void fft_async_destroy(fft_async_t* async)
+ *
+ * @brief runs the jobs still queued, then stops the workers and releases the queue. NULL is accepted.
+ */
+void fft_async_destroy(fft_async_t* async);
+
+/**
+ * uint64_t fft_async_submit(fft_async_t* async, const double* data, size_t nb_channels, int layout,
+ *                           int mode, double* out, fft_async_fn fn, void* context)
+ *
+ * @brief queues spectrum_batch_ws over a frame of nb_channels channels of n samples.
+ *        Wait-free and allocation-free, safe from a real-time thread.
+ * @param data (in), the frame, in the FFT_LAYOUT_xxx layout, read by the worker
+ * @param out (out), nb_channels x fft_output_length(n, mode) values, written by the worker
+ * @param fn, called once the job is complete, NULL to poll only
+ * @param context, passed to fn
+ * @return the id of the job (ids are consecutive from 1), 0 if no slot is free
+ */
+uint64_t fft_async_submit(fft_async_t* async, const double* data, size_t nb_channels, int layout,
+                          int mode, double* out, fft_async_fn fn, void* context);
+
+/**
+ * int fft_async_poll(const fft_async_t* async, uint64_t job)
+ *
+ * @brief returns the state of a job, without waiting. The status of a job is kept until
+ *        nb_slots newer jobs are submitted.
+ * @return one of FFT_ASYNC_xxx
+ */
+int fft_async_poll(const fft_async_t* async, uint64_t job);
+
+/**
+ * int fft_async_wait(fft_async_t* async, uint64_t job)
+ *
+ * @brief waits for a job to complete. Blocks: not for the real-time threads.
+ * @return one of FFT_ASYNC_xxx, never FFT_ASYNC_PENDING
+ */
+int fft_async_wait(fft_async_t* async, uint64_t job);
+
+/*
+ * Multithreaded signal generation.
+ */
+
+/**
+ * void signal_mix_next_parallel(thread_pool_t* pool, signal_mix_t* mix, double* signal, int n)
+ *
+ * @brief same as signal_mix_next, with the channels split across the workers of the pool.
+ *        Each channel has its own random streams, so the samples are the same as with signal_mix_next.
+ */
+void signal_mix_next_parallel(thread_pool_t* pool, signal_mix_t* mix, double* signal, int n);
+
+#endif
@@ -0,0 +1,286 @@
+/**
+ * @file band_power.c
+ * @brief Power of frequency bands over a sliding window, for several channels at once.
+ *
+ *        Each channel runs a sliding DFT (see dft_interval.c) over the union of the
+ *        bins of the bands only: a bin shared by two bands is tracked once. Since the
+ *        bins are sorted, the bins of a band stay contiguous in that union, and the band
+ *        power is a sum over a range of it. All the channels advance together, so the
+ *        position in the window and the exact recomputation every n samples are shared,
+ *        and a push is cut at the recomputations to run channel after channel.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fft.h"
+#include "fft_internal.h"
+
+/**
+ * struct band_power_s
+ * @brief state of a multichannel band power tracker
+ */
+struct band_power_s{
+
+	int n;
+	int nb_channels;
+	int nb_bands;
+	int nb_bins;
+
+	/*sorted union of the bins of the bands, and the first of each band in it*/
+	int *bins;
+	int *band_first;
+	int *band_length;
+
+	/*rotation applied to each bin on every new sample, exp(j*2*pi*k/n)*/
+	double *rot_real;
+	double *rot_imag;
+
+	/*cos/sin(2*pi*i/n), used to recompute the bins exactly*/
+	double *cos_table;
+	double *sin_table;
+
+	/*bins of channel c at X_real + c*nb_bins*/
+	double *X_real;
+	double *X_imag;
+
+	/*last n samples of channel c at history + c*n, the oldest one at 'head'*/
+	double *history;
+	int head;
+
+	/*number of samples pushed since the last exact recomputation*/
+	int since_resync;
+};
+
+static void band_power_resync(band_power_t *tracker);
+
+/**
+ * band_power_t* band_power_create(int n, int nb_channels, int nb_bands, const int* band_start, const int* band_stop)
+ *
+ * @brief creates a tracker of the bands [band_start[b], band_stop[b]) of nb_channels channels,
+ *        over a window of n samples initially filled with zeros.
+ * @return the tracker, NULL if out of memory or if a band is empty or outside [0, n)
+ */
+band_power_t* band_power_create(int n, int nb_channels, int nb_bands, const int* band_start, const int* band_stop){
+
+	band_power_t *tracker;
+	char *used = NULL;
+	int b, k, i;
+
+	if(n <= 0 || nb_channels <= 0 || nb_bands <= 0)
+		return NULL;
+	for(b=0;b<nb_bands;b++){
+		if(band_start[b] < 0 || band_stop[b] > n || band_stop[b] <= band_start[b])
+			return NULL;
+	}
+
+	tracker = (band_power_t*)calloc(1, sizeof(band_power_t));
+	used = (char*)calloc(n, sizeof(char));
+	if(tracker == NULL || used == NULL)
+		goto error;
+
+	tracker->n = n;
+	tracker->nb_channels = nb_channels;
+	tracker->nb_bands = nb_bands;
+
+	/*union of the bands, in increasing order*/
+	for(b=0;b<nb_bands;b++){
+		for(k=band_start[b];k<band_stop[b];k++)
+			used[k] = 1;
+	}
+	for(k=0;k<n;k++)
+		tracker->nb_bins += used[k];
+
+	tracker->bins = (int*)malloc(tracker->nb_bins*sizeof(int));
+	tracker->band_first = (int*)malloc(nb_bands*sizeof(int));
+	tracker->band_length = (int*)malloc(nb_bands*sizeof(int));
+	tracker->rot_real = (double*)malloc(tracker->nb_bins*sizeof(double));
+	tracker->rot_imag = (double*)malloc(tracker->nb_bins*sizeof(double));
+	tracker->cos_table = (double*)malloc(n*sizeof(double));
+	tracker->sin_table = (double*)malloc(n*sizeof(double));
+	tracker->X_real = (double*)malloc((size_t)nb_channels*tracker->nb_bins*sizeof(double));
+	tracker->X_imag = (double*)malloc((size_t)nb_channels*tracker->nb_bins*sizeof(double));
+	tracker->history = (double*)malloc((size_t)nb_channels*n*sizeof(double));
+	if(tracker->bins == NULL || tracker->band_first == NULL || tracker->band_length == NULL
+			|| tracker->rot_real == NULL || tracker->rot_imag == NULL
+			|| tracker->cos_table == NULL || tracker->sin_table == NULL
+			|| tracker->X_real == NULL || tracker->X_imag == NULL
+			|| tracker->history == NULL)
+		goto error;
+
+	for(k=0,i=0;k<n;k++){
+		if(used[k])
+			tracker->bins[i++] = k;
+	}
+
+	/*the bins of a band are all in the union, so they follow each other in it*/
+	for(b=0;b<nb_bands;b++){
+		for(i=0;tracker->bins[i]!=band_start[b];i++);
+		tracker->band_first[b] = i;
+		tracker->band_length[b] = band_stop[b] - band_start[b];
+	}
+
+	for(i=0;i<n;i++){
+		tracker->cos_table[i] = cos(2*M_PI*i/n);
+		tracker->sin_table[i] = sin(2*M_PI*i/n);
+	}
+
+	for(i=0;i<tracker->nb_bins;i++){
+		tracker->rot_real[i] = cos(2*M_PI*tracker->bins[i]/n);
+		tracker->rot_imag[i] = sin(2*M_PI*tracker->bins[i]/n);
+	}
+
+	free(used);
+	band_power_reset(tracker);
+
+	return tracker;
+
+error:
+	free(used);
+	band_power_destroy(tracker);
+	return NULL;
+}
+
+/**
+ * void band_power_destroy(band_power_t* tracker)
+ *
+ * @brief releases the memory held by a tracker. NULL is accepted.
+ */
+void band_power_destroy(band_power_t* tracker){
+
+	if(tracker == NULL)
+		return;
+
+	free(tracker->bins);
+	free(tracker->band_first);
+	free(tracker->band_length);
+	free(tracker->rot_real);
+	free(tracker->rot_imag);
+	free(tracker->cos_table);
+	free(tracker->sin_table);
+	free(tracker->X_real);
+	free(tracker->X_imag);
+	free(tracker->history);
+	free(tracker);
+}
+
+/**
+ * void band_power_reset(band_power_t* tracker)
+ *
+ * @brief fills the windows of all the channels with zeros.
+ */
+void band_power_reset(band_power_t* tracker){
+
+	memset(tracker->history, 0, (size_t)tracker->nb_channels*tracker->n*sizeof(double));
+	memset(tracker->X_real, 0, (size_t)tracker->nb_channels*tracker->nb_bins*sizeof(double));
+	memset(tracker->X_imag, 0, (size_t)tracker->nb_channels*tracker->nb_bins*sizeof(double));
+	tracker->head = 0;
+	tracker->since_resync = 0;
+}
+
+/**
+ * int band_power_nb_bins(const band_power_t* tracker)
+ *
+ * @brief returns the number of bins tracked per channel, the size of the union of the bands.
+ */
+int band_power_nb_bins(const band_power_t* tracker){
+	return tracker->nb_bins;
+}
+
+/**
+ * int band_power_push(band_power_t* tracker, const double* data, int count, int layout)
+ *
+ * @brief advances the windows of all the channels by count samples.
+ * @return 1 if success, 0 otherwise (unknown layout)
+ */
+int band_power_push(band_power_t* tracker, const double* data, int count, int layout){
+
+	int done = 0;
+	int c, head = tracker->head;
+
+	if(layout != FFT_LAYOUT_CHANNEL_MAJOR && layout != FFT_LAYOUT_INTERLEAVED)
+		return 0;
+
+	/*runs up to the next exact recomputation, each channel in turn*/
+	while(done < count){
+
+		int run = tracker->n - tracker->since_resync;
+		if(run > count - done)
+			run = count - done;
+
+		/*every channel starts at the shared head and ends at the same one*/
+		for(c=0;c<tracker->nb_channels;c++){
+
+			const double *samples = (layout == FFT_LAYOUT_CHANNEL_MAJOR)
+			                        ? data + (size_t)c*count + done
+			                        : data + (size_t)done*tracker->nb_channels + c;
+			size_t stride = (layout == FFT_LAYOUT_CHANNEL_MAJOR) ? 1 : (size_t)tracker->nb_channels;
+
+			head = sliding_dft_rotate(tracker->history + (size_t)c*tracker->n, tracker->n, tracker->head,
+			                          samples, stride, run,
+			                          tracker->X_real + (size_t)c*tracker->nb_bins,
+			                          tracker->X_imag + (size_t)c*tracker->nb_bins,
+			                          tracker->rot_real, tracker->rot_imag, tracker->nb_bins);
+		}
+
+		tracker->head = head;
+		tracker->since_resync += run;
+		done += run;
+
+		if(tracker->since_resync == tracker->n)
+			band_power_resync(tracker);
+	}
+
+	return 1;
+}
+
+/**
+ * void band_power_get(const band_power_t* tracker, double* power)
+ *
+ * @brief returns the power of every band of every channel over the current window, the
+ *        sum over the bins of the band of (2*|X(k)|/n)^2 as in FFT_OUTPUT_POWER.
+ * @param power (out), nb_channels x nb_bands values, band b of channel c at power[c*nb_bands+b]
+ */
+void band_power_get(const band_power_t* tracker, double* power){
+
+	double scale = 4.0/((double)tracker->n*tracker->n);
+	int c, b, i;
+
+	for(c=0;c<tracker->nb_channels;c++){
+
+		const double *re = tracker->X_real + (size_t)c*tracker->nb_bins;
+		const double *im = tracker->X_imag + (size_t)c*tracker->nb_bins;
+
+		for(b=0;b<tracker->nb_bands;b++){
+			int first = tracker->band_first[b];
+			int stop = first + tracker->band_length[b];
+			double sum = 0;
+			for(i=first;i<stop;i++)
+				sum += re[i]*re[i] + im[i]*im[i];
+			power[(size_t)c*tracker->nb_bands + b] = scale*sum;
+		}
+	}
+}
+
+/*
+ * Recomputes the bins of every channel exactly from its history, oldest sample
+ * at t = 0, as sliding_dft_resync does.
+ */
+static void band_power_resync(band_power_t *tracker){
+
+	int n = tracker->n;
+	int c, k;
+
+	for(c=0;c<tracker->nb_channels;c++){
+
+		const double *history = tracker->history + (size_t)c*n;
+		double *X_real = tracker->X_real + (size_t)c*tracker->nb_bins;
+		double *X_imag = tracker->X_imag + (size_t)c*tracker->nb_bins;
+
+		for(k=0;k<tracker->nb_bins;k++)
+			sliding_dft_exact_bin(history, n, tracker->head, tracker->bins[k],
+			                      tracker->cos_table, tracker->sin_table, X_real + k, X_imag + k);
+	}
+
+	tracker->since_resync = 0;
+}
@@ -0,0 +1,387 @@
+/**
+ * @file dft_interval.c
+ * @brief Fourier coefficients over an interval of bins [interval_start, interval_stop),
+ *        as returned by abs_dft_interval (2*|X(k)|/n).
+ *
+ *        The block engine uses the Goertzel recurrence, one multiply-add per sample
+ *        and per bin with a precomputed coefficient 2*cos(2*pi*k/n), instead of a
+ *        cos() and a sin() per sample and per bin.
+ *
+ *        The streaming engine is a sliding DFT: the window advances one sample at a
+ *        time and each bin is updated in O(1), X(k) <- (X(k) - x_old + x_new)*exp(j*2*pi*k/n).
+ *        To stop round-off from accumulating, the bins are recomputed exactly from the
+ *        history once every n samples, which keeps the amortized cost in O(k) per sample.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fft.h"
+#include "fft_internal.h"
+
+/**
+ * struct dft_interval_plan_s
+ * @brief Goertzel coefficients of the bins of an interval
+ */
+struct dft_interval_plan_s{
+
+	int n;
+	int nb_bins;
+	double *coef;        /*2*cos(2*pi*k/n) for each bin*/
+};
+
+/**
+ * struct sliding_dft_s
+ * @brief state of a sliding DFT over the bins of an interval
+ */
+struct sliding_dft_s{
+
+	int n;
+	int interval_start;
+	int nb_bins;
+
+	/*rotation applied to each bin on every new sample, exp(j*2*pi*k/n)*/
+	double *rot_real;
+	double *rot_imag;
+
+	/*current value of each bin*/
+	double *X_real;
+	double *X_imag;
+
+	/*cos/sin(2*pi*i/n), used to recompute the bins exactly*/
+	double *cos_table;
+	double *sin_table;
+
+	/*history of the last n samples, oldest sample at 'head'*/
+	double *history;
+	int head;
+
+	/*number of samples pushed since the last exact recomputation*/
+	int since_resync;
+};
+
+static double goertzel_abs(const double *signal, int n, double coef);
+static void sliding_dft_resync(sliding_dft_t *sdft);
+
+/**
+ * void abs_dft_interval(const double *signal, double *abs_power_interval, int n, int interval_start, int interval_stop)
+ * @brief This is used in preprocess_core.c in preprocess-daemon
+ *        abs value of the fourier coefficients k in [interval_start, interval_stop) of an n-long signal,
+ *        2*|X(k)|/n, computed with the Goertzel recurrence
+ */
+void abs_dft_interval(const double *signal, double *abs_power_interval, int n, int interval_start, int interval_stop){
+	FFT_STATS_ENTRY(FFT_STATS_ABS_DFT_INTERVAL);
+
+	int k;
+	int coef_idx = 0;
+
+	/*loop through all coefficients*/
+	for (k = interval_start; k < interval_stop; k++) {
+		abs_power_interval[coef_idx] = goertzel_abs(signal, n, 2*cos(2*M_PI*k/n));
+		coef_idx++;
+	}
+}
+
+/**
+ * dft_interval_plan_t* dft_interval_plan_create(int n, int interval_start, int interval_stop)
+ *
+ * @brief precomputes the Goertzel coefficients of the bins [interval_start, interval_stop) for an n-long signal
+ * @return the plan, NULL if out of memory or if the interval is empty
+ */
+dft_interval_plan_t* dft_interval_plan_create(int n, int interval_start, int interval_stop){
+
+	dft_interval_plan_t *plan;
+	int k;
+
+	if(n <= 0 || interval_stop <= interval_start)
+		return NULL;
+
+	plan = (dft_interval_plan_t*)malloc(sizeof(dft_interval_plan_t));
+	if(plan == NULL)
+		return NULL;
+
+	plan->n = n;
+	plan->nb_bins = interval_stop - interval_start;
+	plan->coef = (double*)malloc(plan->nb_bins*sizeof(double));
+	if(plan->coef == NULL){
+		free(plan);
+		return NULL;
+	}
+
+	for(k=0;k<plan->nb_bins;k++){
+		plan->coef[k] = 2*cos(2*M_PI*(interval_start+k)/n);
+	}
+
+	return plan;
+}
+
+/**
+ * void dft_interval_plan_destroy(dft_interval_plan_t* plan)
+ *
+ * @brief releases the memory held by a plan. NULL is accepted.
+ */
+void dft_interval_plan_destroy(dft_interval_plan_t* plan){
+
+	if(plan == NULL)
+		return;
+
+	free(plan->coef);
+	free(plan);
+}
+
+/**
+ * void abs_dft_interval_plan(const dft_interval_plan_t* plan, const double *signal, double *abs_power_interval)
+ *
+ * @brief same as abs_dft_interval, with the coefficients taken from the plan.
+ * @param signal (in), the n-long signal
+ * @param abs_power_interval (out), one value per bin of the interval
+ */
+void abs_dft_interval_plan(const dft_interval_plan_t* plan, const double *signal, double *abs_power_interval){
+
+	int k;
+
+	for(k=0;k<plan->nb_bins;k++){
+		abs_power_interval[k] = goertzel_abs(signal, plan->n, plan->coef[k]);
+	}
+}
+
+/*
+ * Goertzel recurrence s(t) = x(t) + coef*s(t-1) - s(t-2), then
+ * |X|^2 = s(n-1)^2 + s(n-2)^2 - coef*s(n-1)*s(n-2)
+ */
+static double goertzel_abs(const double *signal, int n, double coef){
+
+	double s1 = 0.0, s2 = 0.0;
+	double power;
+	int t;
+
+	for(t=0;t<n;t++){
+		double s0 = signal[t] + coef*s1 - s2;
+		s2 = s1;
+		s1 = s0;
+	}
+
+	power = s1*s1 + s2*s2 - coef*s1*s2;
+
+	/*round-off can make it slightly negative for a null bin*/
+	if(power < 0)
+		power = 0;
+
+	/*compute 2*real value, to get abs fft*/
+	return 2*sqrt(power)/n;
+}
+
+/**
+ * sliding_dft_t* sliding_dft_create(int n, int interval_start, int interval_stop)
+ *
+ * @brief creates a sliding DFT over a window of n samples, tracking the bins [interval_start, interval_stop).
+ *        The window is initially filled with zeros.
+ * @return the sliding DFT, NULL if out of memory or if the interval is empty
+ */
+sliding_dft_t* sliding_dft_create(int n, int interval_start, int interval_stop){
+
+	sliding_dft_t *sdft;
+	int k, i;
+
+	if(n <= 0 || interval_stop <= interval_start)
+		return NULL;
+
+	sdft = (sliding_dft_t*)calloc(1, sizeof(sliding_dft_t));
+	if(sdft == NULL)
+		return NULL;
+
+	sdft->n = n;
+	sdft->interval_start = interval_start;
+	sdft->nb_bins = interval_stop - interval_start;
+
+	sdft->rot_real = (double*)malloc(sdft->nb_bins*sizeof(double));
+	sdft->rot_imag = (double*)malloc(sdft->nb_bins*sizeof(double));
+	sdft->X_real = (double*)malloc(sdft->nb_bins*sizeof(double));
+	sdft->X_imag = (double*)malloc(sdft->nb_bins*sizeof(double));
+	sdft->cos_table = (double*)malloc(n*sizeof(double));
+	sdft->sin_table = (double*)malloc(n*sizeof(double));
+	sdft->history = (double*)malloc(n*sizeof(double));
+	if(sdft->rot_real == NULL || sdft->rot_imag == NULL
+			|| sdft->X_real == NULL || sdft->X_imag == NULL
+			|| sdft->cos_table == NULL || sdft->sin_table == NULL
+			|| sdft->history == NULL){
+		sliding_dft_destroy(sdft);
+		return NULL;
+	}
+
+	for(i=0;i<n;i++){
+		sdft->cos_table[i] = cos(2*M_PI*i/n);
+		sdft->sin_table[i] = sin(2*M_PI*i/n);
+	}
+
+	for(k=0;k<sdft->nb_bins;k++){
+		sdft->rot_real[k] = cos(2*M_PI*(interval_start+k)/n);
+		sdft->rot_imag[k] = sin(2*M_PI*(interval_start+k)/n);
+	}
+
+	sliding_dft_reset(sdft);
+
+	return sdft;
+}
+
+/**
+ * void sliding_dft_destroy(sliding_dft_t* sdft)
+ *
+ * @brief releases the memory held by a sliding DFT. NULL is accepted.
+ */
+void sliding_dft_destroy(sliding_dft_t* sdft){
+
+	if(sdft == NULL)
+		return;
+
+	free(sdft->rot_real);
+	free(sdft->rot_imag);
+	free(sdft->X_real);
+	free(sdft->X_imag);
+	free(sdft->cos_table);
+	free(sdft->sin_table);
+	free(sdft->history);
+	free(sdft);
+}
+
+/**
+ * void sliding_dft_reset(sliding_dft_t* sdft)
+ *
+ * @brief fills the window with zeros.
+ */
+void sliding_dft_reset(sliding_dft_t* sdft){
+
+	memset(sdft->history, 0, sdft->n*sizeof(double));
+	memset(sdft->X_real, 0, sdft->nb_bins*sizeof(double));
+	memset(sdft->X_imag, 0, sdft->nb_bins*sizeof(double));
+	sdft->head = 0;
+	sdft->since_resync = 0;
+}
+
+/**
+ * void sliding_dft_push(sliding_dft_t* sdft, const double *samples, int count)
+ *
+ * @brief advances the window by count samples, in O(nb of bins) per sample.
+ * @param samples (in), the new samples, oldest first
+ * @param count (in), number of new samples, any value is accepted
+ */
+void sliding_dft_push(sliding_dft_t* sdft, const double *samples, int count){
+
+	int done = 0;
+
+	/*runs up to the next exact recomputation*/
+	while(done < count){
+
+		int run = sdft->n - sdft->since_resync;
+		if(run > count - done)
+			run = count - done;
+
+		sdft->head = sliding_dft_rotate(sdft->history, sdft->n, sdft->head, samples + done, 1, run,
+		                                sdft->X_real, sdft->X_imag, sdft->rot_real, sdft->rot_imag,
+		                                sdft->nb_bins);
+		sdft->since_resync += run;
+		done += run;
+
+		if(sdft->since_resync == sdft->n)
+			sliding_dft_resync(sdft);
+	}
+}
+
+/**
+ * void sliding_dft_abs(const sliding_dft_t* sdft, double *abs_power_interval)
+ *
+ * @brief returns the abs value of the bins over the current window, as abs_dft_interval would.
+ * @param abs_power_interval (out), one value per bin of the interval
+ */
+void sliding_dft_abs(const sliding_dft_t* sdft, double *abs_power_interval){
+
+	int k;
+
+	for(k=0;k<sdft->nb_bins;k++){
+		abs_power_interval[k] = 2*sqrt(sdft->X_real[k]*sdft->X_real[k] + sdft->X_imag[k]*sdft->X_imag[k])/sdft->n;
+	}
+}
+
+/*
+ * Recomputes the bins exactly from the history, oldest sample at t = 0.
+ */
+static void sliding_dft_resync(sliding_dft_t *sdft){
+
+	int n = sdft->n;
+	int k;
+
+	for(k=0;k<sdft->nb_bins;k++){
+
+		int step = (sdft->interval_start+k) % n;
+		if(step < 0)
+			step += n;
+
+		sliding_dft_exact_bin(sdft->history, n, sdft->head, step, sdft->cos_table, sdft->sin_table,
+		                      sdft->X_real + k, sdft->X_imag + k);
+	}
+
+	sdft->since_resync = 0;
+}
+
+/*
+ * Pushes count samples, read every stride values, into the window, the newest sample
+ * replacing the oldest one: X(k) <- (X(k) - x_old + x_new)*exp(j*2*pi*k/n).
+ */
+int sliding_dft_rotate(double *history, int n, int head,
+                       const double *samples, size_t stride, int count,
+                       double *X_real, double *X_imag,
+                       const double *rot_real, const double *rot_imag, int nb_bins){
+
+	int i, k;
+
+	for(i=0;i<count;i++){
+
+		double x = samples[(size_t)i*stride];
+		double delta = x - history[head];
+
+		/*the newest sample replaces the oldest one*/
+		history[head] = x;
+		head++;
+		if(head == n)
+			head = 0;
+
+		for(k=0;k<nb_bins;k++){
+			double re = X_real[k] + delta;
+			double im = X_imag[k];
+			X_real[k] = re*rot_real[k] - im*rot_imag[k];
+			X_imag[k] = re*rot_imag[k] + im*rot_real[k];
+		}
+	}
+
+	return head;
+}
+
+/*
+ * Exact DFT of one bin over the window, oldest sample at t = 0.
+ * The table index t*step mod n is advanced incrementally instead of being recomputed.
+ */
+void sliding_dft_exact_bin(const double *history, int n, int head, int step,
+                           const double *cos_table, const double *sin_table,
+                           double *X_real, double *X_imag){
+
+	double sumreal = 0;
+	double sumimag = 0;
+	int idx = 0;
+	int h = head;
+	int t;
+
+	for(t=0;t<n;t++){
+		sumreal += history[h]*cos_table[idx];
+		sumimag -= history[h]*sin_table[idx];
+
+		h++;
+		if(h == n)
+			h = 0;
+		idx += step;
+		if(idx >= n)
+			idx -= n;
+	}
+
+	*X_real = sumreal;
+	*X_imag = sumimag;
+}
@@ -0,0 +1,427 @@
+/**
+ * @file dwt.c
+ * @brief Discrete wavelet transform by lifting, Haar and Daubechies 2 (4 taps), orthonormal.
+ *
+ *        A level splits the signal in its even and odd samples and runs the lifting
+ *        steps of the wavelet over the pairs: each step updates one half from its
+ *        neighbours of the other half, so a level is a few passes of O(1) work per
+ *        pair, in place, and each step is undone by the same step with the opposite
+ *        sign. Level j works on the approximation left by level j-1, which stays at
+ *        stride 2^j in the buffer: the coefficients are never moved, and the whole
+ *        transform costs O(n). The block transform is periodic, the last pair of a
+ *        level being the left neighbour of the first one.
+ *
+ *        The stream runs the same steps on an unbounded signal, one pair at a time:
+ *        the Daubechies steps need the previous pair (kept per level) and the detail
+ *        of the next one, so each approximation leaves a level one pair late. The
+ *        first one out of a level, that of the pair before the stream, is dropped:
+ *        the next level starts one sample later and pairs the approximations as dwt.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fft.h"
+#include "fft_internal.h"
+
+/*lifting steps of the Daubechies 2 wavelet (Daubechies and Sweldens)*/
+#define DB2_SQRT3 1.7320508075688772935
+#define DB2_PREDICT_0 (DB2_SQRT3/4)           /*weight of s1[i] in d1[i]*/
+#define DB2_PREDICT_1 ((DB2_SQRT3 - 2)/4)     /*weight of s1[i-1] in d1[i]*/
+#define DB2_SCALE_S ((DB2_SQRT3 - 1)/M_SQRT2)
+#define DB2_SCALE_D ((DB2_SQRT3 + 1)/M_SQRT2)
+
+/**
+ * struct dwt_level_s
+ * @brief lifting state of a level of the stream
+ */
+struct dwt_level_s{
+
+	double even;             /*first sample of the pending pair*/
+	int has_even;
+	double s_prev;           /*s1 of the previous pair (Daubechies only)*/
+	int started;             /*a pair was lifted since the reset (Daubechies only)*/
+};
+
+/**
+ * struct dwt_stream_s
+ * @brief state of a streaming wavelet band energy tracker
+ */
+struct dwt_stream_s{
+
+	int wavelet;
+	int levels;
+	size_t hop;
+
+	struct dwt_level_s *state;
+
+	/*energy of the details of level j+1 at detail[j], and of the last approximation*/
+	double *detail;
+	double approx;
+
+	double *energy;          /*levels+1 values handed to the callback*/
+	size_t since_frame;
+	size_t frame;
+};
+
+static int dwt_check(size_t n, int wavelet, int *levels);
+static void haar_forward(double *data, size_t m, size_t stride);
+static void haar_inverse(double *data, size_t m, size_t stride);
+static void db2_forward(double *data, size_t m, size_t stride);
+static void db2_inverse(double *data, size_t m, size_t stride);
+static void dwt_stream_sample(dwt_stream_t *stream, double x);
+
+/**
+ * int dwt_max_levels(size_t n)
+ *
+ * @brief returns the number of levels of the longest decomposition of n samples, log2 of
+ *        the largest power of 2 dividing n.
+ */
+int dwt_max_levels(size_t n){
+
+	int levels = 0;
+
+	if(n == 0)
+		return 0;
+	while(n % 2 == 0){
+		n /= 2;
+		levels++;
+	}
+	return levels;
+}
+
+/**
+ * int dwt(double* data, size_t n, int wavelet, int levels)
+ *
+ * @brief multilevel periodic wavelet transform of data, in place.
+ * @return 1 if success, 0 otherwise (unknown wavelet, or n not a multiple of 2^levels)
+ */
+int dwt(double* data, size_t n, int wavelet, int levels){
+	FFT_STATS_ENTRY(FFT_STATS_DWT);
+
+	size_t stride = 1;
+	int j;
+
+	if(!dwt_check(n, wavelet, &levels))
+		return 0;
+
+	for(j=0;j<levels;j++){
+		size_t m = n/(2*stride);
+		if(wavelet == FFT_WAVELET_HAAR)
+			haar_forward(data, m, stride);
+		else
+			db2_forward(data, m, stride);
+		stride *= 2;
+	}
+	return 1;
+}
+
+/**
+ * int idwt(double* data, size_t n, int wavelet, int levels)
+ *
+ * @brief inverse of dwt, in place.
+ * @return 1 if success, 0 otherwise (unknown wavelet, or n not a multiple of 2^levels)
+ */
+int idwt(double* data, size_t n, int wavelet, int levels){
+	FFT_STATS_ENTRY(FFT_STATS_DWT);
+
+	size_t stride;
+	int j;
+
+	if(!dwt_check(n, wavelet, &levels))
+		return 0;
+
+	stride = (size_t)1 << levels;
+	for(j=levels;j>0;j--){
+		size_t m;
+		stride /= 2;
+		m = n/(2*stride);
+		if(wavelet == FFT_WAVELET_HAAR)
+			haar_inverse(data, m, stride);
+		else
+			db2_inverse(data, m, stride);
+	}
+	return 1;
+}
+
+/**
+ * int dwt_band_energy(const double* coefficients, size_t n, int levels, double* energy)
+ *
+ * @brief returns the energy of each band of a dwt of n samples, ordered by frequency.
+ * @return 1 if success, 0 otherwise (n not a multiple of 2^levels)
+ */
+int dwt_band_energy(const double* coefficients, size_t n, int levels, double* energy){
+
+	double scale;
+	size_t stride, i;
+	int j;
+
+	/*only the length matters here*/
+	if(!dwt_check(n, FFT_WAVELET_HAAR, &levels))
+		return 0;
+	scale = 2.0/n;
+
+	/*details of level j at the odd multiples of 2^(j-1), the highest band last*/
+	for(j=1,stride=1;j<=levels;j++,stride*=2){
+		double sum = 0;
+		for(i=stride;i<n;i+=2*stride)
+			sum += coefficients[i]*coefficients[i];
+		energy[levels+1-j] = scale*sum;
+	}
+
+	energy[0] = 0;
+	for(i=0;i<n;i+=stride)
+		energy[0] += coefficients[i]*coefficients[i];
+	energy[0] *= scale;
+
+	return 1;
+}
+
+/**
+ * dwt_stream_t* dwt_stream_create(int wavelet, int levels, size_t hop)
+ *
+ * @brief creates a streaming tracker of the band energies of a levels deep decomposition,
+ *        reported every hop samples.
+ * @return the tracker, NULL if out of memory or if a parameter is invalid
+ */
+dwt_stream_t* dwt_stream_create(int wavelet, int levels, size_t hop){
+
+	dwt_stream_t *stream;
+
+	if(levels <= 0 || !dwt_check(hop, wavelet, &levels))
+		return NULL;
+
+	stream = (dwt_stream_t*)calloc(1, sizeof(dwt_stream_t));
+	if(stream == NULL)
+		return NULL;
+
+	stream->wavelet = wavelet;
+	stream->levels = levels;
+	stream->hop = hop;
+
+	stream->state = (struct dwt_level_s*)malloc(levels*sizeof(struct dwt_level_s));
+	stream->detail = (double*)malloc(levels*sizeof(double));
+	stream->energy = (double*)malloc((levels+1)*sizeof(double));
+	if(stream->state == NULL || stream->detail == NULL || stream->energy == NULL){
+		dwt_stream_destroy(stream);
+		return NULL;
+	}
+
+	dwt_stream_reset(stream);
+	return stream;
+}
+
+/**
+ * void dwt_stream_destroy(dwt_stream_t* stream)
+ *
+ * @brief releases the memory held by a tracker. NULL is accepted.
+ */
+void dwt_stream_destroy(dwt_stream_t* stream){
+
+	if(stream == NULL)
+		return;
+
+	free(stream->state);
+	free(stream->detail);
+	free(stream->energy);
+	free(stream);
+}
+
+/**
+ * void dwt_stream_reset(dwt_stream_t* stream)
+ *
+ * @brief clears the history of the tracker, as if only zeros had been pushed, and restarts the frame count.
+ */
+void dwt_stream_reset(dwt_stream_t* stream){
+
+	memset(stream->state, 0, stream->levels*sizeof(struct dwt_level_s));
+	memset(stream->detail, 0, stream->levels*sizeof(double));
+	stream->approx = 0;
+	stream->since_frame = 0;
+	stream->frame = 0;
+}
+
+/**
+ * size_t dwt_stream_push(dwt_stream_t* stream, const double* samples, size_t count, dwt_frame_fn fn, void* context)
+ *
+ * @brief pushes count new samples, and reports the frames completed by them.
+ * @return the number of frames completed
+ */
+size_t dwt_stream_push(dwt_stream_t* stream, const double* samples, size_t count,
+                       dwt_frame_fn fn, void* context){
+	FFT_STATS_ENTRY(FFT_STATS_DWT);
+
+	double scale = 2.0/stream->hop;
+	size_t nb_frames = 0;
+	size_t i;
+	int j;
+
+	for(i=0;i<count;i++){
+
+		dwt_stream_sample(stream, samples[i]);
+		if(++stream->since_frame < stream->hop)
+			continue;
+
+		stream->energy[0] = scale*stream->approx;
+		for(j=0;j<stream->levels;j++)
+			stream->energy[stream->levels-j] = scale*stream->detail[j];
+		if(fn != NULL)
+			fn(context, stream->energy, stream->frame);
+
+		memset(stream->detail, 0, stream->levels*sizeof(double));
+		stream->approx = 0;
+		stream->since_frame = 0;
+		stream->frame++;
+		nb_frames++;
+	}
+
+	return nb_frames;
+}
+
+/*
+ * Checks the wavelet and the length, and replaces levels = 0 by the maximum.
+ */
+static int dwt_check(size_t n, int wavelet, int *levels){
+
+	int max_levels = dwt_max_levels(n);
+
+	if(wavelet != FFT_WAVELET_HAAR && wavelet != FFT_WAVELET_DB2)
+		return 0;
+	if(*levels == 0)
+		*levels = max_levels;
+	return *levels > 0 && *levels <= max_levels;
+}
+
+/*
+ * One level over the m pairs (data[2i*stride], data[(2i+1)*stride]).
+ * s = (even + odd)/sqrt(2), d = (odd - even)/sqrt(2).
+ */
+static void haar_forward(double *data, size_t m, size_t stride){
+
+	size_t i;
+
+	for(i=0;i<m;i++){
+		double *even = data + 2*i*stride;
+		double *odd = even + stride;
+		double d = *odd - *even;
+		double s = *even + 0.5*d;
+		*even = M_SQRT2*s;
+		*odd = M_SQRT1_2*d;
+	}
+}
+
+static void haar_inverse(double *data, size_t m, size_t stride){
+
+	size_t i;
+
+	for(i=0;i<m;i++){
+		double *even = data + 2*i*stride;
+		double *odd = even + stride;
+		double d = M_SQRT2*(*odd);
+		double s = M_SQRT1_2*(*even);
+		*even = s - 0.5*d;
+		*odd = *even + d;
+	}
+}
+
+/*
+ * One level over the m pairs, periodic:
+ * s1[i] = even[i] + sqrt(3)*odd[i]
+ * d1[i] = odd[i] - sqrt(3)/4*s1[i] - (sqrt(3)-2)/4*s1[i-1]
+ * s2[i] = s1[i] - d1[i+1]
+ * then s = (sqrt(3)-1)/sqrt(2)*s2, d = (sqrt(3)+1)/sqrt(2)*d1.
+ * Each pass only writes the half that the pass reads the neighbours of
+ * from the other half, so the passes run in place.
+ */
+static void db2_forward(double *data, size_t m, size_t stride){
+
+	size_t step = 2*stride;
+	size_t last = (m-1)*step;
+	size_t i;
+
+	for(i=0;i<m*step;i+=step)
+		data[i] += DB2_SQRT3*data[i+stride];
+
+	data[stride] -= DB2_PREDICT_0*data[0] + DB2_PREDICT_1*data[last];
+	for(i=step;i<m*step;i+=step)
+		data[i+stride] -= DB2_PREDICT_0*data[i] + DB2_PREDICT_1*data[i-step];
+
+	for(i=0;i<last;i+=step)
+		data[i] -= data[i+step+stride];
+	data[last] -= data[stride];
+
+	for(i=0;i<m*step;i+=step){
+		data[i] *= DB2_SCALE_S;
+		data[i+stride] *= DB2_SCALE_D;
+	}
+}
+
+static void db2_inverse(double *data, size_t m, size_t stride){
+
+	size_t step = 2*stride;
+	size_t last = (m-1)*step;
+	size_t i;
+
+	for(i=0;i<m*step;i+=step){
+		data[i] /= DB2_SCALE_S;
+		data[i+stride] /= DB2_SCALE_D;
+	}
+
+	for(i=0;i<last;i+=step)
+		data[i] += data[i+step+stride];
+	data[last] += data[stride];
+
+	data[stride] += DB2_PREDICT_0*data[0] + DB2_PREDICT_1*data[last];
+	for(i=step;i<m*step;i+=step)
+		data[i+stride] += DB2_PREDICT_0*data[i] + DB2_PREDICT_1*data[i-step];
+
+	for(i=0;i<m*step;i+=step)
+		data[i] -= DB2_SQRT3*data[i+stride];
+}
+
+/*
+ * Pushes one sample into the first level, and the approximations down the levels
+ * as their pairs complete. The detail energy is counted as soon as a pair is
+ * lifted; a Daubechies approximation waits for the detail of the next pair.
+ */
+static void dwt_stream_sample(dwt_stream_t *stream, double x){
+
+	int j;
+
+	for(j=0;j<stream->levels;j++){
+
+		struct dwt_level_s *level = &stream->state[j];
+		double s, d;
+
+		if(!level->has_even){
+			level->even = x;
+			level->has_even = 1;
+			return;
+		}
+		level->has_even = 0;
+
+		if(stream->wavelet == FFT_WAVELET_HAAR){
+			d = M_SQRT1_2*(x - level->even);
+			s = M_SQRT1_2*(x + level->even);
+		}
+		else{
+			double s1 = level->even + DB2_SQRT3*x;
+			double d1 = x - DB2_PREDICT_0*s1 - DB2_PREDICT_1*level->s_prev;
+			s = DB2_SCALE_S*(level->s_prev - d1);
+			d = DB2_SCALE_D*d1;
+			level->s_prev = s1;
+
+			/*s is the approximation of the pair before the stream, not passed down*/
+			if(!level->started){
+				level->started = 1;
+				stream->detail[j] += d*d;
+				return;
+			}
+		}
+
+		stream->detail[j] += d*d;
+		x = s;
+	}
+
+	stream->approx += x*x;
+}
@@ -26,12 +26,24 @@
 #include <stdlib.h>
 #include <string.h>
 #include "fft.h"
+#include "fft_internal.h"
+
+#define FFT_REAL double
+#define FFT_SQRT sqrt
+#define FFT_T(name) name##_d
+#include "fft_template.h"
 
 
 // Private function prototypes
 static size_t reverse_bits(size_t x, unsigned int n);
+static int transform_interleaved_direction(double data[], size_t n, int inverse);
+static int transform_codelet(codelet_fn codelet, double real[], double imag[], size_t n);
+static int transform_cached(double real[], double imag[], size_t n);
+static double *transform_packed(const double signal_1[], const double signal_2[], size_t n);
 
+#ifndef SIZE_MAX
 #define SIZE_MAX ((size_t)-1)
+#endif
 
 
 /**
@@ -52,62 +64,38 @@ int fft_2signals(double* signal_1, double* signal_2,
                  double* X1_real, double* X1_imag, 
                  double* X2_real, double* X2_imag,
                  size_t n){
+	FFT_STATS_ENTRY(FFT_STATS_FFT_2SIGNALS);
 	
-	int status;
-	register int i,k;
-	double *X_real = (double*)malloc(n * sizeof(double));
-	double *X_imag = (double*)malloc(n * sizeof(double));
+	double *X_real;
 	
-	for(i=0;i<n;i++){
-		X_real[i] = signal_1[i];
-		X_imag[i] = signal_2[i];
-	}
+	if(n == 0)
+		return 1;
 	
 	/*Compute the fourier transform of the two signals at once*/
-	if(!transform(X_real, X_imag, n)){
-		status = 0;
-		goto cleanup;
-	}
+	X_real = transform_packed(signal_1, signal_2, n);
+	if(X_real == NULL)
+		return 0;
 	
 	/*compute the split operation to recover X1(k) and X2(k)*/
-	/* 
-	 * X1(k) = 1/2*[X(k)+X*(N-k)]
-	 * X2(k) = 1/(j2)*[X(k)-X*(N-k)]
-	 */
-	X1_real[0] = X_real[0];
-	X1_imag[0] = 0;
-
-	X2_real[0] = X_imag[0];
-	X2_imag[0] = 0;
-
-	X1_real[n/2] = X_imag[n/2];
-	X2_real[n/2] = X_imag[n/2];
-	X1_imag[n/2] = 0;
-	X2_imag[n/2] = 0;	
-	
-	for(k=1;k<n/2;k++){
-		X1_real[k] = 0.5*(X_real[k]+X_real[n-k]);
-		X2_real[k] = 0.5*(X_imag[k]+X_imag[n-k]);
-		
-		/*make use of the symmetry*/
-		X1_real[n-k] = X1_real[k];
-		X2_real[n-k] = X2_real[k];
-		
-		X1_imag[k] = 0.5*(X_imag[k]-X_imag[n-k]);
-		X2_imag[k] = -0.5*(X_real[k]-X_real[n-k]);
-		
-		/*make use of the symmetry*/
-		X1_imag[n-k] = -X1_imag[k];
-		X2_imag[n-k] = -X2_imag[k];
-	}
-	
-	status = 1;
+	split_2signals(X_real, X_real + n, X1_real, X1_imag, X2_real, X2_imag, n);
 	
-cleanup:
 	free(X_real);
-	free(X_imag);
-	
-	return status;
+	return 1;
+}
+
+/*
+ * split_2signals
+ * 
+ * Recovers the spectra X1(k), X2(k) of two real signals packed as x = x1 + j*x2,
+ * from the full transform X(k) of x. Works for even and odd n.
+ * X1(k) = 1/2*[X(k)+X*(N-k)]
+ * X2(k) = 1/(j2)*[X(k)-X*(N-k)]
+ */
+void split_2signals(const double *X_real, const double *X_imag,
+                    double *X1_real, double *X1_imag,
+                    double *X2_real, double *X2_imag,
+                    size_t n){
+	split_spectra_d(X_real, X_imag, X1_real, X1_imag, X2_real, X2_imag, n);
 }
 
 /**
@@ -126,39 +114,22 @@ int abs_fft_2signals(double* signal_1, double* signal_2,
                  double* X1, 
                  double* X2,
                  size_t n){
+	FFT_STATS_ENTRY(FFT_STATS_ABS_FFT_2SIGNALS);
+	
+	if(n == 0)
+		return 1;
 				
-	int i, status;
-					 
-	double* X1_real = (double*)malloc(sizeof(double)*n);
-	double* X1_imag = (double*)malloc(sizeof(double)*n);
-	double* X2_real = (double*)malloc(sizeof(double)*n);
-	double* X2_imag = (double*)malloc(sizeof(double)*n);					 
-					 
-	/*compute the complex fft of both signals*/				 
-	if(!fft_2signals(signal_1, signal_2, 
-                 X1_real, X1_imag, 
-                 X2_real, X2_imag,
-                 n)){
-		status = 0;	
-		goto cleanup;			
-	}
+	/*compute the complex fft of both signals at once*/
+	double* X_real = transform_packed(signal_1, signal_2, n);
 	
-	/*compute the absolute values of the one-sided fft of the signal*/
-	for(i=0;i<(n/2+1);i++){
-		X1[i] = 2*(sqrt(X1_real[i]*X1_real[i] + X1_imag[i]*X1_imag[i])/n);
-		X2[i] = 2*(sqrt(X2_real[i]*X2_real[i] + X2_imag[i]*X2_imag[i])/n);
-	}			
+	if(X_real == NULL)
+		return 0;
 	
-	status = 1;			
-				
-cleanup:
-				
-	free(X1_real);	
-	free(X1_imag);	
-	free(X2_real);	
-	free(X2_imag);	 
-				 
-	return status;				 
+	/*split and abs values of the one-sided fft, without the mirrored half*/
+	split_spectrum_d(X_real, X_real + n, n, FFT_OUTPUT_MAGNITUDE, X1, X2);
+	
+	free(X_real);
+	return 1;
 }
 
 
@@ -175,28 +146,40 @@ cleanup:
 int abs_fft(double* signal,
             double* abs_onesided_fft, 
             size_t n){
+	FFT_STATS_ENTRY(FFT_STATS_ABS_FFT);
 		
-	int i,status = 0;		
-	int one_sided_fft_length = (n/2)+1;	
-	/*duplicate the signal*/
-	double* real = (double*)memdup(signal, n*sizeof(double));
-	double* imag = zero_reals(n);
+	int status = 0;		
 	
-	/*compute the complex fft*/
-	status = transform(real, imag, n);
+	if(n == 0)
+		return 1;
 	
-	/*compute the abs values one-sided fft*/
-	if(status){
-		for(i=0;i<one_sided_fft_length;i++){
-			abs_onesided_fft[i] = 2*(sqrt(real[i]*real[i]+imag[i]*imag[i])/n);
+	/*even length: use the real-input transform of the cached plan, at half the cost*/
+	if(n%2 == 0){
+		plan_cache_slot_t *slot;
+		const fft_plan_t *plan = plan_cache_acquire(n, 0, PLAN_WITH_REAL, &slot);
+		double *scratch = (double*)fft_malloc(rfft_workspace_size(n));
+		
+		if(plan != NULL && scratch != NULL){
+			rfft_spectrum_execute(plan->real, signal, FFT_OUTPUT_MAGNITUDE, abs_onesided_fft, scratch);
+			status = 1;
 		}
+		
+		free(scratch);
+		plan_cache_release(slot, plan);
+		return status;
 	}
 	
-	free(real);
-	free(imag);
+	/*compute the complex fft, odd length*/
+	double* real = transform_packed(signal, NULL, n);
 	
-	return status;
-				
+	if(real == NULL)
+		return 0;
+	
+	/*compute the abs values one-sided fft*/
+	spectrum_onesided_d(real, real + n, n, FFT_OUTPUT_MAGNITUDE, abs_onesided_fft);
+	
+	free(real);
+	return 1;
 }                 
 
 
@@ -224,21 +207,38 @@ void get_fft_infos(double* freq_scale, double* df, int n, double fs){
 
 
 int transform(double real[], double imag[], size_t n) {
+	FFT_STATS_ENTRY(FFT_STATS_TRANSFORM);
+	codelet_fn codelet = codelet_lookup(n);
 	if (n == 0)
 		return 1;
-	else if ((n & (n - 1)) == 0)  // Is power of 2
-		return transform_radix2(real, imag, n);
-	else  // More complicated algorithm for arbitrary sizes
-		return transform_bluestein(real, imag, n);
+	else if (codelet != NULL)  // Length generated at build time (CODELET_SIZES)
+		return transform_codelet(codelet, real, imag, n);
+	else  // Radix-2, mixed radix or Bluestein plan, from the plan cache
+		return transform_cached(real, imag, n);
 }
 
 
 int inverse_transform(double real[], double imag[], size_t n) {
+	FFT_STATS_ENTRY(FFT_STATS_INVERSE_TRANSFORM);
 	return transform(imag, real, n);
 }
 
 
+int transform_interleaved(double data[], size_t n) {
+	FFT_STATS_ENTRY(FFT_STATS_TRANSFORM_INTERLEAVED);
+	return transform_interleaved_direction(data, n, 0);
+}
+
+
+int inverse_transform_interleaved(double data[], size_t n) {
+	FFT_STATS_ENTRY(FFT_STATS_TRANSFORM_INTERLEAVED);
+	return transform_interleaved_direction(data, n, 1);
+}
+
+
 int transform_radix2(double real[], double imag[], size_t n) {
+	FFT_STATS_ENTRY(FFT_STATS_TRANSFORM_RADIX2);
+	FFT_STATS_PATH(FFT_STATS_PATH_RADIX2, n);
 	// Variables
 	int status = 0;
 	unsigned int levels;
@@ -313,6 +313,8 @@ cleanup:
 
 
 int transform_bluestein(double real[], double imag[], size_t n) {
+	FFT_STATS_ENTRY(FFT_STATS_TRANSFORM_BLUESTEIN);
+	FFT_STATS_PATH(FFT_STATS_PATH_BLUESTEIN, n);
 	// Variables
 	int status = 0;
 	double *cos_table, *sin_table;
@@ -428,8 +430,33 @@ void naive_dft(const double *inreal, const double *inimag, double *outreal, doub
 
 
 int convolve_real(const double x[], const double y[], double out[], size_t n) {
+	FFT_STATS_ENTRY(FFT_STATS_CONVOLVE_REAL);
 	double *ximag, *yimag, *zimag;
 	int status = 0;
+	
+	// Even length: multiply the one-sided spectra of the real-input transform
+	if (n > 0 && n % 2 == 0) {
+		size_t half = n / 2 + 1;
+		plan_cache_slot_t *slot;
+		const fft_plan_t *plan = plan_cache_acquire(n, 0, PLAN_WITH_REAL, &slot);
+		double *xr = (double*)fft_malloc((4 * half + rfft_scratch_length(n)) * sizeof(double));
+		if (plan != NULL && xr != NULL) {
+			double *xi = xr + half;
+			double *yr = xi + half;
+			double *yi = yr + half;
+			double *scratch = yi + half;
+			rfft_execute(plan->real, x, xr, xi, scratch);
+			rfft_execute(plan->real, y, yr, yi, scratch);
+			// Product with the scaling of the inverse (because this FFT implementation omits it)
+			complex_multiply_scaled_d(xr, xi, yr, yi, half, 1.0 / n);
+			irfft_execute(plan->real, xr, xi, out, scratch);
+			status = 1;
+		}
+		free(xr);
+		plan_cache_release(slot, plan);
+		return status;
+	}
+	
 	ximag = (double*)calloc(n, sizeof(double));
 	yimag = (double*)calloc(n, sizeof(double));
 	zimag = (double*)calloc(n, sizeof(double));
@@ -446,46 +473,141 @@ cleanup:
 
 
 int convolve_complex(const double xreal[], const double ximag[], const double yreal[], const double yimag[], double outreal[], double outimag[], size_t n) {
+	FFT_STATS_ENTRY(FFT_STATS_CONVOLVE_COMPLEX);
+	plan_cache_slot_t *slot;
+	const fft_plan_t *plan;
 	int status = 0;
 	size_t size;
-	size_t i;
-	double *xr, *xi, *yr, *yi;
-	if (SIZE_MAX / sizeof(double) < n)
+	double *yr, *yi;
+	if (n == 0)
+		return 1;
+	// n first: the subtraction, and transform_scratch_length, would wrap past it
+	if (n > SIZE_MAX / sizeof(double) / 2 || SIZE_MAX / sizeof(double) / 2 - n < transform_scratch_length(n))
 		return 0;
 	size = n * sizeof(double);
-	xr = (double*)memdup(xreal, size);
-	xi = (double*)memdup(ximag, size);
-	yr = (double*)memdup(yreal, size);
-	yi = (double*)memdup(yimag, size);
-	if (xr == NULL || xi == NULL || yr == NULL || yi == NULL)
-		goto cleanup;
 	
-	if (!transform(xr, xi, n))
-		goto cleanup;
-	if (!transform(yr, yi, n))
-		goto cleanup;
-	for (i = 0; i < n; i++) {
-		double temp = xr[i] * yr[i] - xi[i] * yi[i];
-		xi[i] = xi[i] * yr[i] + xr[i] * yi[i];
-		xr[i] = temp;
-	}
-	if (!inverse_transform(xr, xi, n))
-		goto cleanup;
-	for (i = 0; i < n; i++) {  // Scaling (because this FFT implementation omits it)
-		outreal[i] = xr[i] / n;
-		outimag[i] = xi[i] / n;
+	// One block for y and the scratch of the transforms, x is convolved in the output arrays
+	plan = plan_cache_acquire(n, 0, 0, &slot);
+	yr = (double*)fft_malloc((2 * n + transform_scratch_length(n)) * sizeof(double));
+	if (plan != NULL && yr != NULL) {
+		yi = yr + n;
+		memcpy(yr, yreal, size);  // y first, the output may overwrite it
+		memcpy(yi, yimag, size);
+		memmove(outreal, xreal, size);
+		memmove(outimag, ximag, size);
+		convolve_execute(plan, outreal, outimag, yr, yi, yi + n);
+		status = 1;
 	}
-	status = 1;
 	
-cleanup:
-	free(yi);
 	free(yr);
-	free(xi);
-	free(xr);
+	plan_cache_release(slot, plan);
+	return status;
+}
+
+
+// Runs a cached plan over the interleaved data, with a scratch of 2n + transform_scratch_length(n) doubles
+static int transform_interleaved_direction(double data[], size_t n, int inverse) {
+	plan_cache_slot_t *slot;
+	const fft_plan_t *plan;
+	double *scratch;
+	int status = 0;
+	
+	if (n == 0)
+		return 1;
+	// 2n + scratch + 1 doubles, n first so that neither the subtraction nor the scratch length wraps
+	if (n > SIZE_MAX / sizeof(double) / 2 || SIZE_MAX / sizeof(double) / 2 - n <= transform_scratch_length(n))
+		return 0;
+	
+	plan = plan_cache_acquire(n, inverse, 0, &slot);
+	scratch = (double*)fft_malloc((2 * n + transform_scratch_length(n) + 1) * sizeof(double));
+	if (plan != NULL && scratch != NULL) {
+		plan_execute_interleaved(plan, data, scratch);
+		status = 1;
+	}
+	
+	free(scratch);
+	plan_cache_release(slot, plan);
+	return status;
+}
+
+
+// Transform of signal_1 + j*signal_2 (zeros when signal_2 is NULL) with the cached plan, into
+// a fft_malloc'ed block holding the real then the imaginary part, followed by the scratch.
+// Returns the block to free, NULL if n is 0 or out of memory.
+static double *transform_packed(const double signal_1[], const double signal_2[], size_t n) {
+	plan_cache_slot_t *slot;
+	const fft_plan_t *plan;
+	double *X;
+	
+	if (n == 0)
+		return NULL;
+	// 2n + scratch + 1 doubles, n first so that neither the subtraction nor the scratch length wraps
+	if (n > SIZE_MAX / sizeof(double) / 2 || SIZE_MAX / sizeof(double) / 2 - n <= transform_scratch_length(n))
+		return NULL;
+	
+	plan = plan_cache_acquire(n, 0, 0, &slot);
+	X = (double*)fft_malloc((2 * n + transform_scratch_length(n) + 1) * sizeof(double));
+	if (plan != NULL && X != NULL) {
+		memcpy(X, signal_1, n * sizeof(double));
+		if (signal_2 != NULL)
+			memcpy(X + n, signal_2, n * sizeof(double));
+		else
+			memset(X + n, 0, n * sizeof(double));
+		plan_execute(plan, X, X + n, X + 2 * n);
+	} else {
+		free(X);
+		X = NULL;
+	}
+	
+	plan_cache_release(slot, plan);
+	return X;
+}
+
+
+// Runs a cached plan, the scratch memory (none for powers of 2) belongs to the call.
+// Without the cache, the transforms picked by transform before the cache run instead.
+static int transform_cached(double real[], double imag[], size_t n) {
+	plan_cache_slot_t *slot;
+	const fft_plan_t *plan;
+	size_t length = transform_scratch_length(n);
+	double *scratch = NULL;
+	int status = 0;
+	
+	if (!plan_cache_enabled(n)) {
+		if ((n & (n - 1)) == 0)  // Is power of 2
+			return transform_radix2(real, imag, n);
+		else if (mixed_radix_supported(n))  // Only small prime factors (2, 3, 5, 7, 11)
+			return transform_mixed_radix(real, imag, n);
+		else
+			return transform_bluestein(real, imag, n);
+	}
+	if (SIZE_MAX / sizeof(double) < length)
+		return 0;
+	
+	plan = plan_cache_acquire(n, 0, 0, &slot);
+	if (plan == NULL)
+		return 0;
+	if (length > 0)
+		scratch = (double*)fft_malloc(length * sizeof(double));
+	if (length == 0 || scratch != NULL) {
+		plan_execute(plan, real, imag, scratch);
+		status = 1;
+	}
+	
+	free(scratch);
+	plan_cache_release(slot, plan);
 	return status;
 }
 
 
+// Runs the straight-line kernel of length n, no table nor memory needed
+static int transform_codelet(codelet_fn codelet, double real[], double imag[], size_t n) {
+	FFT_STATS_PATH(FFT_STATS_PATH_CODELET, n);
+	codelet(real, imag);
+	return 1;
+}
+
+
 static size_t reverse_bits(size_t x, unsigned int n) {
 	size_t result = 0;
 	unsigned int i;
@@ -495,8 +617,39 @@ static size_t reverse_bits(size_t x, unsigned int n) {
 }
 
 
+/**
+ * fft_malloc(size_t size)
+ * 
+ * @brief allocates size bytes aligned on FFT_ALIGNMENT, released with free().
+ * @return the block, NULL if out of memory
+ */ 
+void *fft_malloc(size_t size) {
+	void *result;
+	// posix_memalign does not promise a free()-able pointer for size 0
+	if (posix_memalign(&result, FFT_ALIGNMENT, size > 0 ? size : 1) != 0)
+		return NULL;
+	return result;
+}
+
+/**
+ * fft_alloc_reals(size_t n)
+ * 
+ * @brief allocates n doubles set to 0, aligned on FFT_ALIGNMENT.
+ * @return the vector, NULL if out of memory
+ */ 
+double *fft_alloc_reals(size_t n) {
+	double *result;
+	if (n > SIZE_MAX / sizeof(double))
+		return NULL;
+	result = (double*)fft_malloc(n * sizeof(double));
+	if (result != NULL)
+		memset(result, 0, n * sizeof(double));
+	return result;
+}
+
+
 void *memdup(const void *src, size_t n) {
-	void *dest = malloc(n);
+	void *dest = fft_malloc(n);
 	if (dest != NULL)
 		memcpy(dest, src, n);
 	return dest;
@@ -511,8 +664,10 @@ void *memdup(const void *src, size_t n) {
  * @return 1 if success, 0 otherwise
  */ 
 double *random_reals(int n) {
-	double *result = (double*)malloc(n * sizeof(double));
+	double *result = (double*)fft_malloc(n * sizeof(double));
 	int i;
+	if (result == NULL)
+		return NULL;
 	for (i = 0; i < n; i++)
 		result[i] = (rand() / (RAND_MAX + 1.0)) * 2 - 1;
 	return result;
@@ -526,40 +681,5 @@ double *random_reals(int n) {
  * @return 1 if success, 0 otherwise
  */ 
 double *zero_reals(int n) {
-	double *result = (double*)malloc(n * sizeof(double));
-	int i;
-	for (i = 0; i < n; i++)
-		result[i] = 0;
-	return result;
+	return fft_alloc_reals(n);
 }
-
-/**
- * void abs_dft_interval(const double *signal, double *abs_power_interval, int n, int interval_start, int interval_stop)
- * @brief This is used in preprocess_core.c in preprocess-daemon
- */
-void abs_dft_interval(const double *signal, double *abs_power_interval, int n, int interval_start, int interval_stop){
-	
-	int k;
-	int coef_idx = 0;
-	
-	/*loop through all coefficients*/
-	for (k = interval_start; k < interval_stop; k++) {
-		
-		/*computing registers*/
-		double sumreal = 0;
-		double sumimag = 0;
-		int t;
-		
-		/*compute each terms*/
-		for(t = 0; t < n; t++) {
-			double angle = -2*M_PI * ((long long)t * k % n) / n;
-			sumreal += signal[t]*cos(angle);
-			sumimag += signal[t]*sin(angle);
-		}
-		
-		/*compute 2*real value, to get abs fft*/
-		abs_power_interval[coef_idx] = 2*sqrt(sumreal*sumreal+sumimag*sumimag)/n;
-		coef_idx++;
-	}
-}  
-
@@ -0,0 +1,357 @@
+/**
+ * @file fft_async.c
+ * @brief Asynchronous batched spectra: a single-producer/multi-consumer ring of
+ *        preallocated job slots, served by dedicated worker threads sharing one plan.
+ *
+ *        Job ids are consecutive, and job 'id' lives in slot id & mask: the ring of slots
+ *        is the queue itself. The producer fills the slot of 'tail' and publishes it by
+ *        bumping tail, the workers claim jobs by moving 'head' forward with a
+ *        compare-and-swap. A slot is reused only once its job is complete, which the
+ *        producer checks with one load, so a full ring makes the submission fail instead
+ *        of waiting. Nothing is allocated nor locked on the submission path; the only
+ *        system call is the sem_post that wakes a sleeping worker.
+ *
+ *        The fields of a slot are written by the producer before the release store of
+ *        tail, and read by the worker after its acquire load of tail. The worker copies
+ *        them before the release store of the DONE state, after which the producer may
+ *        overwrite them.
+ */
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "fft.h"
+#include "fft_internal.h"
+#include "thread_pool.h"
+
+/*state of a slot*/
+#define SLOT_FREE 0      /*never used*/
+#define SLOT_QUEUED 1    /*submitted, queued or running*/
+#define SLOT_DONE 2
+#define SLOT_FAILED 3
+
+/**
+ * struct fft_async_slot_s
+ * @brief a job, and the id and state that let it be polled
+ */
+struct fft_async_slot_s{
+
+	uint64_t id;             /*job in the slot, 0 before the first one*/
+	int state;               /*SLOT_xxx*/
+
+	const double *data;
+	size_t nb_channels;
+	int layout;
+	int mode;
+	double *out;
+	fft_async_fn fn;
+	void *context;
+};
+
+/**
+ * struct fft_async_s
+ * @brief job ring and workers of an asynchronous fft queue
+ */
+struct fft_async_s{
+
+	size_t n;
+	fft_plan_t *plan;        /*read-only, shared by the workers*/
+	int nb_threads;
+	pthread_t *threads;
+	struct fft_async_worker_s *workers;
+
+	struct fft_async_slot_s *slots;
+	uint64_t mask;           /*number of slots - 1*/
+
+	/*next job to submit (written by the producer only) and next job to claim*/
+	uint64_t tail;
+	uint64_t head;
+
+	sem_t pending;           /*one post per submitted job, and one per worker to stop*/
+	int stop;
+
+	/*fft_async_wait: the workers only take the lock when somebody waits*/
+	int nb_waiters;
+	pthread_mutex_t lock;
+	pthread_cond_t done;
+};
+
+/**
+ * struct fft_async_worker_s
+ * @brief workspace of a worker
+ */
+struct fft_async_worker_s{
+
+	struct fft_async_s *async;
+	void *workspace;         /*fft_batch_workspace_size(n) bytes*/
+};
+
+static void* async_worker_main(void *arg);
+static int async_claim(fft_async_t *async, uint64_t *id);
+static void async_stop(fft_async_t *async, int nb_spawned);
+
+/**
+ * fft_async_t* fft_async_create(size_t n, int nb_threads, size_t nb_slots)
+ *
+ * @brief creates an asynchronous queue of batched spectra of length n.
+ * @return the queue, NULL if out of memory or if the threads could not be created
+ */
+fft_async_t* fft_async_create(size_t n, int nb_threads, size_t nb_slots){
+
+	fft_async_t *async;
+	size_t capacity = 1;
+	int i;
+
+	if(nb_threads <= 0){
+		long nb_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		nb_threads = (nb_cpus > 0) ? (int)nb_cpus : 1;
+	}
+	if(nb_slots == 0)
+		nb_slots = FFT_ASYNC_DEFAULT_SLOTS;
+	while(capacity < nb_slots){
+		if(capacity > ((size_t)-1)/2/sizeof(struct fft_async_slot_s))
+			return NULL;
+		capacity *= 2;
+	}
+
+	async = (fft_async_t*)calloc(1, sizeof(fft_async_t));
+	if(async == NULL)
+		return NULL;
+
+	async->n = n;
+	async->nb_threads = nb_threads;
+	async->mask = capacity - 1;
+	async->tail = 1;
+	async->head = 1;
+
+	/*spectrum_batch_ws only writes to the workspace, the plan has none*/
+	async->plan = plan_create(n, 0, PLAN_WITH_REAL);
+	async->slots = (struct fft_async_slot_s*)calloc(capacity, sizeof(struct fft_async_slot_s));
+	async->threads = (pthread_t*)malloc(nb_threads*sizeof(pthread_t));
+	async->workers = (struct fft_async_worker_s*)calloc(nb_threads, sizeof(struct fft_async_worker_s));
+	if(async->plan == NULL || async->slots == NULL || async->threads == NULL || async->workers == NULL)
+		goto error;
+
+	for(i=0;i<nb_threads;i++){
+		async->workers[i].async = async;
+		async->workers[i].workspace = fft_malloc(fft_batch_workspace_size(n));
+		if(async->workers[i].workspace == NULL)
+			goto error;
+	}
+
+	if(sem_init(&async->pending, 0, 0) != 0)
+		goto error;
+	pthread_mutex_init(&async->lock, NULL);
+	pthread_cond_init(&async->done, NULL);
+
+	for(i=0;i<nb_threads;i++){
+		if(pthread_create(&async->threads[i], NULL, async_worker_main, &async->workers[i]) != 0){
+			async_stop(async, i);
+			return NULL;
+		}
+	}
+
+	return async;
+
+error:
+	if(async->workers != NULL){
+		for(i=0;i<nb_threads;i++)
+			free(async->workers[i].workspace);
+	}
+	fft_plan_destroy(async->plan);
+	free(async->workers);
+	free(async->threads);
+	free(async->slots);
+	free(async);
+	return NULL;
+}
+
+/**
+ * void fft_async_destroy(fft_async_t* async)
+ *
+ * @brief runs the jobs still queued, then stops the workers and releases the queue. NULL is accepted.
+ */
+void fft_async_destroy(fft_async_t* async){
+
+	if(async == NULL)
+		return;
+	async_stop(async, async->nb_threads);
+}
+
+/**
+ * uint64_t fft_async_submit(fft_async_t* async, const double* data, size_t nb_channels, int layout,
+ *                           int mode, double* out, fft_async_fn fn, void* context)
+ *
+ * @brief queues spectrum_batch_ws(plan, data, nb_channels, layout, mode, out) on a worker.
+ * @return the id of the job, 0 if every slot holds a job that is not complete
+ */
+uint64_t fft_async_submit(fft_async_t* async, const double* data, size_t nb_channels, int layout,
+                          int mode, double* out, fft_async_fn fn, void* context){
+
+	uint64_t id = async->tail;
+	struct fft_async_slot_s *slot = &async->slots[id & async->mask];
+	int state = __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE);
+
+	if(state == SLOT_QUEUED)
+		return 0;
+
+	slot->data = data;
+	slot->nb_channels = nb_channels;
+	slot->layout = layout;
+	slot->mode = mode;
+	slot->out = out;
+	slot->fn = fn;
+	slot->context = context;
+
+	/*the id before the state, fft_async_poll reads them the other way round*/
+	__atomic_store_n(&slot->id, id, __ATOMIC_RELAXED);
+	__atomic_store_n(&slot->state, SLOT_QUEUED, __ATOMIC_RELEASE);
+	__atomic_store_n(&async->tail, id + 1, __ATOMIC_RELEASE);
+
+	sem_post(&async->pending);
+	return id;
+}
+
+/**
+ * int fft_async_poll(const fft_async_t* async, uint64_t job)
+ *
+ * @brief returns the state of a job, without waiting.
+ * @return one of FFT_ASYNC_xxx
+ */
+int fft_async_poll(const fft_async_t* async, uint64_t job){
+
+	const struct fft_async_slot_s *slot = &async->slots[job & async->mask];
+	uint64_t id;
+	int state;
+
+	if(job == 0 || job >= __atomic_load_n(&async->tail, __ATOMIC_ACQUIRE))
+		return FFT_ASYNC_UNKNOWN;
+
+	/*a state read after the reuse of the slot is followed by an id read of the new job*/
+	state = __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE);
+	id = __atomic_load_n(&slot->id, __ATOMIC_ACQUIRE);
+	if(id != job)
+		return FFT_ASYNC_RETIRED;
+
+	switch(state){
+		case SLOT_DONE:
+			return FFT_ASYNC_DONE;
+		case SLOT_FAILED:
+			return FFT_ASYNC_FAILED;
+		default:
+			return FFT_ASYNC_PENDING;
+	}
+}
+
+/**
+ * int fft_async_wait(fft_async_t* async, uint64_t job)
+ *
+ * @brief waits for a job to complete. Blocks: not for the real-time threads.
+ * @return one of FFT_ASYNC_xxx, never FFT_ASYNC_PENDING
+ */
+int fft_async_wait(fft_async_t* async, uint64_t job){
+
+	int status = fft_async_poll(async, job);
+
+	if(status != FFT_ASYNC_PENDING)
+		return status;
+
+	/*the workers read nb_waiters after the state, so one of the two sees the other*/
+	__atomic_fetch_add(&async->nb_waiters, 1, __ATOMIC_SEQ_CST);
+	pthread_mutex_lock(&async->lock);
+	while((status = fft_async_poll(async, job)) == FFT_ASYNC_PENDING)
+		pthread_cond_wait(&async->done, &async->lock);
+	pthread_mutex_unlock(&async->lock);
+	__atomic_fetch_sub(&async->nb_waiters, 1, __ATOMIC_SEQ_CST);
+
+	return status;
+}
+
+/*
+ * Worker loop: sleeps until a job is posted, claims it and runs it.
+ */
+static void* async_worker_main(void *arg){
+
+	struct fft_async_worker_s *worker = (struct fft_async_worker_s*)arg;
+	fft_async_t *async = worker->async;
+	uint64_t id;
+
+	for(;;){
+
+		struct fft_async_slot_s *slot;
+		struct fft_async_slot_s job;
+		int status;
+
+		while(sem_wait(&async->pending) != 0);
+
+		if(!async_claim(async, &id)){
+			/*a post without a job is a stop, once the ring is empty*/
+			if(__atomic_load_n(&async->stop, __ATOMIC_ACQUIRE))
+				break;
+			continue;
+		}
+
+		slot = &async->slots[id & async->mask];
+		job = *slot;
+
+		status = spectrum_batch_ws(async->plan, job.data, job.nb_channels, job.layout,
+		                           job.mode, job.out, worker->workspace);
+
+		/*the slot may be reused from here on*/
+		__atomic_store_n(&slot->state, status ? SLOT_DONE : SLOT_FAILED, __ATOMIC_SEQ_CST);
+		if(__atomic_load_n(&async->nb_waiters, __ATOMIC_SEQ_CST) > 0){
+			pthread_mutex_lock(&async->lock);
+			pthread_cond_broadcast(&async->done);
+			pthread_mutex_unlock(&async->lock);
+		}
+
+		if(job.fn != NULL)
+			job.fn(job.context, id, status ? FFT_ASYNC_DONE : FFT_ASYNC_FAILED);
+	}
+
+	return NULL;
+}
+
+/*
+ * Claims the oldest job not claimed yet. Returns 0 if there is none.
+ */
+static int async_claim(fft_async_t *async, uint64_t *id){
+
+	uint64_t head = __atomic_load_n(&async->head, __ATOMIC_RELAXED);
+
+	do{
+		if(head == __atomic_load_n(&async->tail, __ATOMIC_ACQUIRE))
+			return 0;
+	}while(!__atomic_compare_exchange_n(&async->head, &head, head + 1, 1,
+	                                    __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+	*id = head;
+	return 1;
+}
+
+/*
+ * Lets the nb_spawned workers drain the ring and exit, joins them and frees everything.
+ */
+static void async_stop(fft_async_t *async, int nb_spawned){
+
+	int i;
+
+	__atomic_store_n(&async->stop, 1, __ATOMIC_RELEASE);
+	for(i=0;i<nb_spawned;i++)
+		sem_post(&async->pending);
+	for(i=0;i<nb_spawned;i++)
+		pthread_join(async->threads[i], NULL);
+
+	for(i=0;i<async->nb_threads;i++)
+		free(async->workers[i].workspace);
+	fft_plan_destroy(async->plan);
+	sem_destroy(&async->pending);
+	pthread_mutex_destroy(&async->lock);
+	pthread_cond_destroy(&async->done);
+	free(async->workers);
+	free(async->threads);
+	free(async->slots);
+	free(async);
+}
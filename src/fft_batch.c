@@ -0,0 +1,146 @@
+/**
+ * @file fft_batch.c
+ * @brief Batched one-sided spectra of multichannel frames. The channels share one
+ *        plan and are transformed two at a time, packed as x = x1 + j*x2 as in
+ *        fft_2signals. The samples are gathered straight from the frame into the
+ *        packed vector, and the output stage (magnitude, power...) runs during the
+ *        split, so the split spectra are never written to memory.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fft.h"
+#include "fft_internal.h"
+
+#define FFT_REAL double
+#define FFT_SQRT sqrt
+#define FFT_T(name) name##_d
+#include "fft_template.h"
+
+/**
+ * size_t fft_batch_workspace_size(size_t n)
+ *
+ * @brief returns the size in bytes of the workspace needed by abs_fft_batch_ws for length n.
+ */
+size_t fft_batch_workspace_size(size_t n){
+	return n*sizeof(double) + fft_workspace_size(n);
+}
+
+/**
+ * int abs_fft_batch_ws(const fft_plan_t* plan, const double* data, size_t nb_channels, int layout,
+ *                      double* abs_onesided_fft, void* workspace)
+ *
+ * @brief computes the abs value of the one-sided fft of each channel of a frame, as abs_fft would.
+ * @param plan, a forward plan of length n
+ * @param data (in), nb_channels x n samples, in the FFT_LAYOUT_xxx layout
+ * @param nb_channels, number of channels in the frame
+ * @param layout, FFT_LAYOUT_CHANNEL_MAJOR or FFT_LAYOUT_INTERLEAVED
+ * @param abs_onesided_fft (out), nb_channels x (n/2+1) values, channel after channel
+ * @param workspace, fft_batch_workspace_size(n) bytes of memory
+ * @return 1 if success, 0 otherwise (inverse plan, unknown layout)
+ */
+int abs_fft_batch_ws(const fft_plan_t* plan,
+                     const double* data, size_t nb_channels, int layout,
+                     double* abs_onesided_fft,
+                     void* workspace){
+	return spectrum_batch_range(plan, data, nb_channels, layout, 0, nb_channels,
+	                            FFT_OUTPUT_MAGNITUDE, abs_onesided_fft, workspace);
+}
+
+/**
+ * int spectrum_batch_ws(const fft_plan_t* plan, const double* data, size_t nb_channels, int layout,
+ *                       int mode, double* out, void* workspace)
+ *
+ * @brief same as abs_fft_batch_ws, with the spectra in the FFT_OUTPUT_xxx format.
+ * @param out (out), nb_channels x fft_output_length(n, mode) values, channel after channel
+ * @param workspace, fft_batch_workspace_size(n) bytes of memory
+ * @return 1 if success, 0 otherwise (inverse plan, unknown layout or mode)
+ */
+int spectrum_batch_ws(const fft_plan_t* plan,
+                      const double* data, size_t nb_channels, int layout,
+                      int mode, double* out,
+                      void* workspace){
+	return spectrum_batch_range(plan, data, nb_channels, layout, 0, nb_channels, mode, out, workspace);
+}
+
+/*
+ * Same as spectrum_batch_ws over the channels [first, first+count) of the frame only,
+ * the spectrum of the channel c being written at out + c*fft_output_length(n, mode).
+ * Lets several threads share out the channels of one frame.
+ */
+int spectrum_batch_range(const fft_plan_t* plan,
+                         const double* data, size_t nb_channels, int layout,
+                         size_t first, size_t count,
+                         int mode, double* out,
+                         void* workspace){
+	FFT_STATS_ENTRY(FFT_STATS_SPECTRUM_BATCH);
+
+	size_t n = plan->n;
+	size_t out_length = fft_output_length(n, mode);
+	size_t stop = first + count;
+	double *X_real = (double*)workspace;
+	double *X_imag = X_real + n;
+	size_t c;
+
+	if(plan->inverse || n == 0 || out_length == 0)
+		return 0;
+	if(layout != FFT_LAYOUT_CHANNEL_MAJOR && layout != FFT_LAYOUT_INTERLEAVED)
+		return 0;
+
+	/*two channels per transform*/
+	for(c=first;c+1<stop;c+=2){
+
+		double *out_1 = out + c*out_length;
+		double *out_2 = out_1 + out_length;
+
+		gather_channel(data, n, nb_channels, layout, c, X_real);
+		gather_channel(data, n, nb_channels, layout, c+1, X_imag);
+
+		plan_execute(plan, X_real, X_imag, X_imag + n);
+
+		/*split and output stage in one pass*/
+		split_spectrum_d(X_real, X_imag, n, mode, out_1, out_2);
+	}
+
+	/*odd number of channels, the last one goes through the real-input path*/
+	if(c < stop){
+		gather_channel(data, n, nb_channels, layout, c, X_real);
+		if(!spectrum_ws(plan, X_real, mode, out + c*out_length, X_real + n))
+			return 0;
+	}
+
+	return 1;
+}
+
+/**
+ * int abs_fft_batch(fft_plan_t* plan, const double* data, size_t nb_channels, int layout,
+ *                   double* abs_onesided_fft)
+ *
+ * @brief same as abs_fft_batch_ws, using the workspace owned by the plan.
+ * @return 1 if success, 0 otherwise
+ */
+int abs_fft_batch(fft_plan_t* plan,
+                  const double* data, size_t nb_channels, int layout,
+                  double* abs_onesided_fft){
+	return abs_fft_batch_ws(plan, data, nb_channels, layout, abs_onesided_fft, plan->work);
+}
+
+/*
+ * Copies the samples of one channel of the frame into a contiguous vector.
+ */
+void gather_channel(const double *data, size_t n, size_t nb_channels, int layout,
+                    size_t channel, double *out){
+
+	size_t t;
+
+	if(layout == FFT_LAYOUT_CHANNEL_MAJOR){
+		memcpy(out, data + channel*n, n*sizeof(double));
+	}
+	else{
+		const double *in = data + channel;
+		for(t=0;t<n;t++){
+			out[t] = in[t*nb_channels];
+		}
+	}
+}
@@ -0,0 +1,459 @@
+/**
+ * @file fft_features.c
+ * @brief Spectral features of real signals (band powers, band ratios, spectral entropy,
+ *        peak frequency), accumulated during the output stage of the transform.
+ *
+ *        The bin-to-band map is built once at creation: the band edges cut the one-sided
+ *        bins into contiguous segments, each bin maps to its segment, and a band is a
+ *        range of segments, so overlapping bands cost nothing more per bin. Each bin
+ *        leaves the last loop of the transform (the real-input post-twiddle, or the split
+ *        of two packed channels) as a power added to its segment, to the entropy sums and
+ *        to the peak search: the spectrum itself is never written to memory. The bins of
+ *        the post-twiddle come out in pairs k, n/2-k, hence the map rather than a cursor.
+ *
+ *        The power of bin k is (2*|X(k)|/n)^2, as FFT_OUTPUT_POWER and band_power_get.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fft.h"
+#include "fft_internal.h"
+
+/**
+ * struct fft_features_s
+ * @brief bin-to-band map and plan of a feature extractor
+ */
+struct fft_features_s{
+
+	size_t n;
+	double df;
+	int flags;
+
+	fft_plan_t *plan;
+	void *workspace;         /*fft_features_workspace_size bytes, for fft_features_batch*/
+
+	/*segment of each of the n/2+1 bins, -1 outside of every band*/
+	int *bin_segment;
+	size_t nb_segments;
+
+	/*band b is made of the segments [band_first[b], band_stop[b])*/
+	int nb_bands;
+	size_t *band_first;
+	size_t *band_stop;
+
+	int nb_ratios;
+	int *ratio_numerator;
+	int *ratio_denominator;
+};
+
+/**
+ * struct features_acc_s
+ * @brief sums of one channel during the output stage
+ */
+struct features_acc_s{
+
+	double *segment;         /*power of each segment*/
+	double total;            /*power of the bins 1..n/2*/
+	double plogp;            /*sum of p*log(p) over the same bins*/
+	size_t peak;
+	double peak_power;
+};
+
+static void features_acc_init(const fft_features_t *features, struct features_acc_s *acc, double *segment);
+static void features_store(const fft_features_t *features, const struct features_acc_s *acc, double *out);
+static void features_channel(const fft_features_t *features, double *signal,
+                             double *scratch, struct features_acc_s *acc);
+
+/*
+ * Adds bin k to the sums, from v = 2*X(k).
+ */
+static inline void features_bin(const fft_features_t *features, struct features_acc_s *acc,
+                                size_t k, double vr, double vi){
+
+	double n = (double)features->n;
+	double p = (vr*vr + vi*vi)/(n*n);
+	int segment = features->bin_segment[k];
+
+	if(segment >= 0)
+		acc->segment[segment] += p;
+
+	/*the mean of the signal is not part of its spectral shape*/
+	if(k == 0)
+		return;
+
+	acc->total += p;
+	if((features->flags & FFT_FEATURE_ENTROPY) && p > 0)
+		acc->plogp += p*log(p);
+	if(p > acc->peak_power || (p == acc->peak_power && k < acc->peak)){
+		acc->peak_power = p;
+		acc->peak = k;
+	}
+}
+
+/**
+ * fft_features_t* fft_features_create(size_t n, double fs, int nb_bands, const double* band_low,
+ *                                     const double* band_high, int flags)
+ *
+ * @brief creates an extractor of the features of signals of n samples at rate fs.
+ * @return the extractor, NULL if out of memory or if a parameter is invalid
+ */
+fft_features_t* fft_features_create(size_t n, double fs, int nb_bands, const double* band_low,
+                                    const double* band_high, int flags){
+
+	fft_features_t *features;
+	size_t half = n/2+1;
+	size_t *edges = NULL;
+	size_t nb_edges = 0;
+	size_t k, i;
+	int b;
+
+	if(n == 0 || !(fs > 0) || nb_bands < 0 || (flags & ~FFT_FEATURE_ALL) != 0)
+		return NULL;
+
+	features = (fft_features_t*)calloc(1, sizeof(fft_features_t));
+	if(features == NULL)
+		return NULL;
+
+	features->n = n;
+	features->df = fs/(double)n;
+	features->flags = flags;
+	features->nb_bands = nb_bands;
+
+	features->plan = fft_plan_create(n, 0);
+	features->bin_segment = (int*)malloc(half*sizeof(int));
+	features->band_first = (size_t*)malloc((nb_bands+1)*sizeof(size_t));
+	features->band_stop = (size_t*)malloc((nb_bands+1)*sizeof(size_t));
+	edges = (size_t*)malloc((2*nb_bands+1)*sizeof(size_t));
+	if(features->plan == NULL || features->bin_segment == NULL
+			|| features->band_first == NULL || features->band_stop == NULL || edges == NULL)
+		goto error;
+
+	/*bins of the bands, the bin k being at frequency k*df as in get_fft_infos*/
+	for(b=0;b<nb_bands;b++){
+		double first, stop;
+		if(!(band_low[b] >= 0) || !(band_high[b] > band_low[b]))
+			goto error;
+		first = ceil(band_low[b]/features->df);
+		stop = ceil(band_high[b]/features->df);
+		features->band_first[b] = (first < half) ? (size_t)first : half;
+		features->band_stop[b] = (stop < half) ? (size_t)stop : half;
+		if(features->band_stop[b] <= features->band_first[b])
+			goto error;
+	}
+
+	/*sorted distinct edges of the bands, segment i is [edges[i], edges[i+1])*/
+	for(b=0;b<nb_bands;b++){
+		size_t pair[2];
+		int e;
+		pair[0] = features->band_first[b];
+		pair[1] = features->band_stop[b];
+		for(e=0;e<2;e++){
+			for(i=0;i<nb_edges && edges[i]<pair[e];i++);
+			if(i < nb_edges && edges[i] == pair[e])
+				continue;
+			memmove(edges + i + 1, edges + i, (nb_edges - i)*sizeof(size_t));
+			edges[i] = pair[e];
+			nb_edges++;
+		}
+	}
+	features->nb_segments = (nb_edges > 0) ? nb_edges - 1 : 0;
+
+	for(k=0;k<half;k++)
+		features->bin_segment[k] = -1;
+	for(i=0;i<features->nb_segments;i++){
+		for(k=edges[i];k<edges[i+1];k++)
+			features->bin_segment[k] = (int)i;
+	}
+
+	/*the bands as ranges of segments*/
+	for(b=0;b<nb_bands;b++){
+		for(i=0;edges[i]!=features->band_first[b];i++);
+		features->band_first[b] = i;
+		for(;edges[i]!=features->band_stop[b];i++);
+		features->band_stop[b] = i;
+	}
+
+	features->workspace = fft_malloc(fft_features_workspace_size(features));
+	if(features->workspace == NULL)
+		goto error;
+
+	free(edges);
+	return features;
+
+error:
+	free(edges);
+	fft_features_destroy(features);
+	return NULL;
+}
+
+/**
+ * void fft_features_destroy(fft_features_t* features)
+ *
+ * @brief releases the memory held by an extractor. NULL is accepted.
+ */
+void fft_features_destroy(fft_features_t* features){
+
+	if(features == NULL)
+		return;
+
+	fft_plan_destroy(features->plan);
+	free(features->workspace);
+	free(features->bin_segment);
+	free(features->band_first);
+	free(features->band_stop);
+	free(features->ratio_numerator);
+	free(features->ratio_denominator);
+	free(features);
+}
+
+/**
+ * int fft_features_add_ratio(fft_features_t* features, int numerator, int denominator)
+ *
+ * @brief adds the ratio of the powers of two bands to the features.
+ * @return 1 if success, 0 otherwise (out of memory, or unknown band)
+ */
+int fft_features_add_ratio(fft_features_t* features, int numerator, int denominator){
+
+	int *num, *den;
+
+	if(numerator < 0 || numerator >= features->nb_bands
+			|| denominator < 0 || denominator >= features->nb_bands)
+		return 0;
+
+	num = (int*)realloc(features->ratio_numerator, (features->nb_ratios+1)*sizeof(int));
+	if(num == NULL)
+		return 0;
+	features->ratio_numerator = num;
+	den = (int*)realloc(features->ratio_denominator, (features->nb_ratios+1)*sizeof(int));
+	if(den == NULL)
+		return 0;
+	features->ratio_denominator = den;
+
+	num[features->nb_ratios] = numerator;
+	den[features->nb_ratios] = denominator;
+	features->nb_ratios++;
+	return 1;
+}
+
+/**
+ * size_t fft_features_length(const fft_features_t* features)
+ *
+ * @brief returns the number of values of the features of one channel.
+ */
+size_t fft_features_length(const fft_features_t* features){
+
+	size_t length = features->nb_ratios;
+
+	if(features->flags & FFT_FEATURE_BANDS)
+		length += features->nb_bands;
+	if(features->flags & FFT_FEATURE_ENTROPY)
+		length += 1;
+	if(features->flags & FFT_FEATURE_PEAK)
+		length += 2;
+	return length;
+}
+
+/**
+ * size_t fft_features_workspace_size(const fft_features_t* features)
+ *
+ * @brief returns the size in bytes of the workspace needed by fft_features_batch_ws.
+ */
+size_t fft_features_workspace_size(const fft_features_t* features){
+	return 2*features->nb_segments*sizeof(double) + fft_batch_workspace_size(features->n);
+}
+
+/**
+ * int fft_features_batch_ws(const fft_features_t* features, const double* data, size_t nb_channels,
+ *                           int layout, double* out, void* workspace)
+ *
+ * @brief computes the features of each channel of a frame.
+ * @return 1 if success, 0 otherwise (unknown layout)
+ */
+int fft_features_batch_ws(const fft_features_t* features,
+                          const double* data, size_t nb_channels, int layout,
+                          double* out,
+                          void* workspace){
+	FFT_STATS_ENTRY(FFT_STATS_FEATURES);
+
+	size_t n = features->n;
+	size_t half = n/2+1;
+	size_t out_length = fft_features_length(features);
+	double *segment_1 = (double*)workspace;
+	double *segment_2 = segment_1 + features->nb_segments;
+	double *X_real = segment_2 + features->nb_segments;
+	double *X_imag = X_real + n;
+	struct features_acc_s acc_1, acc_2;
+	size_t c, k;
+
+	if(layout != FFT_LAYOUT_CHANNEL_MAJOR && layout != FFT_LAYOUT_INTERLEAVED)
+		return 0;
+
+	/*two channels per transform, the features accumulated during the split*/
+	for(c=0;c+1<nb_channels;c+=2){
+
+		gather_channel(data, n, nb_channels, layout, c, X_real);
+		gather_channel(data, n, nb_channels, layout, c+1, X_imag);
+
+		plan_execute(features->plan, X_real, X_imag, X_imag + n);
+
+		features_acc_init(features, &acc_1, segment_1);
+		features_acc_init(features, &acc_2, segment_2);
+		for(k=0;k<half;k++){
+			size_t nk = (k == 0) ? 0 : n-k;
+			double ar = X_real[k] + X_real[nk];
+			double ai = X_imag[k] - X_imag[nk];
+			double br = X_real[k] - X_real[nk];
+			double bi = X_imag[k] + X_imag[nk];
+			features_bin(features, &acc_1, k, ar, ai);
+			features_bin(features, &acc_2, k, bi, -br);
+		}
+
+		features_store(features, &acc_1, out + c*out_length);
+		features_store(features, &acc_2, out + (c+1)*out_length);
+	}
+
+	/*odd number of channels, the last one goes through the real-input path*/
+	if(c < nb_channels){
+		gather_channel(data, n, nb_channels, layout, c, X_real);
+		features_acc_init(features, &acc_1, segment_1);
+		features_channel(features, X_real, X_real + n, &acc_1);
+		features_store(features, &acc_1, out + c*out_length);
+	}
+
+	return 1;
+}
+
+/**
+ * int fft_features_batch(fft_features_t* features, const double* data, size_t nb_channels,
+ *                        int layout, double* out)
+ *
+ * @brief same as fft_features_batch_ws, using the workspace owned by the extractor.
+ * @return 1 if success, 0 otherwise (unknown layout)
+ */
+int fft_features_batch(fft_features_t* features,
+                       const double* data, size_t nb_channels, int layout,
+                       double* out){
+	return fft_features_batch_ws(features, data, nb_channels, layout, out, features->workspace);
+}
+
+/**
+ * int fft_features(fft_features_t* features, const double* signal, double* out)
+ *
+ * @brief computes the features of one signal, using the workspace owned by the extractor.
+ * @return 1 if success, 0 otherwise
+ */
+int fft_features(fft_features_t* features, const double* signal, double* out){
+	return fft_features_batch_ws(features, signal, 1, FFT_LAYOUT_CHANNEL_MAJOR, out, features->workspace);
+}
+
+static void features_acc_init(const fft_features_t *features, struct features_acc_s *acc, double *segment){
+
+	memset(segment, 0, features->nb_segments*sizeof(double));
+	acc->segment = segment;
+	acc->total = 0;
+	acc->plogp = 0;
+	acc->peak = 0;
+	acc->peak_power = -1;
+}
+
+/*
+ * Writes the features of a channel from its sums, in the order of fft_features_length:
+ * band powers, ratios, entropy, peak frequency and magnitude.
+ */
+static void features_store(const fft_features_t *features, const struct features_acc_s *acc, double *out){
+
+	size_t nb_bins = features->n/2;
+	size_t i;
+	int b, r;
+
+	if(features->flags & FFT_FEATURE_BANDS){
+		for(b=0;b<features->nb_bands;b++){
+			double power = 0;
+			for(i=features->band_first[b];i<features->band_stop[b];i++)
+				power += acc->segment[i];
+			*out++ = power;
+		}
+	}
+
+	for(r=0;r<features->nb_ratios;r++){
+		double num = 0, den = 0;
+		b = features->ratio_numerator[r];
+		for(i=features->band_first[b];i<features->band_stop[b];i++)
+			num += acc->segment[i];
+		b = features->ratio_denominator[r];
+		for(i=features->band_first[b];i<features->band_stop[b];i++)
+			den += acc->segment[i];
+		*out++ = (den > 0) ? num/den : 0;
+	}
+
+	/*H = -sum q*log(q) with q = p/S, that is log(S) - sum(p*log(p))/S, over log(nb of bins)*/
+	if(features->flags & FFT_FEATURE_ENTROPY){
+		if(acc->total > 0 && nb_bins > 1)
+			*out++ = (log(acc->total) - acc->plogp/acc->total)/log((double)nb_bins);
+		else
+			*out++ = 0;
+	}
+
+	if(features->flags & FFT_FEATURE_PEAK){
+		*out++ = acc->peak*features->df;
+		*out++ = (acc->peak_power > 0) ? sqrt(acc->peak_power) : 0;
+	}
+}
+
+/*
+ * Features of one signal, the transform run as in rfft_spectrum_execute with the
+ * output stage replaced by the sums. The signal is overwritten for the odd lengths,
+ * scratch holds fft_workspace_size(n) bytes.
+ */
+static void features_channel(const fft_features_t *features, double *signal,
+                             double *scratch, struct features_acc_s *acc){
+
+	const rfft_plan_t *rplan = features->plan->real;
+	size_t n = features->n;
+	size_t half = n/2;
+	size_t j, k;
+
+	if(rplan == NULL){
+		double *imag = scratch;
+
+		memset(imag, 0, n*sizeof(double));
+		plan_execute(features->plan, signal, imag, imag + n);
+
+		for(k=0;k<=half;k++)
+			features_bin(features, acc, k, 2*signal[k], 2*imag[k]);
+		return;
+	}
+
+	{
+		double *zr = scratch;
+		double *zi = scratch + half;
+
+		for(j=0;j<half;j++){
+			zr[j] = signal[2*j];
+			zi[j] = signal[2*j+1];
+		}
+
+		plan_execute(rplan->half, zr, zi, zi + half);
+
+		/*post-twiddle terms of rfft_post_spectrum, v = 2*X(k)*/
+		features_bin(features, acc, 0, 2*(zr[0] + zi[0]), 0);
+		features_bin(features, acc, half, 2*(zr[0] - zi[0]), 0);
+
+		for(k=1;k<=half/2;k++){
+			size_t nk = half-k;
+			double er = zr[k]+zr[nk];
+			double ei = zi[k]-zi[nk];
+			double or = zi[k]+zi[nk];
+			double oi = -(zr[k]-zr[nk]);
+			double c = rplan->tw_cos[k];
+			double s = rplan->tw_sin[k];
+			double tr = or*c + oi*s;
+			double ti = oi*c - or*s;
+
+			features_bin(features, acc, k, er + tr, ei + ti);
+			if(nk != k)
+				features_bin(features, acc, nk, er - tr, -(ei - ti));
+		}
+	}
+}
@@ -0,0 +1,507 @@
+/**
+ * @file fft_fixed.c
+ * @brief Fixed-point transforms for the targets without a double-precision FPU:
+ *        power-of-2 FFT over Q15 or Q31 samples, and Goertzel over an interval of bins.
+ *
+ *        Both run in block floating point: a block of integers shares one exponent, the
+ *        block is shifted right only when it would overflow, and the caller gets the
+ *        result as integers and the exponent, out[k]*2^exponent. The transform shifts
+ *        between its stages as needed, Goertzel as its states grow. The hot loops only
+ *        use integer additions, multiplications and shifts. The tables are computed with
+ *        cos() and sin() when the plans are created.
+ *
+ *        The samples are the raw integers of the ADC, so that out[k]*2^exponent is
+ *        what abs_fft or abs_dft_interval return for the same samples as doubles.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fft.h"
+#include "fft_internal.h"
+
+/*Goertzel: states below 2^60, so that s(t) = x(t) + coef*s(t-1) - s(t-2) stays within 63 bits*/
+#define GOERTZEL_LIMIT_BITS 60
+/*Goertzel: samples normalized below 2^31 at the start*/
+#define GOERTZEL_SAMPLE_BITS 31
+/*Goertzel: real and imaginary parts of the bins below 2^29, the magnitudes scaled by 2/n stay below 2^31*/
+#define GOERTZEL_OUT_BITS 29
+
+/*fractional bits of the Q15 magnitudes: |X| < 2^15 once normalized, 2^30 once scaled*/
+#define Q15_MAG_SHIFT 15
+
+/**
+ * struct fft_fixed_plan_s
+ * @brief tables and work vectors of a fixed-point transform of length n = 2^levels,
+ *        the work vectors written by every call
+ */
+struct fft_fixed_plan_s{
+
+	size_t n;
+	int levels;
+	size_t *bitrev;
+
+	/*cos/sin(2*pi*i/n) for i < n/2, in Q15 and Q31*/
+	int16_t *cos_q15;
+	int16_t *sin_q15;
+	int32_t *cos_q31;
+	int32_t *sin_q31;
+
+	/*real parts then imaginary parts, n values each*/
+	int16_t *work_q15;
+	int32_t *work_q31;
+};
+
+/*
+ * Goertzel coefficients of a bin w = 2*pi*k/n. Near w = 0 and w = pi, the bins that
+ * have the largest states, a rounding of 2*cos(w) to a fixed number of bits would move
+ * the bin by about 2^-bits/sin(w). So 2*cos(w) is written sign*(2 - delta), where
+ * delta = 2*(1 - |cos(w)|) is computed as 4*sin(w/2)^2 (or 4*cos(w/2)^2) and kept as a
+ * 31-bit mantissa and a shift: its relative precision does not depend on w.
+ */
+typedef struct goertzel_bin_s{
+	int sign;            /*+1 if cos(w) >= 0, -1 otherwise*/
+	int64_t delta;       /*delta*2^delta_shift, in [2^30, 2^31] unless delta is 0*/
+	int delta_shift;
+	int64_t sine;        /*sin(w)*2^sine_shift, same format*/
+	int sine_shift;
+} goertzel_bin_t;
+
+/**
+ * struct dft_interval_fixed_plan_s
+ * @brief Goertzel coefficients of the bins of an interval
+ */
+struct dft_interval_fixed_plan_s{
+
+	int n;
+	int nb_bins;
+	goertzel_bin_t *bins;
+
+	/*magnitude and exponent of each bin before they are given a common exponent*/
+	int32_t *mag;
+	int *exponent;
+};
+
+static int fixed_bit_length(int64_t v);
+static int64_t fixed_round_shift64(int64_t v, int s);
+static int64_t fixed_mul_shift(int64_t c, int64_t v, int shift);
+static void fixed_mantissa(double v, int64_t *mantissa, int *shift);
+static uint64_t fixed_isqrt(uint64_t v);
+static int64_t fixed_quantize(double v, int frac_bits, int64_t max);
+
+#define FIXED_T int16_t
+#define FIXED_WIDE int32_t
+#define FIXED_FRAC 15
+#define FIXED_HEADROOM 13
+#define FIXED_MAG_SHIFT Q15_MAG_SHIFT
+#define FIXED_Q(name) name##_q15
+#include "fft_fixed_template.h"
+#undef FIXED_T
+#undef FIXED_WIDE
+#undef FIXED_FRAC
+#undef FIXED_HEADROOM
+#undef FIXED_MAG_SHIFT
+#undef FIXED_Q
+
+#define FIXED_T int32_t
+#define FIXED_WIDE int64_t
+#define FIXED_FRAC 31
+#define FIXED_HEADROOM 29
+#define FIXED_MAG_SHIFT 0
+#define FIXED_Q(name) name##_q31
+#include "fft_fixed_template.h"
+#undef FIXED_T
+#undef FIXED_WIDE
+#undef FIXED_FRAC
+#undef FIXED_HEADROOM
+#undef FIXED_MAG_SHIFT
+#undef FIXED_Q
+
+/**
+ * fft_fixed_plan_t* fft_fixed_plan_create(size_t n)
+ *
+ * @brief creates a plan for the fixed-point transforms of length n.
+ * @param n, a power of 2, the other lengths are not supported (radix-2 stages only)
+ * @return the plan, NULL if n is not a power of 2 or if out of memory
+ */
+fft_fixed_plan_t* fft_fixed_plan_create(size_t n){
+	FFT_STATS_ENTRY(FFT_STATS_PLAN_CREATE);
+
+	fft_fixed_plan_t *plan;
+	size_t half = n/2;
+	size_t i;
+
+	if(n == 0 || (n & (n - 1)) != 0 || n > SIZE_MAX/(2*sizeof(int32_t)))
+		return NULL;
+
+	plan = (fft_fixed_plan_t*)calloc(1, sizeof(fft_fixed_plan_t));
+	if(plan == NULL)
+		return NULL;
+
+	plan->n = n;
+	while(((size_t)1 << plan->levels) < n)
+		plan->levels++;
+
+	/*half+1 entries in the tables, so that n = 1 gets valid pointers*/
+	plan->bitrev = (size_t*)fft_malloc(n*sizeof(size_t));
+	plan->cos_q15 = (int16_t*)fft_malloc((half+1)*sizeof(int16_t));
+	plan->sin_q15 = (int16_t*)fft_malloc((half+1)*sizeof(int16_t));
+	plan->cos_q31 = (int32_t*)fft_malloc((half+1)*sizeof(int32_t));
+	plan->sin_q31 = (int32_t*)fft_malloc((half+1)*sizeof(int32_t));
+	plan->work_q15 = (int16_t*)fft_malloc(2*n*sizeof(int16_t));
+	plan->work_q31 = (int32_t*)fft_malloc(2*n*sizeof(int32_t));
+	if(plan->bitrev == NULL || plan->cos_q15 == NULL || plan->sin_q15 == NULL
+			|| plan->cos_q31 == NULL || plan->sin_q31 == NULL
+			|| plan->work_q15 == NULL || plan->work_q31 == NULL){
+		fft_fixed_plan_destroy(plan);
+		return NULL;
+	}
+
+	for(i=0;i<n;i++){
+		size_t x = i, r = 0;
+		int b;
+		for(b=0;b<plan->levels;b++, x >>= 1)
+			r = (r << 1) | (x & 1);
+		plan->bitrev[i] = r;
+	}
+
+	for(i=0;i<half;i++){
+		double c = cos(2*M_PI*i/n);
+		double s = sin(2*M_PI*i/n);
+		plan->cos_q15[i] = (int16_t)fixed_quantize(c, 15, INT16_MAX);
+		plan->sin_q15[i] = (int16_t)fixed_quantize(s, 15, INT16_MAX);
+		plan->cos_q31[i] = (int32_t)fixed_quantize(c, 31, INT32_MAX);
+		plan->sin_q31[i] = (int32_t)fixed_quantize(s, 31, INT32_MAX);
+	}
+
+	return plan;
+}
+
+/**
+ * void fft_fixed_plan_destroy(fft_fixed_plan_t* plan)
+ *
+ * @brief releases the memory held by a plan. NULL is accepted.
+ */
+void fft_fixed_plan_destroy(fft_fixed_plan_t* plan){
+
+	if(plan == NULL)
+		return;
+
+	free(plan->bitrev);
+	free(plan->cos_q15);
+	free(plan->sin_q15);
+	free(plan->cos_q31);
+	free(plan->sin_q31);
+	free(plan->work_q15);
+	free(plan->work_q31);
+	free(plan);
+}
+
+/**
+ * int transform_q15(fft_fixed_plan_t* plan, int16_t real[], int16_t imag[], int* exponent)
+ *
+ * @brief computes the DFT of the complex vector in place, in block floating point.
+ * @param real, imag, complex vector of length n, replaced by X(k) = (real[k] + j*imag[k])*2^(*exponent)
+ * @param exponent (out), the exponent of the result
+ * @return 1 if success, 0 otherwise
+ */
+int transform_q15(fft_fixed_plan_t* plan, int16_t real[], int16_t imag[], int* exponent){
+	FFT_STATS_ENTRY(FFT_STATS_TRANSFORM_FIXED);
+
+	int16_t *re = plan->work_q15;
+	int16_t *im = re + plan->n;
+
+	*exponent = load_normalized_q15(real, imag, re, im, plan->n, plan->bitrev);
+	radix2_stages_bfp_q15(re, im, plan->n, plan->cos_q15, plan->sin_q15, exponent);
+	memcpy(real, re, plan->n*sizeof(int16_t));
+	memcpy(imag, im, plan->n*sizeof(int16_t));
+	return 1;
+}
+
+/**
+ * int transform_q31(fft_fixed_plan_t* plan, int32_t real[], int32_t imag[], int* exponent)
+ *
+ * @brief same as transform_q15 over 32-bit values.
+ * @return 1 if success, 0 otherwise
+ */
+int transform_q31(fft_fixed_plan_t* plan, int32_t real[], int32_t imag[], int* exponent){
+	FFT_STATS_ENTRY(FFT_STATS_TRANSFORM_FIXED);
+
+	int32_t *re = plan->work_q31;
+	int32_t *im = re + plan->n;
+
+	*exponent = load_normalized_q31(real, imag, re, im, plan->n, plan->bitrev);
+	radix2_stages_bfp_q31(re, im, plan->n, plan->cos_q31, plan->sin_q31, exponent);
+	memcpy(real, re, plan->n*sizeof(int32_t));
+	memcpy(imag, im, plan->n*sizeof(int32_t));
+	return 1;
+}
+
+/**
+ * int abs_fft_q15(fft_fixed_plan_t* plan, const int16_t* signal, int32_t* abs_onesided_fft, int* exponent)
+ *
+ * @brief fixed-point abs_fft: abs value of the one-sided fft of the signal, 2*|X(k)|/n.
+ * @param signal (in), the n-long signal
+ * @param abs_onesided_fft (out), n/2+1 values, abs_fft(signal)[k] = abs_onesided_fft[k]*2^(*exponent)
+ * @param exponent (out), the exponent of the result
+ * @return 1 if success, 0 otherwise
+ */
+int abs_fft_q15(fft_fixed_plan_t* plan, const int16_t* signal, int32_t* abs_onesided_fft, int* exponent){
+	FFT_STATS_ENTRY(FFT_STATS_TRANSFORM_FIXED);
+
+	int16_t *re = plan->work_q15;
+	int16_t *im = re + plan->n;
+	int e = load_normalized_q15(signal, NULL, re, im, plan->n, plan->bitrev);
+
+	radix2_stages_bfp_q15(re, im, plan->n, plan->cos_q15, plan->sin_q15, &e);
+	magnitudes_q15(re, im, plan->n/2+1, abs_onesided_fft);
+
+	/*2*|X|/n, n = 2^levels*/
+	*exponent = e + 1 - plan->levels - Q15_MAG_SHIFT;
+	return 1;
+}
+
+/**
+ * int abs_fft_q31(fft_fixed_plan_t* plan, const int32_t* signal, int32_t* abs_onesided_fft, int* exponent)
+ *
+ * @brief same as abs_fft_q15 over 32-bit samples.
+ * @return 1 if success, 0 otherwise
+ */
+int abs_fft_q31(fft_fixed_plan_t* plan, const int32_t* signal, int32_t* abs_onesided_fft, int* exponent){
+	FFT_STATS_ENTRY(FFT_STATS_TRANSFORM_FIXED);
+
+	int32_t *re = plan->work_q31;
+	int32_t *im = re + plan->n;
+	int e = load_normalized_q31(signal, NULL, re, im, plan->n, plan->bitrev);
+
+	radix2_stages_bfp_q31(re, im, plan->n, plan->cos_q31, plan->sin_q31, &e);
+	magnitudes_q31(re, im, plan->n/2+1, abs_onesided_fft);
+
+	*exponent = e + 1 - plan->levels;
+	return 1;
+}
+
+/**
+ * dft_interval_fixed_plan_t* dft_interval_fixed_plan_create(int n, int interval_start, int interval_stop)
+ *
+ * @brief precomputes the fixed-point Goertzel coefficients of the bins [interval_start, interval_stop)
+ *        for an n-long signal.
+ * @return the plan, NULL if out of memory or if the interval is empty
+ */
+dft_interval_fixed_plan_t* dft_interval_fixed_plan_create(int n, int interval_start, int interval_stop){
+
+	dft_interval_fixed_plan_t *plan;
+	int k;
+
+	if(n <= 0 || interval_stop <= interval_start)
+		return NULL;
+
+	plan = (dft_interval_fixed_plan_t*)calloc(1, sizeof(dft_interval_fixed_plan_t));
+	if(plan == NULL)
+		return NULL;
+
+	plan->n = n;
+	plan->nb_bins = interval_stop - interval_start;
+	plan->bins = (goertzel_bin_t*)malloc(plan->nb_bins*sizeof(goertzel_bin_t));
+	plan->mag = (int32_t*)malloc(plan->nb_bins*sizeof(int32_t));
+	plan->exponent = (int*)malloc(plan->nb_bins*sizeof(int));
+	if(plan->bins == NULL || plan->mag == NULL || plan->exponent == NULL){
+		dft_interval_fixed_plan_destroy(plan);
+		return NULL;
+	}
+
+	for(k=0;k<plan->nb_bins;k++){
+		goertzel_bin_t *bin = plan->bins + k;
+		double w = 2*M_PI*(interval_start+k)/n;
+		double half_sin = sin(w/2);
+		double half_cos = cos(w/2);
+
+		/*1 - cos(w) = 2*sin(w/2)^2 and 1 + cos(w) = 2*cos(w/2)^2, without cancellation*/
+		bin->sign = (cos(w) >= 0) ? 1 : -1;
+		fixed_mantissa((bin->sign > 0) ? 4*half_sin*half_sin : 4*half_cos*half_cos,
+		               &bin->delta, &bin->delta_shift);
+		fixed_mantissa(sin(w), &bin->sine, &bin->sine_shift);
+	}
+
+	return plan;
+}
+
+/**
+ * void dft_interval_fixed_plan_destroy(dft_interval_fixed_plan_t* plan)
+ *
+ * @brief releases the memory held by a plan. NULL is accepted.
+ */
+void dft_interval_fixed_plan_destroy(dft_interval_fixed_plan_t* plan){
+
+	if(plan == NULL)
+		return;
+
+	free(plan->bins);
+	free(plan->mag);
+	free(plan->exponent);
+	free(plan);
+}
+
+/*
+ * Gives the bins of the interval the largest of their exponents and scales
+ * them by 2/n, as goertzel_abs does: out[k]*2^(*exponent) = 2*mag[k]*2^exponent[k]/n.
+ */
+static void dft_interval_fixed_store(const dft_interval_fixed_plan_t* plan, int32_t *out, int *exponent){
+
+	int n = plan->n;
+	int common = 0;
+	int found = 0;
+	int sh = 0;
+	int k;
+
+	for(k=0;k<plan->nb_bins;k++){
+		if(plan->mag[k] != 0 && (!found || plan->exponent[k] > common)){
+			common = plan->exponent[k];
+			found = 1;
+		}
+	}
+
+	/*2^sh/n in [1, 2): the magnitudes stay below 2^31*/
+	while(((int64_t)1 << sh) < n)
+		sh++;
+
+	for(k=0;k<plan->nb_bins;k++){
+		int64_t m = fixed_round_shift64(plan->mag[k], common - plan->exponent[k]);
+		out[k] = (int32_t)(((m << sh) + n/2)/n);
+	}
+
+	*exponent = common + 1 - sh;
+}
+
+/**
+ * void abs_dft_interval_q15(dft_interval_fixed_plan_t* plan, const int16_t* signal,
+ *                           int32_t* abs_power_interval, int* exponent)
+ *
+ * @brief fixed-point abs_dft_interval_plan: 2*|X(k)|/n for the bins of the plan, with the
+ *        Goertzel recurrence in block floating point.
+ * @param signal (in), the n-long signal
+ * @param abs_power_interval (out), one value per bin, abs_dft_interval(signal)[k] = abs_power_interval[k]*2^(*exponent)
+ * @param exponent (out), the exponent of the result
+ */
+void abs_dft_interval_q15(dft_interval_fixed_plan_t* plan, const int16_t* signal,
+                          int32_t* abs_power_interval, int* exponent){
+	FFT_STATS_ENTRY(FFT_STATS_ABS_DFT_INTERVAL_FIXED);
+
+	int e = goertzel_exponent_q15(signal, plan->n);
+	int k;
+
+	for(k=0;k<plan->nb_bins;k++){
+		int32_t re, im;
+		goertzel_bfp_q15(signal, plan->n, e, plan->bins + k, &re, &im, plan->exponent + k);
+		plan->mag[k] = (int32_t)fixed_isqrt((uint64_t)((int64_t)re*re + (int64_t)im*im));
+	}
+
+	dft_interval_fixed_store(plan, abs_power_interval, exponent);
+}
+
+/**
+ * void abs_dft_interval_q31(dft_interval_fixed_plan_t* plan, const int32_t* signal,
+ *                           int32_t* abs_power_interval, int* exponent)
+ *
+ * @brief same as abs_dft_interval_q15 over 32-bit samples.
+ */
+void abs_dft_interval_q31(dft_interval_fixed_plan_t* plan, const int32_t* signal,
+                          int32_t* abs_power_interval, int* exponent){
+	FFT_STATS_ENTRY(FFT_STATS_ABS_DFT_INTERVAL_FIXED);
+
+	int e = goertzel_exponent_q31(signal, plan->n);
+	int k;
+
+	for(k=0;k<plan->nb_bins;k++){
+		int32_t re, im;
+		goertzel_bfp_q31(signal, plan->n, e, plan->bins + k, &re, &im, plan->exponent + k);
+		plan->mag[k] = (int32_t)fixed_isqrt((uint64_t)((int64_t)re*re + (int64_t)im*im));
+	}
+
+	dft_interval_fixed_store(plan, abs_power_interval, exponent);
+}
+
+/*
+ * Number of bits of v > 0, floor(log2(v)) + 1.
+ */
+static int fixed_bit_length(int64_t v){
+
+	int bits = 0;
+
+	while(v != 0){
+		v >>= 1;
+		bits++;
+	}
+	return bits;
+}
+
+/*
+ * v/2^s rounded to the nearest, s >= 0, 0 when the shift is over the width of v.
+ */
+static int64_t fixed_round_shift64(int64_t v, int s){
+
+	if(s <= 0)
+		return v;
+	if(s >= 63)
+		return 0;
+	return (v + ((int64_t)1 << (s-1))) >> s;
+}
+
+/*
+ * c*v/2^shift rounded, for |c| <= 2^31, |v| < 2^61 and shift >= 30: v is split in
+ * 31 high bits and 30 low bits, two 32x32->64 products instead of a 128-bit one.
+ */
+static int64_t fixed_mul_shift(int64_t c, int64_t v, int shift){
+
+	int64_t hi = v >> 30;
+	int64_t lo = v & (((int64_t)1 << 30) - 1);
+
+	return fixed_round_shift64(c*hi + ((c*lo + ((int64_t)1 << 29)) >> 30), shift - 30);
+}
+
+/*
+ * v = mantissa*2^-shift, |mantissa| in [2^30, 2^31] and shift in [30, 61], or a mantissa of 0 for v = 0.
+ */
+static void fixed_mantissa(double v, int64_t *mantissa, int *shift){
+
+	*shift = 30;
+	while(*shift < 61 && fabs(ldexp(v, *shift + 1)) <= ldexp(1, 31))
+		(*shift)++;
+	*mantissa = (int64_t)floor(ldexp(v, *shift) + 0.5);
+}
+
+/*
+ * floor(sqrt(v)), bit by bit. The test is turned into a mask: the magnitudes are noise
+ * to the branch predictor, and the loop runs once per bit of the result.
+ */
+static uint64_t fixed_isqrt(uint64_t v){
+
+	uint64_t result = 0;
+	uint64_t bit = (uint64_t)1 << 62;
+
+	while(bit > v)
+		bit >>= 2;
+
+	while(bit != 0){
+		uint64_t t = result + bit;
+		uint64_t mask = (uint64_t)0 - (uint64_t)(v >= t);
+		v -= t & mask;
+		result = (result >> 1) + (bit & mask);
+		bit >>= 2;
+	}
+	return result;
+}
+
+/*
+ * round(v*2^frac_bits), clamped to [-max-1, max] (1.0 does not fit in Q15 or Q31).
+ */
+static int64_t fixed_quantize(double v, int frac_bits, int64_t max){
+
+	double q = floor(ldexp(v, frac_bits) + 0.5);
+
+	if(q > (double)max)
+		return max;
+	if(q < -(double)max - 1)
+		return -max - 1;
+	return (int64_t)q;
+}
@@ -0,0 +1,234 @@
+/**
+ * @file fft_fixed_template.h
+ * @brief Block-floating-point kernels of fft_fixed.c, generic over the width of the samples.
+ *
+ *        Not a public header: fft_fixed.c includes it once per format, after defining
+ *          FIXED_T          type of the samples and of the twiddles (int16_t, int32_t)
+ *          FIXED_WIDE       type of the products (int32_t, int64_t)
+ *          FIXED_FRAC       fractional bits of the twiddles (15, 31)
+ *          FIXED_HEADROOM   the inputs of a stage are kept below 2^FIXED_HEADROOM: a radix-2
+ *                           butterfly grows a component by at most 1+sqrt(2), so the outputs
+ *                           still fit in FIXED_T
+ *          FIXED_MAG_SHIFT  extra fractional bits of the magnitudes, as many as fit in 31 bits
+ *          FIXED_Q(name)    the name of a function for this format (name##_q15)
+ *
+ *        A block of values v[i] stands for v[i]*2^exponent, with one exponent for the block.
+ */
+
+#include <stdint.h>
+
+/*
+ * v/2^s rounded to the nearest, s >= 0.
+ */
+static inline FIXED_WIDE FIXED_Q(round_shift)(FIXED_WIDE v, int s){
+	return (s > 0) ? (v + ((FIXED_WIDE)1 << (s-1))) >> s : v;
+}
+
+/*
+ * max(max, |v|).
+ */
+static inline FIXED_WIDE FIXED_Q(max_abs)(FIXED_WIDE max, FIXED_WIDE v){
+	if(v < 0)
+		v = -v;
+	return (v > max) ? v : max;
+}
+
+/*
+ * Smallest s >= 0 such that max/2^s < 2^FIXED_HEADROOM.
+ */
+static inline int FIXED_Q(headroom_shift)(int64_t max){
+
+	int s = 0;
+
+	while((max >> s) >= ((int64_t)1 << FIXED_HEADROOM))
+		s++;
+	return s;
+}
+
+/*
+ * Copies the samples to re/im in bit-reversed order, scaled by 2^-exponent so that the
+ * largest one lies in [2^(FIXED_HEADROOM-1), 2^FIXED_HEADROOM]. imag can be NULL for a
+ * real signal. Returns the exponent, 0 for an all-zero block.
+ */
+static inline int FIXED_Q(load_normalized)(const FIXED_T *real, const FIXED_T *imag,
+                                           FIXED_T *re, FIXED_T *im, size_t n, const size_t *bitrev){
+
+	int64_t max = 0;
+	int exponent = 0;
+	size_t i;
+
+	for(i=0;i<n;i++){
+		int64_t a = real[i] < 0 ? -(int64_t)real[i] : real[i];
+		if(a > max)
+			max = a;
+		if(imag != NULL){
+			a = imag[i] < 0 ? -(int64_t)imag[i] : imag[i];
+			if(a > max)
+				max = a;
+		}
+	}
+
+	if(max > 0)
+		exponent = fixed_bit_length(max) - FIXED_HEADROOM;
+
+	for(i=0;i<n;i++){
+		int64_t vr = real[bitrev[i]];
+		int64_t vi = (imag != NULL) ? imag[bitrev[i]] : 0;
+		if(exponent >= 0){
+			re[i] = (FIXED_T)((exponent > 0) ? (vr + ((int64_t)1 << (exponent-1))) >> exponent : vr);
+			im[i] = (FIXED_T)((exponent > 0) ? (vi + ((int64_t)1 << (exponent-1))) >> exponent : vi);
+		}else{
+			re[i] = (FIXED_T)(vr * ((int64_t)1 << -exponent));
+			im[i] = (FIXED_T)(vi * ((int64_t)1 << -exponent));
+		}
+	}
+
+	return exponent;
+}
+
+/*
+ * Radix-2 decimation in time over bit-reversed data, the loop of radix2_stages in block
+ * floating point. The outputs of a stage are scanned as they are written, and if the
+ * largest is too big for the next stage, the whole block is shifted right while it is
+ * read by the next stage: one pass per stage, and the shifts are added to *exponent.
+ */
+static inline void FIXED_Q(radix2_stages_bfp)(FIXED_T re[], FIXED_T im[], size_t n,
+                                              const FIXED_T *cos_table, const FIXED_T *sin_table,
+                                              int *exponent){
+
+	const FIXED_WIDE half = (FIXED_WIDE)1 << (FIXED_FRAC-1);
+	size_t size, i;
+	int shift = 0;
+
+	for (size = 2; size <= n; size *= 2) {
+		size_t halfsize = size / 2;
+		size_t tablestep = n / size;
+		FIXED_WIDE max = 0;
+
+		for (i = 0; i < n; i += size) {
+			size_t j;
+			size_t k;
+			for (j = i, k = 0; j < i + halfsize; j++, k += tablestep) {
+				FIXED_WIDE ar = FIXED_Q(round_shift)(re[j], shift);
+				FIXED_WIDE ai = FIXED_Q(round_shift)(im[j], shift);
+				FIXED_WIDE br = FIXED_Q(round_shift)(re[j+halfsize], shift);
+				FIXED_WIDE bi = FIXED_Q(round_shift)(im[j+halfsize], shift);
+				FIXED_WIDE tpre, tpim;
+
+				/*the first twiddle is 1, exactly*/
+				if (k == 0) {
+					tpre = br;
+					tpim = bi;
+				} else {
+					tpre = ( br * cos_table[k] + bi * sin_table[k] + half) >> FIXED_FRAC;
+					tpim = (-br * sin_table[k] + bi * cos_table[k] + half) >> FIXED_FRAC;
+				}
+
+				re[j + halfsize] = (FIXED_T)(ar - tpre);
+				im[j + halfsize] = (FIXED_T)(ai - tpim);
+				re[j] = (FIXED_T)(ar + tpre);
+				im[j] = (FIXED_T)(ai + tpim);
+				max = FIXED_Q(max_abs)(max, ar - tpre);
+				max = FIXED_Q(max_abs)(max, ai - tpim);
+				max = FIXED_Q(max_abs)(max, ar + tpre);
+				max = FIXED_Q(max_abs)(max, ai + tpim);
+			}
+		}
+
+		*exponent += shift;
+		shift = FIXED_Q(headroom_shift)(max);
+		if (size == n)  // Prevent overflow in 'size *= 2', the last outputs are not shifted
+			break;
+	}
+}
+
+/*
+ * |re[k] + j*im[k]|*2^FIXED_MAG_SHIFT, floored, for k in [0, count).
+ */
+static inline void FIXED_Q(magnitudes)(const FIXED_T *re, const FIXED_T *im, size_t count, int32_t *out){
+
+	size_t k;
+
+	for(k=0;k<count;k++){
+		uint64_t p = (uint64_t)((int64_t)re[k]*re[k] + (int64_t)im[k]*im[k]);
+		out[k] = (int32_t)fixed_isqrt(p << (2*FIXED_MAG_SHIFT));
+	}
+}
+
+/*
+ * Goertzel recurrence of goertzel_abs in block floating point, with the samples scaled
+ * by 2^-exponent. The states are 64-bit: at the low bins they grow as n^2*max|x|, and
+ * they are kept below 2^GOERTZEL_LIMIT_BITS by shifting them right (and the next samples
+ * with them) when s(t) reaches it. Writes X = (*re + j*(*im))*2^(*exponent), up to a phase,
+ * with |re|, |im| < 2^GOERTZEL_OUT_BITS. 2*cos(w) is applied as sign*(2 - delta), see
+ * goertzel_bin_t.
+ */
+static inline void FIXED_Q(goertzel_bfp)(const FIXED_T *signal, int n, int exponent,
+                                         const goertzel_bin_t *bin,
+                                         int32_t *re, int32_t *im, int *out_exponent){
+
+	const int64_t limit = (int64_t)1 << GOERTZEL_LIMIT_BITS;
+	int64_t s1 = 0, s2 = 0;
+	int64_t vr, vi;
+	int t, r;
+
+	for(t=0;t<n;t++){
+
+		int64_t x = signal[t];
+		int64_t s0;
+
+		if(exponent > 0)
+			x = fixed_round_shift64(x, exponent);
+		else
+			x *= (int64_t)1 << -exponent;
+
+		s0 = 2*s1 - fixed_mul_shift(bin->delta, s1, bin->delta_shift);
+		s0 = x + (bin->sign > 0 ? s0 : -s0) - s2;
+
+		/*rare: at most once per bit of growth of the states over 2^GOERTZEL_LIMIT_BITS*/
+		if(s0 >= limit || s0 <= -limit){
+			r = 0;
+			while((s0 >> r) >= limit || (s0 >> r) <= -limit)
+				r++;
+			s0 = fixed_round_shift64(s0, r);
+			s1 = fixed_round_shift64(s1, r);
+			exponent += r;
+		}
+
+		s2 = s1;
+		s1 = s0;
+	}
+
+	/*cos(w) = sign*(1 - delta/2)*/
+	vr = s2 - fixed_mul_shift(bin->delta, s2, bin->delta_shift + 1);
+	vr = s1 - (bin->sign > 0 ? vr : -vr);
+	vi = fixed_mul_shift(bin->sine, s2, bin->sine_shift);
+
+	/*down to 32 bits for the magnitude*/
+	r = 0;
+	while(((vr < 0 ? -vr : vr) >> r) >= ((int64_t)1 << GOERTZEL_OUT_BITS)
+			|| ((vi < 0 ? -vi : vi) >> r) >= ((int64_t)1 << GOERTZEL_OUT_BITS))
+		r++;
+
+	*re = (int32_t)fixed_round_shift64(vr, r);
+	*im = (int32_t)fixed_round_shift64(vi, r);
+	*out_exponent = exponent + r;
+}
+
+/*
+ * Exponent that scales the largest sample of an n-long signal to [2^(GOERTZEL_SAMPLE_BITS-1), 2^GOERTZEL_SAMPLE_BITS).
+ */
+static inline int FIXED_Q(goertzel_exponent)(const FIXED_T *signal, int n){
+
+	int64_t max = 0;
+	int t;
+
+	for(t=0;t<n;t++){
+		int64_t a = signal[t] < 0 ? -(int64_t)signal[t] : signal[t];
+		if(a > max)
+			max = a;
+	}
+	if(max == 0)
+		return 0;
+	return fixed_bit_length(max) - GOERTZEL_SAMPLE_BITS;
+}
@@ -0,0 +1,661 @@
+/**
+ * @file fft_float.c
+ * @brief Single precision plans and wrappers. The plans are built as in
+ *        fft_plan.c, with the tables computed in double and rounded to float,
+ *        and executed with the float instance of the kernels of fft_template.h,
+ *        the same code as the double transforms. Half the memory traffic of the
+ *        double plans, for signals which do not need more than 24 bits.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fft.h"
+#include "fft_internal.h"
+
+#define FFT_REAL float
+#define FFT_SQRT sqrtf
+#define FFT_T(name) name##_f
+#include "fft_template.h"
+
+static int plan_f_init_radix2(fft_plan_f_t *plan);
+static int plan_f_init_mixed(fft_plan_f_t *plan);
+static int plan_f_init_bluestein(fft_plan_f_t *plan);
+static void plan_f_execute(const fft_plan_f_t *plan, float real[], float imag[], float *scratch);
+static void radix2_execute_f(const fft_plan_f_t *plan, float real[], float imag[]);
+static void bluestein_execute_f(const fft_plan_f_t *plan, float real[], float imag[], float *scratch);
+static int fft_2signals_work_f(const fft_plan_f_t *plan, float *work,
+                               const float *signal_1, const float *signal_2,
+                               float *X1_real, float *X1_imag, float *X2_real, float *X2_imag);
+static int spectrum_work_f(const fft_plan_f_t *plan, float *work, const float *signal, int mode, float *out);
+static int spectrum_2signals_work_f(const fft_plan_f_t *plan, float *work,
+                                    const float *signal_1, const float *signal_2, int mode,
+                                    float *out_1, float *out_2);
+static size_t work_f_length(size_t n);
+
+/**
+ * fft_plan_f_t* fft_plan_f_create(size_t n, int inverse)
+ *
+ * @brief same as fft_plan_create, in single precision.
+ * @param n, the length of the transform, any length is supported.
+ * @param inverse, 1 for the inverse transform (unscaled), FFT_INVERSE_SCALED for the inverse
+ *        transform scaled by 1/n, 0 for the forward transform
+ * @return the plan, NULL if out of memory
+ */
+fft_plan_f_t* fft_plan_f_create(size_t n, int inverse){
+
+	/*forward plans of even length also carry the real-input transform*/
+	int flags = PLAN_WITH_WORK;
+	if(!inverse)
+		flags |= PLAN_WITH_REAL;
+
+	return plan_f_create(n, inverse, flags);
+}
+
+/**
+ * void fft_plan_f_destroy(fft_plan_f_t* plan)
+ *
+ * @brief releases the memory held by a plan. NULL is accepted.
+ */
+void fft_plan_f_destroy(fft_plan_f_t* plan){
+
+	if(plan == NULL)
+		return;
+
+	fft_plan_f_destroy(plan->sub);
+	fft_plan_f_destroy(plan->half);
+	free(plan->work);
+	free(plan->rtw_cos);
+	free(plan->rtw_sin);
+	free(plan->bfft_imag);
+	free(plan->bfft_real);
+	free(plan->chirp_sin);
+	free(plan->chirp_cos);
+	free(plan->bitrev);
+	free(plan->tw_real);
+	free(plan->tw_imag);
+	free(plan->sin_table);
+	free(plan->cos_table);
+	free(plan);
+}
+
+/**
+ * size_t fft_plan_f_length(const fft_plan_f_t* plan)
+ *
+ * @brief returns the length of the transform computed by the plan.
+ */
+size_t fft_plan_f_length(const fft_plan_f_t* plan){
+	return plan->n;
+}
+
+/**
+ * int transform_plan_f(fft_plan_f_t* plan, float real[], float imag[])
+ *
+ * @brief same as transform_plan, in single precision.
+ * @return 1 if success, 0 otherwise
+ */
+int transform_plan_f(fft_plan_f_t* plan, float real[], float imag[]){
+	FFT_STATS_ENTRY(FFT_STATS_TRANSFORM_PLAN_F);
+
+	plan_f_execute(plan, real, imag, plan->work);
+	return 1;
+}
+
+/**
+ * int fft_2signals_plan_f(fft_plan_f_t* plan, ...)
+ *
+ * @brief same as fft_2signals_plan, in single precision.
+ * @return 1 if success, 0 otherwise (inverse plan)
+ */
+int fft_2signals_plan_f(fft_plan_f_t* plan,
+                        const float* signal_1, const float* signal_2,
+                        float* X1_real, float* X1_imag,
+                        float* X2_real, float* X2_imag){
+	return fft_2signals_work_f(plan, plan->work, signal_1, signal_2, X1_real, X1_imag, X2_real, X2_imag);
+}
+
+/*
+ * fft_2signals_plan_f with the work memory of the caller, work_f_length(n) floats.
+ */
+static int fft_2signals_work_f(const fft_plan_f_t *plan, float *work,
+                               const float *signal_1, const float *signal_2,
+                               float *X1_real, float *X1_imag, float *X2_real, float *X2_imag){
+
+	size_t n = plan->n;
+	float *X_real = work;
+	float *X_imag = X_real + n;
+
+	if(plan->inverse)
+		return 0;
+
+	memcpy(X_real, signal_1, n*sizeof(float));
+	memcpy(X_imag, signal_2, n*sizeof(float));
+
+	/*Compute the fourier transform of the two signals at once*/
+	plan_f_execute(plan, X_real, X_imag, X_imag + n);
+
+	/*compute the split operation to recover X1(k) and X2(k)*/
+	split_spectra_f(X_real, X_imag, X1_real, X1_imag, X2_real, X2_imag, n);
+
+	return 1;
+}
+
+/**
+ * int spectrum_plan_f(fft_plan_f_t* plan, const float* signal, int mode, float* out)
+ *
+ * @brief same as spectrum_plan, in single precision.
+ * @return 1 if success, 0 otherwise (inverse plan, unknown mode)
+ */
+int spectrum_plan_f(fft_plan_f_t* plan,
+                    const float* signal, int mode,
+                    float* out){
+	FFT_STATS_ENTRY(FFT_STATS_SPECTRUM_PLAN_F);
+	return spectrum_work_f(plan, plan->work, signal, mode, out);
+}
+
+/*
+ * spectrum_plan_f with the work memory of the caller, work_f_length(n) floats.
+ */
+static int spectrum_work_f(const fft_plan_f_t *plan, float *work, const float *signal, int mode, float *out){
+
+	size_t n = plan->n;
+	size_t half = n/2;
+	float *real = work;
+	float *imag = real + n;
+	size_t j;
+
+	if(plan->inverse || n == 0 || fft_output_length(n, mode) == 0)
+		return 0;
+
+	/*even length: transform of the n/2 packed samples, then post-twiddle and output stage*/
+	if(plan->half != NULL){
+		float *zr = work;
+		float *zi = zr + half;
+
+		for(j=0;j<half;j++){
+			zr[j] = signal[2*j];
+			zi[j] = signal[2*j+1];
+		}
+		plan_f_execute(plan->half, zr, zi, zi + half);
+		rfft_post_spectrum_f(zr, zi, half, plan->rtw_cos, plan->rtw_sin, mode, out);
+		return 1;
+	}
+
+	memcpy(real, signal, n*sizeof(float));
+	memset(imag, 0, n*sizeof(float));
+
+	/*compute the complex fft*/
+	plan_f_execute(plan, real, imag, imag + n);
+
+	/*output stage over the one-sided bins*/
+	spectrum_onesided_f(real, imag, n, mode, out);
+
+	return 1;
+}
+
+/**
+ * int spectrum_2signals_plan_f(fft_plan_f_t* plan, const float* signal_1, const float* signal_2, int mode,
+ *                              float* out_1, float* out_2)
+ *
+ * @brief same as spectrum_2signals_plan, in single precision.
+ * @return 1 if success, 0 otherwise (inverse plan, unknown mode)
+ */
+int spectrum_2signals_plan_f(fft_plan_f_t* plan,
+                             const float* signal_1, const float* signal_2, int mode,
+                             float* out_1, float* out_2){
+	return spectrum_2signals_work_f(plan, plan->work, signal_1, signal_2, mode, out_1, out_2);
+}
+
+/*
+ * spectrum_2signals_plan_f with the work memory of the caller, work_f_length(n) floats.
+ */
+static int spectrum_2signals_work_f(const fft_plan_f_t *plan, float *work,
+                                    const float *signal_1, const float *signal_2, int mode,
+                                    float *out_1, float *out_2){
+
+	size_t n = plan->n;
+	float *X_real = work;
+	float *X_imag = X_real + n;
+
+	if(plan->inverse || n == 0 || fft_output_length(n, mode) == 0)
+		return 0;
+
+	memcpy(X_real, signal_1, n*sizeof(float));
+	memcpy(X_imag, signal_2, n*sizeof(float));
+	plan_f_execute(plan, X_real, X_imag, X_imag + n);
+
+	/*split and output stage in one pass, the split spectra are never stored*/
+	split_spectrum_f(X_real, X_imag, n, mode, out_1, out_2);
+
+	return 1;
+}
+
+/**
+ * int abs_fft_plan_f(fft_plan_f_t* plan, const float* signal, float* abs_onesided_fft)
+ *
+ * @brief same as abs_fft_plan, in single precision.
+ * @return 1 if success, 0 otherwise (inverse plan)
+ */
+int abs_fft_plan_f(fft_plan_f_t* plan,
+                   const float* signal,
+                   float* abs_onesided_fft){
+	return spectrum_plan_f(plan, signal, FFT_OUTPUT_MAGNITUDE, abs_onesided_fft);
+}
+
+/**
+ * int abs_fft_2signals_plan_f(fft_plan_f_t* plan, ...)
+ *
+ * @brief same as abs_fft_2signals_plan, in single precision.
+ * @return 1 if success, 0 otherwise (inverse plan)
+ */
+int abs_fft_2signals_plan_f(fft_plan_f_t* plan,
+                            const float* signal_1, const float* signal_2,
+                            float* X1,
+                            float* X2){
+	return spectrum_2signals_plan_f(plan, signal_1, signal_2, FFT_OUTPUT_MAGNITUDE, X1, X2);
+}
+
+/*
+ * float versions of transform and inverse_transform, any length.
+ * Returns 1 (true) if successful, 0 (false) otherwise (out of memory).
+ */
+int transform_f(float real[], float imag[], size_t n){
+
+	plan_cache_slot_t *slot;
+	const fft_plan_f_t *plan;
+	size_t length = transform_scratch_length(n);
+	float *scratch = NULL;
+	int status = 0;
+
+	if(n == 0)
+		return 1;
+
+	/*the plan is shared through the cache, the scratch memory belongs to the call*/
+	plan = plan_cache_acquire_f(n, 0, 0, &slot);
+	if(plan == NULL)
+		return 0;
+	if(length > 0)
+		scratch = (float*)fft_malloc(length*sizeof(float));
+	if(length == 0 || scratch != NULL){
+		plan_f_execute(plan, real, imag, scratch);
+		status = 1;
+	}
+
+	free(scratch);
+	plan_cache_release_f(slot, plan);
+	return status;
+}
+
+int inverse_transform_f(float real[], float imag[], size_t n){
+	return transform_f(imag, real, n);
+}
+
+/**
+ * int fft_2signals_f(const float* signal_1, const float* signal_2, ..., size_t n)
+ *
+ * @brief float version of fft_2signals.
+ * @return 1 if success, 0 otherwise (out of memory)
+ */
+int fft_2signals_f(const float* signal_1, const float* signal_2,
+                   float* X1_real, float* X1_imag,
+                   float* X2_real, float* X2_imag,
+                   size_t n){
+
+	plan_cache_slot_t *slot;
+	const fft_plan_f_t *plan;
+	float *work;
+	int status = 0;
+
+	if(n == 0)
+		return 1;
+
+	plan = plan_cache_acquire_f(n, 0, 0, &slot);
+	work = (float*)fft_malloc(work_f_length(n)*sizeof(float));
+	if(plan != NULL && work != NULL)
+		status = fft_2signals_work_f(plan, work, signal_1, signal_2, X1_real, X1_imag, X2_real, X2_imag);
+
+	free(work);
+	plan_cache_release_f(slot, plan);
+	return status;
+}
+
+/**
+ * int abs_fft_f(const float* signal, float* abs_onesided_fft, size_t n)
+ *
+ * @brief float version of abs_fft.
+ * @return 1 if success, 0 otherwise (out of memory)
+ */
+int abs_fft_f(const float* signal,
+              float* abs_onesided_fft,
+              size_t n){
+
+	plan_cache_slot_t *slot;
+	const fft_plan_f_t *plan;
+	float *work;
+	int status = 0;
+
+	if(n == 0)
+		return 0;
+
+	/*with the real-input plan for the even lengths*/
+	plan = plan_cache_acquire_f(n, 0, PLAN_WITH_REAL, &slot);
+	work = (float*)fft_malloc(work_f_length(n)*sizeof(float));
+	if(plan != NULL && work != NULL)
+		status = spectrum_work_f(plan, work, signal, FFT_OUTPUT_MAGNITUDE, abs_onesided_fft);
+
+	free(work);
+	plan_cache_release_f(slot, plan);
+	return status;
+}
+
+/**
+ * int abs_fft_2signals_f(const float* signal_1, const float* signal_2, float* X1, float* X2, size_t n)
+ *
+ * @brief float version of abs_fft_2signals.
+ * @return 1 if success, 0 otherwise (out of memory)
+ */
+int abs_fft_2signals_f(const float* signal_1, const float* signal_2,
+                       float* X1,
+                       float* X2,
+                       size_t n){
+
+	plan_cache_slot_t *slot;
+	const fft_plan_f_t *plan;
+	float *work;
+	int status = 0;
+
+	if(n == 0)
+		return 0;
+
+	plan = plan_cache_acquire_f(n, 0, 0, &slot);
+	work = (float*)fft_malloc(work_f_length(n)*sizeof(float));
+	if(plan != NULL && work != NULL)
+		status = spectrum_2signals_work_f(plan, work, signal_1, signal_2, FFT_OUTPUT_MAGNITUDE, X1, X2);
+
+	free(work);
+	plan_cache_release_f(slot, plan);
+	return status;
+}
+
+/*
+ * Floats of the workspace of a plan of length n, the doubles of fft_workspace_size.
+ */
+static size_t work_f_length(size_t n){
+	return fft_workspace_size(n)/sizeof(double);
+}
+
+/*
+ * Builds a plan, same choice of algorithm and flags as plan_create.
+ */
+fft_plan_f_t *plan_f_create(size_t n, int inverse, int flags){
+
+	fft_plan_f_t *plan = (fft_plan_f_t*)calloc(1, sizeof(fft_plan_f_t));
+	int status;
+	size_t k;
+
+	if(plan == NULL)
+		return NULL;
+
+	plan->n = n;
+	plan->inverse = inverse ? 1 : 0;
+	plan->scale = (inverse == FFT_INVERSE_SCALED && n > 0) ? 1.0f/n : 1.0f;
+
+	if(n == 0){
+		plan->kind = FFT_PLAN_NONE;
+		status = 1;
+	}
+	else if((n & (n - 1)) == 0){
+		status = plan_f_init_radix2(plan);
+	}
+	else if(mixed_radix_supported(n)){
+		status = plan_f_init_mixed(plan);
+	}
+	else{
+		status = plan_f_init_bluestein(plan);
+	}
+
+	/*half-length plan and post-twiddles of the real-input transform*/
+	if(status && (flags & PLAN_WITH_REAL) && n >= 2 && n%2 == 0){
+		size_t half = n/2;
+		plan->half = plan_f_create(half, 0, 0);
+		plan->rtw_cos = (float*)fft_malloc((half+1)*sizeof(float));
+		plan->rtw_sin = (float*)fft_malloc((half+1)*sizeof(float));
+		status = (plan->half != NULL && plan->rtw_cos != NULL && plan->rtw_sin != NULL);
+		if(status){
+			for(k=0;k<=half;k++){
+				plan->rtw_cos[k] = (float)cos(2 * M_PI * k / n);
+				plan->rtw_sin[k] = (float)sin(2 * M_PI * k / n);
+			}
+		}
+	}
+
+	/*same number of elements as the double workspace*/
+	if(status && (flags & PLAN_WITH_WORK)){
+		plan->work = (float*)fft_malloc(work_f_length(n)*sizeof(float));
+		status = (plan->work != NULL);
+	}
+
+	if(!status){
+		fft_plan_f_destroy(plan);
+		return NULL;
+	}
+
+	return plan;
+}
+
+/*
+ * Bytes held by a plan, as plan_footprint.
+ */
+size_t plan_f_footprint(const fft_plan_f_t *plan){
+
+	size_t n, bytes;
+
+	if(plan == NULL)
+		return 0;
+
+	n = plan->n;
+	bytes = sizeof(fft_plan_f_t);
+
+	switch(plan->kind){
+		case FFT_PLAN_RADIX2:
+			bytes += 2*(n/2 + 1)*sizeof(float) + n*sizeof(size_t);
+			break;
+		case FFT_PLAN_MIXED:
+			bytes += 2*n*sizeof(float);
+			break;
+		case FFT_PLAN_BLUESTEIN:
+			bytes += 2*(n + plan->m)*sizeof(float) + plan_f_footprint(plan->sub);
+			break;
+		default:
+			break;
+	}
+
+	if(plan->half != NULL)
+		bytes += 2*(n/2 + 1)*sizeof(float) + plan_f_footprint(plan->half);
+	if(plan->work != NULL)
+		bytes += fft_workspace_size(n)/sizeof(double)*sizeof(float);
+
+	return bytes;
+}
+
+static void plan_f_execute(const fft_plan_f_t *plan, float real[], float imag[], float *scratch){
+	FFT_STATS_PATH(FFT_STATS_PLAN_F_PATH(plan->kind), plan->n);
+
+	size_t n = plan->n;
+
+	/*the inverse transform is the forward transform with real and imaginary parts swapped*/
+	if(plan->inverse){
+		float *temp = real;
+		real = imag;
+		imag = temp;
+	}
+
+	switch(plan->kind){
+		case FFT_PLAN_RADIX2:
+			radix2_execute_f(plan, real, imag);
+			break;
+		case FFT_PLAN_MIXED:
+			if(n == 1)
+				break;
+			if(plan->scale != 1.0f){
+				copy_scaled_f(real, imag, scratch, scratch + n, n, plan->scale);
+			}else{
+				memcpy(scratch, real, n*sizeof(float));
+				memcpy(scratch + n, imag, n*sizeof(float));
+			}
+			mixed_work_f(real, imag, scratch, scratch + n, 1, plan->factors, plan->tw_real, plan->tw_imag, n);
+			break;
+		case FFT_PLAN_BLUESTEIN:
+			bluestein_execute_f(plan, real, imag, scratch);
+			break;
+		default:
+			break;
+	}
+}
+
+static void radix2_execute_f(const fft_plan_f_t *plan, float real[], float imag[]){
+
+	if(plan->scale != 1.0f)
+		bitrev_permute_scaled_f(real, imag, plan->n, plan->bitrev, plan->scale);
+	else
+		bitrev_permute_f(real, imag, plan->n, plan->bitrev);
+	radix2_stages_f(real, imag, plan->n, plan->cos_table, plan->sin_table);
+}
+
+static void bluestein_execute_f(const fft_plan_f_t *plan, float real[], float imag[], float *scratch){
+
+	size_t n = plan->n;
+	size_t m = plan->m;
+	float *areal = scratch;
+	float *aimag = scratch + m;
+
+	chirp_rotate_f(real, imag, areal, aimag, n, plan->chirp_cos, plan->chirp_sin);
+	memset(areal + n, 0, (m - n) * sizeof(float));
+	memset(aimag + n, 0, (m - n) * sizeof(float));
+
+	radix2_execute_f(plan->sub, areal, aimag);
+	if(plan->scale != 1.0f)
+		complex_multiply_scaled_f(areal, aimag, plan->bfft_real, plan->bfft_imag, m, plan->scale);
+	else
+		complex_multiply_f(areal, aimag, plan->bfft_real, plan->bfft_imag, m);
+	radix2_execute_f(plan->sub, aimag, areal);
+
+	chirp_rotate_f(areal, aimag, real, imag, n, plan->chirp_cos, plan->chirp_sin);
+}
+
+static int plan_f_init_radix2(fft_plan_f_t *plan){
+
+	size_t n = plan->n;
+	size_t half = n / 2;
+	unsigned int levels = 0;
+	size_t i;
+
+	plan->kind = FFT_PLAN_RADIX2;
+
+	for (i = n; i > 1; i >>= 1)
+		levels++;
+
+	/*at least one entry so that malloc never returns NULL for n == 1*/
+	plan->cos_table = (float*)fft_malloc((half + 1) * sizeof(float));
+	plan->sin_table = (float*)fft_malloc((half + 1) * sizeof(float));
+	plan->bitrev = (size_t*)fft_malloc(n * sizeof(size_t));
+	if (plan->cos_table == NULL || plan->sin_table == NULL || plan->bitrev == NULL)
+		return 0;
+
+	for (i = 0; i < half; i++) {
+		plan->cos_table[i] = (float)cos(2 * M_PI * i / n);
+		plan->sin_table[i] = (float)sin(2 * M_PI * i / n);
+	}
+
+	for (i = 0; i < n; i++) {
+		size_t x = i;
+		size_t result = 0;
+		unsigned int l;
+		for (l = 0; l < levels; l++, x >>= 1)
+			result = (result << 1) | (x & 1);
+		plan->bitrev[i] = result;
+	}
+
+	return 1;
+}
+
+static int plan_f_init_mixed(fft_plan_f_t *plan){
+
+	size_t n = plan->n;
+	size_t i;
+
+	plan->kind = FFT_PLAN_MIXED;
+	plan->nb_factors = mixed_radix_factorize(n, plan->factors);
+
+	plan->tw_real = (float*)fft_malloc(n*sizeof(float));
+	plan->tw_imag = (float*)fft_malloc(n*sizeof(float));
+	if(plan->tw_real == NULL || plan->tw_imag == NULL)
+		return 0;
+
+	for(i=0;i<n;i++){
+		plan->tw_real[i] = (float)cos(2 * M_PI * i / n);
+		plan->tw_imag[i] = (float)-sin(2 * M_PI * i / n);
+	}
+
+	return 1;
+}
+
+/*
+ * The chirp and its transform are computed in double precision, with the
+ * double plan of length m, then rounded.
+ */
+static int plan_f_init_bluestein(fft_plan_f_t *plan){
+
+	size_t n = plan->n;
+	size_t m;
+	size_t i;
+	fft_plan_t *sub_d = NULL;
+	double *breal = NULL, *bimag = NULL;
+	int status = 0;
+
+	plan->kind = FFT_PLAN_BLUESTEIN;
+
+	for (m = 1; m < n * 2 + 1; m *= 2);
+	plan->m = m;
+
+	plan->chirp_cos = (float*)fft_malloc(n * sizeof(float));
+	plan->chirp_sin = (float*)fft_malloc(n * sizeof(float));
+	plan->bfft_real = (float*)fft_malloc(m * sizeof(float));
+	plan->bfft_imag = (float*)fft_malloc(m * sizeof(float));
+	plan->sub = plan_f_create(m, 0, 0);
+	sub_d = plan_create(m, 0, 0);
+	breal = (double*)calloc(m, sizeof(double));
+	bimag = (double*)calloc(m, sizeof(double));
+	if (plan->chirp_cos == NULL || plan->chirp_sin == NULL
+			|| plan->bfft_real == NULL || plan->bfft_imag == NULL
+			|| plan->sub == NULL || sub_d == NULL
+			|| breal == NULL || bimag == NULL)
+		goto cleanup;
+
+	for (i = 0; i < n; i++) {
+		double temp = M_PI * (size_t)((unsigned long long)i * i % ((unsigned long long)n * 2)) / n;
+		breal[i] = cos(temp);
+		bimag[i] = sin(temp);
+		if (i > 0) {
+			breal[m - i] = breal[i];
+			bimag[m - i] = bimag[i];
+		}
+		plan->chirp_cos[i] = (float)breal[i];
+		plan->chirp_sin[i] = (float)bimag[i];
+	}
+
+	/*radix-2 double plans need no scratch*/
+	plan_execute(sub_d, breal, bimag, NULL);
+
+	for (i = 0; i < m; i++) {
+		plan->bfft_real[i] = (float)(breal[i] / m);
+		plan->bfft_imag[i] = (float)(bimag[i] / m);
+	}
+	status = 1;
+
+cleanup:
+	free(breal);
+	free(bimag);
+	fft_plan_destroy(sub_d);
+	return status;
+}
@@ -0,0 +1,341 @@
+/**
+ * @file fft_internal.h
+ * @brief Private definitions shared by the fft translation units.
+ *        Nothing in here is part of the public interface of libsignalproc.
+ */
+
+#ifndef FFT_INTERNAL_H
+#define FFT_INTERNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "fft.h"
+#include "fft_stats.h"
+
+/*algorithm used by a plan*/
+#define FFT_PLAN_NONE 0
+#define FFT_PLAN_RADIX2 1
+#define FFT_PLAN_BLUESTEIN 2
+#define FFT_PLAN_MIXED 3
+
+/*maximum number of stages of a mixed-radix plan*/
+#define MAX_FACTORS 64
+
+/*options of plan_create*/
+#define PLAN_WITH_WORK 1     /*allocate the workspace of the xxx_plan wrappers*/
+#define PLAN_WITH_REAL 2     /*also build the real-input plan (even n only)*/
+
+/*
+ * Radix-4 stage of a power-of-2 plan, see fft_simd.c
+ */
+typedef void (*radix4_stage_fn)(double *re, double *im, size_t n, size_t h, const double *tw);
+
+/**
+ * struct fft_plan_s
+ * @brief precomputed state of a fixed-length transform. Everything in
+ *        here is read-only once fft_plan_create returns, except for work.
+ */
+struct fft_plan_s{
+
+	size_t n;            /*length of the transform*/
+	int inverse;         /*1 for the inverse transform, 0 for the forward*/
+	double scale;        /*1/n for FFT_INVERSE_SCALED, applied in the permutation or copy pass, else 1*/
+	int kind;            /*one of FFT_PLAN_xxx*/
+
+	/*radix-2*/
+	unsigned int levels; /*log2(n)*/
+	double *cos_table;   /*cos(2*pi*i/n), n/2 entries*/
+	double *sin_table;   /*sin(2*pi*i/n), n/2 entries*/
+	size_t *bitrev;      /*bit-reversal permutation, n entries*/
+	double *stage_tw;    /*contiguous twiddles of the radix-4 stages*/
+	radix4_stage_fn stage_fn; /*vector kernel, NULL for the scalar reference loop*/
+
+	/*bluestein*/
+	size_t m;            /*power-of-2 convolution length, m >= 2n+1*/
+	double *chirp_cos;   /*cos(pi*i^2/n), n entries*/
+	double *chirp_sin;   /*sin(pi*i^2/n), n entries*/
+	double *bfft_real;   /*fft of the chirp b, scaled by 1/m, m entries*/
+	double *bfft_imag;
+	struct fft_plan_s *sub; /*forward radix-2 plan of length m*/
+
+	/*mixed radix*/
+	size_t factors[2*MAX_FACTORS]; /*(radix, remaining length) for each stage*/
+	size_t nb_factors;
+	double *tw_real;     /*cos(2*pi*i/n), n entries*/
+	double *tw_imag;     /*-sin(2*pi*i/n), n entries*/
+
+	/*real-input transform of the same length, forward plans of even length only*/
+	struct rfft_plan_s *real;
+
+	/*workspace used by the xxx_plan wrappers and abs_fft_batch, fft_batch_workspace_size(n) bytes*/
+	double *work;
+};
+
+/**
+ * struct rfft_plan_s
+ * @brief real-input transform of length n. For even n, the samples are packed
+ *        as z(j) = x(2j) + j*x(2j+1) and transformed with a complex plan of length n/2.
+ *        For odd n, a complex plan of length n is used with a null imaginary part.
+ */
+struct rfft_plan_s{
+
+	size_t n;
+	struct fft_plan_s *half;  /*forward plan of length n/2 (even n)*/
+	struct fft_plan_s *full;  /*forward plan of length n (odd n)*/
+	double *tw_cos;           /*cos(2*pi*k/n), k = 0..n/2*/
+	double *tw_sin;           /*sin(2*pi*k/n), k = 0..n/2*/
+	double *work;             /*rfft_workspace_size(n) bytes, for rfft/irfft*/
+};
+
+/**
+ * struct fft_plan_f_s
+ * @brief single precision plan (fft_float.c), same layout as fft_plan_s
+ *        without the vector kernels.
+ */
+struct fft_plan_f_s{
+
+	size_t n;
+	int inverse;
+	float scale;         /*1/n for FFT_INVERSE_SCALED, else 1*/
+	int kind;            /*one of FFT_PLAN_xxx*/
+
+	/*radix-2*/
+	float *cos_table;    /*cos(2*pi*i/n), n/2 entries*/
+	float *sin_table;
+	size_t *bitrev;
+
+	/*bluestein*/
+	size_t m;
+	float *chirp_cos;
+	float *chirp_sin;
+	float *bfft_real;    /*fft of the chirp b, scaled by 1/m*/
+	float *bfft_imag;
+	struct fft_plan_f_s *sub;
+
+	/*mixed radix*/
+	size_t factors[2*MAX_FACTORS];
+	size_t nb_factors;
+	float *tw_real;      /*cos(2*pi*i/n), n entries*/
+	float *tw_imag;      /*-sin(2*pi*i/n), n entries*/
+
+	/*real-input transform, forward plans of even length only*/
+	struct fft_plan_f_s *half;  /*forward plan of length n/2*/
+	float *rtw_cos;             /*cos(2*pi*k/n), k = 0..n/2*/
+	float *rtw_sin;
+
+	/*workspace of the wrappers, as many floats as fft_workspace_size(n) holds doubles*/
+	float *work;
+};
+
+/*
+ * Builds a plan, flags is a combination of PLAN_WITH_xxx.
+ */
+fft_plan_t* plan_create(size_t n, int inverse, int flags);
+
+/*
+ * Builds a single precision plan (fft_float.c), same flags as plan_create.
+ */
+fft_plan_f_t* plan_f_create(size_t n, int inverse, int flags);
+
+/*
+ * Bytes held by a plan, tables, sub-plans and workspace included.
+ */
+size_t plan_footprint(const fft_plan_t *plan);
+size_t plan_f_footprint(const fft_plan_f_t *plan);
+
+/*
+ * Plan cache of the functions without a plan argument (fft_plan_cache.c).
+ * plan_cache_acquire returns the forward (inverse = 0) or inverse plan of length n >= 1,
+ * built without a workspace: the plans are shared, the callers bring the scratch memory.
+ * flags is PLAN_WITH_REAL for the callers running the real-input plan (plan->real, or
+ * plan->half in single precision), forward only, 0 otherwise.
+ * *slot is set to the cache slot holding the plan, or to NULL when the plan did not fit
+ * in the cache and belongs to the caller. Either way the plan is handed back to
+ * plan_cache_release. Returns NULL if out of memory.
+ * plan_cache_enabled returns 0 when the plans of length n are never cached (cache
+ * disabled), for the callers that have a cheaper way than a plan for one call.
+ */
+typedef struct plan_cache_slot_s plan_cache_slot_t;
+
+int plan_cache_enabled(size_t n);
+const fft_plan_t* plan_cache_acquire(size_t n, int inverse, int flags, plan_cache_slot_t **slot);
+void plan_cache_release(plan_cache_slot_t *slot, const fft_plan_t *plan);
+const fft_plan_f_t* plan_cache_acquire_f(size_t n, int inverse, int flags, plan_cache_slot_t **slot);
+void plan_cache_release_f(plan_cache_slot_t *slot, const fft_plan_f_t *plan);
+
+/*
+ * Number of doubles of scratch memory the transform of length n needs,
+ * on top of the caller's arrays.
+ */
+size_t transform_scratch_length(size_t n);
+
+/*
+ * Runs the transform of the plan over real/imag, using 'scratch'
+ * (transform_scratch_length(n) doubles) as temporary memory.
+ */
+void plan_execute(const fft_plan_t *plan, double real[], double imag[], double *scratch);
+
+/*
+ * Same over interleaved complex data (element k at data[2k], data[2k+1]), using
+ * 'scratch' (2n + transform_scratch_length(n) doubles) as temporary memory.
+ */
+void plan_execute_interleaved(const fft_plan_t *plan, double data[], double *scratch);
+
+/*
+ * Mixed-radix transform (fft_mixed_radix.c): supported lengths, plan
+ * initialization and forward transform using 2n doubles of scratch.
+ */
+int mixed_radix_supported(size_t n);
+size_t mixed_radix_factorize(size_t n, size_t *factors);
+int plan_init_mixed(fft_plan_t *plan);
+void mixed_radix_execute(const fft_plan_t *plan, double real[], double imag[], double *scratch);
+
+/*
+ * Straight-line forward transform of a fixed length, in place.
+ */
+typedef void (*codelet_fn)(double real[], double imag[]);
+
+/*
+ * Codelet of length n, NULL if n is not in the CODELET_SIZES of the build
+ * (fft_codelets.c, generated by tools/gen_codelets.c).
+ */
+codelet_fn codelet_lookup(size_t n);
+
+/*
+ * Radix-4 stages of the power-of-2 plans (fft_simd.c): kernel selection,
+ * stage twiddles and butterflies over bit-reversed data.
+ */
+radix4_stage_fn radix4_stage_select(int kernel);
+size_t radix4_table_length(unsigned int levels);
+void radix4_table_fill(double *tw, unsigned int levels);
+void radix4_execute(const fft_plan_t *plan, double real[], double imag[]);
+
+/*
+ * Number of doubles of scratch memory the real-input transform of length n needs.
+ */
+size_t rfft_scratch_length(size_t n);
+
+/*
+ * Real-input transform and its inverse (unscaled), using 'scratch'
+ * (rfft_scratch_length(n) doubles) as temporary memory.
+ */
+void rfft_execute(const rfft_plan_t *plan, const double *signal,
+                  double *out_real, double *out_imag,
+                  double *scratch);
+void irfft_execute(const rfft_plan_t *plan,
+                   const double *in_real, const double *in_imag,
+                   double *signal,
+                   double *scratch);
+
+/*
+ * Real-input transform fused with the FFT_OUTPUT_xxx output stage,
+ * fft_output_length(n, mode) values written to out.
+ */
+void rfft_spectrum_execute(const rfft_plan_t *plan, const double *signal,
+                           int mode, double *out,
+                           double *scratch);
+
+/*
+ * Recovers the spectra of two real signals packed as x = x1 + j*x2
+ * from the full transform X of x.
+ */
+void split_2signals(const double *X_real, const double *X_imag,
+                    double *X1_real, double *X1_imag,
+                    double *X2_real, double *X2_imag,
+                    size_t n);
+
+/*
+ * Circular convolution of x and y written over x, y overwritten with its transform,
+ * against a forward plan with transform_scratch_length(n) doubles of scratch.
+ */
+void convolve_execute(const fft_plan_t *plan, double xr[], double xi[], double yr[], double yi[], double *scratch);
+
+/*
+ * Copies the samples of one channel of a frame in the FFT_LAYOUT_xxx layout into a contiguous vector.
+ */
+void gather_channel(const double *data, size_t n, size_t nb_channels, int layout,
+                    size_t channel, double *out);
+
+/*
+ * spectrum_batch_ws over the channels [first, first+count) of a frame of nb_channels channels.
+ */
+int spectrum_batch_range(const fft_plan_t* plan,
+                         const double* data, size_t nb_channels, int layout,
+                         size_t first, size_t count,
+                         int mode, double* out,
+                         void* workspace);
+
+/*
+ * Sliding DFT kernels (dft_interval.c), shared by sliding_dft_t and band_power_t.
+ * history is the n-long window, its oldest sample at head, and X_real/X_imag the tracked bins.
+ * sliding_dft_rotate pushes count samples, read every stride values, each one rotating the
+ * nb_bins bins by rot_real + j*rot_imag, and returns the new head.
+ * sliding_dft_exact_bin recomputes the bin of index step (in [0, n)) from the history, with
+ * the cos/sin(2*pi*i/n) tables, into *X_real, *X_imag.
+ */
+int sliding_dft_rotate(double *history, int n, int head,
+                       const double *samples, size_t stride, int count,
+                       double *X_real, double *X_imag,
+                       const double *rot_real, const double *rot_imag, int nb_bins);
+void sliding_dft_exact_bin(const double *history, int n, int head, int step,
+                           const double *cos_table, const double *sin_table,
+                           double *X_real, double *X_imag);
+
+/*
+ * Instrumentation (fft_stats.c), compiled in with SIGNALPROC_STATS only.
+ *
+ * FFT_STATS_ENTRY(entry) at the top of a function counts the call, then its time and the bytes
+ * allocated by the thread when the function returns, whichever return it takes (the
+ * scope variable has a cleanup handler). FFT_STATS_PATH(path, n) does the same for a
+ * dispatch path, and adds the length to the size histogram. malloc and calloc are
+ * redirected to counting versions in the translation units that include this header.
+ * Without SIGNALPROC_STATS, the macros expand to nothing.
+ */
+#ifdef SIGNALPROC_STATS
+
+typedef struct fft_stats_scope_s{
+	int counter;         /*entry or path index, -1 when nothing is recorded*/
+	int is_path;
+	size_t n;
+	uint64_t start_ns;
+	uint64_t start_bytes;
+} fft_stats_scope_t;
+
+fft_stats_scope_t fft_stats_begin(int counter, int is_path, size_t n);
+void fft_stats_end(fft_stats_scope_t *scope);
+void* fft_stats_malloc(size_t size);
+void* fft_stats_calloc(size_t nmemb, size_t size);
+int fft_stats_posix_memalign(void **ptr, size_t alignment, size_t size);
+
+#define FFT_STATS_ENTRY(entry) \
+	fft_stats_scope_t fft_stats_entry_scope __attribute__((cleanup(fft_stats_end))) = fft_stats_begin(entry, 0, 0)
+#define FFT_STATS_PATH(path, n) \
+	fft_stats_scope_t fft_stats_path_scope __attribute__((cleanup(fft_stats_end))) = fft_stats_begin(path, 1, n)
+
+/*dispatch path of a plan of kind FFT_PLAN_xxx, in double precision*/
+#define FFT_STATS_PLAN_PATH(kind) \
+	((kind) == FFT_PLAN_RADIX2 ? FFT_STATS_PATH_RADIX2 : \
+	 (kind) == FFT_PLAN_MIXED ? FFT_STATS_PATH_MIXED : \
+	 (kind) == FFT_PLAN_BLUESTEIN ? FFT_STATS_PATH_BLUESTEIN : -1)
+
+/*same in single precision*/
+#define FFT_STATS_PLAN_F_PATH(kind) \
+	((kind) == FFT_PLAN_RADIX2 ? FFT_STATS_PATH_RADIX2_F : \
+	 (kind) == FFT_PLAN_MIXED ? FFT_STATS_PATH_MIXED_F : \
+	 (kind) == FFT_PLAN_BLUESTEIN ? FFT_STATS_PATH_BLUESTEIN_F : -1)
+
+#ifndef FFT_STATS_NO_ALLOC_HOOK
+#define malloc(size) fft_stats_malloc(size)
+#define calloc(nmemb, size) fft_stats_calloc(nmemb, size)
+#define posix_memalign(ptr, alignment, size) fft_stats_posix_memalign(ptr, alignment, size)
+#endif
+
+#else
+
+#define FFT_STATS_ENTRY(entry)
+#define FFT_STATS_PATH(path, n)
+
+#endif
+
+#endif
@@ -0,0 +1,142 @@
+/**
+ * @file fft_mixed_radix.c
+ * @brief Mixed-radix Cooley-Tukey transform, for lengths whose prime factors are
+ *        all in {2, 3, 5, 7, 11}, such as our 220 samples epochs (4*5*11).
+ *        The length is split into radix-4, 2, 3, 5 stages (specialized butterflies)
+ *        and radix-7, 11 stages (generic butterfly). Each stage is a recursive
+ *        decimation in time, out of place from a copy of the input, as in kissfft
+ *        by Mark Borgerding (BSD license), adapted to split real/imag arrays.
+ *        This avoids Bluestein's padding to m >= 2n+1 and its three transforms of length m.
+ *        The butterflies themselves live in fft_template.h, shared with the float plans.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fft.h"
+#include "fft_internal.h"
+
+#define FFT_REAL double
+#define FFT_SQRT sqrt
+#define FFT_T(name) name##_d
+#include "fft_template.h"
+
+/**
+ * int transform_mixed_radix(double real[], double imag[], size_t n)
+ *
+ * @brief Computes the discrete Fourier transform (DFT) of the given complex vector, storing the result back into the vector.
+ *        The vector's length must only have 2, 3, 5, 7 and 11 as prime factors.
+ * @return 1 if success, 0 otherwise (n has other prime factors, or out of memory)
+ */
+int transform_mixed_radix(double real[], double imag[], size_t n){
+	FFT_STATS_ENTRY(FFT_STATS_TRANSFORM_MIXED_RADIX);
+
+	plan_cache_slot_t *slot;
+	const fft_plan_t *plan;
+	double *scratch;
+	int status = 0;
+
+	if(!mixed_radix_supported(n))
+		return 0;
+
+	plan = plan_cache_acquire(n, 0, 0, &slot);
+	scratch = (double*)fft_malloc((transform_scratch_length(n)+1)*sizeof(double));
+	if(plan != NULL && scratch != NULL){
+		plan_execute(plan, real, imag, scratch);
+		status = 1;
+	}
+
+	free(scratch);
+	plan_cache_release(slot, plan);
+	return status;
+}
+
+/*
+ * Returns 1 if all the prime factors of n are in {2, 3, 5, 7, 11}.
+ */
+int mixed_radix_supported(size_t n){
+
+	static const size_t primes[] = {2, 3, 5, 7, 11};
+	size_t i;
+
+	if(n == 0)
+		return 0;
+
+	for(i=0;i<sizeof(primes)/sizeof(primes[0]);i++){
+		while(n%primes[i] == 0)
+			n /= primes[i];
+	}
+
+	return (n == 1);
+}
+
+/*
+ * Factorizes n in (radix, remaining length) pairs, radix 4 first.
+ * Returns the number of stages, n must be supported.
+ */
+size_t mixed_radix_factorize(size_t n, size_t *factors){
+
+	static const size_t radices[] = {4, 2, 3, 5, 7, 11};
+	size_t remaining = n;
+	size_t nb_factors = 0;
+	size_t r = 0;
+
+	while(remaining > 1){
+		while(remaining%radices[r] != 0)
+			r++;
+		remaining /= radices[r];
+		factors[2*nb_factors] = radices[r];
+		factors[2*nb_factors+1] = remaining;
+		nb_factors++;
+	}
+
+	return nb_factors;
+}
+
+/*
+ * Factorizes n, then builds the n-long twiddle table exp(-j*2*pi*i/n).
+ */
+int plan_init_mixed(fft_plan_t *plan){
+
+	size_t n = plan->n;
+	size_t i;
+
+	plan->kind = FFT_PLAN_MIXED;
+	plan->nb_factors = mixed_radix_factorize(n, plan->factors);
+
+	plan->tw_real = (double*)fft_malloc(n*sizeof(double));
+	plan->tw_imag = (double*)fft_malloc(n*sizeof(double));
+	if(plan->tw_real == NULL || plan->tw_imag == NULL)
+		return 0;
+
+	for(i=0;i<n;i++){
+		plan->tw_real[i] = cos(2 * M_PI * i / n);
+		plan->tw_imag[i] = -sin(2 * M_PI * i / n);
+	}
+
+	return 1;
+}
+
+/*
+ * Forward transform, the input is copied to scratch (2n doubles)
+ * and the stages write their output back into real/imag.
+ */
+void mixed_radix_execute(const fft_plan_t *plan, double real[], double imag[], double *scratch){
+
+	size_t n = plan->n;
+	double *in_r = scratch;
+	double *in_i = scratch + n;
+
+	if(n == 1)
+		return;
+
+	/*the scaling of the scaled inverse plans rides on the copy*/
+	if(plan->scale != 1.0){
+		copy_scaled_d(real, imag, in_r, in_i, n, plan->scale);
+	}else{
+		memcpy(in_r, real, n*sizeof(double));
+		memcpy(in_i, imag, n*sizeof(double));
+	}
+
+	mixed_work_d(real, imag, in_r, in_i, 1, plan->factors, plan->tw_real, plan->tw_imag, n);
+}
@@ -0,0 +1,422 @@
+/**
+ * @file fft_plan.c
+ * @brief Reusable fft plans. A plan is created once for a given length and
+ *        direction and holds everything that transform_radix2 and
+ *        transform_bluestein recompute on every call: the twiddle tables,
+ *        the bit-reversal permutation, the padded length m and the
+ *        fourier transform of the Bluestein chirp, or the stages of the
+ *        mixed-radix decomposition. Executing a plan only
+ *        runs the butterflies.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fft.h"
+#include "fft_internal.h"
+
+#define FFT_REAL double
+#define FFT_SQRT sqrt
+#define FFT_T(name) name##_d
+#include "fft_template.h"
+
+#ifndef SIZE_MAX
+#define SIZE_MAX ((size_t)-1)
+#endif
+
+static fft_plan_t *plan_alloc(size_t n, int inverse);
+static int plan_init_radix2(fft_plan_t *plan);
+static int plan_init_bluestein(fft_plan_t *plan);
+static void radix2_execute(const fft_plan_t *plan, double real[], double imag[]);
+static void bluestein_execute(const fft_plan_t *plan, double real[], double imag[], double *scratch);
+
+/**
+ * fft_plan_t* fft_plan_create(size_t n, int inverse)
+ *
+ * @brief creates a plan for the transform of length n, along with a workspace
+ *        used by the xxx_plan wrappers and abs_fft_batch.
+ * @param n, the length of the transform, any length is supported.
+ * @param inverse, 1 for the inverse transform (unscaled, as inverse_transform), FFT_INVERSE_SCALED
+ *        for the inverse transform scaled by 1/n, 0 for the forward transform
+ * @return the plan, NULL if out of memory
+ */
+fft_plan_t* fft_plan_create(size_t n, int inverse){
+
+	/*forward plans of even length also carry the real-input transform*/
+	int flags = PLAN_WITH_WORK;
+	if(!inverse)
+		flags |= PLAN_WITH_REAL;
+
+	return plan_create(n, inverse, flags);
+}
+
+/*
+ * Builds a plan. Plans used inside other plans are created without
+ * a workspace or a real-input plan.
+ */
+fft_plan_t* plan_create(size_t n, int inverse, int flags){
+	FFT_STATS_ENTRY(FFT_STATS_PLAN_CREATE);
+
+	fft_plan_t *plan = plan_alloc(n, inverse);
+	int status;
+
+	if(plan == NULL)
+		return NULL;
+
+	if(n == 0){
+		plan->kind = FFT_PLAN_NONE;
+		status = 1;
+	}
+	else if((n & (n - 1)) == 0){  // Is power of 2
+		status = plan_init_radix2(plan);
+	}
+	else if(mixed_radix_supported(n)){  // Only small prime factors
+		status = plan_init_mixed(plan);
+	}
+	else{
+		status = plan_init_bluestein(plan);
+	}
+
+	/*half-length plan used by abs_fft and convolve_real*/
+	if(status && (flags & PLAN_WITH_REAL) && n >= 2 && n%2 == 0){
+		plan->real = rfft_plan_create(n);
+		status = (plan->real != NULL);
+	}
+
+	/*scratch memory used by the wrappers*/
+	if(status && (flags & PLAN_WITH_WORK)){
+		plan->work = (double*)fft_malloc(fft_batch_workspace_size(n));
+		status = (plan->work != NULL);
+	}
+
+	if(!status){
+		fft_plan_destroy(plan);
+		return NULL;
+	}
+
+	return plan;
+}
+
+/**
+ * void fft_plan_destroy(fft_plan_t* plan)
+ *
+ * @brief releases the memory held by a plan. NULL is accepted.
+ * @param plan, the plan to release
+ */
+void fft_plan_destroy(fft_plan_t* plan){
+
+	if(plan == NULL)
+		return;
+
+	fft_plan_destroy(plan->sub);
+	rfft_plan_destroy(plan->real);
+	free(plan->work);
+	free(plan->bfft_imag);
+	free(plan->bfft_real);
+	free(plan->chirp_sin);
+	free(plan->chirp_cos);
+	free(plan->bitrev);
+	free(plan->stage_tw);
+	free(plan->tw_real);
+	free(plan->tw_imag);
+	free(plan->sin_table);
+	free(plan->cos_table);
+	free(plan);
+}
+
+/**
+ * size_t fft_plan_length(const fft_plan_t* plan)
+ *
+ * @brief returns the length of the transform computed by the plan.
+ */
+size_t fft_plan_length(const fft_plan_t* plan){
+	return plan->n;
+}
+
+/*
+ * Number of doubles of scratch memory the transform of length n needs.
+ * Mixed radix works out of place from a copy of the input.
+ * Bluestein convolves two m-long complex vectors, one of which lives in the plan.
+ */
+size_t transform_scratch_length(size_t n){
+
+	size_t m;
+
+	if(n == 0 || (n & (n - 1)) == 0)
+		return 0;
+
+	if(mixed_radix_supported(n))
+		return 2*n;
+
+	for (m = 1; m < n * 2 + 1; m *= 2);
+	return 2*m;
+}
+
+/*
+ * Bytes held by a plan, tables, sub-plans and workspace included.
+ */
+size_t plan_footprint(const fft_plan_t *plan){
+
+	size_t n, bytes;
+
+	if(plan == NULL)
+		return 0;
+
+	n = plan->n;
+	bytes = sizeof(fft_plan_t);
+
+	switch(plan->kind){
+		case FFT_PLAN_RADIX2:
+			bytes += 2*(n/2 + 1)*sizeof(double) + n*sizeof(size_t);
+			if(plan->stage_tw != NULL)
+				bytes += (radix4_table_length(plan->levels) + 1)*sizeof(double);
+			break;
+		case FFT_PLAN_MIXED:
+			bytes += 2*n*sizeof(double);
+			break;
+		case FFT_PLAN_BLUESTEIN:
+			bytes += 2*(n + plan->m)*sizeof(double) + plan_footprint(plan->sub);
+			break;
+		default:
+			break;
+	}
+
+	if(plan->real != NULL){
+		bytes += sizeof(rfft_plan_t) + 2*(n/2 + 1)*sizeof(double) + rfft_workspace_size(n);
+		bytes += plan_footprint(plan->real->half) + plan_footprint(plan->real->full);
+	}
+	if(plan->work != NULL)
+		bytes += fft_batch_workspace_size(n);
+
+	return bytes;
+}
+
+void plan_execute(const fft_plan_t *plan, double real[], double imag[], double *scratch){
+	FFT_STATS_PATH(FFT_STATS_PLAN_PATH(plan->kind), plan->n);
+
+	/*the inverse transform is the forward transform with real and imaginary parts swapped*/
+	if(plan->inverse){
+		double *temp = real;
+		real = imag;
+		imag = temp;
+	}
+
+	switch(plan->kind){
+		case FFT_PLAN_RADIX2:
+			radix2_execute(plan, real, imag);
+			break;
+		case FFT_PLAN_MIXED:
+			mixed_radix_execute(plan, real, imag, scratch);
+			break;
+		case FFT_PLAN_BLUESTEIN:
+			bluestein_execute(plan, real, imag, scratch);
+			break;
+		default:
+			break;
+	}
+}
+
+void plan_execute_interleaved(const fft_plan_t *plan, double data[], double *scratch){
+
+	size_t n = plan->n;
+
+	/*the scalar radix-2 loop runs on the interleaved data directly*/
+	if(plan->kind == FFT_PLAN_RADIX2 && plan->stage_fn == NULL){
+		FFT_STATS_PATH(FFT_STATS_PATH_RADIX2, n);
+		if(plan->scale != 1.0)
+			bitrev_permute_interleaved_scaled_d(data, n, plan->bitrev, plan->scale);
+		else
+			bitrev_permute_interleaved_d(data, n, plan->bitrev);
+		radix2_stages_interleaved_d(data, n, plan->cos_table, plan->sin_table, plan->inverse);
+		return;
+	}
+
+	/*the vector kernels, mixed radix and Bluestein work on split vectors*/
+	deinterleave_d(data, scratch, scratch + n, n);
+	plan_execute(plan, scratch, scratch + n, scratch + 2*n);
+	interleave_d(scratch, scratch + n, data, n);
+}
+
+/*
+ * Same decomposition as transform_radix2, with the tables and the
+ * permutation taken from the plan. Unless the scalar kernel was selected,
+ * the stages run as vectorized radix-4 stages.
+ */
+static void radix2_execute(const fft_plan_t *plan, double real[], double imag[]){
+
+	size_t n = plan->n;
+
+	// Bit-reversed addressing permutation, with the scaling of the scaled inverse plans
+	if (plan->scale != 1.0)
+		bitrev_permute_scaled_d(real, imag, n, plan->bitrev, plan->scale);
+	else
+		bitrev_permute_d(real, imag, n, plan->bitrev);
+
+	// Vectorized radix-4 stages
+	if (plan->stage_fn != NULL) {
+		radix4_execute(plan, real, imag);
+		return;
+	}
+
+	// Cooley-Tukey decimation-in-time radix-2 FFT
+	radix2_stages_d(real, imag, n, plan->cos_table, plan->sin_table);
+}
+
+/*
+ * Same algorithm as transform_bluestein. The fft of the chirp b is already
+ * in the plan (scaled by 1/m), so only a is transformed and the product
+ * inverse-transformed.
+ */
+static void bluestein_execute(const fft_plan_t *plan, double real[], double imag[], double *scratch){
+
+	size_t n = plan->n;
+	size_t m = plan->m;
+	const double *cos_table = plan->chirp_cos;
+	const double *sin_table = plan->chirp_sin;
+	double *areal = scratch;
+	double *aimag = scratch + m;
+
+	// Temporary vectors and preprocessing
+	chirp_rotate_d(real, imag, areal, aimag, n, cos_table, sin_table);
+	memset(areal + n, 0, (m - n) * sizeof(double));
+	memset(aimag + n, 0, (m - n) * sizeof(double));
+
+	// Convolution with the chirp, in the frequency domain
+	radix2_execute(plan->sub, areal, aimag);
+	if (plan->scale != 1.0)
+		complex_multiply_scaled_d(areal, aimag, plan->bfft_real, plan->bfft_imag, m, plan->scale);
+	else
+		complex_multiply_d(areal, aimag, plan->bfft_real, plan->bfft_imag, m);
+	radix2_execute(plan->sub, aimag, areal);
+
+	// Postprocessing
+	chirp_rotate_d(areal, aimag, real, imag, n, cos_table, sin_table);
+}
+
+static fft_plan_t *plan_alloc(size_t n, int inverse){
+
+	fft_plan_t *plan = (fft_plan_t*)calloc(1, sizeof(fft_plan_t));
+
+	if(plan != NULL){
+		plan->n = n;
+		plan->inverse = inverse ? 1 : 0;
+		plan->scale = (inverse == FFT_INVERSE_SCALED && n > 0) ? 1.0/n : 1.0;
+	}
+	return plan;
+}
+
+static int plan_init_radix2(fft_plan_t *plan){
+
+	size_t n = plan->n;
+	size_t half = n / 2;
+	size_t i;
+
+	plan->kind = FFT_PLAN_RADIX2;
+
+	// Compute levels = floor(log2(n))
+	{
+		size_t temp = n;
+		plan->levels = 0;
+		while (temp > 1) {
+			plan->levels++;
+			temp >>= 1;
+		}
+	}
+
+	if (SIZE_MAX / sizeof(size_t) < n)
+		return 0;
+
+	/*at least one entry so that malloc never returns NULL for n == 1*/
+	plan->cos_table = (double*)fft_malloc((half + 1) * sizeof(double));
+	plan->sin_table = (double*)fft_malloc((half + 1) * sizeof(double));
+	plan->bitrev = (size_t*)fft_malloc(n * sizeof(size_t));
+	if (plan->cos_table == NULL || plan->sin_table == NULL || plan->bitrev == NULL)
+		return 0;
+
+	/*contiguous per-stage twiddles of the vector kernels*/
+	plan->stage_fn = radix4_stage_select(fft_get_kernel());
+	if (plan->stage_fn != NULL) {
+		plan->stage_tw = (double*)fft_malloc((radix4_table_length(plan->levels) + 1) * sizeof(double));
+		if (plan->stage_tw == NULL)
+			return 0;
+		radix4_table_fill(plan->stage_tw, plan->levels);
+	}
+
+	for (i = 0; i < half; i++) {
+		plan->cos_table[i] = cos(2 * M_PI * i / n);
+		plan->sin_table[i] = sin(2 * M_PI * i / n);
+	}
+
+	for (i = 0; i < n; i++) {
+		size_t x = i;
+		size_t result = 0;
+		unsigned int l;
+		for (l = 0; l < plan->levels; l++, x >>= 1)
+			result = (result << 1) | (x & 1);
+		plan->bitrev[i] = result;
+	}
+
+	return 1;
+}
+
+static int plan_init_bluestein(fft_plan_t *plan){
+
+	size_t n = plan->n;
+	size_t m;
+	size_t i;
+	double *breal, *bimag;
+
+	plan->kind = FFT_PLAN_BLUESTEIN;
+
+	// Find a power-of-2 convolution length m such that m >= n * 2 + 1
+	{
+		size_t target;
+		if (n > (SIZE_MAX - 1) / 2)
+			return 0;
+		target = n * 2 + 1;
+		for (m = 1; m < target; m *= 2) {
+			if (SIZE_MAX / 2 < m)
+				return 0;
+		}
+	}
+	plan->m = m;
+
+	if (SIZE_MAX / sizeof(double) < m)
+		return 0;
+
+	plan->chirp_cos = (double*)fft_malloc(n * sizeof(double));
+	plan->chirp_sin = (double*)fft_malloc(n * sizeof(double));
+	plan->bfft_real = fft_alloc_reals(m);
+	plan->bfft_imag = fft_alloc_reals(m);
+	plan->sub = plan_alloc(m, 0);
+	if (plan->chirp_cos == NULL || plan->chirp_sin == NULL
+			|| plan->bfft_real == NULL || plan->bfft_imag == NULL
+			|| plan->sub == NULL || !plan_init_radix2(plan->sub))
+		return 0;
+
+	// Trignometric tables
+	for (i = 0; i < n; i++) {
+		double temp = M_PI * (size_t)((unsigned long long)i * i % ((unsigned long long)n * 2)) / n;
+		plan->chirp_cos[i] = cos(temp);
+		plan->chirp_sin[i] = sin(temp);
+	}
+
+	// Chirp b, transformed once and for all
+	breal = plan->bfft_real;
+	bimag = plan->bfft_imag;
+	breal[0] = plan->chirp_cos[0];
+	bimag[0] = plan->chirp_sin[0];
+	for (i = 1; i < n; i++) {
+		breal[i] = breal[m - i] = plan->chirp_cos[i];
+		bimag[i] = bimag[m - i] = plan->chirp_sin[i];
+	}
+	radix2_execute(plan->sub, breal, bimag);
+
+	/*fold the 1/m scaling of the inverse transform into b*/
+	for (i = 0; i < m; i++) {
+		breal[i] /= m;
+		bimag[i] /= m;
+	}
+
+	return 1;
+}
@@ -0,0 +1,395 @@
+/**
+ * @file fft_plan_cache.c
+ * @brief Process-wide cache of the plans used by the functions without a plan argument.
+ *
+ *        The cache is a fixed array of slots, each holding one plan, its key and the
+ *        number of calls running it. Readers never take the lock: a reader that sees
+ *        the key it wants claims the slot by incrementing its count with a
+ *        compare-and-swap, which fails once the count is SLOT_BUSY, then checks the key
+ *        again. The writers (insertion, eviction, clear) are serialized by a mutex, and
+ *        only change a slot they took from a count of 0 to SLOT_BUSY: a plan is never
+ *        released while a call runs it. The slots themselves are never released, so a
+ *        reader racing with a writer finds at worst a different key, never freed memory.
+ *
+ *        The counts are acquired and released with acquire/release ordering, so the
+ *        plan written by a writer before it hands the slot back is visible to the
+ *        readers claiming it afterwards. Each claim stamps its slot with a global clock,
+ *        the eviction picks the oldest stamp among the slots nobody uses.
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "fft.h"
+#include "fft_internal.h"
+
+/*number of cached plans, looked up linearly*/
+#define FFT_PLAN_CACHE_SLOTS 64
+/*count of a slot taken by a writer*/
+#define SLOT_BUSY (-1)
+/*bit of the key of the plans carrying the real-input plan*/
+#define KEY_WITH_REAL ((uint64_t)1 << 5)
+/*lengths that fit in the key*/
+#define KEY_MAX_LENGTH (UINT64_MAX >> 6)
+
+/**
+ * struct plan_cache_slot_s
+ * @brief a cached plan and the calls running it
+ */
+struct plan_cache_slot_s{
+
+	int refs;                /*calls running the plan, SLOT_BUSY while a writer owns the slot*/
+	uint64_t key;            /*cache_key of the plan, 0 for an empty slot*/
+	uint64_t last_use;       /*clock of the last claim*/
+
+	int precision;           /*FFT_PRECISION_xxx, type of plan*/
+	void *plan;
+	size_t bytes;            /*footprint of the plan*/
+};
+
+/**
+ * struct plan_cache_s
+ * @brief slots of the cache, and the state of the writers
+ */
+struct plan_cache_s{
+
+	struct plan_cache_slot_s slots[FFT_PLAN_CACHE_SLOTS];
+	uint64_t clock;
+
+	pthread_mutex_t lock;    /*held by the writers*/
+	size_t memory;           /*bytes of the cached plans*/
+	size_t limit;
+};
+
+static struct plan_cache_s cache = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.limit = FFT_PLAN_CACHE_DEFAULT_LIMIT
+};
+
+static void* cache_acquire(size_t n, int inverse, int precision, int flags, plan_cache_slot_t **slot);
+static uint64_t cache_key(size_t n, int inverse, int precision, int flags);
+static plan_cache_slot_t* cache_find(uint64_t key, uint64_t mask);
+static plan_cache_slot_t* cache_store(uint64_t key, int precision, void *plan, size_t bytes);
+static int cache_evict(void);
+static void slot_empty(plan_cache_slot_t *slot);
+static void* plan_build(size_t n, int inverse, int precision, int flags);
+static void plan_release(void *plan, int precision);
+
+/**
+ * int fft_plan_cache_prewarm(size_t n, int inverse, int precision)
+ *
+ * @brief builds the cached plan of a length ahead of time.
+ * @return 1 if the plan is in the cache, 0 otherwise (out of memory, or larger than the limit)
+ */
+int fft_plan_cache_prewarm(size_t n, int inverse, int precision){
+
+	plan_cache_slot_t *slot;
+	void *plan;
+
+	if(precision != FFT_PRECISION_DOUBLE && precision != FFT_PRECISION_FLOAT)
+		return 0;
+	/*nothing to build, the transforms of length 0 return right away*/
+	if(n == 0)
+		return 1;
+
+	/*with the real-input plan, which serves every caller*/
+	plan = cache_acquire(n, inverse, precision, PLAN_WITH_REAL, &slot);
+	if(plan == NULL)
+		return 0;
+
+	if(slot == NULL){
+		plan_release(plan, precision);
+		return 0;
+	}
+	__atomic_fetch_sub(&slot->refs, 1, __ATOMIC_RELEASE);
+	return 1;
+}
+
+/**
+ * void fft_plan_cache_set_limit(size_t bytes)
+ *
+ * @brief caps the memory held by the cached plans. 0 disables the cache.
+ */
+void fft_plan_cache_set_limit(size_t bytes){
+
+	pthread_mutex_lock(&cache.lock);
+	__atomic_store_n(&cache.limit, bytes, __ATOMIC_RELAXED);
+	while(cache.memory > bytes && cache_evict());
+	pthread_mutex_unlock(&cache.lock);
+}
+
+/**
+ * size_t fft_plan_cache_memory(void)
+ *
+ * @brief returns the bytes held by the cached plans.
+ */
+size_t fft_plan_cache_memory(void){
+	return __atomic_load_n(&cache.memory, __ATOMIC_RELAXED);
+}
+
+/**
+ * void fft_plan_cache_clear(void)
+ *
+ * @brief releases the cached plans, except the ones a call is running.
+ */
+void fft_plan_cache_clear(void){
+
+	size_t i;
+
+	pthread_mutex_lock(&cache.lock);
+	for(i=0;i<FFT_PLAN_CACHE_SLOTS;i++){
+		plan_cache_slot_t *slot = &cache.slots[i];
+		int zero = 0;
+
+		if(slot->key != 0 && __atomic_compare_exchange_n(&slot->refs, &zero, SLOT_BUSY, 0,
+		                                                 __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			slot_empty(slot);
+	}
+	pthread_mutex_unlock(&cache.lock);
+}
+
+int plan_cache_enabled(size_t n){
+	return (uint64_t)n <= KEY_MAX_LENGTH && __atomic_load_n(&cache.limit, __ATOMIC_RELAXED) != 0;
+}
+
+const fft_plan_t* plan_cache_acquire(size_t n, int inverse, int flags, plan_cache_slot_t **slot){
+	return (const fft_plan_t*)cache_acquire(n, inverse, FFT_PRECISION_DOUBLE, flags, slot);
+}
+
+void plan_cache_release(plan_cache_slot_t *slot, const fft_plan_t *plan){
+
+	if(slot != NULL)
+		__atomic_fetch_sub(&slot->refs, 1, __ATOMIC_RELEASE);
+	else
+		fft_plan_destroy((fft_plan_t*)plan);
+}
+
+const fft_plan_f_t* plan_cache_acquire_f(size_t n, int inverse, int flags, plan_cache_slot_t **slot){
+	return (const fft_plan_f_t*)cache_acquire(n, inverse, FFT_PRECISION_FLOAT, flags, slot);
+}
+
+void plan_cache_release_f(plan_cache_slot_t *slot, const fft_plan_f_t *plan){
+
+	if(slot != NULL)
+		__atomic_fetch_sub(&slot->refs, 1, __ATOMIC_RELEASE);
+	else
+		fft_plan_f_destroy((fft_plan_f_t*)plan);
+}
+
+/*
+ * Finds or builds the plan. A missing plan is built outside of the lock, so that the
+ * other lengths stay available meanwhile; if another thread stored the same plan in
+ * the meantime, that one is used and ours released. A plan with the real-input plan
+ * serves the callers that do not ask for it, a missing one is built with the flags of
+ * the caller only.
+ */
+static void* cache_acquire(size_t n, int inverse, int precision, int flags, plan_cache_slot_t **slot){
+
+	plan_cache_slot_t *found;
+	uint64_t key, mask;
+	void *plan;
+
+	*slot = NULL;
+	inverse = inverse ? 1 : 0;
+	flags = inverse ? 0 : (flags & PLAN_WITH_REAL);
+
+	/*too long for the key, or cache disabled: a plan for this call only*/
+	if(!plan_cache_enabled(n))
+		return plan_build(n, inverse, precision, flags);
+
+	key = cache_key(n, inverse, precision, flags);
+	mask = (flags & PLAN_WITH_REAL) ? 0 : KEY_WITH_REAL;
+	found = cache_find(key, mask);
+	if(found != NULL){
+		*slot = found;
+		return found->plan;
+	}
+
+	plan = plan_build(n, inverse, precision, flags);
+	if(plan == NULL)
+		return NULL;
+
+	pthread_mutex_lock(&cache.lock);
+	found = cache_find(key, mask);
+	if(found != NULL){
+		plan_release(plan, precision);
+		plan = found->plan;
+		*slot = found;
+	}
+	else{
+		size_t bytes = (precision == FFT_PRECISION_DOUBLE) ? plan_footprint((const fft_plan_t*)plan)
+		                                                   : plan_f_footprint((const fft_plan_f_t*)plan);
+		*slot = cache_store(key, precision, plan, bytes);
+	}
+	pthread_mutex_unlock(&cache.lock);
+
+	return plan;
+}
+
+/*
+ * Length, real-input plan, butterfly kernel, precision and direction: fft_set_kernel
+ * applies to the plans built afterwards, the cached ones must not hide it. Never 0
+ * for n >= 1.
+ */
+static uint64_t cache_key(size_t n, int inverse, int precision, int flags){
+
+	uint64_t kernel = (precision == FFT_PRECISION_DOUBLE) ? (uint64_t)fft_get_kernel() : 0;
+	uint64_t real = (flags & PLAN_WITH_REAL) ? KEY_WITH_REAL : 0;
+
+	return ((uint64_t)n << 6) | real | (kernel << 2) | ((uint64_t)precision << 1) | (inverse ? 1 : 0);
+}
+
+/*
+ * Lock-free lookup. Returns the slot of a key equal to key outside of the bits of mask
+ * with one more reference, NULL if there is none in the cache.
+ */
+static plan_cache_slot_t* cache_find(uint64_t key, uint64_t mask){
+
+	size_t i;
+
+	for(i=0;i<FFT_PLAN_CACHE_SLOTS;i++){
+
+		plan_cache_slot_t *slot = &cache.slots[i];
+		int refs;
+
+		if((__atomic_load_n(&slot->key, __ATOMIC_RELAXED) | mask) != (key | mask))
+			continue;
+
+		refs = __atomic_load_n(&slot->refs, __ATOMIC_RELAXED);
+		do{
+			if(refs == SLOT_BUSY)
+				break;
+		}while(!__atomic_compare_exchange_n(&slot->refs, &refs, refs + 1, 1,
+		                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+		if(refs == SLOT_BUSY)
+			continue;
+
+		/*the key cannot change while we hold a reference, but it may have before*/
+		if((__atomic_load_n(&slot->key, __ATOMIC_RELAXED) | mask) != (key | mask)){
+			__atomic_fetch_sub(&slot->refs, 1, __ATOMIC_RELEASE);
+			continue;
+		}
+
+		__atomic_store_n(&slot->last_use, __atomic_add_fetch(&cache.clock, 1, __ATOMIC_RELAXED),
+		                 __ATOMIC_RELAXED);
+		return slot;
+	}
+
+	return NULL;
+}
+
+/*
+ * Stores a plan with one reference, evicting the least recently used ones to make room.
+ * Lock held. Returns NULL if the plan does not fit.
+ */
+static plan_cache_slot_t* cache_store(uint64_t key, int precision, void *plan, size_t bytes){
+
+	size_t limit = cache.limit;
+	size_t i;
+
+	if(bytes > limit)
+		return NULL;
+	while(cache.memory > limit - bytes){
+		if(!cache_evict())
+			return NULL;
+	}
+
+	/*an empty slot, or the one of the oldest plan*/
+	for(;;){
+		for(i=0;i<FFT_PLAN_CACHE_SLOTS;i++){
+
+			plan_cache_slot_t *slot = &cache.slots[i];
+			int zero = 0;
+
+			/*a reader that saw the previous key may hold the slot for a moment*/
+			if(slot->key != 0 || !__atomic_compare_exchange_n(&slot->refs, &zero, SLOT_BUSY, 0,
+			                                                  __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+				continue;
+
+			slot->precision = precision;
+			slot->plan = plan;
+			slot->bytes = bytes;
+			__atomic_store_n(&slot->last_use, __atomic_add_fetch(&cache.clock, 1, __ATOMIC_RELAXED),
+			                 __ATOMIC_RELAXED);
+			__atomic_store_n(&slot->key, key, __ATOMIC_RELAXED);
+			__atomic_store_n(&cache.memory, cache.memory + bytes, __ATOMIC_RELAXED);
+
+			/*publishes the plan, with the reference of the caller*/
+			__atomic_store_n(&slot->refs, 1, __ATOMIC_RELEASE);
+			return slot;
+		}
+
+		if(!cache_evict())
+			return NULL;
+	}
+}
+
+/*
+ * Releases the least recently used plan that no call is running. Lock held.
+ * Returns 0 if every cached plan is running.
+ */
+static int cache_evict(void){
+
+	int attempt;
+	size_t i;
+
+	/*a victim claimed between the scan and the compare-and-swap is skipped*/
+	for(attempt=0;attempt<FFT_PLAN_CACHE_SLOTS;attempt++){
+
+		plan_cache_slot_t *victim = NULL;
+		uint64_t oldest = UINT64_MAX;
+		int zero = 0;
+
+		for(i=0;i<FFT_PLAN_CACHE_SLOTS;i++){
+			plan_cache_slot_t *slot = &cache.slots[i];
+			uint64_t stamp = __atomic_load_n(&slot->last_use, __ATOMIC_RELAXED);
+
+			if(slot->key != 0 && __atomic_load_n(&slot->refs, __ATOMIC_RELAXED) == 0 && stamp <= oldest){
+				victim = slot;
+				oldest = stamp;
+			}
+		}
+		if(victim == NULL)
+			return 0;
+
+		if(__atomic_compare_exchange_n(&victim->refs, &zero, SLOT_BUSY, 0,
+		                               __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)){
+			slot_empty(victim);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Releases the plan of a slot taken with SLOT_BUSY and hands the slot back, empty. Lock held.
+ */
+static void slot_empty(plan_cache_slot_t *slot){
+
+	plan_release(slot->plan, slot->precision);
+	__atomic_store_n(&cache.memory, cache.memory - slot->bytes, __ATOMIC_RELAXED);
+	slot->plan = NULL;
+	slot->bytes = 0;
+	__atomic_store_n(&slot->key, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&slot->refs, 0, __ATOMIC_RELEASE);
+}
+
+/*
+ * Shared plans have no workspace. The real-input plan is only built for abs_fft,
+ * convolve_real and abs_fft_f.
+ */
+static void* plan_build(size_t n, int inverse, int precision, int flags){
+
+	if(precision == FFT_PRECISION_FLOAT)
+		return plan_f_create(n, inverse, flags);
+	return plan_create(n, inverse, flags);
+}
+
+static void plan_release(void *plan, int precision){
+
+	if(precision == FFT_PRECISION_FLOAT)
+		fft_plan_f_destroy((fft_plan_f_t*)plan);
+	else
+		fft_plan_destroy((fft_plan_t*)plan);
+}
@@ -0,0 +1,291 @@
+/**
+ * @file fft_real.c
+ * @brief Real-input fourier transform. A real signal of even length n is packed
+ *        into a complex signal of length n/2, z(j) = x(2j) + j*x(2j+1), which is
+ *        transformed and post-twiddled to recover the n/2+1 bins of the one-sided
+ *        spectrum. This is the split of fft_2signals applied to the even and odd
+ *        samples of a single signal, and costs about half of a complex transform.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fft.h"
+#include "fft_internal.h"
+
+#define FFT_REAL double
+#define FFT_SQRT sqrt
+#define FFT_T(name) name##_d
+#include "fft_template.h"
+
+/**
+ * rfft_plan_t* rfft_plan_create(size_t n)
+ *
+ * @brief creates a plan for the real-input transform of length n.
+ * @param n, the length of the real signal, any length is supported (odd lengths run a full complex transform)
+ * @return the plan, NULL if out of memory
+ */
+rfft_plan_t* rfft_plan_create(size_t n){
+
+	rfft_plan_t *plan = (rfft_plan_t*)calloc(1, sizeof(rfft_plan_t));
+	size_t k;
+	size_t half = n/2;
+
+	if(plan == NULL)
+		return NULL;
+
+	plan->n = n;
+
+	if(n%2 == 0){
+		plan->half = plan_create(half, 0, 0);
+		plan->tw_cos = (double*)fft_malloc((half+1)*sizeof(double));
+		plan->tw_sin = (double*)fft_malloc((half+1)*sizeof(double));
+		if(plan->half == NULL || plan->tw_cos == NULL || plan->tw_sin == NULL)
+			goto error;
+
+		for(k=0;k<=half;k++){
+			plan->tw_cos[k] = cos(2 * M_PI * k / n);
+			plan->tw_sin[k] = sin(2 * M_PI * k / n);
+		}
+	}
+	else{
+		plan->full = plan_create(n, 0, 0);
+		if(plan->full == NULL)
+			goto error;
+	}
+
+	plan->work = (double*)fft_malloc(rfft_workspace_size(n));
+	if(plan->work == NULL)
+		goto error;
+
+	return plan;
+
+error:
+	rfft_plan_destroy(plan);
+	return NULL;
+}
+
+/**
+ * void rfft_plan_destroy(rfft_plan_t* plan)
+ *
+ * @brief releases the memory held by a plan. NULL is accepted.
+ */
+void rfft_plan_destroy(rfft_plan_t* plan){
+
+	if(plan == NULL)
+		return;
+
+	fft_plan_destroy(plan->half);
+	fft_plan_destroy(plan->full);
+	free(plan->tw_cos);
+	free(plan->tw_sin);
+	free(plan->work);
+	free(plan);
+}
+
+/**
+ * size_t rfft_workspace_size(size_t n)
+ *
+ * @brief returns the size in bytes of the workspace needed by rfft_ws and irfft_ws for length n.
+ */
+size_t rfft_workspace_size(size_t n){
+	return (rfft_scratch_length(n) + 1)*sizeof(double);
+}
+
+/*
+ * Even n: the packed n/2-long complex vector and the scratch of its transform.
+ * Odd n: a full n-long complex vector and the scratch of its transform.
+ */
+size_t rfft_scratch_length(size_t n){
+
+	if(n%2 == 0)
+		return n + transform_scratch_length(n/2);
+	return 2*n + transform_scratch_length(n);
+}
+
+/**
+ * int rfft_ws(const rfft_plan_t* plan, const double* signal, double* out_real, double* out_imag, void* workspace)
+ *
+ * @brief computes the one-sided fourier transform of a real signal.
+ * @param signal (in), the n-long signal
+ * @param out_real, out_imag (out), bins 0..n/2 of the transform (n/2+1 values each)
+ * @param workspace, rfft_workspace_size(n) bytes of memory
+ * @return 1 if success, 0 otherwise
+ */
+int rfft_ws(const rfft_plan_t* plan, const double* signal,
+            double* out_real, double* out_imag,
+            void* workspace){
+	FFT_STATS_ENTRY(FFT_STATS_RFFT);
+
+	rfft_execute(plan, signal, out_real, out_imag, (double*)workspace);
+	return 1;
+}
+
+/**
+ * int irfft_ws(const rfft_plan_t* plan, const double* in_real, const double* in_imag, double* signal, void* workspace)
+ *
+ * @brief computes the inverse of rfft_ws. As inverse_transform, it does not perform
+ *        scaling, so the output is n times the original signal.
+ * @param in_real, in_imag (in), bins 0..n/2 of the transform of a real signal
+ * @param signal (out), the n-long signal
+ * @param workspace, rfft_workspace_size(n) bytes of memory
+ * @return 1 if success, 0 otherwise
+ */
+int irfft_ws(const rfft_plan_t* plan,
+             const double* in_real, const double* in_imag,
+             double* signal,
+             void* workspace){
+	FFT_STATS_ENTRY(FFT_STATS_IRFFT);
+
+	irfft_execute(plan, in_real, in_imag, signal, (double*)workspace);
+	return 1;
+}
+
+/**
+ * int rfft(rfft_plan_t* plan, const double* signal, double* out_real, double* out_imag)
+ *
+ * @brief same as rfft_ws, using the workspace owned by the plan.
+ */
+int rfft(rfft_plan_t* plan, const double* signal,
+         double* out_real, double* out_imag){
+	return rfft_ws(plan, signal, out_real, out_imag, plan->work);
+}
+
+/**
+ * int irfft(rfft_plan_t* plan, const double* in_real, const double* in_imag, double* signal)
+ *
+ * @brief same as irfft_ws, using the workspace owned by the plan.
+ */
+int irfft(rfft_plan_t* plan,
+          const double* in_real, const double* in_imag,
+          double* signal){
+	return irfft_ws(plan, in_real, in_imag, signal, plan->work);
+}
+
+void rfft_execute(const rfft_plan_t *plan, const double *signal,
+                  double *out_real, double *out_imag,
+                  double *scratch){
+
+	size_t n = plan->n;
+	size_t half = n/2;
+	size_t j;
+
+	if(n == 0)
+		return;
+
+	if(n%2 != 0){
+		double *real = scratch;
+		double *imag = scratch + n;
+
+		memcpy(real, signal, n*sizeof(double));
+		memset(imag, 0, n*sizeof(double));
+		plan_execute(plan->full, real, imag, imag + n);
+
+		memcpy(out_real, real, (half+1)*sizeof(double));
+		memcpy(out_imag, imag, (half+1)*sizeof(double));
+		return;
+	}
+
+	{
+		double *zr = scratch;
+		double *zi = scratch + half;
+
+		/*pack the even samples in the real part and the odd samples in the imaginary part*/
+		for(j=0;j<half;j++){
+			zr[j] = signal[2*j];
+			zi[j] = signal[2*j+1];
+		}
+
+		plan_execute(plan->half, zr, zi, zi + half);
+
+		/*split and post-twiddle, X(k) = Xe(k) + exp(-j*2*pi*k/n)*Xo(k)*/
+		rfft_post_twiddle_d(zr, zi, out_real, out_imag, half, plan->tw_cos, plan->tw_sin);
+	}
+}
+
+void irfft_execute(const rfft_plan_t *plan,
+                   const double *in_real, const double *in_imag,
+                   double *signal,
+                   double *scratch){
+
+	size_t n = plan->n;
+	size_t half = n/2;
+	size_t j, k;
+
+	if(n == 0)
+		return;
+
+	if(n%2 != 0){
+		double *real = scratch;
+		double *imag = scratch + n;
+
+		/*rebuild the hermitian spectrum, and run the inverse by swapping real and imaginary parts*/
+		real[0] = in_real[0];
+		imag[0] = in_imag[0];
+		for(k=1;k<=half;k++){
+			real[k] = in_real[k];
+			imag[k] = in_imag[k];
+			real[n-k] = in_real[k];
+			imag[n-k] = -in_imag[k];
+		}
+		plan_execute(plan->full, imag, real, imag + n);
+
+		memcpy(signal, real, n*sizeof(double));
+		return;
+	}
+
+	{
+		double *zr = scratch;
+		double *zi = scratch + half;
+
+		/*undo the post-twiddle, scaled by 2 so that the output is n*x*/
+		irfft_pre_twiddle_d(in_real, in_imag, zr, zi, half, plan->tw_cos, plan->tw_sin);
+
+		/*inverse transform, by swapping the real and imaginary parts*/
+		plan_execute(plan->half, zi, zr, zi + half);
+
+		for(j=0;j<half;j++){
+			signal[2*j] = zr[j];
+			signal[2*j+1] = zi[j];
+		}
+	}
+}
+
+void rfft_spectrum_execute(const rfft_plan_t *plan, const double *signal,
+                           int mode, double *out,
+                           double *scratch){
+
+	size_t n = plan->n;
+	size_t half = n/2;
+	size_t j;
+
+	if(n == 0)
+		return;
+
+	if(n%2 != 0){
+		double *real = scratch;
+		double *imag = scratch + n;
+
+		memcpy(real, signal, n*sizeof(double));
+		memset(imag, 0, n*sizeof(double));
+		plan_execute(plan->full, real, imag, imag + n);
+
+		spectrum_onesided_d(real, imag, n, mode, out);
+		return;
+	}
+
+	{
+		double *zr = scratch;
+		double *zi = scratch + half;
+
+		for(j=0;j<half;j++){
+			zr[j] = signal[2*j];
+			zi[j] = signal[2*j+1];
+		}
+
+		plan_execute(plan->half, zr, zi, zi + half);
+
+		/*post-twiddle, each bin stored in the output format as soon as it is computed*/
+		rfft_post_spectrum_d(zr, zi, half, plan->tw_cos, plan->tw_sin, mode, out);
+	}
+}
@@ -0,0 +1,456 @@
+/**
+ * @file fft_simd.c
+ * @brief Vectorized butterflies of the power-of-2 plans, with runtime selection.
+ *
+ *        After the bit-reversal permutation, consecutive pairs of radix-2 stages are
+ *        fused into radix-4 stages. For a stage combining blocks of h points into
+ *        blocks of 4h points, the twiddles W4h^2j and W4h^j, j < h, are stored
+ *        contiguously in the plan, so the butterflies vectorize over j with plain loads.
+ *        When log2(n) is odd, a first radix-2 stage (no twiddles) is run.
+ *
+ *        Kernels: SSE2 and AVX2+FMA on x86 (chosen with the CPU feature flags at run
+ *        time, so the same libsignalproc.so runs on any x86-64), NEON on aarch64
+ *        (armv7 NEON has no double-precision lanes) and a portable radix-4 kernel.
+ *        FFT_KERNEL_SCALAR keeps the original radix-2 loop of transform_radix2,
+ *        which remains the reference.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fft.h"
+#include "fft_internal.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define HAVE_NEON_KERNELS 1
+#include <arm_neon.h>
+#endif
+
+/*kernel requested with fft_set_kernel, used by the plans created afterwards*/
+static int requested_kernel = FFT_KERNEL_AUTO;
+
+static void radix4_stage_portable(double *re, double *im, size_t n, size_t h, const double *tw);
+#ifdef HAVE_X86_KERNELS
+static void radix4_stage_sse2(double *re, double *im, size_t n, size_t h, const double *tw);
+static void radix4_stage_avx2(double *re, double *im, size_t n, size_t h, const double *tw);
+#endif
+#ifdef HAVE_NEON_KERNELS
+static void radix4_stage_neon(double *re, double *im, size_t n, size_t h, const double *tw);
+#endif
+
+/**
+ * int fft_kernel_available(int kernel)
+ *
+ * @brief tells if a butterfly kernel can run on this CPU.
+ * @param kernel, one of FFT_KERNEL_xxx
+ * @return 1 if available, 0 otherwise
+ */
+int fft_kernel_available(int kernel){
+
+	switch(kernel){
+		case FFT_KERNEL_AUTO:
+		case FFT_KERNEL_SCALAR:
+		case FFT_KERNEL_RADIX4:
+			return 1;
+#ifdef HAVE_X86_KERNELS
+		case FFT_KERNEL_SSE2:
+			return __builtin_cpu_supports("sse2") ? 1 : 0;
+		case FFT_KERNEL_AVX2:
+			return (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) ? 1 : 0;
+#endif
+#ifdef HAVE_NEON_KERNELS
+		case FFT_KERNEL_NEON:
+			return 1;
+#endif
+		default:
+			return 0;
+	}
+}
+
+/**
+ * int fft_set_kernel(int kernel)
+ *
+ * @brief selects the butterfly kernel used by the power-of-2 plans created from now on.
+ *        Plans that already exist keep their kernel. FFT_KERNEL_AUTO (the default)
+ *        picks the fastest kernel available on this CPU.
+ * @param kernel, one of FFT_KERNEL_xxx
+ * @return 1 if success, 0 if the kernel is not available on this CPU
+ */
+int fft_set_kernel(int kernel){
+
+	if(!fft_kernel_available(kernel))
+		return 0;
+
+	requested_kernel = kernel;
+	return 1;
+}
+
+/**
+ * int fft_get_kernel(void)
+ *
+ * @brief returns the kernel used by the plans created from now on, FFT_KERNEL_AUTO resolved.
+ */
+int fft_get_kernel(void){
+
+	if(requested_kernel != FFT_KERNEL_AUTO)
+		return requested_kernel;
+
+	if(fft_kernel_available(FFT_KERNEL_AVX2))
+		return FFT_KERNEL_AVX2;
+	if(fft_kernel_available(FFT_KERNEL_NEON))
+		return FFT_KERNEL_NEON;
+	if(fft_kernel_available(FFT_KERNEL_SSE2))
+		return FFT_KERNEL_SSE2;
+	return FFT_KERNEL_RADIX4;
+}
+
+/**
+ * const char* fft_kernel_name(int kernel)
+ *
+ * @brief returns a printable name of the kernel.
+ */
+const char* fft_kernel_name(int kernel){
+
+	switch(kernel){
+		case FFT_KERNEL_AUTO: return "auto";
+		case FFT_KERNEL_SCALAR: return "scalar";
+		case FFT_KERNEL_RADIX4: return "radix4";
+		case FFT_KERNEL_SSE2: return "sse2";
+		case FFT_KERNEL_AVX2: return "avx2";
+		case FFT_KERNEL_NEON: return "neon";
+		default: return "unknown";
+	}
+}
+
+/*
+ * Returns the stage function of the kernel, NULL for the scalar reference loop.
+ */
+radix4_stage_fn radix4_stage_select(int kernel){
+
+	switch(kernel){
+		case FFT_KERNEL_RADIX4:
+			return radix4_stage_portable;
+#ifdef HAVE_X86_KERNELS
+		case FFT_KERNEL_SSE2:
+			return radix4_stage_sse2;
+		case FFT_KERNEL_AVX2:
+			return radix4_stage_avx2;
+#endif
+#ifdef HAVE_NEON_KERNELS
+		case FFT_KERNEL_NEON:
+			return radix4_stage_neon;
+#endif
+		default:
+			return NULL;
+	}
+}
+
+/*
+ * Number of doubles of the contiguous stage twiddles of a power-of-2 plan.
+ */
+size_t radix4_table_length(unsigned int levels){
+
+	size_t length = 0;
+	size_t h = (levels % 2) ? 2 : 1;
+
+	for(; 4*h <= ((size_t)1 << levels); h *= 4){
+		length += 4*h;
+	}
+	return length;
+}
+
+/*
+ * Fills the stage twiddles: for each radix-4 stage of quarter size h,
+ * W4h^2j (real, imag) then W4h^j (real, imag), j < h, with W4h = exp(-j*2*pi/(4h)).
+ */
+void radix4_table_fill(double *tw, unsigned int levels){
+
+	size_t h = (levels % 2) ? 2 : 1;
+	size_t j;
+
+	for(; 4*h <= ((size_t)1 << levels); h *= 4){
+		for(j=0;j<h;j++){
+			tw[j] = cos(2 * M_PI * 2*j / (4*h));
+			tw[h+j] = -sin(2 * M_PI * 2*j / (4*h));
+			tw[2*h+j] = cos(2 * M_PI * j / (4*h));
+			tw[3*h+j] = -sin(2 * M_PI * j / (4*h));
+		}
+		tw += 4*h;
+	}
+}
+
+/*
+ * Butterflies of a power-of-2 plan, bit-reversed input already in place.
+ */
+void radix4_execute(const fft_plan_t *plan, double real[], double imag[]){
+
+	size_t n = plan->n;
+	const double *tw = plan->stage_tw;
+	size_t h, i;
+
+	/*odd number of levels, first radix-2 stage has no twiddle*/
+	if(plan->levels % 2){
+		for(i=0;i<n;i+=2){
+			double tr = real[i+1];
+			double ti = imag[i+1];
+			real[i+1] = real[i] - tr;
+			imag[i+1] = imag[i] - ti;
+			real[i] += tr;
+			imag[i] += ti;
+		}
+		h = 2;
+	}
+	else{
+		h = 1;
+	}
+
+	for(; 4*h <= n; h *= 4){
+		/*vector kernels need a few lanes, the short stages use the portable one*/
+		if(h < 4)
+			radix4_stage_portable(real, imag, n, h, tw);
+		else
+			plan->stage_fn(real, imag, n, h, tw);
+		tw += 4*h;
+	}
+}
+
+/*
+ * Radix-4 stage, combining blocks of h points into blocks of 4h points:
+ * two radix-2 stages of sizes 2h and 4h. The second twiddle of the
+ * second stage is W4h^(j+h) = -j*W4h^j, so it needs no table.
+ */
+static void radix4_stage_portable(double *re, double *im, size_t n, size_t h, const double *tw){
+
+	const double *w1r = tw;
+	const double *w1i = tw + h;
+	const double *w2r = tw + 2*h;
+	const double *w2i = tw + 3*h;
+	size_t b, j;
+
+	for(b=0;b<n;b+=4*h){
+		double *r0 = re + b, *r1 = r0 + h, *r2 = r1 + h, *r3 = r2 + h;
+		double *i0 = im + b, *i1 = i0 + h, *i2 = i1 + h, *i3 = i2 + h;
+
+		for(j=0;j<h;j++){
+			double tr, ti, ur, ui;
+			double y0r, y0i, y1r, y1i, y2r, y2i, y3r, y3i;
+
+			/*stage of size 2h*/
+			tr = r1[j]*w1r[j] - i1[j]*w1i[j];
+			ti = r1[j]*w1i[j] + i1[j]*w1r[j];
+			y0r = r0[j] + tr;
+			y0i = i0[j] + ti;
+			y1r = r0[j] - tr;
+			y1i = i0[j] - ti;
+
+			tr = r3[j]*w1r[j] - i3[j]*w1i[j];
+			ti = r3[j]*w1i[j] + i3[j]*w1r[j];
+			y2r = r2[j] + tr;
+			y2i = i2[j] + ti;
+			y3r = r2[j] - tr;
+			y3i = i2[j] - ti;
+
+			/*stage of size 4h*/
+			tr = y2r*w2r[j] - y2i*w2i[j];
+			ti = y2r*w2i[j] + y2i*w2r[j];
+			ur = y3r*w2r[j] - y3i*w2i[j];
+			ui = y3r*w2i[j] + y3i*w2r[j];
+
+			r0[j] = y0r + tr;
+			i0[j] = y0i + ti;
+			r2[j] = y0r - tr;
+			i2[j] = y0i - ti;
+			r1[j] = y1r + ui;
+			i1[j] = y1i - ur;
+			r3[j] = y1r - ui;
+			i3[j] = y1i + ur;
+		}
+	}
+}
+
+#ifdef HAVE_X86_KERNELS
+
+/*
+ * Same stage, two lanes of doubles. h is a multiple of 4 here.
+ */
+__attribute__((target("sse2")))
+static void radix4_stage_sse2(double *re, double *im, size_t n, size_t h, const double *tw){
+
+	const double *w1r = tw;
+	const double *w1i = tw + h;
+	const double *w2r = tw + 2*h;
+	const double *w2i = tw + 3*h;
+	size_t b, j;
+
+	for(b=0;b<n;b+=4*h){
+		double *r0 = re + b, *r1 = r0 + h, *r2 = r1 + h, *r3 = r2 + h;
+		double *i0 = im + b, *i1 = i0 + h, *i2 = i1 + h, *i3 = i2 + h;
+
+		for(j=0;j<h;j+=2){
+			__m128d ar = _mm_loadu_pd(w1r+j), ai = _mm_loadu_pd(w1i+j);
+			__m128d br = _mm_loadu_pd(w2r+j), bi = _mm_loadu_pd(w2i+j);
+			__m128d x0r = _mm_loadu_pd(r0+j), x0i = _mm_loadu_pd(i0+j);
+			__m128d x1r = _mm_loadu_pd(r1+j), x1i = _mm_loadu_pd(i1+j);
+			__m128d x2r = _mm_loadu_pd(r2+j), x2i = _mm_loadu_pd(i2+j);
+			__m128d x3r = _mm_loadu_pd(r3+j), x3i = _mm_loadu_pd(i3+j);
+			__m128d tr, ti, ur, ui;
+			__m128d y0r, y0i, y1r, y1i, y2r, y2i, y3r, y3i;
+
+			tr = _mm_sub_pd(_mm_mul_pd(x1r, ar), _mm_mul_pd(x1i, ai));
+			ti = _mm_add_pd(_mm_mul_pd(x1r, ai), _mm_mul_pd(x1i, ar));
+			y0r = _mm_add_pd(x0r, tr);
+			y0i = _mm_add_pd(x0i, ti);
+			y1r = _mm_sub_pd(x0r, tr);
+			y1i = _mm_sub_pd(x0i, ti);
+
+			tr = _mm_sub_pd(_mm_mul_pd(x3r, ar), _mm_mul_pd(x3i, ai));
+			ti = _mm_add_pd(_mm_mul_pd(x3r, ai), _mm_mul_pd(x3i, ar));
+			y2r = _mm_add_pd(x2r, tr);
+			y2i = _mm_add_pd(x2i, ti);
+			y3r = _mm_sub_pd(x2r, tr);
+			y3i = _mm_sub_pd(x2i, ti);
+
+			tr = _mm_sub_pd(_mm_mul_pd(y2r, br), _mm_mul_pd(y2i, bi));
+			ti = _mm_add_pd(_mm_mul_pd(y2r, bi), _mm_mul_pd(y2i, br));
+			ur = _mm_sub_pd(_mm_mul_pd(y3r, br), _mm_mul_pd(y3i, bi));
+			ui = _mm_add_pd(_mm_mul_pd(y3r, bi), _mm_mul_pd(y3i, br));
+
+			_mm_storeu_pd(r0+j, _mm_add_pd(y0r, tr));
+			_mm_storeu_pd(i0+j, _mm_add_pd(y0i, ti));
+			_mm_storeu_pd(r2+j, _mm_sub_pd(y0r, tr));
+			_mm_storeu_pd(i2+j, _mm_sub_pd(y0i, ti));
+			_mm_storeu_pd(r1+j, _mm_add_pd(y1r, ui));
+			_mm_storeu_pd(i1+j, _mm_sub_pd(y1i, ur));
+			_mm_storeu_pd(r3+j, _mm_sub_pd(y1r, ui));
+			_mm_storeu_pd(i3+j, _mm_add_pd(y1i, ur));
+		}
+	}
+}
+
+/*
+ * Same stage, four lanes of doubles with fused multiply-adds. h is a multiple of 4 here.
+ */
+__attribute__((target("avx2,fma")))
+static void radix4_stage_avx2(double *re, double *im, size_t n, size_t h, const double *tw){
+
+	const double *w1r = tw;
+	const double *w1i = tw + h;
+	const double *w2r = tw + 2*h;
+	const double *w2i = tw + 3*h;
+	size_t b, j;
+
+	for(b=0;b<n;b+=4*h){
+		double *r0 = re + b, *r1 = r0 + h, *r2 = r1 + h, *r3 = r2 + h;
+		double *i0 = im + b, *i1 = i0 + h, *i2 = i1 + h, *i3 = i2 + h;
+
+		for(j=0;j<h;j+=4){
+			__m256d ar = _mm256_loadu_pd(w1r+j), ai = _mm256_loadu_pd(w1i+j);
+			__m256d br = _mm256_loadu_pd(w2r+j), bi = _mm256_loadu_pd(w2i+j);
+			__m256d x0r = _mm256_loadu_pd(r0+j), x0i = _mm256_loadu_pd(i0+j);
+			__m256d x1r = _mm256_loadu_pd(r1+j), x1i = _mm256_loadu_pd(i1+j);
+			__m256d x2r = _mm256_loadu_pd(r2+j), x2i = _mm256_loadu_pd(i2+j);
+			__m256d x3r = _mm256_loadu_pd(r3+j), x3i = _mm256_loadu_pd(i3+j);
+			__m256d tr, ti, ur, ui;
+			__m256d y0r, y0i, y1r, y1i, y2r, y2i, y3r, y3i;
+
+			tr = _mm256_fmsub_pd(x1r, ar, _mm256_mul_pd(x1i, ai));
+			ti = _mm256_fmadd_pd(x1r, ai, _mm256_mul_pd(x1i, ar));
+			y0r = _mm256_add_pd(x0r, tr);
+			y0i = _mm256_add_pd(x0i, ti);
+			y1r = _mm256_sub_pd(x0r, tr);
+			y1i = _mm256_sub_pd(x0i, ti);
+
+			tr = _mm256_fmsub_pd(x3r, ar, _mm256_mul_pd(x3i, ai));
+			ti = _mm256_fmadd_pd(x3r, ai, _mm256_mul_pd(x3i, ar));
+			y2r = _mm256_add_pd(x2r, tr);
+			y2i = _mm256_add_pd(x2i, ti);
+			y3r = _mm256_sub_pd(x2r, tr);
+			y3i = _mm256_sub_pd(x2i, ti);
+
+			tr = _mm256_fmsub_pd(y2r, br, _mm256_mul_pd(y2i, bi));
+			ti = _mm256_fmadd_pd(y2r, bi, _mm256_mul_pd(y2i, br));
+			ur = _mm256_fmsub_pd(y3r, br, _mm256_mul_pd(y3i, bi));
+			ui = _mm256_fmadd_pd(y3r, bi, _mm256_mul_pd(y3i, br));
+
+			_mm256_storeu_pd(r0+j, _mm256_add_pd(y0r, tr));
+			_mm256_storeu_pd(i0+j, _mm256_add_pd(y0i, ti));
+			_mm256_storeu_pd(r2+j, _mm256_sub_pd(y0r, tr));
+			_mm256_storeu_pd(i2+j, _mm256_sub_pd(y0i, ti));
+			_mm256_storeu_pd(r1+j, _mm256_add_pd(y1r, ui));
+			_mm256_storeu_pd(i1+j, _mm256_sub_pd(y1i, ur));
+			_mm256_storeu_pd(r3+j, _mm256_sub_pd(y1r, ui));
+			_mm256_storeu_pd(i3+j, _mm256_add_pd(y1i, ur));
+		}
+	}
+
+	/*the compiler only inserts it when optimizing: without it, the SSE code that
+	  runs next (libm included) pays the AVX-SSE transition on every instruction*/
+	_mm256_zeroupper();
+}
+
+#endif
+
+#ifdef HAVE_NEON_KERNELS
+
+/*
+ * Same stage, two lanes of doubles with fused multiply-adds. h is a multiple of 4 here.
+ */
+static void radix4_stage_neon(double *re, double *im, size_t n, size_t h, const double *tw){
+
+	const double *w1r = tw;
+	const double *w1i = tw + h;
+	const double *w2r = tw + 2*h;
+	const double *w2i = tw + 3*h;
+	size_t b, j;
+
+	for(b=0;b<n;b+=4*h){
+		double *r0 = re + b, *r1 = r0 + h, *r2 = r1 + h, *r3 = r2 + h;
+		double *i0 = im + b, *i1 = i0 + h, *i2 = i1 + h, *i3 = i2 + h;
+
+		for(j=0;j<h;j+=2){
+			float64x2_t ar = vld1q_f64(w1r+j), ai = vld1q_f64(w1i+j);
+			float64x2_t br = vld1q_f64(w2r+j), bi = vld1q_f64(w2i+j);
+			float64x2_t x0r = vld1q_f64(r0+j), x0i = vld1q_f64(i0+j);
+			float64x2_t x1r = vld1q_f64(r1+j), x1i = vld1q_f64(i1+j);
+			float64x2_t x2r = vld1q_f64(r2+j), x2i = vld1q_f64(i2+j);
+			float64x2_t x3r = vld1q_f64(r3+j), x3i = vld1q_f64(i3+j);
+			float64x2_t tr, ti, ur, ui;
+			float64x2_t y0r, y0i, y1r, y1i, y2r, y2i, y3r, y3i;
+
+			tr = vfmsq_f64(vmulq_f64(x1r, ar), x1i, ai);
+			ti = vfmaq_f64(vmulq_f64(x1r, ai), x1i, ar);
+			y0r = vaddq_f64(x0r, tr);
+			y0i = vaddq_f64(x0i, ti);
+			y1r = vsubq_f64(x0r, tr);
+			y1i = vsubq_f64(x0i, ti);
+
+			tr = vfmsq_f64(vmulq_f64(x3r, ar), x3i, ai);
+			ti = vfmaq_f64(vmulq_f64(x3r, ai), x3i, ar);
+			y2r = vaddq_f64(x2r, tr);
+			y2i = vaddq_f64(x2i, ti);
+			y3r = vsubq_f64(x2r, tr);
+			y3i = vsubq_f64(x2i, ti);
+
+			tr = vfmsq_f64(vmulq_f64(y2r, br), y2i, bi);
+			ti = vfmaq_f64(vmulq_f64(y2r, bi), y2i, br);
+			ur = vfmsq_f64(vmulq_f64(y3r, br), y3i, bi);
+			ui = vfmaq_f64(vmulq_f64(y3r, bi), y3i, br);
+
+			vst1q_f64(r0+j, vaddq_f64(y0r, tr));
+			vst1q_f64(i0+j, vaddq_f64(y0i, ti));
+			vst1q_f64(r2+j, vsubq_f64(y0r, tr));
+			vst1q_f64(i2+j, vsubq_f64(y0i, ti));
+			vst1q_f64(r1+j, vaddq_f64(y1r, ui));
+			vst1q_f64(i1+j, vsubq_f64(y1i, ur));
+			vst1q_f64(r3+j, vsubq_f64(y1r, ui));
+			vst1q_f64(i3+j, vaddq_f64(y1i, ur));
+		}
+	}
+}
+
+#endif
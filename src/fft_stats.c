@@ -0,0 +1,206 @@
+/**
+ * @file fft_stats.c
+ * @brief Counters of the instrumentation layer, see fft_stats.h.
+ *
+ *        The counters are plain 64-bit integers updated with relaxed atomic additions:
+ *        no lock is taken on the hot paths, and each value read by fft_stats_get is
+ *        consistent on its own. The bytes allocated inside an entry point are measured
+ *        with a per-thread total, so that other threads allocating at the same time
+ *        are not charged to it.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*this file implements the hooks, it calls the real allocator*/
+#define FFT_STATS_NO_ALLOC_HOOK
+#include "fft_internal.h"
+
+static const char *entry_names[FFT_STATS_NB_ENTRIES] = {
+	"transform", "inverse_transform", "transform_radix2", "transform_mixed_radix",
+	"transform_bluestein", "convolve_real", "convolve_complex", "fft_2signals",
+	"abs_fft", "abs_fft_2signals", "plan_create", "transform_ws", "spectrum_ws",
+	"spectrum_2signals_ws", "convolve_ws", "spectrum_batch", "rfft", "irfft",
+	"transform_plan_f", "spectrum_plan_f", "stft_push", "abs_dft_interval",
+	"transform_interleaved", "transform_fixed", "abs_dft_interval_fixed",
+	"resampler_process", "dwt", "features"
+};
+
+static const char *path_names[FFT_STATS_NB_PATHS] = {
+	"radix2", "mixed", "bluestein", "radix2_f", "mixed_f", "bluestein_f", "codelet"
+};
+
+#ifdef SIGNALPROC_STATS
+
+/*all the counters, updated with __atomic builtins only*/
+static fft_stats_t counters;
+
+/*bytes allocated by the current thread through the hooks*/
+static __thread uint64_t thread_bytes;
+
+static uint64_t now_ns(void);
+static int size_bucket(size_t n);
+static void count_alloc(size_t bytes);
+
+#endif
+
+/**
+ * int fft_stats_enabled(void)
+ *
+ * @brief tells whether the library was built with the instrumentation.
+ * @return 1 if the counters are maintained, 0 otherwise
+ */
+int fft_stats_enabled(void){
+#ifdef SIGNALPROC_STATS
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+/**
+ * void fft_stats_get(fft_stats_t* stats)
+ *
+ * @brief copies the current value of all the counters.
+ */
+void fft_stats_get(fft_stats_t* stats){
+
+#ifdef SIGNALPROC_STATS
+	const uint64_t *src = (const uint64_t*)&counters;
+	uint64_t *dst = (uint64_t*)stats;
+	size_t i;
+
+	/*the struct only holds uint64_t, it is read as an array of them*/
+	for(i=0;i<sizeof(fft_stats_t)/sizeof(uint64_t);i++)
+		dst[i] = __atomic_load_n(src + i, __ATOMIC_RELAXED);
+#else
+	memset(stats, 0, sizeof(fft_stats_t));
+#endif
+}
+
+/**
+ * void fft_stats_reset(void)
+ *
+ * @brief sets all the counters back to zero.
+ */
+void fft_stats_reset(void){
+
+#ifdef SIGNALPROC_STATS
+	uint64_t *dst = (uint64_t*)&counters;
+	size_t i;
+
+	for(i=0;i<sizeof(fft_stats_t)/sizeof(uint64_t);i++)
+		__atomic_store_n(dst + i, 0, __ATOMIC_RELAXED);
+#endif
+}
+
+/**
+ * const char* fft_stats_entry_name(int entry)
+ *
+ * @brief returns the name of an entry point (FFT_STATS_xxx), NULL if unknown.
+ */
+const char* fft_stats_entry_name(int entry){
+
+	if(entry < 0 || entry >= FFT_STATS_NB_ENTRIES)
+		return NULL;
+	return entry_names[entry];
+}
+
+/**
+ * const char* fft_stats_path_name(int path)
+ *
+ * @brief returns the name of a dispatch path (FFT_STATS_PATH_xxx), NULL if unknown.
+ */
+const char* fft_stats_path_name(int path){
+
+	if(path < 0 || path >= FFT_STATS_NB_PATHS)
+		return NULL;
+	return path_names[path];
+}
+
+#ifdef SIGNALPROC_STATS
+
+fft_stats_scope_t fft_stats_begin(int counter, int is_path, size_t n){
+
+	fft_stats_scope_t scope;
+
+	scope.counter = counter;
+	scope.is_path = is_path;
+	scope.n = n;
+	scope.start_bytes = thread_bytes;
+	scope.start_ns = (counter < 0) ? 0 : now_ns();
+	return scope;
+}
+
+void fft_stats_end(fft_stats_scope_t *scope){
+
+	fft_stats_counter_t *counter;
+
+	if(scope->counter < 0)
+		return;
+
+	if(scope->is_path){
+		counter = counters.path + scope->counter;
+		__atomic_fetch_add(&counters.sizes[scope->counter][size_bucket(scope->n)], 1, __ATOMIC_RELAXED);
+	}else{
+		counter = counters.entry + scope->counter;
+		__atomic_fetch_add(&counter->bytes, thread_bytes - scope->start_bytes, __ATOMIC_RELAXED);
+	}
+
+	__atomic_fetch_add(&counter->calls, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&counter->ns, now_ns() - scope->start_ns, __ATOMIC_RELAXED);
+}
+
+void* fft_stats_malloc(size_t size){
+
+	void *p = malloc(size);
+	if(p != NULL)
+		count_alloc(size);
+	return p;
+}
+
+void* fft_stats_calloc(size_t nmemb, size_t size){
+
+	/*calloc checked nmemb*size for overflow if it succeeded*/
+	void *p = calloc(nmemb, size);
+	if(p != NULL)
+		count_alloc(nmemb*size);
+	return p;
+}
+
+int fft_stats_posix_memalign(void **ptr, size_t alignment, size_t size){
+
+	int status = posix_memalign(ptr, alignment, size);
+	if(status == 0)
+		count_alloc(size);
+	return status;
+}
+
+static void count_alloc(size_t bytes){
+
+	thread_bytes += bytes;
+	__atomic_fetch_add(&counters.nb_allocs, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&counters.bytes_allocated, bytes, __ATOMIC_RELAXED);
+}
+
+static uint64_t now_ns(void){
+
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec*1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static int size_bucket(size_t n){
+
+	int bucket = 0;
+
+	while(n > 1 && bucket < FFT_STATS_NB_SIZE_BUCKETS-1){
+		n >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+#endif
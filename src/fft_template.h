@@ -0,0 +1,689 @@
+/**
+ * @file fft_template.h
+ * @brief Precision-generic kernels of the fft plans: butterflies, chirp products,
+ *        real-input post-twiddles and spectrum splits. The file is included by
+ *        each translation unit which needs them, after defining
+ *        - FFT_REAL, the sample type (double or float)
+ *        - FFT_SQRT, its square root (sqrt or sqrtf)
+ *        - FFT_T(name), the name of the instance of a kernel (name_d or name_f)
+ *        so that the double and float transforms run the same code.
+ *        Everything is static inline, a translation unit only keeps what it uses.
+ */
+
+#ifndef FFT_REAL
+#error "define FFT_REAL, FFT_SQRT and FFT_T before including fft_template.h"
+#endif
+
+/*constant of the sample type, so that float kernels are not promoted to double*/
+#define FFT_C(x) ((FFT_REAL)(x))
+
+/*largest supported radix of the mixed-radix stages, size of the scratch of the generic butterfly*/
+#ifndef MAX_RADIX
+#define MAX_RADIX 11
+#endif
+
+static inline void FFT_T(mixed_work)(FFT_REAL *out_r, FFT_REAL *out_i,
+                                     const FFT_REAL *in_r, const FFT_REAL *in_i,
+                                     size_t fstride, const size_t *factors,
+                                     const FFT_REAL *twr, const FFT_REAL *twi, size_t n);
+
+/*
+ * Bit-reversed addressing permutation, in place.
+ */
+static inline void FFT_T(bitrev_permute)(FFT_REAL real[], FFT_REAL imag[], size_t n, const size_t *bitrev){
+
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		size_t j = bitrev[i];
+		if (j > i) {
+			FFT_REAL temp = real[i];
+			real[i] = real[j];
+			real[j] = temp;
+			temp = imag[i];
+			imag[i] = imag[j];
+			imag[j] = temp;
+		}
+	}
+}
+
+/*
+ * bitrev_permute with every value multiplied by scale in the same pass,
+ * the 1/n of the scaled inverse plans.
+ */
+static inline void FFT_T(bitrev_permute_scaled)(FFT_REAL real[], FFT_REAL imag[], size_t n, const size_t *bitrev,
+                                                FFT_REAL scale){
+
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		size_t j = bitrev[i];
+		if (j > i) {
+			FFT_REAL temp = real[i];
+			real[i] = real[j] * scale;
+			real[j] = temp * scale;
+			temp = imag[i];
+			imag[i] = imag[j] * scale;
+			imag[j] = temp * scale;
+		} else if (j == i) {
+			real[i] *= scale;
+			imag[i] *= scale;
+		}
+	}
+}
+
+/*
+ * Cooley-Tukey decimation-in-time radix-2 stages over bit-reversed data,
+ * cos_table/sin_table holding cos/sin(2*pi*i/n) for i < n/2.
+ */
+static inline void FFT_T(radix2_stages)(FFT_REAL real[], FFT_REAL imag[], size_t n,
+                                        const FFT_REAL *cos_table, const FFT_REAL *sin_table){
+
+	size_t size, i;
+
+	for (size = 2; size <= n; size *= 2) {
+		size_t halfsize = size / 2;
+		size_t tablestep = n / size;
+		for (i = 0; i < n; i += size) {
+			size_t j;
+			size_t k;
+			for (j = i, k = 0; j < i + halfsize; j++, k += tablestep) {
+				FFT_REAL tpre =  real[j+halfsize] * cos_table[k] + imag[j+halfsize] * sin_table[k];
+				FFT_REAL tpim = -real[j+halfsize] * sin_table[k] + imag[j+halfsize] * cos_table[k];
+				real[j + halfsize] = real[j] - tpre;
+				imag[j + halfsize] = imag[j] - tpim;
+				real[j] += tpre;
+				imag[j] += tpim;
+			}
+		}
+		if (size == n)  // Prevent overflow in 'size *= 2'
+			break;
+	}
+}
+
+/*
+ * Same permutation over interleaved complex data, element i at data[2i], data[2i+1].
+ */
+static inline void FFT_T(bitrev_permute_interleaved)(FFT_REAL data[], size_t n, const size_t *bitrev){
+
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		size_t j = bitrev[i];
+		if (j > i) {
+			FFT_REAL temp = data[2*i];
+			data[2*i] = data[2*j];
+			data[2*j] = temp;
+			temp = data[2*i+1];
+			data[2*i+1] = data[2*j+1];
+			data[2*j+1] = temp;
+		}
+	}
+}
+
+/*
+ * Same as bitrev_permute_scaled over interleaved complex data.
+ */
+static inline void FFT_T(bitrev_permute_interleaved_scaled)(FFT_REAL data[], size_t n, const size_t *bitrev,
+                                                            FFT_REAL scale){
+
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		size_t j = bitrev[i];
+		if (j > i) {
+			FFT_REAL temp = data[2*i];
+			data[2*i] = data[2*j] * scale;
+			data[2*j] = temp * scale;
+			temp = data[2*i+1];
+			data[2*i+1] = data[2*j+1] * scale;
+			data[2*j+1] = temp * scale;
+		} else if (j == i) {
+			data[2*i] *= scale;
+			data[2*i+1] *= scale;
+		}
+	}
+}
+
+/*
+ * radix2_stages over interleaved complex data, so that the two halves of a
+ * butterfly are one stream each instead of two. inverse flips the sign of the twiddles.
+ */
+static inline void FFT_T(radix2_stages_interleaved)(FFT_REAL data[], size_t n,
+                                                    const FFT_REAL *cos_table, const FFT_REAL *sin_table,
+                                                    int inverse){
+
+	FFT_REAL sign = inverse ? FFT_C(-1) : FFT_C(1);
+	size_t size, i;
+
+	for (size = 2; size <= n; size *= 2) {
+		size_t halfsize = size / 2;
+		size_t tablestep = n / size;
+		for (i = 0; i < n; i += size) {
+			FFT_REAL *lo = data + 2*i;
+			FFT_REAL *hi = lo + 2*halfsize;
+			size_t j;
+			size_t k;
+			for (j = 0, k = 0; j < 2*halfsize; j += 2, k += tablestep) {
+				FFT_REAL c = cos_table[k];
+				FFT_REAL s = sign*sin_table[k];
+				FFT_REAL tpre =  hi[j] * c + hi[j+1] * s;
+				FFT_REAL tpim = -hi[j] * s + hi[j+1] * c;
+				hi[j] = lo[j] - tpre;
+				hi[j+1] = lo[j+1] - tpim;
+				lo[j] += tpre;
+				lo[j+1] += tpim;
+			}
+		}
+		if (size == n)  // Prevent overflow in 'size *= 2'
+			break;
+	}
+}
+
+/*
+ * Conversions between interleaved complex data and split real/imag vectors.
+ */
+static inline void FFT_T(deinterleave)(const FFT_REAL *data, FFT_REAL *real, FFT_REAL *imag, size_t n){
+
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		real[i] = data[2*i];
+		imag[i] = data[2*i+1];
+	}
+}
+
+static inline void FFT_T(interleave)(const FFT_REAL *real, const FFT_REAL *imag, FFT_REAL *data, size_t n){
+
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		data[2*i] = real[i];
+		data[2*i+1] = imag[i];
+	}
+}
+
+/*
+ * out = in*exp(-j*theta), with cos/sin(theta) given for each sample.
+ * Pre and post-processing of Bluestein's algorithm; in and out may be the same vectors.
+ */
+static inline void FFT_T(chirp_rotate)(const FFT_REAL *in_r, const FFT_REAL *in_i,
+                                       FFT_REAL *out_r, FFT_REAL *out_i, size_t n,
+                                       const FFT_REAL *cos_table, const FFT_REAL *sin_table){
+
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		FFT_REAL re = in_r[i];
+		FFT_REAL im = in_i[i];
+		out_r[i] =  re * cos_table[i] + im * sin_table[i];
+		out_i[i] = -re * sin_table[i] + im * cos_table[i];
+	}
+}
+
+/*
+ * a = a*b, element-wise over m complex values.
+ */
+static inline void FFT_T(complex_multiply)(FFT_REAL *a_r, FFT_REAL *a_i,
+                                           const FFT_REAL *b_r, const FFT_REAL *b_i, size_t m){
+
+	size_t i;
+
+	for (i = 0; i < m; i++) {
+		FFT_REAL temp = a_r[i] * b_r[i] - a_i[i] * b_i[i];
+		a_i[i] = a_i[i] * b_r[i] + a_r[i] * b_i[i];
+		a_r[i] = temp;
+	}
+}
+
+/*
+ * a = a*b*scale, element-wise: the product of a convolution with the 1/n of its
+ * inverse transform folded in.
+ */
+static inline void FFT_T(complex_multiply_scaled)(FFT_REAL *a_r, FFT_REAL *a_i,
+                                                  const FFT_REAL *b_r, const FFT_REAL *b_i, size_t m,
+                                                  FFT_REAL scale){
+
+	size_t i;
+
+	for (i = 0; i < m; i++) {
+		FFT_REAL temp = (a_r[i] * b_r[i] - a_i[i] * b_i[i]) * scale;
+		a_i[i] = (a_i[i] * b_r[i] + a_r[i] * b_i[i]) * scale;
+		a_r[i] = temp;
+	}
+}
+
+/*
+ * Copy of n complex values multiplied by scale, the input of the scaled
+ * mixed-radix transforms.
+ */
+static inline void FFT_T(copy_scaled)(const FFT_REAL *in_r, const FFT_REAL *in_i,
+                                      FFT_REAL *out_r, FFT_REAL *out_i, size_t n, FFT_REAL scale){
+
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		out_r[i] = in_r[i] * scale;
+		out_i[i] = in_i[i] * scale;
+	}
+}
+
+/*
+ * Mixed-radix butterflies, see fft_mixed_radix.c. The twiddles exp(-j*2*pi*i/n)
+ * come from the n-long table (twr, twi).
+ */
+static inline void FFT_T(bfly2)(FFT_REAL *Fr, FFT_REAL *Fi, size_t fstride, size_t m,
+                                const FFT_REAL *twr, const FFT_REAL *twi){
+
+	size_t u;
+
+	for(u=0;u<m;u++){
+		size_t t = u*fstride;
+		FFT_REAL tr = Fr[u+m]*twr[t] - Fi[u+m]*twi[t];
+		FFT_REAL ti = Fr[u+m]*twi[t] + Fi[u+m]*twr[t];
+		Fr[u+m] = Fr[u] - tr;
+		Fi[u+m] = Fi[u] - ti;
+		Fr[u] += tr;
+		Fi[u] += ti;
+	}
+}
+
+static inline void FFT_T(bfly3)(FFT_REAL *Fr, FFT_REAL *Fi, size_t fstride, size_t m,
+                                const FFT_REAL *twr, const FFT_REAL *twi){
+
+	FFT_REAL epi3 = twi[fstride*m];   /*imaginary part of exp(-j*2*pi/3)*/
+	size_t u;
+
+	for(u=0;u<m;u++){
+		size_t t1 = u*fstride;
+		size_t t2 = 2*u*fstride;
+		FFT_REAL s1r = Fr[u+m]*twr[t1] - Fi[u+m]*twi[t1];
+		FFT_REAL s1i = Fr[u+m]*twi[t1] + Fi[u+m]*twr[t1];
+		FFT_REAL s2r = Fr[u+2*m]*twr[t2] - Fi[u+2*m]*twi[t2];
+		FFT_REAL s2i = Fr[u+2*m]*twi[t2] + Fi[u+2*m]*twr[t2];
+		FFT_REAL s3r = s1r + s2r;
+		FFT_REAL s3i = s1i + s2i;
+		FFT_REAL s0r = (s1r - s2r)*epi3;
+		FFT_REAL s0i = (s1i - s2i)*epi3;
+		FFT_REAL ar = Fr[u] - FFT_C(0.5)*s3r;
+		FFT_REAL ai = Fi[u] - FFT_C(0.5)*s3i;
+
+		Fr[u] += s3r;
+		Fi[u] += s3i;
+		Fr[u+2*m] = ar + s0i;
+		Fi[u+2*m] = ai - s0r;
+		Fr[u+m] = ar - s0i;
+		Fi[u+m] = ai + s0r;
+	}
+}
+
+static inline void FFT_T(bfly4)(FFT_REAL *Fr, FFT_REAL *Fi, size_t fstride, size_t m,
+                                const FFT_REAL *twr, const FFT_REAL *twi){
+
+	size_t u;
+
+	for(u=0;u<m;u++){
+		size_t t1 = u*fstride;
+		size_t t2 = 2*u*fstride;
+		size_t t3 = 3*u*fstride;
+		FFT_REAL s0r = Fr[u+m]*twr[t1] - Fi[u+m]*twi[t1];
+		FFT_REAL s0i = Fr[u+m]*twi[t1] + Fi[u+m]*twr[t1];
+		FFT_REAL s1r = Fr[u+2*m]*twr[t2] - Fi[u+2*m]*twi[t2];
+		FFT_REAL s1i = Fr[u+2*m]*twi[t2] + Fi[u+2*m]*twr[t2];
+		FFT_REAL s2r = Fr[u+3*m]*twr[t3] - Fi[u+3*m]*twi[t3];
+		FFT_REAL s2i = Fr[u+3*m]*twi[t3] + Fi[u+3*m]*twr[t3];
+		FFT_REAL s5r = Fr[u] - s1r;
+		FFT_REAL s5i = Fi[u] - s1i;
+		FFT_REAL s3r = s0r + s2r;
+		FFT_REAL s3i = s0i + s2i;
+		FFT_REAL s4r = s0r - s2r;
+		FFT_REAL s4i = s0i - s2i;
+		FFT_REAL ar = Fr[u] + s1r;
+		FFT_REAL ai = Fi[u] + s1i;
+
+		Fr[u+2*m] = ar - s3r;
+		Fi[u+2*m] = ai - s3i;
+		Fr[u] = ar + s3r;
+		Fi[u] = ai + s3i;
+		Fr[u+m] = s5r + s4i;
+		Fi[u+m] = s5i - s4r;
+		Fr[u+3*m] = s5r - s4i;
+		Fi[u+3*m] = s5i + s4r;
+	}
+}
+
+static inline void FFT_T(bfly5)(FFT_REAL *Fr, FFT_REAL *Fi, size_t fstride, size_t m,
+                                const FFT_REAL *twr, const FFT_REAL *twi){
+
+	/*exp(-j*2*pi/5) and exp(-j*4*pi/5)*/
+	FFT_REAL yar = twr[fstride*m], yai = twi[fstride*m];
+	FFT_REAL ybr = twr[2*fstride*m], ybi = twi[2*fstride*m];
+	size_t u;
+
+	for(u=0;u<m;u++){
+		size_t t1 = u*fstride;
+		size_t t2 = 2*t1;
+		size_t t3 = 3*t1;
+		size_t t4 = 4*t1;
+		FFT_REAL s0r = Fr[u], s0i = Fi[u];
+		FFT_REAL s1r = Fr[u+m]*twr[t1] - Fi[u+m]*twi[t1];
+		FFT_REAL s1i = Fr[u+m]*twi[t1] + Fi[u+m]*twr[t1];
+		FFT_REAL s2r = Fr[u+2*m]*twr[t2] - Fi[u+2*m]*twi[t2];
+		FFT_REAL s2i = Fr[u+2*m]*twi[t2] + Fi[u+2*m]*twr[t2];
+		FFT_REAL s3r = Fr[u+3*m]*twr[t3] - Fi[u+3*m]*twi[t3];
+		FFT_REAL s3i = Fr[u+3*m]*twi[t3] + Fi[u+3*m]*twr[t3];
+		FFT_REAL s4r = Fr[u+4*m]*twr[t4] - Fi[u+4*m]*twi[t4];
+		FFT_REAL s4i = Fr[u+4*m]*twi[t4] + Fi[u+4*m]*twr[t4];
+		FFT_REAL s7r = s1r + s4r, s7i = s1i + s4i;
+		FFT_REAL s10r = s1r - s4r, s10i = s1i - s4i;
+		FFT_REAL s8r = s2r + s3r, s8i = s2i + s3i;
+		FFT_REAL s9r = s2r - s3r, s9i = s2i - s3i;
+		FFT_REAL s5r = s0r + s7r*yar + s8r*ybr;
+		FFT_REAL s5i = s0i + s7i*yar + s8i*ybr;
+		FFT_REAL s6r = s10i*yai + s9i*ybi;
+		FFT_REAL s6i = -s10r*yai - s9r*ybi;
+		FFT_REAL s11r = s0r + s7r*ybr + s8r*yar;
+		FFT_REAL s11i = s0i + s7i*ybr + s8i*yar;
+		FFT_REAL s12r = -s10i*ybi + s9i*yai;
+		FFT_REAL s12i = s10r*ybi - s9r*yai;
+
+		Fr[u] = s0r + s7r + s8r;
+		Fi[u] = s0i + s7i + s8i;
+		Fr[u+m] = s5r - s6r;
+		Fi[u+m] = s5i - s6i;
+		Fr[u+4*m] = s5r + s6r;
+		Fi[u+4*m] = s5i + s6i;
+		Fr[u+2*m] = s11r + s12r;
+		Fi[u+2*m] = s11i + s12i;
+		Fr[u+3*m] = s11r - s12r;
+		Fi[u+3*m] = s11i - s12i;
+	}
+}
+
+/*
+ * Radix-p butterfly as a direct p-point DFT, the twiddles and the DFT
+ * coefficients both come from the n-long table. Used for radix 7 and 11.
+ */
+static inline void FFT_T(bfly_generic)(FFT_REAL *Fr, FFT_REAL *Fi, size_t fstride, size_t m, size_t p,
+                                       const FFT_REAL *twr, const FFT_REAL *twi, size_t n){
+
+	FFT_REAL sr[MAX_RADIX], si[MAX_RADIX];
+	size_t u, q, q1, k;
+
+	for(u=0;u<m;u++){
+
+		for(q1=0, k=u; q1<p; q1++, k+=m){
+			sr[q1] = Fr[k];
+			si[q1] = Fi[k];
+		}
+
+		for(q1=0, k=u; q1<p; q1++, k+=m){
+			size_t twidx = 0;
+			FFT_REAL accr = sr[0];
+			FFT_REAL acci = si[0];
+			for(q=1;q<p;q++){
+				twidx += fstride*k;
+				if(twidx >= n)
+					twidx -= n;
+				accr += sr[q]*twr[twidx] - si[q]*twi[twidx];
+				acci += sr[q]*twi[twidx] + si[q]*twr[twidx];
+			}
+			Fr[k] = accr;
+			Fi[k] = acci;
+		}
+	}
+}
+
+/*
+ * One stage of the mixed-radix decomposition, factors holding the
+ * (radix, remaining length) pairs of this stage and the next ones.
+ */
+static inline void FFT_T(mixed_work)(FFT_REAL *out_r, FFT_REAL *out_i,
+                                     const FFT_REAL *in_r, const FFT_REAL *in_i,
+                                     size_t fstride, const size_t *factors,
+                                     const FFT_REAL *twr, const FFT_REAL *twi, size_t n){
+
+	size_t p = factors[0];
+	size_t m = factors[1];
+	size_t q;
+
+	if(m == 1){
+		for(q=0;q<p;q++){
+			out_r[q] = in_r[q*fstride];
+			out_i[q] = in_i[q*fstride];
+		}
+	}
+	else{
+		/*decimation in time: each of the p sub-sequences is transformed recursively*/
+		for(q=0;q<p;q++){
+			FFT_T(mixed_work)(out_r + q*m, out_i + q*m, in_r + q*fstride, in_i + q*fstride,
+			                  fstride*p, factors+2, twr, twi, n);
+		}
+	}
+
+	switch(p){
+		case 2: FFT_T(bfly2)(out_r, out_i, fstride, m, twr, twi); break;
+		case 3: FFT_T(bfly3)(out_r, out_i, fstride, m, twr, twi); break;
+		case 4: FFT_T(bfly4)(out_r, out_i, fstride, m, twr, twi); break;
+		case 5: FFT_T(bfly5)(out_r, out_i, fstride, m, twr, twi); break;
+		default: FFT_T(bfly_generic)(out_r, out_i, fstride, m, p, twr, twi, n); break;
+	}
+}
+
+/*
+ * Real-input transform of even length n = 2*half: split and post-twiddle of the
+ * transform Z of the packed signal z(j) = x(2j) + j*x(2j+1), with Z(half) = Z(0)
+ * Xe(k) = 1/2*[Z(k)+Z*(half-k)]
+ * Xo(k) = 1/(j2)*[Z(k)-Z*(half-k)]
+ * X(k) = Xe(k) + exp(-j*2*pi*k/n)*Xo(k)
+ * tw_cos/tw_sin hold cos/sin(2*pi*k/n) for k <= half.
+ */
+static inline void FFT_T(rfft_post_twiddle)(const FFT_REAL *zr, const FFT_REAL *zi,
+                                            FFT_REAL *out_real, FFT_REAL *out_imag, size_t half,
+                                            const FFT_REAL *tw_cos, const FFT_REAL *tw_sin){
+
+	size_t k;
+
+	out_real[0] = zr[0] + zi[0];
+	out_imag[0] = 0;
+	out_real[half] = zr[0] - zi[0];
+	out_imag[half] = 0;
+
+	for(k=1;k<=half/2;k++){
+		size_t nk = half-k;
+		FFT_REAL er = FFT_C(0.5)*(zr[k]+zr[nk]);
+		FFT_REAL ei = FFT_C(0.5)*(zi[k]-zi[nk]);
+		FFT_REAL or = FFT_C(0.5)*(zi[k]+zi[nk]);
+		FFT_REAL oi = FFT_C(-0.5)*(zr[k]-zr[nk]);
+		FFT_REAL c = tw_cos[k];
+		FFT_REAL s = tw_sin[k];
+		FFT_REAL tr = or*c + oi*s;
+		FFT_REAL ti = oi*c - or*s;
+
+		out_real[k] = er + tr;
+		out_imag[k] = ei + ti;
+
+		/*bin half-k uses the same terms, conjugated and rotated by -pi*/
+		out_real[nk] = er - tr;
+		out_imag[nk] = -(ei - ti);
+	}
+}
+
+/*
+ * Inverse of rfft_post_twiddle, scaled by 2 so that the inverse transform of Z is n*x
+ * Z(k) = [X(k)+X*(half-k)] + j*exp(j*2*pi*k/n)*[X(k)-X*(half-k)]
+ */
+static inline void FFT_T(irfft_pre_twiddle)(const FFT_REAL *in_real, const FFT_REAL *in_imag,
+                                            FFT_REAL *zr, FFT_REAL *zi, size_t half,
+                                            const FFT_REAL *tw_cos, const FFT_REAL *tw_sin){
+
+	size_t k;
+
+	for(k=0;k<half;k++){
+		size_t nk = half-k;
+		FFT_REAL er = in_real[k] + in_real[nk];
+		FFT_REAL ei = in_imag[k] - in_imag[nk];
+		FFT_REAL dr = in_real[k] - in_real[nk];
+		FFT_REAL di = in_imag[k] + in_imag[nk];
+		FFT_REAL c = tw_cos[k];
+		FFT_REAL s = tw_sin[k];
+		FFT_REAL or = dr*c - di*s;
+		FFT_REAL oi = di*c + dr*s;
+
+		zr[k] = er - oi;
+		zi[k] = ei + or;
+	}
+}
+
+/*
+ * Recovers the spectra of two real signals packed as x = x1 + j*x2 from the
+ * full transform X of x, X1(k) = 1/2*[X(k)+X*(n-k)], X2(k) = 1/(2j)*[X(k)-X*(n-k)].
+ */
+static inline void FFT_T(split_spectra)(const FFT_REAL *X_real, const FFT_REAL *X_imag,
+                                        FFT_REAL *X1_real, FFT_REAL *X1_imag,
+                                        FFT_REAL *X2_real, FFT_REAL *X2_imag,
+                                        size_t n){
+
+	size_t k;
+
+	if(n == 0)
+		return;
+
+	X1_real[0] = X_real[0];
+	X1_imag[0] = 0;
+
+	X2_real[0] = X_imag[0];
+	X2_imag[0] = 0;
+
+	/*the nyquist bin only exists when n is even*/
+	if(n%2 == 0){
+		X1_real[n/2] = X_real[n/2];
+		X2_real[n/2] = X_imag[n/2];
+		X1_imag[n/2] = 0;
+		X2_imag[n/2] = 0;
+	}
+
+	for(k=1;k<(n+1)/2;k++){
+		X1_real[k] = FFT_C(0.5)*(X_real[k]+X_real[n-k]);
+		X2_real[k] = FFT_C(0.5)*(X_imag[k]+X_imag[n-k]);
+
+		/*make use of the symmetry*/
+		X1_real[n-k] = X1_real[k];
+		X2_real[n-k] = X2_real[k];
+
+		X1_imag[k] = FFT_C(0.5)*(X_imag[k]-X_imag[n-k]);
+		X2_imag[k] = FFT_C(-0.5)*(X_real[k]-X_real[n-k]);
+
+		/*make use of the symmetry*/
+		X1_imag[n-k] = -X1_imag[k];
+		X2_imag[n-k] = -X2_imag[k];
+	}
+}
+
+/*
+ * Stores bin k of a one-sided spectrum in the FFT_OUTPUT_xxx format, from
+ * v = 2*X(k), so that the magnitude is |v|/n as abs_fft returns it.
+ * Power and dB skip the sqrt; the complex format stores X(k) itself.
+ */
+static inline void FFT_T(spectrum_store)(FFT_REAL *out, size_t k, FFT_REAL vr, FFT_REAL vi,
+                                         size_t n, int mode){
+
+	FFT_REAL power;
+
+	switch(mode){
+		case FFT_OUTPUT_MAGNITUDE:
+			out[k] = FFT_SQRT(vr*vr + vi*vi)/n;
+			break;
+		case FFT_OUTPUT_POWER:
+			out[k] = (vr*vr + vi*vi)/((FFT_REAL)n*n);
+			break;
+		case FFT_OUTPUT_DB:
+			power = (vr*vr + vi*vi)/((FFT_REAL)n*n);
+			out[k] = (power > 0) ? (FFT_REAL)(10*log10((double)power)) : FFT_C(FFT_DB_FLOOR);
+			if(out[k] < FFT_C(FFT_DB_FLOOR))
+				out[k] = FFT_C(FFT_DB_FLOOR);
+			break;
+		default:
+			out[2*k] = FFT_C(0.5)*vr;
+			out[2*k+1] = FFT_C(0.5)*vi;
+			break;
+	}
+}
+
+/*
+ * rfft_post_twiddle fused with the output stage: the bins k and n/2-k are
+ * stored in the FFT_OUTPUT_xxx format as soon as they are computed, the
+ * one-sided spectrum is never written out. The terms are the ones of
+ * rfft_post_twiddle, doubled (v = 2*X(k)), which is exact.
+ */
+static inline void FFT_T(rfft_post_spectrum)(const FFT_REAL *zr, const FFT_REAL *zi, size_t half,
+                                             const FFT_REAL *tw_cos, const FFT_REAL *tw_sin,
+                                             int mode, FFT_REAL *out){
+
+	size_t n = 2*half;
+	size_t k;
+
+	FFT_T(spectrum_store)(out, 0, 2*(zr[0] + zi[0]), 0, n, mode);
+	FFT_T(spectrum_store)(out, half, 2*(zr[0] - zi[0]), 0, n, mode);
+
+	for(k=1;k<=half/2;k++){
+		size_t nk = half-k;
+		FFT_REAL er = zr[k]+zr[nk];
+		FFT_REAL ei = zi[k]-zi[nk];
+		FFT_REAL or = zi[k]+zi[nk];
+		FFT_REAL oi = -(zr[k]-zr[nk]);
+		FFT_REAL c = tw_cos[k];
+		FFT_REAL s = tw_sin[k];
+		FFT_REAL tr = or*c + oi*s;
+		FFT_REAL ti = oi*c - or*s;
+
+		FFT_T(spectrum_store)(out, k, er + tr, ei + ti, n, mode);
+		FFT_T(spectrum_store)(out, nk, er - tr, -(ei - ti), n, mode);
+	}
+}
+
+/*
+ * Split fused with the output stage, over the one-sided bins only: no mirrored
+ * n-k half is written. With X(n) = X(0)
+ * 2*X1(k) = X(k)+X*(N-k)
+ * 2*X2(k) = -j*[X(k)-X*(N-k)]
+ */
+static inline void FFT_T(split_spectrum)(const FFT_REAL *X_real, const FFT_REAL *X_imag, size_t n,
+                                         int mode, FFT_REAL *out_1, FFT_REAL *out_2){
+
+	size_t one_sided_fft_length = n/2+1;
+	size_t k;
+
+	if(n == 0)
+		return;
+
+	for(k=0;k<one_sided_fft_length;k++){
+		size_t nk = (k == 0) ? 0 : n-k;
+		FFT_REAL ar = X_real[k] + X_real[nk];
+		FFT_REAL ai = X_imag[k] - X_imag[nk];
+		FFT_REAL br = X_real[k] - X_real[nk];
+		FFT_REAL bi = X_imag[k] + X_imag[nk];
+		FFT_T(spectrum_store)(out_1, k, ar, ai, n, mode);
+		FFT_T(spectrum_store)(out_2, k, bi, -br, n, mode);
+	}
+}
+
+/*
+ * One-sided spectrum of a real signal in the FFT_OUTPUT_xxx format,
+ * from its full complex transform.
+ */
+static inline void FFT_T(spectrum_onesided)(const FFT_REAL *real, const FFT_REAL *imag, size_t n,
+                                            int mode, FFT_REAL *out){
+
+	size_t one_sided_fft_length = n/2+1;
+	size_t k;
+
+	if(n == 0)
+		return;
+
+	for(k=0;k<one_sided_fft_length;k++){
+		FFT_T(spectrum_store)(out, k, 2*real[k], 2*imag[k], n, mode);
+	}
+}
+
+#undef FFT_C
@@ -0,0 +1,389 @@
+/**
+ * @file fft_workspace.c
+ * @brief Allocation-free versions of the fft wrappers. They run against a plan
+ *        and use a caller-owned workspace of fft_workspace_size(n) bytes for all
+ *        their intermediate arrays, so they never touch the heap. The xxx_plan
+ *        wrappers are the same functions, using the workspace owned by the plan.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fft.h"
+#include "fft_internal.h"
+
+#define FFT_REAL double
+#define FFT_SQRT sqrt
+#define FFT_T(name) name##_d
+#include "fft_template.h"
+
+/*number of n-long vectors the wrappers need, on top of the transform's scratch*/
+#define WS_NB_VECTORS 6
+
+/**
+ * size_t fft_workspace_size(size_t n)
+ *
+ * @brief returns the size in bytes of the workspace needed by the xxx_ws functions for length n.
+ * @param n, the length of the transform
+ * @return the size of the workspace, in bytes
+ */
+size_t fft_workspace_size(size_t n){
+
+	size_t complex_length = WS_NB_VECTORS*n + transform_scratch_length(n);
+	/*two one-sided spectra and the real-input transform*/
+	size_t real_length = 4*(n/2+1) + rfft_scratch_length(n);
+
+	/*at least one double so that malloc(fft_workspace_size(0)) is valid*/
+	if(real_length > complex_length)
+		return (real_length + 1)*sizeof(double);
+	return (complex_length + 1)*sizeof(double);
+}
+
+/**
+ * int transform_ws(const fft_plan_t* plan, double real[], double imag[], void* workspace)
+ *
+ * @brief computes the transform described by the plan over the complex vector, in place.
+ * @param plan, a plan created with fft_plan_create
+ * @param real, imag, complex vector of length fft_plan_length(plan)
+ * @param workspace, fft_workspace_size(n) bytes of memory
+ * @return 1 if success, 0 otherwise
+ */
+int transform_ws(const fft_plan_t* plan, double real[], double imag[], void* workspace){
+	FFT_STATS_ENTRY(FFT_STATS_TRANSFORM_WS);
+
+	plan_execute(plan, real, imag, (double*)workspace);
+	return 1;
+}
+
+/**
+ * int transform_interleaved_ws(const fft_plan_t* plan, double data[], void* workspace)
+ *
+ * @brief same as transform_ws over an interleaved complex vector, element k at data[2k], data[2k+1].
+ * @param plan, a plan created with fft_plan_create
+ * @param data, 2*fft_plan_length(plan) values
+ * @param workspace, fft_workspace_size(n) bytes of memory
+ * @return 1 if success, 0 otherwise
+ */
+int transform_interleaved_ws(const fft_plan_t* plan, double data[], void* workspace){
+	FFT_STATS_ENTRY(FFT_STATS_TRANSFORM_WS);
+
+	plan_execute_interleaved(plan, data, (double*)workspace);
+	return 1;
+}
+
+/**
+ * int fft_2signals_ws(const fft_plan_t* plan, ...)
+ *
+ * @brief same as fft_2signals, running against a forward plan of length n.
+ * @param workspace, fft_workspace_size(n) bytes of memory
+ * @return 1 if success, 0 otherwise (inverse plan)
+ */
+int fft_2signals_ws(const fft_plan_t* plan,
+                    const double* signal_1, const double* signal_2,
+                    double* X1_real, double* X1_imag,
+                    double* X2_real, double* X2_imag,
+                    void* workspace){
+
+	size_t n = plan->n;
+	double *X_real = (double*)workspace;
+	double *X_imag = X_real + n;
+
+	if(plan->inverse)
+		return 0;
+
+	memcpy(X_real, signal_1, n*sizeof(double));
+	memcpy(X_imag, signal_2, n*sizeof(double));
+
+	/*Compute the fourier transform of the two signals at once*/
+	plan_execute(plan, X_real, X_imag, X_imag + n);
+
+	/*compute the split operation to recover X1(k) and X2(k)*/
+	split_2signals(X_real, X_imag, X1_real, X1_imag, X2_real, X2_imag, n);
+
+	return 1;
+}
+
+/**
+ * size_t fft_output_length(size_t n, int mode)
+ *
+ * @brief returns the number of values of the one-sided spectrum of an n-long signal in a given mode,
+ *        n/2+1, or 2*(n/2+1) for FFT_OUTPUT_COMPLEX. 0 for an unknown mode.
+ */
+size_t fft_output_length(size_t n, int mode){
+
+	switch(mode){
+		case FFT_OUTPUT_MAGNITUDE:
+		case FFT_OUTPUT_POWER:
+		case FFT_OUTPUT_DB:
+			return n/2+1;
+		case FFT_OUTPUT_COMPLEX:
+			return 2*(n/2+1);
+		default:
+			return 0;
+	}
+}
+
+/**
+ * int spectrum_ws(const fft_plan_t* plan, const double* signal, int mode, double* out, void* workspace)
+ *
+ * @brief computes the one-sided spectrum of a real signal, in the FFT_OUTPUT_xxx format.
+ * @param workspace, fft_workspace_size(n) bytes of memory
+ * @return 1 if success, 0 otherwise (inverse plan, unknown mode)
+ */
+int spectrum_ws(const fft_plan_t* plan,
+                const double* signal, int mode,
+                double* out,
+                void* workspace){
+	FFT_STATS_ENTRY(FFT_STATS_SPECTRUM_WS);
+
+	size_t n = plan->n;
+	double *real = (double*)workspace;
+	double *imag = real + n;
+
+	if(plan->inverse || n == 0 || fft_output_length(n, mode) == 0)
+		return 0;
+
+	/*even length: only the one-sided spectrum is computed, at half the cost*/
+	if(plan->real != NULL){
+		rfft_spectrum_execute(plan->real, signal, mode, out, real);
+		return 1;
+	}
+
+	memcpy(real, signal, n*sizeof(double));
+	memset(imag, 0, n*sizeof(double));
+
+	/*compute the complex fft*/
+	plan_execute(plan, real, imag, imag + n);
+
+	/*output stage over the one-sided bins*/
+	spectrum_onesided_d(real, imag, n, mode, out);
+
+	return 1;
+}
+
+/**
+ * int spectrum_2signals_ws(const fft_plan_t* plan, const double* signal_1, const double* signal_2, int mode,
+ *                          double* out_1, double* out_2, void* workspace)
+ *
+ * @brief computes the one-sided spectra of two real signals with one complex transform.
+ *        The split only visits the one-sided bins, the mirrored half is never written.
+ * @param workspace, fft_workspace_size(n) bytes of memory
+ * @return 1 if success, 0 otherwise (inverse plan, unknown mode)
+ */
+int spectrum_2signals_ws(const fft_plan_t* plan,
+                         const double* signal_1, const double* signal_2, int mode,
+                         double* out_1, double* out_2,
+                         void* workspace){
+	FFT_STATS_ENTRY(FFT_STATS_SPECTRUM_2SIGNALS_WS);
+
+	size_t n = plan->n;
+	double *X_real = (double*)workspace;
+	double *X_imag = X_real + n;
+
+	if(plan->inverse || n == 0 || fft_output_length(n, mode) == 0)
+		return 0;
+
+	memcpy(X_real, signal_1, n*sizeof(double));
+	memcpy(X_imag, signal_2, n*sizeof(double));
+
+	/*Compute the fourier transform of the two signals at once*/
+	plan_execute(plan, X_real, X_imag, X_imag + n);
+
+	/*split and output stage in one pass*/
+	split_spectrum_d(X_real, X_imag, n, mode, out_1, out_2);
+
+	return 1;
+}
+
+/**
+ * int abs_fft_ws(const fft_plan_t* plan, const double* signal, double* abs_onesided_fft, void* workspace)
+ *
+ * @brief same as abs_fft, running against a forward plan of length n.
+ * @param workspace, fft_workspace_size(n) bytes of memory
+ * @return 1 if success, 0 otherwise (inverse plan)
+ */
+int abs_fft_ws(const fft_plan_t* plan,
+               const double* signal,
+               double* abs_onesided_fft,
+               void* workspace){
+	return spectrum_ws(plan, signal, FFT_OUTPUT_MAGNITUDE, abs_onesided_fft, workspace);
+}
+
+/**
+ * int abs_fft_2signals_ws(const fft_plan_t* plan, ...)
+ *
+ * @brief same as abs_fft_2signals, running against a forward plan of length n.
+ * @param workspace, fft_workspace_size(n) bytes of memory
+ * @return 1 if success, 0 otherwise (inverse plan)
+ */
+int abs_fft_2signals_ws(const fft_plan_t* plan,
+                        const double* signal_1, const double* signal_2,
+                        double* X1,
+                        double* X2,
+                        void* workspace){
+	return spectrum_2signals_ws(plan, signal_1, signal_2, FFT_OUTPUT_MAGNITUDE, X1, X2, workspace);
+}
+
+/**
+ * int convolve_complex_ws(const fft_plan_t* plan, ...)
+ *
+ * @brief same as convolve_complex, running against a forward plan of length n.
+ *        outreal/outimag may be the arrays of x or y.
+ * @param workspace, fft_workspace_size(n) bytes of memory
+ * @return 1 if success, 0 otherwise (inverse plan)
+ */
+int convolve_complex_ws(const fft_plan_t* plan,
+                        const double xreal[], const double ximag[],
+                        const double yreal[], const double yimag[],
+                        double outreal[], double outimag[],
+                        void* workspace){
+	FFT_STATS_ENTRY(FFT_STATS_CONVOLVE_WS);
+
+	size_t n = plan->n;
+	size_t size = n * sizeof(double);
+	double *yr = (double*)workspace;
+	double *yi = yr + n;
+
+	if(plan->inverse)
+		return 0;
+
+	/*y first, the output may overwrite it; x is convolved in the output arrays*/
+	memcpy(yr, yreal, size);
+	memcpy(yi, yimag, size);
+	memmove(outreal, xreal, size);
+	memmove(outimag, ximag, size);
+
+	convolve_execute(plan, outreal, outimag, yr, yi, yi + n);
+	return 1;
+}
+
+/**
+ * int convolve_complex_inplace_ws(const fft_plan_t* plan, double xreal[], double ximag[],
+ *                                 double yreal[], double yimag[], void* workspace)
+ *
+ * @brief circular convolution of x and y, written over x. y is overwritten with its transform.
+ * @param workspace, fft_workspace_size(n) bytes of memory
+ * @return 1 if success, 0 otherwise (inverse plan)
+ */
+int convolve_complex_inplace_ws(const fft_plan_t* plan,
+                                double xreal[], double ximag[],
+                                double yreal[], double yimag[],
+                                void* workspace){
+	FFT_STATS_ENTRY(FFT_STATS_CONVOLVE_WS);
+
+	if(plan->inverse)
+		return 0;
+
+	convolve_execute(plan, xreal, ximag, yreal, yimag, (double*)workspace);
+	return 1;
+}
+
+/**
+ * int convolve_real_ws(const fft_plan_t* plan, const double x[], const double y[], double out[], void* workspace)
+ *
+ * @brief same as convolve_real, running against a forward plan of length n.
+ * @param workspace, fft_workspace_size(n) bytes of memory
+ * @return 1 if success, 0 otherwise (inverse plan)
+ */
+int convolve_real_ws(const fft_plan_t* plan,
+                     const double x[], const double y[], double out[],
+                     void* workspace){
+	FFT_STATS_ENTRY(FFT_STATS_CONVOLVE_WS);
+
+	size_t n = plan->n;
+	double *xr = (double*)workspace;
+	double *xi = xr + n;
+	double *yr = xi + n;
+	double *yi = yr + n;
+	double *scratch = yi + n;
+
+	if(plan->inverse)
+		return 0;
+
+	/*even length: multiply the one-sided spectra, with the 1/n of the inverse folded in*/
+	if(plan->real != NULL){
+		size_t half = n/2+1;
+		xi = xr + half;
+		yr = xi + half;
+		yi = yr + half;
+		scratch = yi + half;
+
+		rfft_execute(plan->real, x, xr, xi, scratch);
+		rfft_execute(plan->real, y, yr, yi, scratch);
+		complex_multiply_scaled_d(xr, xi, yr, yi, half, 1.0/n);
+		irfft_execute(plan->real, xr, xi, out, scratch);
+		return 1;
+	}
+
+	memcpy(xr, x, n * sizeof(double));
+	memset(xi, 0, n * sizeof(double));
+	memcpy(yr, y, n * sizeof(double));
+	memset(yi, 0, n * sizeof(double));
+
+	convolve_execute(plan, xr, xi, yr, yi, scratch);
+	memcpy(out, xr, n * sizeof(double));
+
+	return 1;
+}
+
+/*
+ * x = x (*) y in place. Both vectors are transformed in place, their product
+ * takes the 1/n of the inverse transform, which runs on x by swapping its
+ * real and imaginary parts.
+ */
+void convolve_execute(const fft_plan_t *plan, double xr[], double xi[], double yr[], double yi[], double *scratch){
+
+	size_t n = plan->n;
+
+	if(n == 0)
+		return;
+
+	plan_execute(plan, xr, xi, scratch);
+	plan_execute(plan, yr, yi, scratch);
+	complex_multiply_scaled_d(xr, xi, yr, yi, n, 1.0/n);
+	plan_execute(plan, xi, xr, scratch);
+}
+
+/*
+ * The xxx_plan wrappers run the xxx_ws functions in the workspace owned by the plan.
+ */
+
+int transform_plan(fft_plan_t* plan, double real[], double imag[]){
+	return transform_ws(plan, real, imag, plan->work);
+}
+
+int transform_interleaved_plan(fft_plan_t* plan, double data[]){
+	return transform_interleaved_ws(plan, data, plan->work);
+}
+
+int fft_2signals_plan(fft_plan_t* plan,
+                      double* signal_1, double* signal_2,
+                      double* X1_real, double* X1_imag,
+                      double* X2_real, double* X2_imag){
+	return fft_2signals_ws(plan, signal_1, signal_2, X1_real, X1_imag, X2_real, X2_imag, plan->work);
+}
+
+int abs_fft_plan(fft_plan_t* plan,
+                 double* signal,
+                 double* abs_onesided_fft){
+	return abs_fft_ws(plan, signal, abs_onesided_fft, plan->work);
+}
+
+int abs_fft_2signals_plan(fft_plan_t* plan,
+                          double* signal_1, double* signal_2,
+                          double* X1,
+                          double* X2){
+	return abs_fft_2signals_ws(plan, signal_1, signal_2, X1, X2, plan->work);
+}
+
+int spectrum_plan(fft_plan_t* plan,
+                  const double* signal, int mode,
+                  double* out){
+	return spectrum_ws(plan, signal, mode, out, plan->work);
+}
+
+int spectrum_2signals_plan(fft_plan_t* plan,
+                           const double* signal_1, const double* signal_2, int mode,
+                           double* out_1, double* out_2){
+	return spectrum_2signals_ws(plan, signal_1, signal_2, mode, out_1, out_2, plan->work);
+}
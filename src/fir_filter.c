@@ -0,0 +1,252 @@
+/**
+ * @file fir_filter.c
+ * @brief Streaming FIR filter, overlap-save over real-input transforms.
+ *
+ *        With a kernel of m taps and a transform of length nfft (a power of 2), a block
+ *        holds the m-1 last samples of the previous blocks followed by L = nfft-m+1
+ *        new samples. The circular convolution of the block with the kernel is exact
+ *        on its last L samples, which are the filtered new samples. The kernel is
+ *        transformed once at creation, with the 1/nfft of the inverse folded in.
+ *
+ *        New samples are gathered in the block while the output of the previous block
+ *        is handed out, which is where the one-block latency comes from.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fft.h"
+
+/*smallest transform the automatic block selection looks at, below it the per-block overhead dominates*/
+#define FIR_MIN_NFFT 64
+/*largest transform the automatic block selection looks at, in multiples of the kernel length*/
+#define FIR_MAX_NFFT_RATIO 64
+
+/**
+ * struct fir_filter_s
+ * @brief state of a streaming FIR filter
+ */
+struct fir_filter_s{
+
+	size_t kernel_length;
+	size_t nfft;
+	size_t block_length;     /*new samples per block, nfft - kernel_length + 1*/
+
+	rfft_plan_t *plan;
+	void *workspace;         /*rfft_workspace_size(nfft) bytes*/
+
+	/*spectrum of the zero-padded kernel, divided by nfft (nfft/2+1 bins)*/
+	double *H_real;
+	double *H_imag;
+
+	/*spectrum of the current block*/
+	double *X_real;
+	double *X_imag;
+
+	/*kernel_length-1 samples of history then the new samples, nfft values*/
+	double *block;
+	double *y;               /*circular convolution of the block, nfft values*/
+
+	/*filtered samples of the previous block, handed out while the next one fills up*/
+	double *out_block;
+	size_t pos;
+};
+
+static size_t fir_nfft(size_t kernel_length, size_t block_length);
+static void fir_filter_block(fir_filter_t *filter);
+
+/**
+ * fir_filter_t* fir_filter_create(const double* kernel, size_t kernel_length, size_t block_length)
+ *
+ * @brief creates a streaming filter, y[t] = sum kernel[j]*x[t-j] for j in [0, kernel_length).
+ * @return the filter, NULL if out of memory or if the kernel is empty
+ */
+fir_filter_t* fir_filter_create(const double* kernel, size_t kernel_length, size_t block_length){
+
+	fir_filter_t *filter;
+	size_t nfft, half, k;
+
+	if(kernel_length == 0)
+		return NULL;
+
+	nfft = fir_nfft(kernel_length, block_length);
+	if(nfft == 0)
+		return NULL;
+	half = nfft/2+1;
+
+	filter = (fir_filter_t*)calloc(1, sizeof(fir_filter_t));
+	if(filter == NULL)
+		return NULL;
+
+	filter->kernel_length = kernel_length;
+	filter->nfft = nfft;
+	filter->block_length = nfft - kernel_length + 1;
+
+	filter->plan = rfft_plan_create(nfft);
+	filter->workspace = fft_malloc(rfft_workspace_size(nfft));
+	filter->H_real = (double*)malloc(half*sizeof(double));
+	filter->H_imag = (double*)malloc(half*sizeof(double));
+	filter->X_real = (double*)malloc(half*sizeof(double));
+	filter->X_imag = (double*)malloc(half*sizeof(double));
+	filter->block = (double*)malloc(nfft*sizeof(double));
+	filter->y = (double*)malloc(nfft*sizeof(double));
+	filter->out_block = (double*)malloc(filter->block_length*sizeof(double));
+	if(filter->plan == NULL || filter->workspace == NULL
+			|| filter->H_real == NULL || filter->H_imag == NULL
+			|| filter->X_real == NULL || filter->X_imag == NULL
+			|| filter->block == NULL || filter->y == NULL
+			|| filter->out_block == NULL){
+		fir_filter_destroy(filter);
+		return NULL;
+	}
+
+	/*spectrum of the zero-padded kernel, the block buffer is free at this point*/
+	memcpy(filter->block, kernel, kernel_length*sizeof(double));
+	memset(filter->block + kernel_length, 0, (nfft - kernel_length)*sizeof(double));
+	rfft_ws(filter->plan, filter->block, filter->H_real, filter->H_imag, filter->workspace);
+	for(k=0;k<half;k++){
+		filter->H_real[k] /= nfft;
+		filter->H_imag[k] /= nfft;
+	}
+
+	fir_filter_reset(filter);
+
+	return filter;
+}
+
+/**
+ * void fir_filter_destroy(fir_filter_t* filter)
+ *
+ * @brief releases the memory held by a filter. NULL is accepted.
+ */
+void fir_filter_destroy(fir_filter_t* filter){
+
+	if(filter == NULL)
+		return;
+
+	rfft_plan_destroy(filter->plan);
+	free(filter->workspace);
+	free(filter->H_real);
+	free(filter->H_imag);
+	free(filter->X_real);
+	free(filter->X_imag);
+	free(filter->block);
+	free(filter->y);
+	free(filter->out_block);
+	free(filter);
+}
+
+/**
+ * void fir_filter_reset(fir_filter_t* filter)
+ *
+ * @brief clears the history of the filter, as if only zeros had been pushed.
+ */
+void fir_filter_reset(fir_filter_t* filter){
+
+	memset(filter->block, 0, filter->nfft*sizeof(double));
+	memset(filter->out_block, 0, filter->block_length*sizeof(double));
+	filter->pos = 0;
+}
+
+/**
+ * size_t fir_filter_latency(const fir_filter_t* filter)
+ *
+ * @brief returns the delay of the output, in samples (the block length).
+ */
+size_t fir_filter_latency(const fir_filter_t* filter){
+	return filter->block_length;
+}
+
+/**
+ * void fir_filter_process(fir_filter_t* filter, const double* in, double* out, size_t count)
+ *
+ * @brief filters count new samples, in runs up to the end of the current block.
+ */
+void fir_filter_process(fir_filter_t* filter, const double* in, double* out, size_t count){
+
+	double *fresh = filter->block + filter->kernel_length - 1;
+	size_t done = 0;
+
+	while(done < count){
+
+		size_t run = filter->block_length - filter->pos;
+		if(run > count - done)
+			run = count - done;
+
+		/*the input is read before the output is written, in and out may be the same*/
+		memcpy(fresh + filter->pos, in + done, run*sizeof(double));
+		memcpy(out + done, filter->out_block + filter->pos, run*sizeof(double));
+		done += run;
+		filter->pos += run;
+
+		if(filter->pos == filter->block_length){
+			fir_filter_block(filter);
+			filter->pos = 0;
+		}
+	}
+}
+
+/*
+ * Filters the full block into out_block, then keeps its last kernel_length-1
+ * samples as the history of the next one.
+ */
+static void fir_filter_block(fir_filter_t *filter){
+
+	size_t half = filter->nfft/2+1;
+	size_t history = filter->kernel_length - 1;
+	size_t k;
+
+	rfft_ws(filter->plan, filter->block, filter->X_real, filter->X_imag, filter->workspace);
+
+	for(k=0;k<half;k++){
+		double re = filter->X_real[k]*filter->H_real[k] - filter->X_imag[k]*filter->H_imag[k];
+		double im = filter->X_real[k]*filter->H_imag[k] + filter->X_imag[k]*filter->H_real[k];
+		filter->X_real[k] = re;
+		filter->X_imag[k] = im;
+	}
+
+	irfft_ws(filter->plan, filter->X_real, filter->X_imag, filter->y, filter->workspace);
+
+	/*the first kernel_length-1 samples are wrapped around, the others are exact*/
+	memcpy(filter->out_block, filter->y + history, filter->block_length*sizeof(double));
+
+	memmove(filter->block, filter->block + filter->block_length, history*sizeof(double));
+}
+
+/*
+ * Transform length for a kernel: the power of 2 that holds block_length new samples
+ * when given, otherwise the one with the lowest cost per new sample,
+ * nfft*log2(nfft)/(nfft - kernel_length + 1). 0 if it overflows.
+ */
+static size_t fir_nfft(size_t kernel_length, size_t block_length){
+
+	size_t nfft = 2;
+	size_t best = 0;
+	double best_cost = 0;
+
+	if(block_length > 0){
+		while(nfft < block_length + kernel_length - 1){
+			if(nfft > ((size_t)-1)/2)
+				return 0;
+			nfft *= 2;
+		}
+		return nfft;
+	}
+
+	nfft = FIR_MIN_NFFT;
+	while(nfft < kernel_length){
+		if(nfft > ((size_t)-1)/2)
+			return 0;
+		nfft *= 2;
+	}
+
+	for(;nfft/FIR_MAX_NFFT_RATIO <= kernel_length && nfft <= ((size_t)-1)/2;nfft*=2){
+		double cost = nfft*log2((double)nfft)/(nfft - kernel_length + 1);
+		if(best == 0 || cost < best_cost){
+			best = nfft;
+			best_cost = cost;
+		}
+	}
+
+	return best;
+}
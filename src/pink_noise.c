@@ -16,16 +16,43 @@
  */
 
 # include <stdlib.h>
-# include <stdio.h>
+# include <stdint.h>
+# include <assert.h>
 
 # include "signal_generator.h"
 
-#define PINK_GEN_NB 31
+#define PINK_GEN_NB PINK_MAX_ROWS
+
+/*ran1f holds row i for 2^i samples in an int*/
+#if PINK_MAX_ROWS > 31
+#error "PINK_MAX_ROWS is more than the 31 rows of ran1f"
+#endif
+
+/*the sum of the rows of a pink_generator is recomputed every 2^PINK_RESYNC_LOG2 samples*/
+#define PINK_RESYNC_LOG2 10
+
+/**
+ * struct pink_generator_s
+ * @brief rows of a streaming Voss-McCartney generator
+ */
+struct pink_generator_s{
+	
+	int nb_rows;
+	double u[PINK_MAX_ROWS];   /*current value of each row*/
+	double sum;                /*sum of the rows*/
+	uint64_t counter;          /*number of samples since the last reset*/
+	signal_rng_t rng;
+};
 
 void cdelay2 ( int D, int *q );
 double ran1f ( int B, double u[], int q[] );
 double ranh ( int D, double *u, int *q );
 void wrap2 ( int M, int *q );
+static void pink_init(double u[], int q[], signal_rng_t *rng);
+static double ran1f_rng ( int b, double u[], int q[], signal_rng_t *rng );
+static double ranh_rng ( int d, double *u, int *q, signal_rng_t *rng );
+static double pink_uniform(signal_rng_t *rng);
+static int trailing_zeros(uint64_t x);
 
 /**
  * void get_signal_pink(double* signal, int sample_length)
@@ -39,10 +66,247 @@ void get_pink_signal(double* signal, int n)
 	int q[PINK_GEN_NB];
 	double u[PINK_GEN_NB];
 	
+	pink_init(u, q, NULL);
+
+	for ( i = 0; i < n; i++ ){
+		
+		signal[i] = ran1f ( PINK_GEN_NB, u, q );
+	}
+	  
+  
+	return;
+}
+
+/**
+ * void get_pink_signal_f(float* signal, int n)
+ * @brief float version of get_pink_signal, same sequence of samples rounded to float.
+ */ 
+void get_pink_signal_f(float* signal, int n)
+{
+	int i;
+	int q[PINK_GEN_NB];
+	double u[PINK_GEN_NB];
+	
+	pink_init(u, q, NULL);
+
+	for ( i = 0; i < n; i++ ){
+		
+		signal[i] = (float)ran1f ( PINK_GEN_NB, u, q );
+	}
+}
+
+/**
+ * void get_pink_signal_r(signal_rng_t* rng, double* signal, int n)
+ * @brief same as get_pink_signal, drawing from rng.
+ */ 
+void get_pink_signal_r(signal_rng_t* rng, double* signal, int n)
+{
+	int i;
+	int q[PINK_GEN_NB];
+	double u[PINK_GEN_NB];
+	
+	pink_init(u, q, rng);
+
+	for ( i = 0; i < n; i++ ){
+		
+		signal[i] = ran1f_rng ( PINK_GEN_NB, u, q, rng );
+	}
+}
+
+/**
+ * void get_pink_signal_f_r(signal_rng_t* rng, float* signal, int n)
+ * @brief same as get_pink_signal_f, drawing from rng.
+ */ 
+void get_pink_signal_f_r(signal_rng_t* rng, float* signal, int n)
+{
+	int i;
+	int q[PINK_GEN_NB];
+	double u[PINK_GEN_NB];
+	
+	pink_init(u, q, rng);
+
+	for ( i = 0; i < n; i++ ){
+		
+		signal[i] = (float)ran1f_rng ( PINK_GEN_NB, u, q, rng );
+	}
+}
+
+/**
+ * pink_generator_t* pink_generator_create(int nb_rows, const signal_rng_t* rng)
+ * @brief creates a pink noise generator.
+ * @return the generator, NULL if out of memory or if nb_rows is out of range
+ */ 
+pink_generator_t* pink_generator_create(int nb_rows, const signal_rng_t* rng)
+{
+	pink_generator_t *gen;
+	
+	/*checked once here: row i holds for 2^i >= 1 samples and wraps at 2^i - 1 >= 0*/
+	if ( nb_rows < 1 || PINK_MAX_ROWS < nb_rows ){
+		
+		return NULL;
+	}
+	
+	gen = (pink_generator_t*)malloc(sizeof(pink_generator_t));
+	if ( gen == NULL ){
+		
+		return NULL;
+	}
+	
+	gen->nb_rows = nb_rows;
+	if ( rng != NULL ){
+		
+		gen->rng = *rng;
+	}else{
+		
+		signal_rng_seed ( &gen->rng, (uint64_t)rand ( ) );
+	}
+	
+	pink_generator_reset ( gen );
+	
+	return gen;
+}
+
+/**
+ * void pink_generator_destroy(pink_generator_t* gen)
+ * @brief releases the memory held by a generator. NULL is accepted.
+ */ 
+void pink_generator_destroy(pink_generator_t* gen)
+{
+	free(gen);
+}
+
+/**
+ * void pink_generator_reset(pink_generator_t* gen)
+ * @brief redraws all the rows and restarts the sample counter.
+ */ 
+void pink_generator_reset(pink_generator_t* gen)
+{
+	int i;
+	
+	/*same initial state as get_pink_signal, 0 mean rows*/
+	gen->sum = 0.0;
+	for ( i = 0; i < gen->nb_rows; i++ ){
+		
+		gen->u[i] = signal_rng_uniform ( &gen->rng ) - 0.5;
+		gen->sum += gen->u[i];
+	}
+	
+	gen->counter = 0;
+}
+
+/**
+ * void pink_generator_next(pink_generator_t* gen, double* signal, int n)
+ * @brief generates the next n samples of the stream.
+ *        After sample t (counter t+1), the rows i <= ctz(t+1) are due, as in ranh
+ *        where row i holds its value for 2^i samples.
+ */ 
+void pink_generator_next(pink_generator_t* gen, double* signal, int n)
+{
+	int i, k;
+	
+	for ( i = 0; i < n; i++ ){
+		
+		int last;
+		
+		signal[i] = gen->sum / gen->nb_rows;
+		
+		gen->counter++;
+		last = trailing_zeros ( gen->counter );
+		if ( gen->nb_rows <= last ){
+			
+			last = gen->nb_rows - 1;
+		}
+		
+		for ( k = 0; k <= last; k++ ){
+			
+			double fresh = 2.0 * signal_rng_uniform ( &gen->rng ) - 1.0;
+			gen->sum += fresh - gen->u[k];
+			gen->u[k] = fresh;
+		}
+		
+		/*recompute the sum from time to time, to keep round-off from accumulating*/
+		if ( PINK_RESYNC_LOG2 <= last ){
+			
+			gen->sum = 0.0;
+			for ( k = 0; k < gen->nb_rows; k++ ){
+				
+				gen->sum += gen->u[k];
+			}
+		}
+	}
+}
+
+/**
+ * void pink_generator_next_f(pink_generator_t* gen, float* signal, int n)
+ * @brief float version of pink_generator_next, the same stream rounded to float.
+ */ 
+void pink_generator_next_f(pink_generator_t* gen, float* signal, int n)
+{
+	double chunk[64];
+	int i, done = 0;
+	
+	while ( done < n ){
+		
+		int count = ( n - done < 64 ) ? n - done : 64;
+		
+		pink_generator_next ( gen, chunk, count );
+		for ( i = 0; i < count; i++ ){
+			
+			signal[done+i] = (float)chunk[i];
+		}
+		done += count;
+	}
+}
+
+/*
+ * Number of trailing zero bits of x, 64 for 0.
+ */
+static int trailing_zeros(uint64_t x)
+{
+	int n = 0;
+	
+	if ( x == 0 ){
+		
+		return 64;
+	}
+	
+#if defined(__GNUC__)
+	n = __builtin_ctzll ( x );
+#else
+	while ( ( x & 1 ) == 0 ){
+		
+		x >>= 1;
+		n++;
+	}
+#endif
+	
+	return n;
+}
+
+/*
+ * Uniform number in [0, 1], from rng or from the global rand() when rng is NULL.
+ */
+static double pink_uniform(signal_rng_t *rng)
+{
+	if ( rng != NULL ){
+		
+		return signal_rng_uniform ( rng );
+	}
+	
+	return ( double ) rand ( ) / ( double ) ( RAND_MAX );
+}
+
+/*
+ * Initial state of the generators, shared by both precisions.
+ */
+static void pink_init(double u[], int q[], signal_rng_t *rng)
+{
+	int i;
+	
 	/*generate a set of random numbers, with 0 mean*/
 	for ( i = 0; i < PINK_GEN_NB; i++ ){
 		
-		u[i] = (double)rand()/(double)(RAND_MAX)-0.5;
+		u[i] = pink_uniform(rng)-0.5;
 		//2.0*(double)rand()/(double)(RAND_MAX)-1.0;
 	}
 	
@@ -50,14 +314,6 @@ void get_pink_signal(double* signal, int n)
 		
 		q[i] = 0;
 	}
-
-	for ( i = 0; i < n; i++ ){
-		
-		signal[i] = ran1f ( PINK_GEN_NB, u, q );
-	}
-	  
-  
-	return;
 }
 
 /*
@@ -162,28 +418,34 @@ void cdelay2 ( int m, int *q )
     Input/output, int Q[B], a set of counters that determine when each
     entry of U is to be updated.
 
-    Output, double RAN1F, the value.
+    Output, double RAN1F, the value, 0 if B is more than 31 (the state is left untouched).
 */
 double ran1f ( int b, double u[], int q[] )
 {
-	int i;
-	int j;
-	double y;
-
 	if ( 31 < b ){
 		
-		fprintf ( stderr, "\n" );
-		fprintf ( stderr, "RAN1F - Fatal error!\n" );
-		fprintf ( stderr, "  32 <= B, too many signals.\n" );
-		exit ( 1 );
+		return 0.0;
 	}
+	
+	return ran1f_rng ( b, u, q, NULL );
+}
+
+/*
+  ran1f drawing the new values of U from rng (the global rand() when rng is NULL).
+*/
+static double ran1f_rng ( int b, double u[], int q[], signal_rng_t *rng )
+{
+	int i;
+	double y;
+
+	/*unreachable from the generators: PINK_MAX_ROWS <= 31 is checked at compile time*/
+	assert ( b <= 31 );
 
 	y = 0.0;
-	j = 1;
 	
+	/*the hold period of signal i is 2^i, computed per signal so it never overflows*/
 	for ( i = 0; i < b; i++ ){
-		y = y + ranh ( j, u+i, q+i );
-		j = j * 2;
+		y = y + ranh_rng ( 1 << i, u+i, q+i, rng );
 	}
 	
 	if ( 0 < b ){
@@ -229,20 +491,28 @@ double ran1f ( int b, double u[], int q[] )
     Input/output, int *Q, a counter which is decremented by 1 on each call
     until reaching 0.
 
-    Output, double RANH, the input value of U.
+    Output, double RANH, the input value of U, 0 if D < 1 (the state is left untouched).
 */
 double ranh ( int d, double *u, int *q )
 {
-	double y;
-
 	if ( d < 1 ){
 		
-		fprintf ( stderr, "\n" );
-		fprintf ( stderr, "RANH - Fatal error!\n" );
-		fprintf ( stderr, "  D < 1.\n" );
-		exit ( 1 );
+		return 0.0;
 	}
 	
+	return ranh_rng ( d, u, q, NULL );
+}
+
+/*
+  ranh drawing the new value of U from rng (the global rand() when rng is NULL).
+*/
+static double ranh_rng ( int d, double *u, int *q, signal_rng_t *rng )
+{
+	double y;
+
+	/*ran1f_rng only passes hold periods 2^i >= 1*/
+	assert ( 1 <= d );
+	
 	/*Hold this sample for D calls.*/
 	y = *u;
 	
@@ -252,7 +522,7 @@ double ranh ( int d, double *u, int *q )
 	/*Every D calls, get a new U with zero mean.*/
 	if ( *q == 0 )
 	{
-		*u = 2.0 * ( double ) rand ( ) / ( double ) ( RAND_MAX ) - 1.0;
+		*u = 2.0 * pink_uniform ( rng ) - 1.0;
 	}
 	return y;
 }
@@ -314,16 +584,13 @@ double ranh ( int d, double *u, int *q )
     Input, int M, the maximum acceptable value for outputs.
     M must be at least 0.
 
-    Input/output, int *Q, the value to be wrapped.
+    Input/output, int *Q, the value to be wrapped, left untouched if M < 0.
 */
 void wrap2 ( int m, int *q ){
 
 	if ( m < 0 ){
 		
-		fprintf ( stderr, "\n" );
-		fprintf ( stderr, "WRAP2 - Fatal error!\n" );
-		fprintf ( stderr, "  M < 0.\n" );
-		exit ( 1 );
+		return;
 	}
 	
 	/*When Q = M + 1, it wraps to Q = 0.*/
@@ -0,0 +1,294 @@
+/**
+ * @file resampler.c
+ * @brief Streaming polyphase resampler by a rational factor up/down.
+ *
+ *        Resampling is upsampling by 'up' (zeros between the samples), lowpass filtering
+ *        and keeping one output every 'down'. Output m lies at time t = m*down of the
+ *        upsampled stream: only the taps of phase p = t%up meet non-zero samples, so
+ *        it is the dot product of the kernel coefficients p, p+up, p+2*up, ... with the
+ *        last input samples. The kernel is split in its 'up' phases at creation, each
+ *        one reversed so that the product runs forward over the history.
+ *
+ *        The history is kept twice in a buffer of 2*taps samples, every sample written
+ *        at pos and pos+taps, so that the last taps samples are always contiguous.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fft.h"
+#include "fft_internal.h"
+
+/*zero crossings of the sinc on each side, at the lower of the two rates*/
+#define RESAMPLER_DEFAULT_HALF_WIDTH 16
+/*Kaiser window of the kernel, about 80 dB of stopband attenuation*/
+#define RESAMPLER_KAISER_BETA 8.0
+/*outputs per stft_push in resampler_push_stft*/
+#define RESAMPLER_CHUNK 256
+
+/**
+ * struct resampler_s
+ * @brief state of a streaming resampler
+ */
+struct resampler_s{
+
+	int up;
+	int down;
+	size_t kernel_length;
+	size_t taps;             /*taps per phase, ceil(kernel_length/up)*/
+
+	/*phase p at coeffs + p*taps, reversed: coeffs[p*taps + j] = h[p + up*(taps-1-j)]*/
+	double *coeffs;
+
+	/*last taps input samples twice, the oldest one at history[pos]*/
+	double *history;
+	size_t pos;
+
+	/*phase of the next output, and number of samples to push before the one that completes it*/
+	int phase;
+	size_t wait;
+
+	/*outputs of resampler_push_stft, RESAMPLER_CHUNK + up/down + 1 values*/
+	double *chunk;
+};
+
+static double bessel_i0(double x);
+
+/**
+ * resampler_t* resampler_create(int up, int down, size_t half_width)
+ *
+ * @brief creates a resampler from rate fs to rate fs*up/down, with a Kaiser-windowed sinc kernel.
+ * @return the resampler, NULL if out of memory or if a factor is not positive
+ */
+resampler_t* resampler_create(int up, int down, size_t half_width){
+
+	resampler_t *resampler;
+	int g, a, b, rate;
+	double center, cutoff, sum;
+	size_t i, p, j, capacity;
+
+	if(up <= 0 || down <= 0)
+		return NULL;
+	if(half_width == 0)
+		half_width = RESAMPLER_DEFAULT_HALF_WIDTH;
+
+	/*up/down in lowest terms, the phases of 2/4 would repeat the ones of 1/2*/
+	for(a=up,b=down;b!=0;){
+		g = a % b;
+		a = b;
+		b = g;
+	}
+	up /= a;
+	down /= a;
+	rate = (up > down) ? up : down;
+
+	resampler = (resampler_t*)calloc(1, sizeof(resampler_t));
+	if(resampler == NULL)
+		return NULL;
+
+	resampler->up = up;
+	resampler->down = down;
+	resampler->kernel_length = 2*half_width*rate + 1;
+	resampler->taps = (resampler->kernel_length + up - 1)/up;
+
+	/*an stft_push of RESAMPLER_CHUNK outputs, or the outputs of a single input*/
+	capacity = RESAMPLER_CHUNK + up/down + 1;
+
+	resampler->coeffs = (double*)calloc((size_t)up*resampler->taps, sizeof(double));
+	resampler->history = (double*)malloc(2*resampler->taps*sizeof(double));
+	resampler->chunk = (double*)malloc(capacity*sizeof(double));
+	if(resampler->coeffs == NULL || resampler->history == NULL || resampler->chunk == NULL){
+		resampler_destroy(resampler);
+		return NULL;
+	}
+
+	/*lowpass at the lower Nyquist frequency, 1/(2*rate) of the upsampled rate*/
+	center = (resampler->kernel_length - 1)/2.0;
+	cutoff = 0.5/rate;
+	sum = 0;
+	for(i=0;i<resampler->kernel_length;i++){
+		double t = i - center;
+		double r = t/center;
+		double sinc = (t == 0) ? 2*cutoff : sin(2*M_PI*cutoff*t)/(M_PI*t);
+		double h = sinc*bessel_i0(RESAMPLER_KAISER_BETA*sqrt(1 - r*r))/bessel_i0(RESAMPLER_KAISER_BETA);
+
+		p = i % up;
+		j = resampler->taps - 1 - i/up;
+		resampler->coeffs[p*resampler->taps + j] = h;
+		sum += h;
+	}
+
+	/*unit gain at DC: each phase sees one sample out of up*/
+	for(i=0;i<(size_t)up*resampler->taps;i++)
+		resampler->coeffs[i] *= up/sum;
+
+	resampler_reset(resampler);
+
+	return resampler;
+}
+
+/**
+ * void resampler_destroy(resampler_t* resampler)
+ *
+ * @brief releases the memory held by a resampler. NULL is accepted.
+ */
+void resampler_destroy(resampler_t* resampler){
+
+	if(resampler == NULL)
+		return;
+
+	free(resampler->coeffs);
+	free(resampler->history);
+	free(resampler->chunk);
+	free(resampler);
+}
+
+/**
+ * void resampler_reset(resampler_t* resampler)
+ *
+ * @brief clears the history of the resampler, as if only zeros had been pushed.
+ */
+void resampler_reset(resampler_t* resampler){
+
+	memset(resampler->history, 0, 2*resampler->taps*sizeof(double));
+	resampler->pos = 0;
+	resampler->phase = 0;
+	resampler->wait = 0;
+}
+
+/**
+ * double resampler_delay(const resampler_t* resampler)
+ *
+ * @brief returns the group delay of the kernel, in output samples.
+ */
+double resampler_delay(const resampler_t* resampler){
+	return (resampler->kernel_length - 1)/(2.0*resampler->down);
+}
+
+/**
+ * size_t resampler_output_length(const resampler_t* resampler, size_t count)
+ *
+ * @brief returns the number of outputs the next resampler_process of count samples gives.
+ */
+size_t resampler_output_length(const resampler_t* resampler, size_t count){
+
+	/*outputs m >= 0 with wait + (phase + m*down)/up < count*/
+	size_t span;
+
+	if(count <= resampler->wait)
+		return 0;
+	span = (count - resampler->wait)*(size_t)resampler->up - (size_t)resampler->phase;
+	return (span + resampler->down - 1)/resampler->down;
+}
+
+/**
+ * size_t resampler_process(resampler_t* resampler, const double* in, size_t count, double* out)
+ *
+ * @brief resamples count new samples.
+ * @return the number of outputs written, resampler_output_length(resampler, count)
+ */
+size_t resampler_process(resampler_t* resampler, const double* in, size_t count, double* out){
+	FFT_STATS_ENTRY(FFT_STATS_RESAMPLER_PROCESS);
+
+	size_t taps = resampler->taps;
+	double *history = resampler->history;
+	size_t pos = resampler->pos;
+	size_t wait = resampler->wait;
+	int phase = resampler->phase;
+	size_t nb_out = 0;
+	size_t i, j;
+
+	for(i=0;i<count;i++){
+
+		/*samples without an output are only stored*/
+		if(wait > 0){
+			size_t run = wait;
+			if(run > count - i)
+				run = count - i;
+			for(j=0;j<run;j++){
+				history[pos] = history[pos + taps] = in[i+j];
+				pos = (pos + 1 == taps) ? 0 : pos + 1;
+			}
+			wait -= run;
+			i += run - 1;
+			continue;
+		}
+
+		history[pos] = history[pos + taps] = in[i];
+		pos = (pos + 1 == taps) ? 0 : pos + 1;
+
+		/*every output completed by this sample, several when upsampling*/
+		do{
+			const double *c = resampler->coeffs + (size_t)phase*taps;
+			const double *x = history + pos;
+			double sum = 0;
+
+			for(j=0;j<taps;j++)
+				sum += c[j]*x[j];
+			out[nb_out++] = sum;
+
+			phase += resampler->down;
+			wait += phase/resampler->up;
+			phase %= resampler->up;
+		}while(wait == 0);
+		wait--;
+	}
+
+	resampler->pos = pos;
+	resampler->wait = wait;
+	resampler->phase = phase;
+
+	return nb_out;
+}
+
+/**
+ * size_t resampler_push_stft(resampler_t* resampler, stft_t* stft, const double* in, size_t count,
+ *                            stft_frame_fn fn, void* context)
+ *
+ * @brief resamples count new samples straight into a short-time Fourier transform.
+ * @return the number of frames computed
+ */
+size_t resampler_push_stft(resampler_t* resampler, stft_t* stft, const double* in, size_t count,
+                           stft_frame_fn fn, void* context){
+
+	/*inputs per run, so that a run gives at most RESAMPLER_CHUNK + up/down + 1 outputs*/
+	size_t step = (size_t)RESAMPLER_CHUNK*resampler->down/resampler->up;
+	size_t nb_frames = 0;
+	size_t done = 0;
+
+	if(step == 0)
+		step = 1;
+
+	while(done < count){
+
+		size_t run = step;
+		size_t nb_out;
+
+		if(run > count - done)
+			run = count - done;
+
+		nb_out = resampler_process(resampler, in + done, run, resampler->chunk);
+		nb_frames += stft_push(stft, resampler->chunk, nb_out, fn, context);
+		done += run;
+	}
+
+	return nb_frames;
+}
+
+/*
+ * Modified Bessel function of the first kind and order 0, by its power series.
+ */
+static double bessel_i0(double x){
+
+	double sum = 1;
+	double term = 1;
+	int k;
+
+	for(k=1;k<64;k++){
+		term *= (x/(2*k))*(x/(2*k));
+		sum += term;
+		if(term < 1e-17*sum)
+			break;
+	}
+	return sum;
+}
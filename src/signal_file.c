@@ -0,0 +1,357 @@
+/**
+ * @file signal_file.c
+ * @brief Memory-mapped reader and buffered writer of the recording format of signal_file.h.
+ *
+ *        The reader maps the whole file once; the windows are pointers into the mapping
+ *        and the kernel pages the samples in as the transforms touch them. The writer
+ *        gathers the frames in an aligned buffer and hands it to write() when full, so
+ *        the file only sees large sequential writes.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "fft.h"
+#include "signal_file.h"
+
+#define SIGNAL_FILE_MAGIC "SIGREC\0\1"
+#define SIGNAL_FILE_BYTE_ORDER 0x01020304u
+
+/**
+ * struct signal_file_header_s
+ * @brief first SIGNAL_FILE_HEADER_SIZE bytes of a recording
+ */
+struct signal_file_header_s{
+	char magic[8];
+	uint32_t byte_order;
+	uint32_t header_size;
+	uint32_t nb_channels;
+	uint32_t sample_type;
+	double sample_rate;
+	char reserved[SIGNAL_FILE_HEADER_SIZE - 32];
+};
+
+/**
+ * struct signal_file_s
+ * @brief mapping of a recording
+ */
+struct signal_file_s{
+
+	void *map;
+	size_t map_length;
+
+	const double *data;      /*first sample, header_size bytes into the mapping*/
+	size_t nb_channels;
+	size_t nb_frames;
+	double sample_rate;
+	size_t page_size;
+};
+
+/**
+ * struct signal_writer_s
+ * @brief output file and pending frames of a writer
+ */
+struct signal_writer_s{
+
+	int fd;
+	size_t nb_channels;
+	int failed;
+
+	double *buffer;          /*SIGNAL_WRITER_BUFFER_SIZE bytes*/
+	size_t capacity;         /*doubles*/
+	size_t length;           /*doubles pending*/
+};
+
+static int write_all(int fd, const void *data, size_t size);
+
+/**
+ * signal_file_t* signal_file_open(const char* path)
+ *
+ * @brief maps a recording, for sequential reading by default.
+ * @return the file, NULL if it cannot be opened or mapped, or if it is not a recording
+ */
+signal_file_t* signal_file_open(const char* path){
+
+	signal_file_t *file = NULL;
+	struct signal_file_header_s header;
+	struct stat st;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if(fd < 0)
+		return NULL;
+
+	if(fstat(fd, &st) != 0 || st.st_size < SIGNAL_FILE_HEADER_SIZE)
+		goto error;
+	if(pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header))
+		goto error;
+	if(memcmp(header.magic, SIGNAL_FILE_MAGIC, sizeof(header.magic)) != 0
+			|| header.byte_order != SIGNAL_FILE_BYTE_ORDER
+			|| header.header_size < SIGNAL_FILE_HEADER_SIZE
+			|| header.header_size % sizeof(double) != 0
+			|| (uint64_t)header.header_size > (uint64_t)st.st_size
+			|| header.nb_channels == 0
+			|| header.sample_type != SIGNAL_FILE_FLOAT64)
+		goto error;
+	if((uint64_t)st.st_size > (uint64_t)SIZE_MAX)
+		goto error;
+
+	file = (signal_file_t*)calloc(1, sizeof(signal_file_t));
+	if(file == NULL)
+		goto error;
+
+	file->map_length = (size_t)st.st_size;
+	file->map = mmap(NULL, file->map_length, PROT_READ, MAP_SHARED, fd, 0);
+	if(file->map == MAP_FAILED){
+		file->map = NULL;
+		goto error;
+	}
+	close(fd);
+
+	/*batch analysis reads the file once, front to back*/
+	madvise(file->map, file->map_length, MADV_SEQUENTIAL);
+
+	file->data = (const double*)((const char*)file->map + header.header_size);
+	file->nb_channels = header.nb_channels;
+	file->nb_frames = (file->map_length - header.header_size)/sizeof(double)/file->nb_channels;
+	file->sample_rate = header.sample_rate;
+	file->page_size = (size_t)sysconf(_SC_PAGESIZE);
+
+	return file;
+
+error:
+	free(file);
+	close(fd);
+	return NULL;
+}
+
+/**
+ * void signal_file_close(signal_file_t* file)
+ *
+ * @brief unmaps the recording. NULL is accepted.
+ */
+void signal_file_close(signal_file_t* file){
+
+	if(file == NULL)
+		return;
+
+	if(file->map != NULL)
+		munmap(file->map, file->map_length);
+	free(file);
+}
+
+/**
+ * size_t signal_file_nb_channels(const signal_file_t* file)
+ *
+ * @brief returns the number of values per frame.
+ */
+size_t signal_file_nb_channels(const signal_file_t* file){
+	return file->nb_channels;
+}
+
+/**
+ * size_t signal_file_nb_frames(const signal_file_t* file)
+ *
+ * @brief returns the number of complete frames of the recording.
+ */
+size_t signal_file_nb_frames(const signal_file_t* file){
+	return file->nb_frames;
+}
+
+/**
+ * double signal_file_sample_rate(const signal_file_t* file)
+ *
+ * @brief returns the frames per second stored in the header, 0 if unknown.
+ */
+double signal_file_sample_rate(const signal_file_t* file){
+	return file->sample_rate;
+}
+
+/**
+ * const double* signal_file_frames(const signal_file_t* file, size_t first, size_t count)
+ *
+ * @brief returns the frames [first, first+count) of the recording, in place in the mapping.
+ * @return the first sample of frame first, NULL if the window goes past the last frame
+ */
+const double* signal_file_frames(const signal_file_t* file, size_t first, size_t count){
+
+	if(first > file->nb_frames || count > file->nb_frames - first)
+		return NULL;
+	return file->data + first*file->nb_channels;
+}
+
+/**
+ * int signal_file_advise(const signal_file_t* file, size_t first, size_t count, int will_need)
+ *
+ * @brief hints the kernel to read the frames ahead, or to drop them.
+ * @return 1 if success, 0 otherwise (window past the last frame)
+ */
+int signal_file_advise(const signal_file_t* file, size_t first, size_t count, int will_need){
+
+	const double *window = signal_file_frames(file, first, count);
+	uintptr_t start, stop;
+
+	if(window == NULL)
+		return 0;
+	if(count == 0)
+		return 1;
+
+	/*madvise works on whole pages: the pages the window touches when reading ahead,
+	  only the ones it covers entirely when dropping*/
+	start = (uintptr_t)window;
+	stop = (uintptr_t)(window + count*file->nb_channels);
+	if(will_need){
+		start -= start % file->page_size;
+		madvise((void*)start, stop - start, MADV_WILLNEED);
+	}else{
+		start += (file->page_size - start % file->page_size) % file->page_size;
+		stop -= stop % file->page_size;
+		if(stop > start)
+			madvise((void*)start, stop - start, MADV_DONTNEED);
+	}
+	return 1;
+}
+
+/**
+ * signal_writer_t* signal_writer_create(const char* path, size_t nb_channels, double sample_rate)
+ *
+ * @brief creates (or truncates) a recording and writes its header.
+ * @return the writer, NULL if the file cannot be created or nb_channels is 0
+ */
+signal_writer_t* signal_writer_create(const char* path, size_t nb_channels, double sample_rate){
+
+	signal_writer_t *writer;
+	struct signal_file_header_s header;
+
+	if(nb_channels == 0 || nb_channels > UINT32_MAX)
+		return NULL;
+
+	writer = (signal_writer_t*)calloc(1, sizeof(signal_writer_t));
+	if(writer == NULL)
+		return NULL;
+
+	writer->nb_channels = nb_channels;
+	writer->capacity = SIGNAL_WRITER_BUFFER_SIZE/sizeof(double);
+	writer->buffer = (double*)fft_malloc(SIGNAL_WRITER_BUFFER_SIZE);
+	writer->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(writer->buffer == NULL || writer->fd < 0)
+		goto error;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, SIGNAL_FILE_MAGIC, sizeof(header.magic));
+	header.byte_order = SIGNAL_FILE_BYTE_ORDER;
+	header.header_size = SIGNAL_FILE_HEADER_SIZE;
+	header.nb_channels = (uint32_t)nb_channels;
+	header.sample_type = SIGNAL_FILE_FLOAT64;
+	header.sample_rate = sample_rate;
+	if(!write_all(writer->fd, &header, sizeof(header)))
+		goto error;
+
+	return writer;
+
+error:
+	if(writer->fd >= 0)
+		close(writer->fd);
+	free(writer->buffer);
+	free(writer);
+	return NULL;
+}
+
+/**
+ * int signal_writer_append(signal_writer_t* writer, const double* frames, size_t count)
+ *
+ * @brief appends count frames.
+ * @return 1 if success, 0 if this or an earlier write failed
+ */
+int signal_writer_append(signal_writer_t* writer, const double* frames, size_t count){
+
+	size_t length;
+
+	if(writer->failed)
+		return 0;
+	if(count > ((size_t)-1)/sizeof(double)/writer->nb_channels){
+		writer->failed = 1;
+		return 0;
+	}
+	length = count*writer->nb_channels;
+
+	/*too large to be worth a copy: written as is, after what is pending*/
+	if(length >= writer->capacity){
+		if(!signal_writer_flush(writer))
+			return 0;
+		if(!write_all(writer->fd, frames, length*sizeof(double)))
+			writer->failed = 1;
+		return !writer->failed;
+	}
+
+	if(writer->length + length > writer->capacity){
+		if(!signal_writer_flush(writer))
+			return 0;
+	}
+	memcpy(writer->buffer + writer->length, frames, length*sizeof(double));
+	writer->length += length;
+
+	return 1;
+}
+
+/**
+ * int signal_writer_flush(signal_writer_t* writer)
+ *
+ * @brief writes out the buffered frames.
+ * @return 1 if success, 0 if this or an earlier write failed
+ */
+int signal_writer_flush(signal_writer_t* writer){
+
+	if(writer->failed)
+		return 0;
+	if(writer->length > 0 && !write_all(writer->fd, writer->buffer, writer->length*sizeof(double)))
+		writer->failed = 1;
+	writer->length = 0;
+	return !writer->failed;
+}
+
+/**
+ * int signal_writer_close(signal_writer_t* writer)
+ *
+ * @brief flushes the buffer, closes the file and releases the writer. NULL is accepted.
+ * @return 1 if every frame was written, 0 otherwise
+ */
+int signal_writer_close(signal_writer_t* writer){
+
+	int status;
+
+	if(writer == NULL)
+		return 1;
+
+	status = signal_writer_flush(writer);
+	if(close(writer->fd) != 0)
+		status = 0;
+	free(writer->buffer);
+	free(writer);
+	return status;
+}
+
+/*
+ * write() until everything is written, through the short writes and the signals.
+ */
+static int write_all(int fd, const void *data, size_t size){
+
+	const char *p = (const char*)data;
+
+	while(size > 0){
+		ssize_t written = write(fd, p, size);
+		if(written < 0){
+			if(errno == EINTR)
+				continue;
+			return 0;
+		}
+		p += written;
+		size -= (size_t)written;
+	}
+	return 1;
+}
@@ -0,0 +1,337 @@
+/**
+ * @file signal_mix.c
+ * @brief Multichannel mixes of synthetic sources (pink noise, tones, white noise,
+ *        DC, artifacts), for load generation.
+ *
+ *        The state of a mix is one entry per source and per channel. A channel is
+ *        generated SIGNAL_MIX_BLOCK samples at a time: each source writes the block
+ *        in a scratch buffer on the stack, which is added with its gain to the output
+ *        while both are still in L1, so the output is only streamed through once per
+ *        source and block rather than once per source over the whole buffer.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "signal_generator.h"
+#include "thread_pool.h"
+
+/*samples generated per source before they are mixed*/
+#define SIGNAL_MIX_BLOCK 256
+
+/*channel tasks of signal_mix_next_parallel per worker, to even out the load*/
+#define SIGNAL_MIX_TASKS_PER_WORKER 4
+
+/**
+ * struct signal_source_s
+ * @brief state of a source for one channel
+ */
+struct signal_source_s{
+
+	pink_generator_t *pink;     /*SIGNAL_SOURCE_PINK*/
+	sinus_generator_t *sinus;   /*SIGNAL_SOURCE_SINUS*/
+
+	signal_rng_t rng;
+
+	/*SIGNAL_SOURCE_DISPERSED_SINUS: phase of the next sample, in [-pi, pi)*/
+	double phase;
+
+	/*SIGNAL_SOURCE_ARTIFACT: position in the current bump, and its sign*/
+	int bump_pos;
+	int bump_active;
+	double bump_sign;
+};
+
+/**
+ * struct signal_mix_s
+ * @brief description of the sources, and their state for every channel.
+ *        The state of source s for channel c is at state[s][c].
+ */
+struct signal_mix_s{
+
+	int nb_channels;
+	int nb_sources;
+
+	int type[SIGNAL_MIX_MAX_SOURCES];
+	double gain[SIGNAL_MIX_MAX_SOURCES];
+	double param_1[SIGNAL_MIX_MAX_SOURCES];
+	double param_2[SIGNAL_MIX_MAX_SOURCES];
+	struct signal_source_s *state[SIGNAL_MIX_MAX_SOURCES];
+
+	/*next random stream handed out, jumped after each source state*/
+	signal_rng_t streams;
+};
+
+struct signal_mix_job_s{
+	signal_mix_t *mix;
+	double *signal;
+	int n;
+	int chunk;
+};
+
+static void source_block(const signal_mix_t *mix, int s, struct signal_source_s *src, double *block, int n);
+static void channel_next(signal_mix_t *mix, int c, double *signal, int n);
+static void signal_mix_task(void *context, size_t task, int worker);
+
+/**
+ * signal_mix_t* signal_mix_create(int nb_channels, uint64_t seed)
+ * @brief creates an empty mix over nb_channels channels.
+ * @return the mix, NULL if out of memory or if nb_channels < 1
+ */
+signal_mix_t* signal_mix_create(int nb_channels, uint64_t seed){
+
+	signal_mix_t *mix;
+
+	if(nb_channels < 1)
+		return NULL;
+
+	mix = (signal_mix_t*)calloc(1, sizeof(signal_mix_t));
+	if(mix == NULL)
+		return NULL;
+
+	mix->nb_channels = nb_channels;
+	signal_rng_seed(&mix->streams, seed);
+
+	return mix;
+}
+
+/**
+ * void signal_mix_destroy(signal_mix_t* mix)
+ * @brief releases the memory held by a mix and its sources. NULL is accepted.
+ */
+void signal_mix_destroy(signal_mix_t* mix){
+
+	int s, c;
+
+	if(mix == NULL)
+		return;
+
+	for(s=0;s<mix->nb_sources;s++){
+		for(c=0;c<mix->nb_channels;c++){
+			pink_generator_destroy(mix->state[s][c].pink);
+			sinus_generator_destroy(mix->state[s][c].sinus);
+		}
+		free(mix->state[s]);
+	}
+	free(mix);
+}
+
+/**
+ * int signal_mix_add(signal_mix_t* mix, int type, double gain, double param_1, double param_2)
+ * @brief adds a source to the mix, with a state and a random stream per channel.
+ * @return 1 if success, 0 otherwise
+ */
+int signal_mix_add(signal_mix_t* mix, int type, double gain, double param_1, double param_2){
+
+	struct signal_source_s *state;
+	int s = mix->nb_sources;
+	int c;
+
+	if(s == SIGNAL_MIX_MAX_SOURCES)
+		return 0;
+	if(type < SIGNAL_SOURCE_PINK || type > SIGNAL_SOURCE_ARTIFACT)
+		return 0;
+	if(type == SIGNAL_SOURCE_ARTIFACT && (param_1 < 0 || param_1 > 1 || param_2 < 1))
+		return 0;
+
+	state = (struct signal_source_s*)calloc(mix->nb_channels, sizeof(struct signal_source_s));
+	if(state == NULL)
+		return 0;
+
+	for(c=0;c<mix->nb_channels;c++){
+
+		struct signal_source_s *src = state + c;
+
+		src->rng = mix->streams;
+		signal_rng_jump(&mix->streams);
+
+		if(type == SIGNAL_SOURCE_PINK){
+			src->pink = pink_generator_create(PINK_MAX_ROWS, &src->rng);
+			if(src->pink == NULL)
+				goto error;
+		}else if(type == SIGNAL_SOURCE_SINUS){
+			double phase = 2*M_PI*signal_rng_uniform(&src->rng);
+			src->sinus = sinus_generator_create(1, &param_1, NULL, &phase);
+			if(src->sinus == NULL)
+				goto error;
+		}
+	}
+
+	mix->type[s] = type;
+	mix->gain[s] = gain;
+	mix->param_1[s] = param_1;
+	mix->param_2[s] = param_2;
+	mix->state[s] = state;
+	mix->nb_sources++;
+
+	return 1;
+
+error:
+	for(c=0;c<mix->nb_channels;c++){
+		pink_generator_destroy(state[c].pink);
+		sinus_generator_destroy(state[c].sinus);
+	}
+	free(state);
+	return 0;
+}
+
+/**
+ * int signal_mix_nb_channels(const signal_mix_t* mix)
+ * @brief returns the number of channels of the mix.
+ */
+int signal_mix_nb_channels(const signal_mix_t* mix){
+	return mix->nb_channels;
+}
+
+/**
+ * void signal_mix_next(signal_mix_t* mix, double* signal, int n)
+ * @brief generates the next n samples of every channel, channel after channel.
+ */
+void signal_mix_next(signal_mix_t* mix, double* signal, int n){
+	signal_mix_next_channels(mix, signal, n, 0, mix->nb_channels);
+}
+
+/**
+ * void signal_mix_next_channels(signal_mix_t* mix, double* signal, int n, int first, int count)
+ * @brief same as signal_mix_next over the channels [first, first+count) only.
+ */
+void signal_mix_next_channels(signal_mix_t* mix, double* signal, int n, int first, int count){
+
+	int c;
+
+	for(c=first;c<first+count;c++)
+		channel_next(mix, c, signal + (size_t)c*n, n);
+}
+
+/**
+ * void signal_mix_next_parallel(thread_pool_t* pool, signal_mix_t* mix, double* signal, int n)
+ * @brief same as signal_mix_next, with the channels split across the workers of the pool.
+ *        The result is the same as signal_mix_next.
+ */
+void signal_mix_next_parallel(thread_pool_t* pool, signal_mix_t* mix, double* signal, int n){
+
+	struct signal_mix_job_s job;
+	int nb_tasks = thread_pool_size(pool)*SIGNAL_MIX_TASKS_PER_WORKER;
+
+	if(nb_tasks > mix->nb_channels)
+		nb_tasks = mix->nb_channels;
+
+	job.mix = mix;
+	job.signal = signal;
+	job.n = n;
+	job.chunk = (mix->nb_channels + nb_tasks - 1)/nb_tasks;
+
+	thread_pool_run(pool, signal_mix_task, &job,
+	                (mix->nb_channels + job.chunk - 1)/job.chunk);
+}
+
+static void signal_mix_task(void *context, size_t task, int worker){
+
+	struct signal_mix_job_s *job = (struct signal_mix_job_s*)context;
+	int first = (int)task*job->chunk;
+	int count = job->chunk;
+
+	(void)worker;
+	if(first + count > job->mix->nb_channels)
+		count = job->mix->nb_channels - first;
+
+	signal_mix_next_channels(job->mix, job->signal, job->n, first, count);
+}
+
+/*
+ * Generates n samples of channel c, block after block: the first source is written
+ * straight to the output, the others are generated in a scratch block and added.
+ */
+static void channel_next(signal_mix_t *mix, int c, double *signal, int n){
+
+	double block[SIGNAL_MIX_BLOCK];
+	int done, s, i;
+
+	if(mix->nb_sources == 0){
+		memset(signal, 0, n*sizeof(double));
+		return;
+	}
+
+	for(done=0;done<n;done+=SIGNAL_MIX_BLOCK){
+
+		int count = (n - done < SIGNAL_MIX_BLOCK) ? n - done : SIGNAL_MIX_BLOCK;
+		double *out = signal + done;
+
+		for(s=0;s<mix->nb_sources;s++){
+
+			double gain = mix->gain[s];
+
+			source_block(mix, s, mix->state[s] + c, block, count);
+
+			if(s == 0){
+				for(i=0;i<count;i++)
+					out[i] = gain*block[i];
+			}else{
+				for(i=0;i<count;i++)
+					out[i] += gain*block[i];
+			}
+		}
+	}
+}
+
+/*
+ * Next n samples of source s for one channel, before the gain.
+ */
+static void source_block(const signal_mix_t *mix, int s, struct signal_source_s *src, double *block, int n){
+
+	int i;
+
+	switch(mix->type[s]){
+
+		case SIGNAL_SOURCE_PINK:
+			pink_generator_next(src->pink, block, n);
+			break;
+
+		case SIGNAL_SOURCE_SINUS:
+			sinus_generator_next(src->sinus, block, n);
+			break;
+
+		case SIGNAL_SOURCE_DISPERSED_SINUS:{
+			/*sin(norm_freq*pi*i + noise), the noise being a brownian walk as in get_sinus_signal*/
+			double step = mix->param_1[s]*M_PI;
+			double spread = mix->param_2[s]*2*M_PI;
+			signal_rng_normal_batch(&src->rng, block, n);
+			for(i=0;i<n;i++){
+				double noise = block[i];
+				block[i] = sin(src->phase);
+				src->phase += step + noise*spread;
+				if(src->phase >= M_PI || src->phase < -M_PI)
+					src->phase -= 2*M_PI*floor((src->phase + M_PI)/(2*M_PI));
+			}
+			break;
+		}
+
+		case SIGNAL_SOURCE_WHITE:
+			signal_rng_normal_batch(&src->rng, block, n);
+			break;
+
+		case SIGNAL_SOURCE_DC:
+			for(i=0;i<n;i++)
+				block[i] = 1.0;
+			break;
+
+		case SIGNAL_SOURCE_ARTIFACT:{
+			int duration = (int)mix->param_2[s];
+			for(i=0;i<n;i++){
+				if(!src->bump_active && signal_rng_uniform(&src->rng) < mix->param_1[s]){
+					src->bump_active = 1;
+					src->bump_pos = 0;
+					src->bump_sign = (signal_rng_next(&src->rng) >> 63) ? 1.0 : -1.0;
+				}
+				if(src->bump_active){
+					block[i] = src->bump_sign*sin(M_PI*(src->bump_pos + 0.5)/duration);
+					if(++src->bump_pos == duration)
+						src->bump_active = 0;
+				}else{
+					block[i] = 0.0;
+				}
+			}
+			break;
+		}
+	}
+}
@@ -0,0 +1,163 @@
+/**
+ * @file signal_rng.c
+ * @brief xoshiro256** generator, uniform and normal draws.
+ *
+ *        The generator and its jump polynomial are the public domain reference
+ *        implementation by D. Blackman and S. Vigna, the seed is expanded with
+ *        splitmix64 as they recommend, so that close seeds give unrelated states.
+ */
+
+#include <math.h>
+#include "signal_rng.h"
+
+static uint64_t rotl(uint64_t x, int k);
+static uint64_t splitmix64(uint64_t *x);
+
+/**
+ * void signal_rng_seed(signal_rng_t* rng, uint64_t seed)
+ *
+ * @brief initializes a state from a seed, any value (0 included) is accepted.
+ */
+void signal_rng_seed(signal_rng_t* rng, uint64_t seed){
+
+	int i;
+
+	for(i=0;i<4;i++)
+		rng->s[i] = splitmix64(&seed);
+	rng->spare = 0.0;
+	rng->has_spare = 0;
+}
+
+/**
+ * void signal_rng_jump(signal_rng_t* rng)
+ *
+ * @brief advances the state by 2^128 draws.
+ */
+void signal_rng_jump(signal_rng_t* rng){
+
+	static const uint64_t jump[4] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+	                                  0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+	uint64_t s[4] = { 0, 0, 0, 0 };
+	int i, b;
+
+	for(i=0;i<4;i++){
+		for(b=0;b<64;b++){
+			if(jump[i] & ((uint64_t)1 << b)){
+				s[0] ^= rng->s[0];
+				s[1] ^= rng->s[1];
+				s[2] ^= rng->s[2];
+				s[3] ^= rng->s[3];
+			}
+			signal_rng_next(rng);
+		}
+	}
+
+	for(i=0;i<4;i++)
+		rng->s[i] = s[i];
+	rng->has_spare = 0;
+}
+
+/**
+ * uint64_t signal_rng_next(signal_rng_t* rng)
+ *
+ * @brief returns 64 random bits.
+ */
+uint64_t signal_rng_next(signal_rng_t* rng){
+
+	uint64_t *s = rng->s;
+	uint64_t result = rotl(s[1]*5, 7)*9;
+	uint64_t t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotl(s[3], 45);
+
+	return result;
+}
+
+/**
+ * double signal_rng_uniform(signal_rng_t* rng)
+ *
+ * @brief returns a uniform number in [0, 1), with 53 random bits.
+ */
+double signal_rng_uniform(signal_rng_t* rng){
+	return (signal_rng_next(rng) >> 11)*(1.0/9007199254740992.0);
+}
+
+/**
+ * double signal_rng_normal(signal_rng_t* rng)
+ *
+ * @brief returns a normally distributed number, Box-Muller over two independent uniforms.
+ */
+double signal_rng_normal(signal_rng_t* rng){
+
+	double radius, angle;
+
+	if(rng->has_spare){
+		rng->has_spare = 0;
+		return rng->spare;
+	}
+
+	/*1-u is in (0, 1], the log is always finite*/
+	radius = sqrt(-2.0*log(1.0 - signal_rng_uniform(rng)));
+	angle = 2*M_PI*signal_rng_uniform(rng);
+
+	rng->spare = radius*sin(angle);
+	rng->has_spare = 1;
+	return radius*cos(angle);
+}
+
+/**
+ * void signal_rng_uniform_batch(signal_rng_t* rng, double* out, size_t n, double low, double high)
+ *
+ * @brief fills out with n uniform numbers in [low, high).
+ */
+void signal_rng_uniform_batch(signal_rng_t* rng, double* out, size_t n, double low, double high){
+
+	double scale = (high - low)*(1.0/9007199254740992.0);
+	size_t i;
+
+	for(i=0;i<n;i++)
+		out[i] = low + (signal_rng_next(rng) >> 11)*scale;
+}
+
+/**
+ * void signal_rng_normal_batch(signal_rng_t* rng, double* out, size_t n)
+ *
+ * @brief fills out with n normally distributed numbers, the same sequence as n calls
+ *        to signal_rng_normal. The pairs are drawn in a single loop, without the spare.
+ */
+void signal_rng_normal_batch(signal_rng_t* rng, double* out, size_t n){
+
+	size_t i = 0;
+
+	if(n > 0 && rng->has_spare){
+		out[i++] = rng->spare;
+		rng->has_spare = 0;
+	}
+
+	for(;i+1<n;i+=2){
+		double radius = sqrt(-2.0*log(1.0 - signal_rng_uniform(rng)));
+		double angle = 2*M_PI*signal_rng_uniform(rng);
+		out[i] = radius*cos(angle);
+		out[i+1] = radius*sin(angle);
+	}
+
+	if(i < n)
+		out[i] = signal_rng_normal(rng);
+}
+
+static uint64_t rotl(uint64_t x, int k){
+	return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t splitmix64(uint64_t *x){
+
+	uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27))*0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
@@ -6,11 +6,42 @@
 
 # include <stdlib.h>
 # include <stdio.h>
+# include <stdint.h>
+# include <string.h>
 # include <math.h>
 
 # include "signal_generator.h"
 
+/*the tones of a sinus_generator are recomputed exactly every SINUS_RESYNC samples*/
+#define SINUS_RESYNC 4096
+
+/**
+ * struct sinus_generator_s
+ * @brief state of a bank of tones. Lane l of tone j, at j*SINUS_LANES+l, holds
+ *        amplitude*exp(i*phase) of the sample counter+l of the tone.
+ */
+struct sinus_generator_s{
+	
+	int nb_tones;
+	double *norm_freq;
+	double *amplitude;
+	double *phase;
+	
+	double *lane_cos;
+	double *lane_sin;
+	
+	/*rotation of a tone by r samples, at j*SINUS_LANES+r (r=0 being SINUS_LANES samples)*/
+	double *rot_cos;
+	double *rot_sin;
+	
+	uint64_t counter;          /*sample of lane 0*/
+	uint64_t next_resync;
+};
+
+static void sinus_generator_resync(sinus_generator_t *gen);
+
 double randn();
+static double sinus_sample(int i, double norm_freq, double phase_disp, double *phase_noise, signal_rng_t *rng);
 
 /**
  * void get_sinus_signal(double* signal, int sample_length, double norm_frequency, double diff_factor)
@@ -27,18 +58,268 @@ void get_sinus_signal(double* signal, int n, double norm_freq, double phase_disp
 	int i=0;
 	double phase_noise = 0.0;
 	
+	for(i=0;i<n;i++){
+		signal[i] = sinus_sample(i, norm_freq, phase_disp, &phase_noise, NULL);
+	}
+}
+
+/**
+ * void get_sinus_signal_f(float* signal, int n, double norm_freq, double phase_disp)
+ * @brief float version of get_sinus_signal, same sequence of samples rounded to float.
+ */ 
+void get_sinus_signal_f(float* signal, int n, double norm_freq, double phase_disp){
+	
+	int i=0;
+	double phase_noise = 0.0;
+	
+	for(i=0;i<n;i++){
+		signal[i] = (float)sinus_sample(i, norm_freq, phase_disp, &phase_noise, NULL);
+	}
+}
+
+/**
+ * void get_sinus_signal_r(signal_rng_t* rng, double* signal, int n, double norm_freq, double phase_disp)
+ * @brief same as get_sinus_signal, the phase noise being drawn from rng.
+ */ 
+void get_sinus_signal_r(signal_rng_t* rng, double* signal, int n, double norm_freq, double phase_disp){
+	
+	int i=0;
+	double phase_noise = 0.0;
+	
+	for(i=0;i<n;i++){
+		signal[i] = sinus_sample(i, norm_freq, phase_disp, &phase_noise, rng);
+	}
+}
+
+/**
+ * void get_sinus_signal_f_r(signal_rng_t* rng, float* signal, int n, double norm_freq, double phase_disp)
+ * @brief same as get_sinus_signal_f, the phase noise being drawn from rng.
+ */ 
+void get_sinus_signal_f_r(signal_rng_t* rng, float* signal, int n, double norm_freq, double phase_disp){
+	
+	int i=0;
+	double phase_noise = 0.0;
+	
+	for(i=0;i<n;i++){
+		signal[i] = (float)sinus_sample(i, norm_freq, phase_disp, &phase_noise, rng);
+	}
+}
+
+/*
+ * Sample i of the sinus, shared by both precisions. The phase is computed in double
+ * and the brownian noise only drawn when phase_disp > 0, as the samples always were.
+ * The noise comes from rng, or from randn() (the global rand()) when rng is NULL.
+ */
+static double sinus_sample(int i, double norm_freq, double phase_disp, double *phase_noise, signal_rng_t *rng){
+	
+	double sample;
+	
 	if(phase_disp==0){
+		return sin(norm_freq*M_PI*(double)i);
+	}
+	
+	sample = sin(norm_freq*M_PI*i+*phase_noise);
+	*phase_noise += ((rng != NULL) ? signal_rng_normal(rng) : randn())*phase_disp*2*M_PI;
+	return sample;
+}
+
+
+/**
+ * sinus_generator_t* sinus_generator_create(int nb_tones, const double* norm_freq, const double* amplitude, const double* phase)
+ * @brief creates a generator of the sum of nb_tones pure tones.
+ * @return the generator, NULL if out of memory or if nb_tones < 1
+ */ 
+sinus_generator_t* sinus_generator_create(int nb_tones, const double* norm_freq,
+                                          const double* amplitude, const double* phase){
+	
+	sinus_generator_t *gen;
+	size_t nb_lanes;
+	int j, r;
+	
+	if(nb_tones < 1)
+		return NULL;
+	nb_lanes = (size_t)nb_tones*SINUS_LANES;
+	
+	gen = (sinus_generator_t*)calloc(1, sizeof(sinus_generator_t));
+	if(gen == NULL)
+		return NULL;
+	
+	gen->nb_tones = nb_tones;
+	gen->norm_freq = (double*)malloc(nb_tones*sizeof(double));
+	gen->amplitude = (double*)malloc(nb_tones*sizeof(double));
+	gen->phase = (double*)malloc(nb_tones*sizeof(double));
+	gen->lane_cos = (double*)malloc(nb_lanes*sizeof(double));
+	gen->lane_sin = (double*)malloc(nb_lanes*sizeof(double));
+	gen->rot_cos = (double*)malloc(nb_lanes*sizeof(double));
+	gen->rot_sin = (double*)malloc(nb_lanes*sizeof(double));
+	if(gen->norm_freq == NULL || gen->amplitude == NULL || gen->phase == NULL
+			|| gen->lane_cos == NULL || gen->lane_sin == NULL
+			|| gen->rot_cos == NULL || gen->rot_sin == NULL){
+		sinus_generator_destroy(gen);
+		return NULL;
+	}
+	
+	for(j=0;j<nb_tones;j++){
+		gen->norm_freq[j] = norm_freq[j];
+		gen->amplitude[j] = (amplitude != NULL) ? amplitude[j] : 1.0;
+		gen->phase[j] = (phase != NULL) ? phase[j] : 0.0;
 		
-		for(i=0;i<n;i++){
-			signal[i] = sin(norm_freq*M_PI*(double)i);
+		for(r=0;r<SINUS_LANES;r++){
+			int step = (r == 0) ? SINUS_LANES : r;
+			gen->rot_cos[j*SINUS_LANES+r] = cos(norm_freq[j]*M_PI*step);
+			gen->rot_sin[j*SINUS_LANES+r] = sin(norm_freq[j]*M_PI*step);
 		}
 	}
-	else{
-		for(i=0;i<n;i++){
-			signal[i] = sin(norm_freq*M_PI*i+phase_noise);
-			phase_noise += randn()*phase_disp*2*M_PI;
+	
+	sinus_generator_reset(gen);
+	
+	return gen;
+}
+
+/**
+ * void sinus_generator_destroy(sinus_generator_t* gen)
+ * @brief releases the memory held by a generator. NULL is accepted.
+ */ 
+void sinus_generator_destroy(sinus_generator_t* gen){
+	
+	if(gen == NULL)
+		return;
+	
+	free(gen->norm_freq);
+	free(gen->amplitude);
+	free(gen->phase);
+	free(gen->lane_cos);
+	free(gen->lane_sin);
+	free(gen->rot_cos);
+	free(gen->rot_sin);
+	free(gen);
+}
+
+/**
+ * void sinus_generator_reset(sinus_generator_t* gen)
+ * @brief restarts the signal at sample 0.
+ */ 
+void sinus_generator_reset(sinus_generator_t* gen){
+	
+	gen->counter = 0;
+	sinus_generator_resync(gen);
+}
+
+/**
+ * void sinus_generator_next(sinus_generator_t* gen, double* signal, int n)
+ * @brief generates the next n samples of the signal. The tones are added one after
+ *        the other over runs of whole lanes, then lanes are rotated by the few samples
+ *        left at the end of the call.
+ */ 
+void sinus_generator_next(sinus_generator_t* gen, double* signal, int n){
+	
+	size_t done = 0;
+	int j;
+	
+	if(n <= 0)
+		return;
+	
+	memset(signal, 0, n*sizeof(double));
+	
+	while(done < (size_t)n){
+		
+		size_t run = n - done;
+		size_t full, rest, b;
+		int l;
+		
+		if(run > gen->next_resync - gen->counter)
+			run = gen->next_resync - gen->counter;
+		full = run - run%SINUS_LANES;
+		rest = run - full;
+		
+		for(j=0;j<gen->nb_tones;j++){
+			
+			double *lane_cos = gen->lane_cos + j*SINUS_LANES;
+			double *lane_sin = gen->lane_sin + j*SINUS_LANES;
+			double c[SINUS_LANES], s[SINUS_LANES];
+			double step_cos = gen->rot_cos[j*SINUS_LANES];
+			double step_sin = gen->rot_sin[j*SINUS_LANES];
+			
+			for(l=0;l<SINUS_LANES;l++){
+				c[l] = lane_cos[l];
+				s[l] = lane_sin[l];
+			}
+			
+			for(b=0;b<full;b+=SINUS_LANES){
+				double *out = signal + done + b;
+				for(l=0;l<SINUS_LANES;l++){
+					double next_c = c[l]*step_cos - s[l]*step_sin;
+					out[l] += s[l];
+					s[l] = s[l]*step_cos + c[l]*step_sin;
+					c[l] = next_c;
+				}
+			}
+			
+			/*last samples of the run: move every lane by rest samples only*/
+			if(rest > 0){
+				double rest_cos = gen->rot_cos[j*SINUS_LANES+rest];
+				double rest_sin = gen->rot_sin[j*SINUS_LANES+rest];
+				for(l=0;l<(int)rest;l++)
+					signal[done+full+l] += s[l];
+				for(l=0;l<SINUS_LANES;l++){
+					double next_c = c[l]*rest_cos - s[l]*rest_sin;
+					s[l] = s[l]*rest_cos + c[l]*rest_sin;
+					c[l] = next_c;
+				}
+			}
+			
+			for(l=0;l<SINUS_LANES;l++){
+				lane_cos[l] = c[l];
+				lane_sin[l] = s[l];
+			}
+		}
+		
+		done += run;
+		gen->counter += run;
+		if(gen->counter == gen->next_resync)
+			sinus_generator_resync(gen);
+	}
+}
+
+/**
+ * void sinus_generator_next_f(sinus_generator_t* gen, float* signal, int n)
+ * @brief float version of sinus_generator_next, the same signal rounded to float.
+ */ 
+void sinus_generator_next_f(sinus_generator_t* gen, float* signal, int n){
+	
+	double chunk[256];
+	int i, done = 0;
+	
+	while(done < n){
+		
+		int count = (n - done < 256) ? n - done : 256;
+		
+		sinus_generator_next(gen, chunk, count);
+		for(i=0;i<count;i++){
+			signal[done+i] = (float)chunk[i];
+		}
+		done += count;
+	}
+}
+
+/*
+ * Recomputes the lanes of every tone exactly from the sample counter, the phase
+ * being reduced modulo 2*pi before the multiplication by pi to keep its precision.
+ */
+static void sinus_generator_resync(sinus_generator_t *gen){
+	
+	int j, l;
+	
+	for(j=0;j<gen->nb_tones;j++){
+		for(l=0;l<SINUS_LANES;l++){
+			double turns = fmod(gen->norm_freq[j]*(double)(gen->counter + l), 2.0);
+			double angle = turns*M_PI + gen->phase[j];
+			gen->lane_cos[j*SINUS_LANES+l] = gen->amplitude[j]*cos(angle);
+			gen->lane_sin[j*SINUS_LANES+l] = gen->amplitude[j]*sin(angle);
 		}
 	}
+	
+	gen->next_resync = gen->counter + SINUS_RESYNC;
 }
 
 
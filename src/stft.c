@@ -0,0 +1,298 @@
+/**
+ * @file stft.c
+ * @brief Windows and streaming short-time Fourier transform.
+ *
+ *        The last n samples are kept in a ring buffer, the oldest one at 'head'. A frame
+ *        reads the ring in two runs straight into the windowed input of the transform,
+ *        so the overlap between frames is never copied around. The one-sided complex
+ *        spectrum is computed once per frame, and both the callback output (through the
+ *        spectrum output stage) and the Welch accumulator are derived from it.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fft.h"
+#include "fft_internal.h"
+
+#define FFT_REAL double
+#define FFT_SQRT sqrt
+#define FFT_T(name) name##_d
+#include "fft_template.h"
+
+/**
+ * struct stft_s
+ * @brief state of a short-time Fourier transform
+ */
+struct stft_s{
+
+	size_t n;
+	size_t hop;
+	int mode;
+	int welch;
+
+	fft_plan_t *plan;
+	void *workspace;       /*fft_workspace_size(n) bytes*/
+
+	double *window;
+
+	/*last n samples, oldest sample at 'head' once the ring is full*/
+	double *ring;
+	size_t head;
+
+	/*samples left before the next frame, n after a reset so that the ring is full*/
+	size_t countdown;
+	size_t nb_frames;
+
+	double *frame;         /*windowed samples of the current frame*/
+	double *X;             /*one-sided spectrum of the frame, FFT_OUTPUT_COMPLEX*/
+	double *spectrum;      /*frame handed to the callback, in the output mode*/
+
+	/*Welch average: sum of |X(k)|^2 over the frames, and 1/sum(w^2)*/
+	double *psd_sum;
+	size_t psd_frames;
+	double psd_scale;
+};
+
+static void stft_frame(stft_t *stft, stft_frame_fn fn, void *context);
+
+/**
+ * int fft_window(double* window, size_t n, int type)
+ *
+ * @brief fills window with the n-long periodic window of the given type.
+ * @return 1 if success, 0 otherwise (unknown type)
+ */
+int fft_window(double* window, size_t n, int type){
+
+	size_t i;
+
+	for(i=0;i<n;i++){
+		double a = 2*M_PI*i/n;
+		switch(type){
+			case FFT_WINDOW_RECTANGULAR:
+				window[i] = 1.0;
+				break;
+			case FFT_WINDOW_HANN:
+				window[i] = 0.5 - 0.5*cos(a);
+				break;
+			case FFT_WINDOW_HAMMING:
+				window[i] = 0.54 - 0.46*cos(a);
+				break;
+			case FFT_WINDOW_BLACKMAN:
+				window[i] = 0.42 - 0.5*cos(a) + 0.08*cos(2*a);
+				break;
+			default:
+				return 0;
+		}
+	}
+
+	return type >= FFT_WINDOW_RECTANGULAR && type <= FFT_WINDOW_BLACKMAN;
+}
+
+/**
+ * stft_t* stft_create(size_t n, size_t hop, int window, int mode, int welch)
+ *
+ * @brief creates a short-time Fourier transform over frames of n samples.
+ * @return the stft, NULL if out of memory or if a parameter is invalid
+ */
+stft_t* stft_create(size_t n, size_t hop, int window, int mode, int welch){
+
+	stft_t *stft;
+	size_t half = n/2+1;
+	size_t i;
+	double energy = 0;
+
+	if(n == 0 || hop == 0 || fft_output_length(n, mode) == 0)
+		return NULL;
+
+	stft = (stft_t*)calloc(1, sizeof(stft_t));
+	if(stft == NULL)
+		return NULL;
+
+	stft->n = n;
+	stft->hop = hop;
+	stft->mode = mode;
+	stft->welch = welch;
+
+	stft->plan = fft_plan_create(n, 0);
+	stft->workspace = fft_malloc(fft_workspace_size(n));
+	stft->window = (double*)malloc(n*sizeof(double));
+	stft->ring = (double*)malloc(n*sizeof(double));
+	stft->frame = (double*)malloc(n*sizeof(double));
+	stft->X = (double*)malloc(2*half*sizeof(double));
+	stft->spectrum = (double*)malloc(fft_output_length(n, mode)*sizeof(double));
+	stft->psd_sum = (double*)malloc(half*sizeof(double));
+	if(stft->plan == NULL || stft->workspace == NULL
+			|| stft->window == NULL || stft->ring == NULL
+			|| stft->frame == NULL || stft->X == NULL
+			|| stft->spectrum == NULL || stft->psd_sum == NULL){
+		stft_destroy(stft);
+		return NULL;
+	}
+
+	if(!fft_window(stft->window, n, window)){
+		stft_destroy(stft);
+		return NULL;
+	}
+
+	for(i=0;i<n;i++)
+		energy += stft->window[i]*stft->window[i];
+	/*a periodic window of length 1 is 0 for Hann and Blackman*/
+	stft->psd_scale = (energy > 0) ? 1.0/energy : 0.0;
+
+	stft_reset(stft);
+
+	return stft;
+}
+
+/**
+ * void stft_destroy(stft_t* stft)
+ *
+ * @brief releases the memory held by a stft. NULL is accepted.
+ */
+void stft_destroy(stft_t* stft){
+
+	if(stft == NULL)
+		return;
+
+	fft_plan_destroy(stft->plan);
+	free(stft->workspace);
+	free(stft->window);
+	free(stft->ring);
+	free(stft->frame);
+	free(stft->X);
+	free(stft->spectrum);
+	free(stft->psd_sum);
+	free(stft);
+}
+
+/**
+ * void stft_reset(stft_t* stft)
+ *
+ * @brief empties the ring buffer, restarts the frame count and clears the Welch average.
+ */
+void stft_reset(stft_t* stft){
+
+	stft->head = 0;
+	stft->countdown = stft->n;
+	stft->nb_frames = 0;
+	stft_psd_reset(stft);
+}
+
+/**
+ * void stft_psd_reset(stft_t* stft)
+ *
+ * @brief clears the Welch average, the ring buffer is kept.
+ */
+void stft_psd_reset(stft_t* stft){
+
+	memset(stft->psd_sum, 0, (stft->n/2+1)*sizeof(double));
+	stft->psd_frames = 0;
+}
+
+/**
+ * size_t stft_push(stft_t* stft, const double* samples, size_t count, stft_frame_fn fn, void* context)
+ *
+ * @brief pushes count new samples, and computes the frames completed by them.
+ *        The samples are copied into the ring in runs up to the next frame or the
+ *        end of the ring, whichever comes first.
+ * @return the number of frames computed
+ */
+size_t stft_push(stft_t* stft, const double* samples, size_t count,
+                 stft_frame_fn fn, void* context){
+	FFT_STATS_ENTRY(FFT_STATS_STFT_PUSH);
+
+	size_t n = stft->n;
+	size_t done = 0;
+	size_t nb_frames = 0;
+
+	while(done < count){
+
+		size_t run = count - done;
+		if(run > stft->countdown)
+			run = stft->countdown;
+		if(run > n - stft->head)
+			run = n - stft->head;
+
+		memcpy(stft->ring + stft->head, samples + done, run*sizeof(double));
+		done += run;
+		stft->head += run;
+		if(stft->head == n)
+			stft->head = 0;
+
+		stft->countdown -= run;
+		if(stft->countdown == 0){
+			stft_frame(stft, fn, context);
+			stft->countdown = stft->hop;
+			nb_frames++;
+		}
+	}
+
+	return nb_frames;
+}
+
+/**
+ * size_t stft_psd(const stft_t* stft, double* psd)
+ *
+ * @brief returns the one-sided Welch power spectral density averaged over the frames
+ *        since the last stft_psd_reset, for a sampling frequency of 1.
+ *        The bins other than DC and Nyquist hold the power of their mirror as well.
+ * @return the number of frames averaged, 0 if none or if the stft was created without welch
+ */
+size_t stft_psd(const stft_t* stft, double* psd){
+
+	size_t n = stft->n;
+	size_t half = n/2+1;
+	size_t k;
+	double scale;
+
+	if(stft->psd_frames == 0)
+		return 0;
+
+	scale = stft->psd_scale/stft->psd_frames;
+	for(k=0;k<half;k++){
+		int mirrored = (k > 0) && (2*k != n);
+		psd[k] = stft->psd_sum[k]*scale*(mirrored ? 2 : 1);
+	}
+
+	return stft->psd_frames;
+}
+
+/*
+ * Computes the frame over the full ring: windowed samples, one-sided spectrum,
+ * then the callback output and the Welch accumulation from the same bins.
+ */
+static void stft_frame(stft_t *stft, stft_frame_fn fn, void *context){
+
+	size_t n = stft->n;
+	size_t half = n/2+1;
+	size_t tail = n - stft->head;
+	size_t i, k;
+
+	/*the ring is full here, the oldest sample is at head*/
+	for(i=0;i<tail;i++)
+		stft->frame[i] = stft->ring[stft->head+i]*stft->window[i];
+	for(i=tail;i<n;i++)
+		stft->frame[i] = stft->ring[i-tail]*stft->window[i];
+
+	spectrum_ws(stft->plan, stft->frame, FFT_OUTPUT_COMPLEX, stft->X, stft->workspace);
+
+	if(stft->welch){
+		for(k=0;k<half;k++)
+			stft->psd_sum[k] += stft->X[2*k]*stft->X[2*k] + stft->X[2*k+1]*stft->X[2*k+1];
+		stft->psd_frames++;
+	}
+
+	if(fn != NULL){
+		if(stft->mode == FFT_OUTPUT_COMPLEX){
+			fn(context, stft->X, stft->nb_frames);
+		}else{
+			/*same output stage as the spectrum functions, v = 2*X(k)*/
+			for(k=0;k<half;k++)
+				spectrum_store_d(stft->spectrum, k, 2*stft->X[2*k], 2*stft->X[2*k+1], n, stft->mode);
+			fn(context, stft->spectrum, stft->nb_frames);
+		}
+	}
+
+	stft->nb_frames++;
+}
@@ -0,0 +1,484 @@
+/**
+ * @file thread_pool.c
+ * @brief Persistent worker pool (pthreads), and the fft pool which shares the
+ *        batched transforms out over it.
+ *
+ *        The workers sleep on a condition variable between jobs. A job is published
+ *        by bumping a generation counter; the workers and the submitting thread then
+ *        claim the tasks one by one, and the last task to finish wakes the submitter.
+ *        The tasks are coarse (a group of channels each), so one mutex is enough.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "fft.h"
+#include "fft_internal.h"
+#include "thread_pool.h"
+
+struct thread_pool_worker_s{
+
+	struct thread_pool_s *pool;
+	int index;
+};
+
+/**
+ * struct thread_pool_s
+ * @brief workers and current job of a pool
+ */
+struct thread_pool_s{
+
+	int nb_threads;                         /*workers, the calling thread included*/
+	pthread_t *threads;                     /*nb_threads-1 spawned workers*/
+	struct thread_pool_worker_s *workers;
+
+	pthread_mutex_t submit_lock;            /*one job at a time*/
+	pthread_mutex_t lock;                   /*protects everything below*/
+	pthread_cond_t wake;
+	pthread_cond_t done;
+
+	thread_pool_task_fn fn;
+	void *context;
+	size_t nb_tasks;
+	size_t next_task;
+	size_t nb_finished;
+	unsigned long generation;
+	int stop;
+};
+
+/**
+ * struct fft_pool_s
+ * @brief worker pool and per-worker plans
+ */
+struct fft_pool_s{
+
+	size_t n;
+	thread_pool_t *threads;
+	int nb_workers;
+	fft_plan_t **plans;         /*one forward plan, with its workspace, per worker*/
+	size_t min_channels;
+};
+
+/*job of fft_pool_abs_fft_batch*/
+struct abs_fft_batch_job_s{
+
+	fft_pool_t *pool;
+	const double *data;
+	size_t nb_channels;
+	int layout;
+	size_t chunk;
+	double *abs_onesided_fft;
+};
+
+/*job of fft_pool_fft_2signals_batch*/
+struct fft_2signals_batch_job_s{
+
+	fft_pool_t *pool;
+	const double *signals_1;
+	const double *signals_2;
+	size_t nb_pairs;
+	size_t chunk;
+	double *X1_real;
+	double *X1_imag;
+	double *X2_real;
+	double *X2_imag;
+};
+
+static void* worker_main(void *arg);
+static void run_tasks(thread_pool_t *pool, int worker);
+static void stop_workers(thread_pool_t *pool, int nb_spawned);
+static size_t split_tasks(const fft_pool_t *pool, size_t nb_items, size_t granularity, size_t *chunk);
+static void abs_fft_batch_task(void *context, size_t task, int worker);
+static void fft_2signals_batch_task(void *context, size_t task, int worker);
+
+/**
+ * thread_pool_t* thread_pool_create(int nb_threads)
+ *
+ * @brief creates a pool of nb_threads workers, the calling thread being one of them.
+ * @param nb_threads, number of workers, <= 0 for one per online CPU
+ * @return the pool, NULL if the threads could not be created
+ */
+thread_pool_t* thread_pool_create(int nb_threads){
+
+	thread_pool_t *pool;
+	int i;
+
+	if(nb_threads <= 0){
+		long nb_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		nb_threads = (nb_cpus > 0) ? (int)nb_cpus : 1;
+	}
+
+	pool = (thread_pool_t*)calloc(1, sizeof(thread_pool_t));
+	if(pool == NULL)
+		return NULL;
+
+	pool->nb_threads = nb_threads;
+	pool->threads = (pthread_t*)malloc(nb_threads*sizeof(pthread_t));
+	pool->workers = (struct thread_pool_worker_s*)malloc(nb_threads*sizeof(struct thread_pool_worker_s));
+	if(pool->threads == NULL || pool->workers == NULL){
+		free(pool->threads);
+		free(pool->workers);
+		free(pool);
+		return NULL;
+	}
+
+	pthread_mutex_init(&pool->submit_lock, NULL);
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+	pthread_cond_init(&pool->done, NULL);
+
+	/*worker 0 is the thread which submits the job*/
+	for(i=1;i<nb_threads;i++){
+		pool->workers[i].pool = pool;
+		pool->workers[i].index = i;
+		if(pthread_create(&pool->threads[i-1], NULL, worker_main, &pool->workers[i]) != 0){
+			stop_workers(pool, i-1);
+			return NULL;
+		}
+	}
+
+	return pool;
+}
+
+/**
+ * void thread_pool_destroy(thread_pool_t* pool)
+ *
+ * @brief stops and joins the workers. NULL is accepted.
+ */
+void thread_pool_destroy(thread_pool_t* pool){
+
+	if(pool == NULL)
+		return;
+
+	stop_workers(pool, pool->nb_threads-1);
+}
+
+/**
+ * int thread_pool_size(const thread_pool_t* pool)
+ *
+ * @brief returns the number of workers, the calling thread included.
+ */
+int thread_pool_size(const thread_pool_t* pool){
+	return pool->nb_threads;
+}
+
+/**
+ * void thread_pool_run(thread_pool_t* pool, thread_pool_task_fn fn, void* context, size_t nb_tasks)
+ *
+ * @brief runs fn(context, task, worker) for task = 0..nb_tasks-1 over the workers,
+ *        and returns once all of them are done. Jobs submitted from several threads
+ *        are run one after the other.
+ */
+void thread_pool_run(thread_pool_t* pool, thread_pool_task_fn fn, void* context, size_t nb_tasks){
+
+	size_t t;
+
+	if(nb_tasks == 0)
+		return;
+
+	pthread_mutex_lock(&pool->submit_lock);
+
+	/*nothing to share out, the workers are not woken up*/
+	if(nb_tasks == 1 || pool->nb_threads == 1){
+		for(t=0;t<nb_tasks;t++){
+			fn(context, t, 0);
+		}
+		pthread_mutex_unlock(&pool->submit_lock);
+		return;
+	}
+
+	pthread_mutex_lock(&pool->lock);
+
+	pool->fn = fn;
+	pool->context = context;
+	pool->nb_tasks = nb_tasks;
+	pool->next_task = 0;
+	pool->nb_finished = 0;
+	pool->generation++;
+	pthread_cond_broadcast(&pool->wake);
+
+	run_tasks(pool, 0);
+	while(pool->nb_finished < pool->nb_tasks){
+		pthread_cond_wait(&pool->done, &pool->lock);
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+	pthread_mutex_unlock(&pool->submit_lock);
+}
+
+/*
+ * Body of the spawned workers: sleeps until a new job is published, helps with it, and so on.
+ */
+static void* worker_main(void *arg){
+
+	struct thread_pool_worker_s *worker = (struct thread_pool_worker_s*)arg;
+	thread_pool_t *pool = worker->pool;
+	unsigned long seen;
+
+	pthread_mutex_lock(&pool->lock);
+	seen = pool->generation;
+
+	for(;;){
+		while(!pool->stop && pool->generation == seen){
+			pthread_cond_wait(&pool->wake, &pool->lock);
+		}
+		if(pool->stop)
+			break;
+
+		seen = pool->generation;
+		run_tasks(pool, worker->index);
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+
+	return NULL;
+}
+
+/*
+ * Claims and runs the tasks of the current job until there is none left.
+ * Called, and returns, with pool->lock held; the lock is released while a task runs.
+ */
+static void run_tasks(thread_pool_t *pool, int worker){
+
+	while(pool->next_task < pool->nb_tasks){
+
+		size_t task = pool->next_task++;
+		thread_pool_task_fn fn = pool->fn;
+		void *context = pool->context;
+
+		pthread_mutex_unlock(&pool->lock);
+		fn(context, task, worker);
+		pthread_mutex_lock(&pool->lock);
+
+		pool->nb_finished++;
+		if(pool->nb_finished == pool->nb_tasks)
+			pthread_cond_signal(&pool->done);
+	}
+}
+
+/*
+ * Stops and joins the nb_spawned first workers, then releases the pool.
+ */
+static void stop_workers(thread_pool_t *pool, int nb_spawned){
+
+	int i;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = 1;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+
+	for(i=0;i<nb_spawned;i++){
+		pthread_join(pool->threads[i], NULL);
+	}
+
+	pthread_cond_destroy(&pool->done);
+	pthread_cond_destroy(&pool->wake);
+	pthread_mutex_destroy(&pool->lock);
+	pthread_mutex_destroy(&pool->submit_lock);
+	free(pool->threads);
+	free(pool->workers);
+	free(pool);
+}
+
+/**
+ * fft_pool_t* fft_pool_create(size_t n, int nb_threads)
+ *
+ * @brief creates a fft pool for signals of length n.
+ * @param n, the length of the signals
+ * @param nb_threads, number of workers, <= 0 for one per online CPU
+ * @return the pool, NULL if out of memory or if the threads could not be created
+ */
+fft_pool_t* fft_pool_create(size_t n, int nb_threads){
+
+	fft_pool_t *pool;
+	int i;
+
+	if(n == 0)
+		return NULL;
+
+	pool = (fft_pool_t*)calloc(1, sizeof(fft_pool_t));
+	if(pool == NULL)
+		return NULL;
+
+	pool->n = n;
+	pool->min_channels = FFT_POOL_MIN_CHANNELS;
+
+	pool->threads = thread_pool_create(nb_threads);
+	if(pool->threads == NULL)
+		goto error;
+
+	pool->nb_workers = thread_pool_size(pool->threads);
+	pool->plans = (fft_plan_t**)calloc(pool->nb_workers, sizeof(fft_plan_t*));
+	if(pool->plans == NULL)
+		goto error;
+
+	for(i=0;i<pool->nb_workers;i++){
+		pool->plans[i] = fft_plan_create(n, 0);
+		if(pool->plans[i] == NULL)
+			goto error;
+	}
+
+	return pool;
+
+error:
+	fft_pool_destroy(pool);
+	return NULL;
+}
+
+/**
+ * void fft_pool_destroy(fft_pool_t* pool)
+ *
+ * @brief releases the pool and the plans of its workers. NULL is accepted.
+ */
+void fft_pool_destroy(fft_pool_t* pool){
+
+	int i;
+
+	if(pool == NULL)
+		return;
+
+	thread_pool_destroy(pool->threads);
+	if(pool->plans != NULL){
+		for(i=0;i<pool->nb_workers;i++){
+			fft_plan_destroy(pool->plans[i]);
+		}
+		free(pool->plans);
+	}
+	free(pool);
+}
+
+/**
+ * void fft_pool_set_min_channels(fft_pool_t* pool, size_t min_channels)
+ *
+ * @brief sets the minimum number of channels given to one worker (FFT_POOL_MIN_CHANNELS by default).
+ *        A batch smaller than twice this runs inline on the calling thread.
+ */
+void fft_pool_set_min_channels(fft_pool_t* pool, size_t min_channels){
+	pool->min_channels = (min_channels > 0) ? min_channels : 1;
+}
+
+/**
+ * int fft_pool_abs_fft_batch(fft_pool_t* pool, const double* data, size_t nb_channels, int layout,
+ *                            double* abs_onesided_fft)
+ *
+ * @brief same as abs_fft_batch_ws, with the channels split across the workers.
+ * @return 1 if success, 0 otherwise
+ */
+int fft_pool_abs_fft_batch(fft_pool_t* pool,
+                           const double* data, size_t nb_channels, int layout,
+                           double* abs_onesided_fft){
+
+	struct abs_fft_batch_job_s job;
+	size_t nb_tasks;
+
+	if(layout != FFT_LAYOUT_CHANNEL_MAJOR && layout != FFT_LAYOUT_INTERLEAVED)
+		return 0;
+
+	job.pool = pool;
+	job.data = data;
+	job.nb_channels = nb_channels;
+	job.layout = layout;
+	job.abs_onesided_fft = abs_onesided_fft;
+
+	/*even chunks, so that no pair of channels is split between two workers*/
+	nb_tasks = split_tasks(pool, nb_channels, 2, &job.chunk);
+	thread_pool_run(pool->threads, abs_fft_batch_task, &job, nb_tasks);
+
+	return 1;
+}
+
+/**
+ * int fft_pool_fft_2signals_batch(fft_pool_t* pool, const double* signals_1, const double* signals_2, size_t nb_pairs,
+ *                                 double* X1_real, double* X1_imag, double* X2_real, double* X2_imag)
+ *
+ * @brief runs fft_2signals over nb_pairs pairs of signals, split across the workers.
+ *        Every array holds nb_pairs n-long vectors, one after the other.
+ * @return 1 if success, 0 otherwise
+ */
+int fft_pool_fft_2signals_batch(fft_pool_t* pool,
+                                const double* signals_1, const double* signals_2,
+                                size_t nb_pairs,
+                                double* X1_real, double* X1_imag,
+                                double* X2_real, double* X2_imag){
+
+	struct fft_2signals_batch_job_s job;
+	size_t nb_tasks;
+
+	job.pool = pool;
+	job.signals_1 = signals_1;
+	job.signals_2 = signals_2;
+	job.nb_pairs = nb_pairs;
+	job.X1_real = X1_real;
+	job.X1_imag = X1_imag;
+	job.X2_real = X2_real;
+	job.X2_imag = X2_imag;
+
+	/*a pair holds two channels*/
+	nb_tasks = split_tasks(pool, 2*nb_pairs, 2, &job.chunk);
+	job.chunk /= 2;
+	thread_pool_run(pool->threads, fft_2signals_batch_task, &job, nb_tasks);
+
+	return 1;
+}
+
+/*
+ * Splits nb_items channels into at most one task per worker, each of them holding at
+ * least min_channels channels, in chunks which are multiples of granularity.
+ * Returns the number of tasks (1 for a batch run inline), the chunk size in *chunk.
+ */
+static size_t split_tasks(const fft_pool_t *pool, size_t nb_items, size_t granularity, size_t *chunk){
+
+	size_t nb_tasks = nb_items / pool->min_channels;
+	size_t size;
+
+	if(nb_items == 0){
+		*chunk = 0;
+		return 0;
+	}
+
+	if(nb_tasks > (size_t)pool->nb_workers)
+		nb_tasks = pool->nb_workers;
+	if(nb_tasks < 1)
+		nb_tasks = 1;
+
+	size = (nb_items + nb_tasks - 1) / nb_tasks;
+	size = (size + granularity - 1) / granularity * granularity;
+
+	*chunk = size;
+	return (nb_items + size - 1) / size;
+}
+
+static void abs_fft_batch_task(void *context, size_t task, int worker){
+
+	struct abs_fft_batch_job_s *job = (struct abs_fft_batch_job_s*)context;
+	const fft_plan_t *plan = job->pool->plans[worker];
+	size_t first = task*job->chunk;
+	size_t count = job->chunk;
+
+	if(first + count > job->nb_channels)
+		count = job->nb_channels - first;
+
+	spectrum_batch_range(plan, job->data, job->nb_channels, job->layout,
+	                     first, count, FFT_OUTPUT_MAGNITUDE, job->abs_onesided_fft, plan->work);
+}
+
+static void fft_2signals_batch_task(void *context, size_t task, int worker){
+
+	struct fft_2signals_batch_job_s *job = (struct fft_2signals_batch_job_s*)context;
+	const fft_plan_t *plan = job->pool->plans[worker];
+	size_t n = plan->n;
+	size_t first = task*job->chunk;
+	size_t stop = first + job->chunk;
+	size_t p;
+
+	if(stop > job->nb_pairs)
+		stop = job->nb_pairs;
+
+	for(p=first;p<stop;p++){
+		fft_2signals_ws(plan, job->signals_1 + p*n, job->signals_2 + p*n,
+		                job->X1_real + p*n, job->X1_imag + p*n,
+		                job->X2_real + p*n, job->X2_imag + p*n,
+		                plan->work);
+	}
+}
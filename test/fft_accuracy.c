@@ -0,0 +1,2070 @@
+/**
+ * @file fft_accuracy.c
+ * @brief Accuracy regression of every transform backend against naive_dft, built and
+ *        run by 'make check'.
+ *
+ *        For each length, the reference transforms of two random signals are computed
+ *        once with naive_dft, then every backend (legacy wrappers, plans with every
+ *        butterfly kernel of this CPU, real-input transforms, single precision plans)
+ *        runs on the same inputs. The error of a call is the largest distance to the
+ *        reference over the largest magnitude of the reference,
+ *
+ *        max_k |y(k) - ref(k)| / max_k |ref(k)|
+ *
+ *        which stays around eps*log2(n) for a correct fft whatever the length. The
+ *        inputs are rounded to single precision so that the float backends are compared
+ *        to the exact transform of what they were given. The fixed-point backends get the
+ *        inputs scaled to 16 or 32-bit integers, exact in Q31, rounded in Q15.
+ *        The convolutions are compared to the circular convolution by its definition,
+ *        the spectral features to the same quantities taken from the naive_dft, each
+ *        value to its own magnitude, and the sliding band powers, pushed in chunks of random
+ *        sizes, to the FFT_OUTPUT_POWER bins of the naive_dft of their last window. The
+ *        resampler gets a tone in chunks up to 2n samples: its output is compared to the
+ *        tone delayed by the kernel, an absolute error. The async queue is filled past its
+ *        slots, its job states checked, and its outputs compared to spectrum_batch_ws.
+ *        The fft pool must give the abs_fft_batch_ws spectra to the bit.
+ *        The stft frames, pushed in the same random chunks, are compared to abs_fft of
+ *        the windowed samples, the FIR filter output to the direct convolution and the
+ *        sliding DFT, pushed past its resynchronisations, to 2|X(k)|/n. The stream written
+ *        as a recording must be read back to the bit, and the streaming wavelet bands
+ *        must be the dwt_band_energy of their frames. The streaming sinus generator is
+ *        compared to sin() over the resyncs of its tones, the streaming pink noise to
+ *        itself in one call and to the ran1f stream of get_pink_signal_r. A mix generated
+ *        on the workers of a pool must be the mix of the same seed generated serially.
+ *
+ *        Per case, the worst error over the lengths is printed with its length, and
+ *        the program exits with 1 if any case goes over its tolerance.
+ *
+ *        Usage: fft_accuracy [--sizes n1,n2,...] [--verbose]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "fft.h"
+#include "signal_rng.h"
+#include "signal_file.h"
+#include "signal_generator.h"
+#include "thread_pool.h"
+
+/*every length up to here, then the ones of CHECK_DEFAULT_SIZES*/
+#define CHECK_ALL_SIZES_UP_TO 64
+/*powers of 2 and 3, the epochs of 220 samples, mixed-radix 2310 = 2*3*5*7*11, and primes (Bluestein)*/
+#define CHECK_DEFAULT_SIZES "81,97,100,127,128,210,220,243,250,256,257,440,500,509,512,660,1000," \
+                            "1009,1024,1331,2048,2053,2310,4096"
+#define CHECK_MAX_SIZES 256
+#define CHECK_MAX_CASES 128
+
+/*maximum relative errors, about 20 times the worst ones of the default lengths*/
+#define CHECK_TOL_DOUBLE 1e-13
+#define CHECK_TOL_FLOAT 1e-5
+/*fixed point: the bounds of fft.h are relative to max|x|, about 20*sqrt(n) times max|ref| for these inputs*/
+#define CHECK_TOL_Q15 5e-2
+#define CHECK_TOL_Q31 1e-6
+/*passband ripple of the 80 dB Kaiser kernel of the resampler*/
+#define CHECK_TOL_RESAMPLER 1e-4
+/*sliding DFT: each rotated sample adds about eps, up to n of them between two resyncs*/
+#define CHECK_TOL_SLIDING_DFT 1e-11
+
+#define CHECK_SKIP -1
+
+/*spectral features: the bands in Hz, the first two overlapping, away from every bin frequency of the lengths*/
+#define CHECK_FEATURES_FS 1000.0
+#define CHECK_FEATURES_BANDS 3
+#define CHECK_FEATURES_CHANNELS 3
+
+/*band power tracker: input_1 and input_2 pushed after CHECK_STREAM_PREFIX windows of noise*/
+#define CHECK_BAND_POWER_BANDS 3
+#define CHECK_BAND_POWER_CHANNELS 2
+#define CHECK_STREAM_PREFIX 2
+
+/*resampler: a tone at 0.3 times the lower Nyquist frequency, over that many input samples*/
+#define CHECK_RESAMPLER_TONE 0.3
+#define CHECK_RESAMPLER_LENGTH 4000
+
+/*async queue: workers, slots, and rounds of nb_slots jobs waited one by one*/
+#define CHECK_ASYNC_THREADS 2
+#define CHECK_ASYNC_SLOTS 4
+#define CHECK_ASYNC_ROUNDS 3
+
+/*fft pool: workers, and the channels of the stream, 2 per worker*/
+#define CHECK_POOL_THREADS 3
+#define CHECK_POOL_CHANNELS (2*(CHECK_STREAM_PREFIX + 1))
+
+/*streaming wavelets: frames of n samples pushed, the Daubechies lag is over after the first*/
+#define CHECK_DWT_PERIODS 4
+
+/*generators: samples pushed per length, past several resyncs of the sinus tones*/
+#define CHECK_GENERATOR_LENGTH 32768
+#define CHECK_SINUS_TONES 3
+/*sinus generator: the rotations drift by about eps per sample until the next resync*/
+#define CHECK_TOL_SINUS 5e-10
+
+/*signal mixes: channels, more than the tasks of the pool, and one source of each type*/
+#define CHECK_MIX_CHANNELS 13
+#define CHECK_MIX_SOURCES 6
+#define CHECK_MIX_LENGTH 4096
+
+/*recordings: frames per second of the written file, and its name, completed by mkstemp*/
+#define CHECK_FILE_RATE 48000.0
+#define CHECK_FILE_TEMPLATE "/tmp/fft_accuracy_XXXXXX"
+
+/*reference a case is compared to*/
+#define REF_FORWARD 0     /*transform of input_1 + j*input_2, n bins*/
+#define REF_INVERSE 1     /*unscaled inverse transform of input_1 + j*input_2, n bins*/
+#define REF_ONESIDED 2    /*bins 0..n/2 of the transform of input_1*/
+#define REF_MAGNITUDE 3   /*2*|X(k)|/n for the bins 0..n/2 of the transform of input_1, in out_real*/
+#define REF_SIGNAL 4      /*n*input_1, in out_real*/
+#define REF_2SIGNALS 5    /*transforms of input_1 then input_2, n bins each*/
+#define REF_CONVOLVE 6    /*circular convolution of input_1 + j*input_2 and input_2 + j*input_1, n values*/
+#define REF_CONVOLVE_REAL 7 /*circular convolution of input_1 and input_2, in out_real*/
+#define REF_FEATURES 8    /*features of the channels input_1, input_2, input_1, in out_real, each value to its own scale*/
+#define REF_BAND_POWER 9  /*power of the bands of input_1 then input_2, in out_real*/
+#define REF_STREAM 10     /*error measured by the case itself, in stream_error*/
+
+/**
+ * struct check_ctx_s
+ * @brief inputs, references and output buffers of one length
+ */
+struct check_ctx_s{
+
+	size_t n;
+
+	double *input_1;
+	double *input_2;
+
+	/*naive_dft of input_1 + j*input_2, forward and inverse*/
+	double *fwd_real;
+	double *fwd_imag;
+	double *inv_real;
+	double *inv_imag;
+	/*naive_dft of the real signals input_1 and input_2, one after the other (2n bins)*/
+	double *real_real;
+	double *real_imag;
+	/*naive circular convolutions, complex and real*/
+	double *conv_real;
+	double *conv_imag;
+	double *conv_signal;
+
+	/*outputs of the case being checked, 2n values each*/
+	double *out_real;
+	double *out_imag;
+	float *real_f;
+	float *imag_f;
+
+	fft_plan_t *plan;
+	fft_plan_t *plan_inverse;
+	fft_plan_t *plan_scaled;
+	fft_plan_f_t *plan_f;
+	fft_plan_f_t *plan_f_inverse;
+	rfft_plan_t *rplan;
+	void *workspace;
+	void *rworkspace;
+
+	/*input_1 as Q15 and Q31 integers, the fixed-point plan only exists for the powers of 2*/
+	int16_t *input_q15;
+	int32_t *input_q31;
+	int32_t *out_fixed;
+	fft_fixed_plan_t *plan_fixed;
+	dft_interval_fixed_plan_t *plan_goertzel;
+
+	/*extractor, the frame of its channels in both layouts, and their features from the naive_dft*/
+	fft_features_t *features;
+	void *features_workspace;
+	double *frame;
+	double *frame_interleaved;
+	double *features_ref;
+	size_t nb_features;      /*values written by the case being checked*/
+
+	/*tracker of overlapping bands, the interleaved stream of its two channels ending
+	  with input_1 and input_2, a chunk in the channel-major layout, and the powers
+	  of the bands from the naive_dft*/
+	band_power_t *band_power;
+	double *stream;
+	double *chunk;
+	double *signal;          /*first channel of the stream alone, for the single-channel cases*/
+	double band_power_ref[CHECK_BAND_POWER_CHANNELS*CHECK_BAND_POWER_BANDS];
+	signal_rng_t *rng;       /*draws the chunk sizes of the streaming cases*/
+	double stream_error;     /*error of the REF_STREAM case being checked*/
+};
+
+/*
+ * Case function: writes its result in ctx->out_real/out_imag in the layout
+ * of its reference. Returns 1 if success, 0 if the call failed, CHECK_SKIP
+ * if the case does not apply to this length.
+ */
+typedef int (*check_fn)(struct check_ctx_s *ctx);
+
+/**
+ * struct check_result_s
+ * @brief worst error of a case over the lengths
+ */
+struct check_result_s{
+	const char *name;
+	const char *backend;
+	double tolerance;
+	double worst;
+	size_t worst_n;
+	int nb_sizes;
+	int nb_failed;
+};
+
+static struct check_result_s results[CHECK_MAX_CASES];
+static int nb_results = 0;
+static size_t sizes[CHECK_MAX_SIZES];
+static int nb_sizes = 0;
+static int verbose = 0;
+
+static int parse_options(int argc, char **argv);
+static int ctx_init(struct check_ctx_s *ctx, size_t n, signal_rng_t *rng);
+static void ctx_free(struct check_ctx_s *ctx);
+static void check_length(size_t n, signal_rng_t *rng);
+static void check_case(const char *name, const char *backend, struct check_ctx_s *ctx,
+                       int reference, double tolerance, check_fn fn);
+static double relative_error(const struct check_ctx_s *ctx, int reference);
+static int is_power_of_2(size_t n);
+static int features_init(struct check_ctx_s *ctx);
+static int band_power_init(struct check_ctx_s *ctx);
+
+/*
+ * The cases. The outputs are copied from the inputs first for the in-place transforms.
+ */
+static void load_complex(struct check_ctx_s *ctx){
+	memcpy(ctx->out_real, ctx->input_1, ctx->n*sizeof(double));
+	memcpy(ctx->out_imag, ctx->input_2, ctx->n*sizeof(double));
+}
+
+static void load_complex_f(struct check_ctx_s *ctx){
+	size_t i;
+	for(i=0;i<ctx->n;i++){
+		ctx->real_f[i] = (float)ctx->input_1[i];
+		ctx->imag_f[i] = (float)ctx->input_2[i];
+	}
+}
+
+static void store_complex_f(struct check_ctx_s *ctx){
+	size_t i;
+	for(i=0;i<ctx->n;i++){
+		ctx->out_real[i] = ctx->real_f[i];
+		ctx->out_imag[i] = ctx->imag_f[i];
+	}
+}
+
+/*
+ * The interleaved vector is built in out_imag and spread back forward after the
+ * transform, data[2k+1] is read before out_imag[k] is written.
+ */
+static double* load_interleaved(struct check_ctx_s *ctx){
+	double *data = ctx->out_imag;
+	size_t i;
+	for(i=0;i<ctx->n;i++){
+		data[2*i] = ctx->input_1[i];
+		data[2*i+1] = ctx->input_2[i];
+	}
+	return data;
+}
+
+static void store_interleaved(struct check_ctx_s *ctx, const double *data){
+	size_t i;
+	for(i=0;i<ctx->n;i++){
+		ctx->out_real[i] = data[2*i];
+		ctx->out_imag[i] = data[2*i+1];
+	}
+}
+
+static int run_transform(struct check_ctx_s *ctx){
+	load_complex(ctx);
+	return transform(ctx->out_real, ctx->out_imag, ctx->n);
+}
+
+static int run_inverse_transform(struct check_ctx_s *ctx){
+	load_complex(ctx);
+	return inverse_transform(ctx->out_real, ctx->out_imag, ctx->n);
+}
+
+static int run_transform_radix2(struct check_ctx_s *ctx){
+	if(!is_power_of_2(ctx->n))
+		return CHECK_SKIP;
+	load_complex(ctx);
+	return transform_radix2(ctx->out_real, ctx->out_imag, ctx->n);
+}
+
+static int run_transform_mixed_radix(struct check_ctx_s *ctx){
+	/*returns 0 for the lengths with other prime factors than 2, 3, 5, 7 and 11*/
+	load_complex(ctx);
+	return transform_mixed_radix(ctx->out_real, ctx->out_imag, ctx->n) ? 1 : CHECK_SKIP;
+}
+
+static int run_transform_bluestein(struct check_ctx_s *ctx){
+	load_complex(ctx);
+	return transform_bluestein(ctx->out_real, ctx->out_imag, ctx->n);
+}
+
+static int run_transform_interleaved(struct check_ctx_s *ctx){
+	double *data = load_interleaved(ctx);
+	if(!transform_interleaved(data, ctx->n))
+		return 0;
+	store_interleaved(ctx, data);
+	return 1;
+}
+
+static int run_inverse_transform_interleaved(struct check_ctx_s *ctx){
+	double *data = load_interleaved(ctx);
+	if(!inverse_transform_interleaved(data, ctx->n))
+		return 0;
+	store_interleaved(ctx, data);
+	return 1;
+}
+
+static int run_fft_2signals(struct check_ctx_s *ctx){
+	return fft_2signals(ctx->input_1, ctx->input_2,
+	                    ctx->out_real, ctx->out_imag,
+	                    ctx->out_real + ctx->n, ctx->out_imag + ctx->n, ctx->n);
+}
+
+static int run_abs_fft(struct check_ctx_s *ctx){
+	return abs_fft(ctx->input_1, ctx->out_real, ctx->n);
+}
+
+/*an empty input is a success with nothing written, checked once at the first length*/
+static int run_empty_input(struct check_ctx_s *ctx){
+	if(ctx->n != sizes[0])
+		return CHECK_SKIP;
+	ctx->stream_error = (fft_2signals(NULL, NULL, NULL, NULL, NULL, NULL, 0)
+	                     && abs_fft_2signals(NULL, NULL, NULL, NULL, 0)
+	                     && abs_fft(NULL, NULL, 0)) ? 0.0 : INFINITY;
+	return 1;
+}
+
+static int run_transform_plan(struct check_ctx_s *ctx){
+	load_complex(ctx);
+	return transform_plan(ctx->plan, ctx->out_real, ctx->out_imag);
+}
+
+static int run_transform_plan_inverse(struct check_ctx_s *ctx){
+	load_complex(ctx);
+	return transform_plan(ctx->plan_inverse, ctx->out_real, ctx->out_imag);
+}
+
+/*the 1/n of the scaled inverse is taken back out, to compare with the unscaled reference*/
+static int run_transform_plan_scaled(struct check_ctx_s *ctx){
+	size_t i;
+	load_complex(ctx);
+	if(!transform_plan(ctx->plan_scaled, ctx->out_real, ctx->out_imag))
+		return 0;
+	for(i=0;i<ctx->n;i++){
+		ctx->out_real[i] *= ctx->n;
+		ctx->out_imag[i] *= ctx->n;
+	}
+	return 1;
+}
+
+static int run_transform_interleaved_ws(struct check_ctx_s *ctx){
+	double *data = load_interleaved(ctx);
+	if(!transform_interleaved_ws(ctx->plan, data, ctx->workspace))
+		return 0;
+	store_interleaved(ctx, data);
+	return 1;
+}
+
+static int run_transform_interleaved_plan_inverse(struct check_ctx_s *ctx){
+	double *data = load_interleaved(ctx);
+	if(!transform_interleaved_plan(ctx->plan_inverse, data))
+		return 0;
+	store_interleaved(ctx, data);
+	return 1;
+}
+
+static int run_fft_2signals_ws(struct check_ctx_s *ctx){
+	return fft_2signals_ws(ctx->plan, ctx->input_1, ctx->input_2,
+	                       ctx->out_real, ctx->out_imag,
+	                       ctx->out_real + ctx->n, ctx->out_imag + ctx->n, ctx->workspace);
+}
+
+static int run_spectrum_ws(struct check_ctx_s *ctx){
+
+	/*FFT_OUTPUT_COMPLEX is X(k) interleaved, through the real-input path for even lengths.
+	  It is written in out_imag and spread forward, the reads stay ahead of the writes*/
+	size_t half = ctx->n/2;
+	double *out = ctx->out_imag;
+	size_t k;
+
+	if(!spectrum_ws(ctx->plan, ctx->input_1, FFT_OUTPUT_COMPLEX, out, ctx->workspace))
+		return 0;
+	for(k=0;k<=half;k++){
+		ctx->out_real[k] = out[2*k];
+		ctx->out_imag[k] = out[2*k+1];
+	}
+	return 1;
+}
+
+static int run_abs_fft_ws(struct check_ctx_s *ctx){
+	return abs_fft_ws(ctx->plan, ctx->input_1, ctx->out_real, ctx->workspace);
+}
+
+static int run_rfft_ws(struct check_ctx_s *ctx){
+	return rfft_ws(ctx->rplan, ctx->input_1, ctx->out_real, ctx->out_imag, ctx->rworkspace);
+}
+
+static int run_irfft_ws(struct check_ctx_s *ctx){
+	/*from the exact one-sided spectrum, saved before out_real is overwritten*/
+	size_t half = ctx->n/2;
+	double *in_real = ctx->out_imag;
+	double *in_imag = ctx->out_imag + half + 1;
+
+	memcpy(in_real, ctx->real_real, (half+1)*sizeof(double));
+	memcpy(in_imag, ctx->real_imag, (half+1)*sizeof(double));
+	return irfft_ws(ctx->rplan, in_real, in_imag, ctx->out_real, ctx->rworkspace);
+}
+
+/*
+ * The fixed-point outputs are scaled back by the 2^15 or 2^31 of the inputs.
+ */
+static void store_fixed(struct check_ctx_s *ctx, int exponent){
+	size_t k;
+	for(k=0;k<=ctx->n/2;k++)
+		ctx->out_real[k] = ldexp((double)ctx->out_fixed[k], exponent);
+}
+
+static int run_abs_fft_q15(struct check_ctx_s *ctx){
+	int exponent;
+	if(ctx->plan_fixed == NULL)
+		return CHECK_SKIP;
+	if(!abs_fft_q15(ctx->plan_fixed, ctx->input_q15, ctx->out_fixed, &exponent))
+		return 0;
+	store_fixed(ctx, exponent - 15);
+	return 1;
+}
+
+static int run_abs_fft_q31(struct check_ctx_s *ctx){
+	int exponent;
+	if(ctx->plan_fixed == NULL)
+		return CHECK_SKIP;
+	if(!abs_fft_q31(ctx->plan_fixed, ctx->input_q31, ctx->out_fixed, &exponent))
+		return 0;
+	store_fixed(ctx, exponent - 31);
+	return 1;
+}
+
+static int run_abs_dft_interval_q15(struct check_ctx_s *ctx){
+	int exponent;
+	abs_dft_interval_q15(ctx->plan_goertzel, ctx->input_q15, ctx->out_fixed, &exponent);
+	store_fixed(ctx, exponent - 15);
+	return 1;
+}
+
+static int run_abs_dft_interval_q31(struct check_ctx_s *ctx){
+	int exponent;
+	abs_dft_interval_q31(ctx->plan_goertzel, ctx->input_q31, ctx->out_fixed, &exponent);
+	store_fixed(ctx, exponent - 31);
+	return 1;
+}
+
+/*
+ * Convolutions of x = input_1 + j*input_2 and y = input_2 + j*input_1: the aliased
+ * arrays are loaded in out_real/out_imag, y after x in their second halves when both are.
+ */
+static int run_convolve_real(struct check_ctx_s *ctx){
+	return convolve_real(ctx->input_1, ctx->input_2, ctx->out_real, ctx->n);
+}
+
+static int run_convolve_complex(struct check_ctx_s *ctx){
+	return convolve_complex(ctx->input_1, ctx->input_2, ctx->input_2, ctx->input_1,
+	                        ctx->out_real, ctx->out_imag, ctx->n);
+}
+
+static int run_convolve_real_ws(struct check_ctx_s *ctx){
+	return convolve_real_ws(ctx->plan, ctx->input_1, ctx->input_2, ctx->out_real, ctx->workspace);
+}
+
+static int run_convolve_complex_ws(struct check_ctx_s *ctx){
+	return convolve_complex_ws(ctx->plan, ctx->input_1, ctx->input_2, ctx->input_2, ctx->input_1,
+	                           ctx->out_real, ctx->out_imag, ctx->workspace);
+}
+
+static int run_convolve_complex_ws_out_x(struct check_ctx_s *ctx){
+	load_complex(ctx);
+	return convolve_complex_ws(ctx->plan, ctx->out_real, ctx->out_imag, ctx->input_2, ctx->input_1,
+	                           ctx->out_real, ctx->out_imag, ctx->workspace);
+}
+
+static int run_convolve_complex_ws_out_y(struct check_ctx_s *ctx){
+	memcpy(ctx->out_real, ctx->input_2, ctx->n*sizeof(double));
+	memcpy(ctx->out_imag, ctx->input_1, ctx->n*sizeof(double));
+	return convolve_complex_ws(ctx->plan, ctx->input_1, ctx->input_2, ctx->out_real, ctx->out_imag,
+	                           ctx->out_real, ctx->out_imag, ctx->workspace);
+}
+
+static int run_convolve_complex_inplace_ws(struct check_ctx_s *ctx){
+	double *y_real = ctx->out_real + ctx->n;
+	double *y_imag = ctx->out_imag + ctx->n;
+	load_complex(ctx);
+	memcpy(y_real, ctx->input_2, ctx->n*sizeof(double));
+	memcpy(y_imag, ctx->input_1, ctx->n*sizeof(double));
+	return convolve_complex_inplace_ws(ctx->plan, ctx->out_real, ctx->out_imag, y_real, y_imag,
+	                                   ctx->workspace);
+}
+
+static int run_fft_features(struct check_ctx_s *ctx){
+	if(ctx->features == NULL)
+		return CHECK_SKIP;
+	ctx->nb_features = fft_features_length(ctx->features);
+	return fft_features(ctx->features, ctx->input_1, ctx->out_real);
+}
+
+static int run_fft_features_batch_major(struct check_ctx_s *ctx){
+	if(ctx->features == NULL)
+		return CHECK_SKIP;
+	ctx->nb_features = CHECK_FEATURES_CHANNELS*fft_features_length(ctx->features);
+	return fft_features_batch_ws(ctx->features, ctx->frame, CHECK_FEATURES_CHANNELS,
+	                             FFT_LAYOUT_CHANNEL_MAJOR, ctx->out_real, ctx->features_workspace);
+}
+
+static int run_fft_features_batch_interleaved(struct check_ctx_s *ctx){
+	if(ctx->features == NULL)
+		return CHECK_SKIP;
+	ctx->nb_features = CHECK_FEATURES_CHANNELS*fft_features_length(ctx->features);
+	return fft_features_batch_ws(ctx->features, ctx->frame_interleaved, CHECK_FEATURES_CHANNELS,
+	                             FFT_LAYOUT_INTERLEAVED, ctx->out_real, ctx->features_workspace);
+}
+
+/*
+ * Pushes the stream in chunks of random sizes, from none to one and a half window, so
+ * that the pushes start and stop anywhere between two exact recomputations.
+ */
+static int run_band_power(struct check_ctx_s *ctx, int layout){
+
+	size_t length = (CHECK_STREAM_PREFIX + 1)*ctx->n;
+	size_t done = 0;
+
+	if(ctx->n*2 < CHECK_BAND_POWER_CHANNELS*CHECK_BAND_POWER_BANDS)
+		return CHECK_SKIP;
+
+	band_power_reset(ctx->band_power);
+	while(done < length){
+
+		const double *data = ctx->stream + done*CHECK_BAND_POWER_CHANNELS;
+		size_t count = (size_t)(signal_rng_next(ctx->rng) % (ctx->n + ctx->n/2 + 1));
+		size_t c, t;
+
+		if(count > length - done)
+			count = length - done;
+		if(layout == FFT_LAYOUT_CHANNEL_MAJOR){
+			for(c=0;c<CHECK_BAND_POWER_CHANNELS;c++){
+				for(t=0;t<count;t++)
+					ctx->chunk[c*count + t] = data[t*CHECK_BAND_POWER_CHANNELS + c];
+			}
+			data = ctx->chunk;
+		}
+		if(!band_power_push(ctx->band_power, data, (int)count, layout))
+			return 0;
+		done += count;
+	}
+
+	band_power_get(ctx->band_power, ctx->out_real);
+	return 1;
+}
+
+static int run_band_power_major(struct check_ctx_s *ctx){
+	return run_band_power(ctx, FFT_LAYOUT_CHANNEL_MAJOR);
+}
+
+static int run_band_power_interleaved(struct check_ctx_s *ctx){
+	return run_band_power(ctx, FFT_LAYOUT_INTERLEAVED);
+}
+
+/*
+ * Size of the next chunk of a streaming case, from none to 2n samples, at most left.
+ */
+static size_t check_chunk(struct check_ctx_s *ctx, size_t left){
+
+	size_t count = (size_t)(signal_rng_next(ctx->rng) % (2*ctx->n + 1));
+	return (count > left) ? left : count;
+}
+
+/*
+ * Resamples a tone pushed in chunks of 0 to 2n samples. Every call must give the
+ * resampler_output_length announced before it, ceil(length*up/down) in total, and
+ * output m must be the tone at input time (m - delay)*down/up once the kernel is
+ * past the first input.
+ */
+static int run_resampler(struct check_ctx_s *ctx, int up, int down){
+
+	size_t length = CHECK_RESAMPLER_LENGTH;
+	size_t expected = (length*up + down - 1)/down;
+	double rate = (up < down) ? (double)up/down : 1;
+	double omega = 2*M_PI*CHECK_RESAMPLER_TONE*0.5*rate;
+	resampler_t *resampler = resampler_create(up, down, 0);
+	double *in = (double*)malloc(length*sizeof(double));
+	double *out = (double*)malloc((expected + 1)*sizeof(double));
+	size_t done = 0, nb_out = 0, m, t;
+	double delay, max_diff = 0;
+	int status = 0;
+
+	if(resampler == NULL || in == NULL || out == NULL)
+		goto error;
+
+	for(t=0;t<length;t++)
+		in[t] = sin(omega*t);
+
+	while(done < length){
+		size_t count = check_chunk(ctx, length - done);
+		size_t announced;
+		announced = resampler_output_length(resampler, count);
+		if(nb_out + announced > expected || resampler_process(resampler, in + done, count, out + nb_out) != announced)
+			goto error;
+		nb_out += announced;
+		done += count;
+	}
+	if(nb_out != expected)
+		goto error;
+
+	/*the first 2*delay outputs see the zeros of the initial history*/
+	delay = resampler_delay(resampler);
+	for(m=(size_t)ceil(2*delay);m<nb_out;m++){
+		double diff = fabs(out[m] - sin(omega*(m - delay)*down/up));
+		if(!(diff <= max_diff))
+			max_diff = diff;
+	}
+	ctx->stream_error = max_diff;
+	status = 1;
+
+error:
+	resampler_destroy(resampler);
+	free(in);
+	free(out);
+	return status;
+}
+
+static int run_resampler_1_4(struct check_ctx_s *ctx){
+	return run_resampler(ctx, 1, 4);
+}
+
+static int run_resampler_3_2(struct check_ctx_s *ctx){
+	return run_resampler(ctx, 3, 2);
+}
+
+static int run_resampler_2_3(struct check_ctx_s *ctx){
+	return run_resampler(ctx, 2, 3);
+}
+
+/*
+ * Largest distance between two batches of spectra over the largest value of the reference.
+ */
+static double batch_error(const double *out, const double *ref, size_t count){
+
+	double max_diff = 0, max_ref = 0;
+	size_t k;
+
+	for(k=0;k<count;k++){
+		double diff = fabs(out[k] - ref[k]);
+		if(fabs(ref[k]) > max_ref)
+			max_ref = fabs(ref[k]);
+		if(!(diff <= max_diff))
+			max_diff = diff;
+	}
+	return (max_ref > 0) ? max_diff/max_ref : max_diff;
+}
+
+/**
+ * struct async_gate_s
+ * @brief holds the workers of an async queue in the callbacks of their jobs
+ */
+struct async_gate_s{
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	int nb_held;
+	int open;
+};
+
+static void async_gate_fn(void *context, uint64_t job, int status){
+
+	struct async_gate_s *gate = (struct async_gate_s*)context;
+
+	pthread_mutex_lock(&gate->lock);
+	gate->nb_held++;
+	pthread_cond_broadcast(&gate->cond);
+	while(!gate->open)
+		pthread_cond_wait(&gate->cond, &gate->lock);
+	pthread_mutex_unlock(&gate->lock);
+}
+
+/*
+ * Holds every worker in the callback of a first job, so that the next nb_slots jobs stay
+ * queued: the ring is full, the first jobs are retired, the ids never submitted unknown.
+ * Then releases the workers, waits for the queued jobs, and runs rounds of jobs polled
+ * one by one. Every output is compared to spectrum_batch_ws on the same frame, the last
+ * window of the band power stream (input_1 and input_2 interleaved).
+ */
+static int run_fft_async(struct check_ctx_s *ctx){
+
+	size_t n = ctx->n;
+	size_t length = 2*fft_output_length(n, FFT_OUTPUT_MAGNITUDE);
+	size_t nb_jobs = CHECK_ASYNC_THREADS + (1 + CHECK_ASYNC_ROUNDS)*CHECK_ASYNC_SLOTS;
+	const double *frame = ctx->stream + 2*CHECK_STREAM_PREFIX*n;
+	struct async_gate_s gate = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0};
+	fft_plan_t *plan = fft_plan_create(n, 0);
+	void *workspace = fft_malloc(fft_batch_workspace_size(n));
+	double *ref = (double*)malloc((nb_jobs + 1)*length*sizeof(double));
+	double *out = ref + length;
+	fft_async_t *async = fft_async_create(n, CHECK_ASYNC_THREADS, CHECK_ASYNC_SLOTS);
+	uint64_t ids[CHECK_ASYNC_THREADS + (1 + CHECK_ASYNC_ROUNDS)*CHECK_ASYNC_SLOTS];
+	size_t j, next = 0;
+	int status = 0;
+
+	if(plan == NULL || workspace == NULL || ref == NULL || async == NULL)
+		goto error;
+	if(!spectrum_batch_ws(plan, frame, 2, FFT_LAYOUT_INTERLEAVED, FFT_OUTPUT_MAGNITUDE, ref, workspace))
+		goto error;
+
+	/*one held job per worker*/
+	for(;next<CHECK_ASYNC_THREADS;next++){
+		ids[next] = fft_async_submit(async, frame, 2, FFT_LAYOUT_INTERLEAVED, FFT_OUTPUT_MAGNITUDE,
+		                             out + next*length, async_gate_fn, &gate);
+		if(ids[next] != next + 1)
+			goto error;
+	}
+	pthread_mutex_lock(&gate.lock);
+	while(gate.nb_held < CHECK_ASYNC_THREADS)
+		pthread_cond_wait(&gate.cond, &gate.lock);
+	pthread_mutex_unlock(&gate.lock);
+
+	/*nothing runs: nb_slots jobs fill the ring, one more is refused*/
+	for(j=0;j<CHECK_ASYNC_SLOTS;j++,next++){
+		ids[next] = fft_async_submit(async, frame, 2, FFT_LAYOUT_INTERLEAVED, FFT_OUTPUT_MAGNITUDE,
+		                             out + next*length, NULL, NULL);
+		if(ids[next] != next + 1 || fft_async_poll(async, ids[next]) != FFT_ASYNC_PENDING)
+			goto error;
+	}
+	if(fft_async_submit(async, frame, 2, FFT_LAYOUT_INTERLEAVED, FFT_OUTPUT_MAGNITUDE, out, NULL, NULL) != 0)
+		goto error;
+	for(j=0;j<CHECK_ASYNC_THREADS;j++){
+		if(fft_async_poll(async, ids[j]) != FFT_ASYNC_RETIRED)
+			goto error;
+	}
+	if(fft_async_poll(async, 0) != FFT_ASYNC_UNKNOWN || fft_async_poll(async, next + 1) != FFT_ASYNC_UNKNOWN)
+		goto error;
+
+	pthread_mutex_lock(&gate.lock);
+	gate.open = 1;
+	pthread_cond_broadcast(&gate.cond);
+	pthread_mutex_unlock(&gate.lock);
+	for(j=CHECK_ASYNC_THREADS;j<next;j++){
+		if(fft_async_wait(async, ids[j]) != FFT_ASYNC_DONE)
+			goto error;
+	}
+
+	/*more jobs than slots, each one polled to completion before the next*/
+	for(;next<nb_jobs;next++){
+		int state;
+		ids[next] = fft_async_submit(async, frame, 2, FFT_LAYOUT_INTERLEAVED, FFT_OUTPUT_MAGNITUDE,
+		                             out + next*length, NULL, NULL);
+		if(ids[next] != next + 1)
+			goto error;
+		while((state = fft_async_poll(async, ids[next])) == FFT_ASYNC_PENDING);
+		if(state != FFT_ASYNC_DONE)
+			goto error;
+	}
+
+	ctx->stream_error = 0;
+	for(j=0;j<nb_jobs;j++){
+		double error = batch_error(out + j*length, ref, length);
+		if(!(error <= ctx->stream_error))
+			ctx->stream_error = error;
+	}
+	status = 1;
+
+error:
+	/*the held workers are released before the queue is stopped*/
+	pthread_mutex_lock(&gate.lock);
+	gate.open = 1;
+	pthread_cond_broadcast(&gate.cond);
+	pthread_mutex_unlock(&gate.lock);
+	fft_async_destroy(async);
+	fft_plan_destroy(plan);
+	free(workspace);
+	free(ref);
+	return status;
+}
+
+/**
+ * struct stft_check_s
+ * @brief reference of the frames of the stft case, computed by its callback
+ */
+struct stft_check_s{
+	const double *signal;
+	size_t n;
+	size_t hop;
+	double *window;
+	double *frame;           /*windowed frame, then its abs_fft*/
+	double *ref;
+	size_t nb_frames;
+	double error;
+	int failed;
+};
+
+/*frame f is the signal from f*hop on, windowed, as abs_fft gives it*/
+static void stft_check_fn(void *context, const double *spectrum, size_t frame){
+
+	struct stft_check_s *check = (struct stft_check_s*)context;
+	const double *x = check->signal + frame*check->hop;
+	double error;
+	size_t i;
+
+	if(frame != check->nb_frames++){
+		check->failed = 1;
+		return;
+	}
+	for(i=0;i<check->n;i++)
+		check->frame[i] = x[i]*check->window[i];
+	if(!abs_fft(check->frame, check->ref, check->n)){
+		check->failed = 1;
+		return;
+	}
+	error = batch_error(spectrum, check->ref, check->n/2+1);
+	if(!(error <= check->error))
+		check->error = error;
+}
+
+/*
+ * Pushes the stream in chunks up to 2n samples into a Hann stft of hop n/3+1: every
+ * frame is compared to abs_fft of the windowed samples.
+ */
+static int run_stft(struct check_ctx_s *ctx){
+
+	size_t n = ctx->n;
+	size_t length = (CHECK_STREAM_PREFIX + 1)*n;
+	struct stft_check_s check;
+	stft_t *stft = stft_create(n, n/3+1, FFT_WINDOW_HANN, FFT_OUTPUT_MAGNITUDE, 0);
+	size_t done = 0, nb_frames = 0;
+	int status = 0;
+
+	memset(&check, 0, sizeof(check));
+	check.signal = ctx->signal;
+	check.n = n;
+	check.hop = n/3+1;
+	check.window = (double*)malloc(n*sizeof(double));
+	check.frame = (double*)malloc(n*sizeof(double));
+	check.ref = (double*)malloc((n/2+1)*sizeof(double));
+	if(stft == NULL || check.window == NULL || check.frame == NULL || check.ref == NULL)
+		goto error;
+	fft_window(check.window, n, FFT_WINDOW_HANN);
+
+	while(done < length){
+		size_t count = check_chunk(ctx, length - done);
+		nb_frames += stft_push(stft, ctx->signal + done, count, stft_check_fn, &check);
+		done += count;
+	}
+	if(check.failed || nb_frames != check.nb_frames || nb_frames != (length - n)/check.hop + 1)
+		goto error;
+
+	ctx->stream_error = check.error;
+	status = 1;
+
+error:
+	stft_destroy(stft);
+	free(check.window);
+	free(check.frame);
+	free(check.ref);
+	return status;
+}
+
+/*
+ * Filters the stream, in chunks up to 2n samples, by input_2 as a kernel of n taps:
+ * the output is compared to the direct convolution delayed by the latency, zeros
+ * before it.
+ */
+static int run_fir_filter(struct check_ctx_s *ctx){
+
+	size_t n = ctx->n;
+	size_t length = (CHECK_STREAM_PREFIX + 1)*n;
+	fir_filter_t *filter = fir_filter_create(ctx->input_2, n, 0);
+	double *out = (double*)malloc(length*sizeof(double));
+	double *ref = (double*)malloc(length*sizeof(double));
+	size_t done = 0, latency, t, j;
+	int status = 0;
+
+	if(filter == NULL || out == NULL || ref == NULL)
+		goto error;
+	latency = fir_filter_latency(filter);
+
+	for(t=0;t<length;t++){
+		double sum = 0.0;
+		if(t >= latency)
+			for(j=0;j<n && j<=t-latency;j++)
+				sum += ctx->input_2[j]*ctx->signal[t-latency-j];
+		ref[t] = sum;
+	}
+	while(done < length){
+		size_t count = check_chunk(ctx, length - done);
+		fir_filter_process(filter, ctx->signal + done, out + done, count);
+		done += count;
+	}
+
+	ctx->stream_error = batch_error(out, ref, length);
+	status = 1;
+
+error:
+	fir_filter_destroy(filter);
+	free(out);
+	free(ref);
+	return status;
+}
+
+/*
+ * Pushes the stream but its first n/2 samples, in chunks up to 2n samples, into a
+ * sliding DFT of the bins [0, n/2+1): past the exact resynchronisations every n samples,
+ * the last n/2 samples rotate the bins, to be compared to what abs_dft_interval gives
+ * for input_1, 2|X(k)|/n, taken from the naive_dft as the Goertzel recurrence drifts.
+ */
+static int run_sliding_dft(struct check_ctx_s *ctx){
+
+	size_t n = ctx->n;
+	size_t length = (CHECK_STREAM_PREFIX + 1)*n;
+	size_t nb_bins = n/2+1;
+	sliding_dft_t *sdft = sliding_dft_create((int)n, 0, (int)nb_bins);
+	double *out = (double*)malloc(nb_bins*sizeof(double));
+	double *ref = (double*)malloc(nb_bins*sizeof(double));
+	size_t done = n/2, k;
+	int status = 0;
+
+	if(sdft == NULL || out == NULL || ref == NULL)
+		goto error;
+	while(done < length){
+		size_t count = check_chunk(ctx, length - done);
+		sliding_dft_push(sdft, ctx->signal + done, (int)count);
+		done += count;
+	}
+	sliding_dft_abs(sdft, out);
+	for(k=0;k<nb_bins;k++)
+		ref[k] = 2*hypot(ctx->real_real[k], ctx->real_imag[k])/n;
+
+	ctx->stream_error = batch_error(out, ref, nb_bins);
+	status = 1;
+
+error:
+	sliding_dft_destroy(sdft);
+	free(out);
+	free(ref);
+	return status;
+}
+
+/*
+ * Splits the stream, seen as CHECK_POOL_CHANNELS n-long channels, across the workers of
+ * a pool taking one channel each at least: the same transforms as abs_fft_batch_ws,
+ * expected to the bit.
+ */
+static int run_fft_pool(struct check_ctx_s *ctx, int layout){
+
+	size_t n = ctx->n;
+	size_t length = CHECK_POOL_CHANNELS*(n/2+1);
+	fft_pool_t *pool = fft_pool_create(n, CHECK_POOL_THREADS);
+	fft_plan_t *plan = fft_plan_create(n, 0);
+	void *workspace = fft_malloc(fft_batch_workspace_size(n));
+	double *ref = (double*)malloc(2*length*sizeof(double));
+	double *out = ref + length;
+	int status = 0;
+
+	if(pool == NULL || plan == NULL || workspace == NULL || ref == NULL)
+		goto error;
+	fft_pool_set_min_channels(pool, 1);
+	if(!abs_fft_batch_ws(plan, ctx->stream, CHECK_POOL_CHANNELS, layout, ref, workspace))
+		goto error;
+	if(!fft_pool_abs_fft_batch(pool, ctx->stream, CHECK_POOL_CHANNELS, layout, out))
+		goto error;
+
+	ctx->stream_error = batch_error(out, ref, length);
+	status = 1;
+
+error:
+	fft_pool_destroy(pool);
+	fft_plan_destroy(plan);
+	free(workspace);
+	free(ref);
+	return status;
+}
+
+static int run_fft_pool_major(struct check_ctx_s *ctx){
+	return run_fft_pool(ctx, FFT_LAYOUT_CHANNEL_MAJOR);
+}
+
+static int run_fft_pool_interleaved(struct check_ctx_s *ctx){
+	return run_fft_pool(ctx, FFT_LAYOUT_INTERLEAVED);
+}
+
+/*
+ * Writes the stream as a recording of CHECK_BAND_POWER_CHANNELS channels, in chunks up
+ * to 2n frames with a flush halfway, then maps it back: its header and its frames must be
+ * the ones written, to the bit, and a window past the last frame is refused.
+ */
+static int run_signal_file(struct check_ctx_s *ctx){
+
+	size_t length = (CHECK_STREAM_PREFIX + 1)*ctx->n;
+	size_t nb_values = CHECK_BAND_POWER_CHANNELS*length;
+	char path[] = CHECK_FILE_TEMPLATE;
+	signal_writer_t *writer = NULL;
+	signal_file_t *file = NULL;
+	const double *frames;
+	size_t done = 0;
+	int fd = mkstemp(path);
+	int written, status = 0;
+
+	if(fd < 0)
+		return 0;
+	close(fd);
+
+	writer = signal_writer_create(path, CHECK_BAND_POWER_CHANNELS, CHECK_FILE_RATE);
+	if(writer == NULL)
+		goto error;
+	while(done < length){
+		size_t count = check_chunk(ctx, length - done);
+		if(!signal_writer_append(writer, ctx->stream + CHECK_BAND_POWER_CHANNELS*done, count))
+			goto error;
+		if(done < length/2 && done + count >= length/2 && !signal_writer_flush(writer))
+			goto error;
+		done += count;
+	}
+	written = signal_writer_close(writer);
+	writer = NULL;
+	if(!written)
+		goto error;
+
+	file = signal_file_open(path);
+	if(file == NULL || signal_file_nb_channels(file) != CHECK_BAND_POWER_CHANNELS
+	   || signal_file_nb_frames(file) != length || signal_file_sample_rate(file) != CHECK_FILE_RATE)
+		goto error;
+	frames = signal_file_frames(file, 0, length);
+	if(frames == NULL || signal_file_frames(file, length - ctx->n, ctx->n + 1) != NULL)
+		goto error;
+
+	ctx->stream_error = batch_error(frames, ctx->stream, nb_values);
+	status = 1;
+
+error:
+	signal_writer_close(writer);
+	signal_file_close(file);
+	unlink(path);
+	return status;
+}
+
+/*
+ * Generates CHECK_GENERATOR_LENGTH samples of a sum of tones of random frequencies,
+ * amplitudes and phases, in chunks up to 2n samples: the samples are compared to
+ * sum amplitude*sin(norm_freq*pi*i + phase), an absolute error over the amplitudes.
+ */
+static int run_sinus_generator(struct check_ctx_s *ctx){
+
+	size_t length = CHECK_GENERATOR_LENGTH;
+	double norm_freq[CHECK_SINUS_TONES], amplitude[CHECK_SINUS_TONES], phase[CHECK_SINUS_TONES];
+	sinus_generator_t *gen;
+	double *out = (double*)malloc(length*sizeof(double));
+	double max_ref = 0, max_diff = 0;
+	size_t done = 0, i;
+	int j, status = 0;
+
+	for(j=0;j<CHECK_SINUS_TONES;j++){
+		norm_freq[j] = signal_rng_uniform(ctx->rng);
+		amplitude[j] = 0.5 + signal_rng_uniform(ctx->rng);
+		phase[j] = 2*M_PI*(signal_rng_uniform(ctx->rng) - 0.5);
+		max_ref += amplitude[j];
+	}
+	gen = sinus_generator_create(CHECK_SINUS_TONES, norm_freq, amplitude, phase);
+	if(gen == NULL || out == NULL)
+		goto error;
+
+	while(done < length){
+		size_t count = check_chunk(ctx, length - done);
+		sinus_generator_next(gen, out + done, (int)count);
+		done += count;
+	}
+	for(i=0;i<length;i++){
+		double ref = 0, diff;
+		for(j=0;j<CHECK_SINUS_TONES;j++)
+			ref += amplitude[j]*sin(norm_freq[j]*M_PI*(double)i + phase[j]);
+		diff = fabs(out[i] - ref);
+		if(!(diff <= max_diff))
+			max_diff = diff;
+	}
+
+	ctx->stream_error = max_diff/max_ref;
+	status = 1;
+
+error:
+	sinus_generator_destroy(gen);
+	free(out);
+	return status;
+}
+
+/*
+ * Generates CHECK_GENERATOR_LENGTH samples of pink noise of PINK_MAX_ROWS rows, in
+ * chunks up to 2n samples from one generator and in one call from another with the
+ * same seed: the two streams must be the same to the bit. The chunked stream is also
+ * compared to the ran1f/ranh stream of get_pink_signal_r with the same seed, which it
+ * reproduces but for the rounding of the running sum of the rows.
+ */
+static int pink_generator_case(struct check_ctx_s *ctx, int reference){
+
+	size_t length = CHECK_GENERATOR_LENGTH;
+	signal_rng_t seed, rng;
+	pink_generator_t *chunked, *whole = NULL;
+	double *out = (double*)malloc(2*length*sizeof(double));
+	double *ref = out + length;
+	size_t done = 0;
+	int status = 0;
+
+	signal_rng_seed(&seed, signal_rng_next(ctx->rng));
+	chunked = pink_generator_create(PINK_MAX_ROWS, &seed);
+	if(chunked == NULL || out == NULL)
+		goto error;
+
+	while(done < length){
+		size_t count = check_chunk(ctx, length - done);
+		pink_generator_next(chunked, out + done, (int)count);
+		done += count;
+	}
+	if(reference){
+		rng = seed;
+		get_pink_signal_r(&rng, ref, (int)length);
+	}else{
+		whole = pink_generator_create(PINK_MAX_ROWS, &seed);
+		if(whole == NULL)
+			goto error;
+		pink_generator_next(whole, ref, (int)length);
+	}
+
+	ctx->stream_error = batch_error(out, ref, length);
+	status = 1;
+
+error:
+	pink_generator_destroy(chunked);
+	pink_generator_destroy(whole);
+	free(out);
+	return status;
+}
+
+static int run_pink_generator(struct check_ctx_s *ctx){
+	return pink_generator_case(ctx, 0);
+}
+
+static int run_pink_generator_ran1f(struct check_ctx_s *ctx){
+	return pink_generator_case(ctx, 1);
+}
+
+/*
+ * Fills two mixes of the same seed with a source of every type, then generates
+ * CHECK_MIX_LENGTH samples per channel from both, in the same chunks up to 2n
+ * samples: with signal_mix_next from one, with signal_mix_next_parallel on a pool of
+ * CHECK_POOL_THREADS workers from the other. The outputs must be the same to the bit.
+ */
+static int run_signal_mix_parallel(struct check_ctx_s *ctx){
+
+	static const int types[CHECK_MIX_SOURCES] = {SIGNAL_SOURCE_PINK, SIGNAL_SOURCE_SINUS,
+	                                             SIGNAL_SOURCE_DISPERSED_SINUS, SIGNAL_SOURCE_WHITE,
+	                                             SIGNAL_SOURCE_DC, SIGNAL_SOURCE_ARTIFACT};
+	static const double params[CHECK_MIX_SOURCES][2] = {{0, 0}, {0.1, 0}, {0.2, 0.05},
+	                                                     {0, 0}, {0, 0}, {0.01, 50}};
+	size_t length = CHECK_MIX_LENGTH;
+	size_t count_max = 2*ctx->n;
+	uint64_t seed = signal_rng_next(ctx->rng);
+	thread_pool_t *pool = thread_pool_create(CHECK_POOL_THREADS);
+	signal_mix_t *serial = signal_mix_create(CHECK_MIX_CHANNELS, seed);
+	signal_mix_t *parallel = signal_mix_create(CHECK_MIX_CHANNELS, seed);
+	double *out = (double*)malloc(2*CHECK_MIX_CHANNELS*count_max*sizeof(double));
+	double *ref = out + CHECK_MIX_CHANNELS*count_max;
+	size_t done = 0;
+	double error = 0;
+	int s, status = 0;
+
+	if(pool == NULL || serial == NULL || parallel == NULL || out == NULL)
+		goto error;
+	for(s=0;s<CHECK_MIX_SOURCES;s++){
+		if(!signal_mix_add(serial, types[s], 1.0, params[s][0], params[s][1])
+		   || !signal_mix_add(parallel, types[s], 1.0, params[s][0], params[s][1]))
+			goto error;
+	}
+
+	while(done < length){
+		size_t count = check_chunk(ctx, length - done);
+		double chunk_error;
+		signal_mix_next(serial, ref, (int)count);
+		signal_mix_next_parallel(pool, parallel, out, (int)count);
+		chunk_error = batch_error(out, ref, CHECK_MIX_CHANNELS*count);
+		if(!(chunk_error <= error))
+			error = chunk_error;
+		done += count;
+	}
+
+	ctx->stream_error = error;
+	status = 1;
+
+error:
+	thread_pool_destroy(pool);
+	signal_mix_destroy(serial);
+	signal_mix_destroy(parallel);
+	free(out);
+	return status;
+}
+
+/*the wavelet transforms are orthonormal: the round trip gives the signal back, scaled to REF_SIGNAL*/
+static int run_dwt_round_trip(struct check_ctx_s *ctx, int wavelet){
+	size_t i;
+	if(dwt_max_levels(ctx->n) == 0)
+		return CHECK_SKIP;
+	memcpy(ctx->out_real, ctx->input_1, ctx->n*sizeof(double));
+	if(!dwt(ctx->out_real, ctx->n, wavelet, 0) || !idwt(ctx->out_real, ctx->n, wavelet, 0))
+		return 0;
+	for(i=0;i<ctx->n;i++)
+		ctx->out_real[i] *= ctx->n;
+	return 1;
+}
+
+/**
+ * struct dwt_stream_check_s
+ * @brief reference of the frames of the streaming wavelet cases, computed by their callback
+ */
+struct dwt_stream_check_s{
+	const double *signal;
+	size_t n;
+	int wavelet;
+	int levels;
+	size_t first_checked;    /*frames before it are not compared*/
+	double *frame;           /*samples of the frame, then their dwt*/
+	double *ref;
+	size_t nb_frames;
+	double error;
+	int failed;
+};
+
+/*frame f is the dwt_band_energy of the signal from f*n on*/
+static void dwt_stream_check_fn(void *context, const double *energy, size_t frame){
+
+	struct dwt_stream_check_s *check = (struct dwt_stream_check_s*)context;
+	size_t count = check->levels + 1;
+	double error;
+
+	if(frame != check->nb_frames++){
+		check->failed = 1;
+		return;
+	}
+	if(frame < check->first_checked)
+		return;
+	memcpy(check->frame, check->signal + frame*check->n, check->n*sizeof(double));
+	if(!dwt(check->frame, check->n, check->wavelet, check->levels)
+	   || !dwt_band_energy(check->frame, check->n, check->levels, check->ref)){
+		check->failed = 1;
+		return;
+	}
+	error = batch_error(energy, check->ref, count);
+	if(!(error <= check->error))
+		check->error = error;
+}
+
+/*
+ * Pushes a signal of CHECK_DWT_PERIODS frames of n samples, in chunks up to 2n samples,
+ * into a wavelet tracker of hop n and every level. The Haar pairs never cross a frame:
+ * every frame of the stream is compared to dwt_band_energy of its samples, band by band.
+ * The Daubechies levels carry their lag over the frames: the stream repeats input_1, and
+ * the bands of its last frame are compared to those of a dwt of input_1, which they only
+ * match if every level pairs its approximations as dwt.
+ */
+static int run_dwt_stream(struct check_ctx_s *ctx, int wavelet){
+
+	size_t n = ctx->n;
+	size_t length = CHECK_DWT_PERIODS*n;
+	struct dwt_stream_check_s check;
+	dwt_stream_t *stream;
+	double *signal;
+	size_t done = 0, nb_frames = 0, t;
+	int status = 0;
+
+	if(dwt_max_levels(n) == 0)
+		return CHECK_SKIP;
+
+	memset(&check, 0, sizeof(check));
+	check.n = n;
+	check.wavelet = wavelet;
+	check.levels = dwt_max_levels(n);
+	if(wavelet == FFT_WAVELET_DB2)
+		check.first_checked = CHECK_DWT_PERIODS - 1;
+	stream = dwt_stream_create(wavelet, check.levels, n);
+	signal = (double*)malloc(length*sizeof(double));
+	check.frame = (double*)malloc(n*sizeof(double));
+	check.ref = (double*)malloc((check.levels + 1)*sizeof(double));
+	if(stream == NULL || signal == NULL || check.frame == NULL || check.ref == NULL)
+		goto error;
+	for(t=0;t<length;t++)
+		signal[t] = (wavelet == FFT_WAVELET_HAAR) ? 2*signal_rng_uniform(ctx->rng) - 1 : ctx->input_1[t % n];
+	check.signal = signal;
+
+	while(done < length){
+		size_t count = check_chunk(ctx, length - done);
+		nb_frames += dwt_stream_push(stream, signal + done, count, dwt_stream_check_fn, &check);
+		done += count;
+	}
+	if(check.failed || nb_frames != check.nb_frames || nb_frames != CHECK_DWT_PERIODS)
+		goto error;
+
+	ctx->stream_error = check.error;
+	status = 1;
+
+error:
+	dwt_stream_destroy(stream);
+	free(signal);
+	free(check.frame);
+	free(check.ref);
+	return status;
+}
+
+static int run_dwt_stream_haar(struct check_ctx_s *ctx){
+	return run_dwt_stream(ctx, FFT_WAVELET_HAAR);
+}
+
+static int run_dwt_stream_db2(struct check_ctx_s *ctx){
+	return run_dwt_stream(ctx, FFT_WAVELET_DB2);
+}
+
+static int run_dwt_haar(struct check_ctx_s *ctx){
+	return run_dwt_round_trip(ctx, FFT_WAVELET_HAAR);
+}
+
+static int run_dwt_db2(struct check_ctx_s *ctx){
+	return run_dwt_round_trip(ctx, FFT_WAVELET_DB2);
+}
+
+static int run_transform_plan_f(struct check_ctx_s *ctx){
+	load_complex_f(ctx);
+	if(!transform_plan_f(ctx->plan_f, ctx->real_f, ctx->imag_f))
+		return 0;
+	store_complex_f(ctx);
+	return 1;
+}
+
+static int run_transform_plan_f_inverse(struct check_ctx_s *ctx){
+	load_complex_f(ctx);
+	if(!transform_plan_f(ctx->plan_f_inverse, ctx->real_f, ctx->imag_f))
+		return 0;
+	store_complex_f(ctx);
+	return 1;
+}
+
+static int run_transform_f(struct check_ctx_s *ctx){
+	load_complex_f(ctx);
+	if(!transform_f(ctx->real_f, ctx->imag_f, ctx->n))
+		return 0;
+	store_complex_f(ctx);
+	return 1;
+}
+
+/*the one-shot wrapper without a plan, the plan wrapper otherwise*/
+static int fft_2signals_f_case(struct check_ctx_s *ctx, fft_plan_f_t *plan){
+
+	size_t n = ctx->n;
+	float *signal_2 = ctx->imag_f;
+	float *X = (float*)malloc(4*n*sizeof(float));
+	size_t i;
+	int status;
+
+	if(X == NULL)
+		return 0;
+
+	load_complex_f(ctx);
+	if(plan != NULL)
+		status = fft_2signals_plan_f(plan, ctx->real_f, signal_2, X, X + n, X + 2*n, X + 3*n);
+	else
+		status = fft_2signals_f(ctx->real_f, signal_2, X, X + n, X + 2*n, X + 3*n, n);
+	if(!status){
+		free(X);
+		return 0;
+	}
+	for(i=0;i<n;i++){
+		ctx->out_real[i] = X[i];
+		ctx->out_imag[i] = X[n+i];
+		ctx->out_real[n+i] = X[2*n+i];
+		ctx->out_imag[n+i] = X[3*n+i];
+	}
+	free(X);
+	return 1;
+}
+
+static int run_fft_2signals_plan_f(struct check_ctx_s *ctx){
+	return fft_2signals_f_case(ctx, ctx->plan_f);
+}
+
+static int run_fft_2signals_f(struct check_ctx_s *ctx){
+	return fft_2signals_f_case(ctx, NULL);
+}
+
+static int run_abs_fft_plan_f(struct check_ctx_s *ctx){
+
+	size_t i;
+
+	for(i=0;i<ctx->n;i++)
+		ctx->real_f[i] = (float)ctx->input_1[i];
+	if(!abs_fft_plan_f(ctx->plan_f, ctx->real_f, ctx->imag_f))
+		return 0;
+	for(i=0;i<=ctx->n/2;i++)
+		ctx->out_real[i] = ctx->imag_f[i];
+	return 1;
+}
+
+static int run_abs_fft_f(struct check_ctx_s *ctx){
+
+	size_t i;
+
+	for(i=0;i<ctx->n;i++)
+		ctx->real_f[i] = (float)ctx->input_1[i];
+	if(!abs_fft_f(ctx->real_f, ctx->imag_f, ctx->n))
+		return 0;
+	for(i=0;i<=ctx->n/2;i++)
+		ctx->out_real[i] = ctx->imag_f[i];
+	return 1;
+}
+
+/*the magnitudes of input_1, those of input_2 only have to be there*/
+static int run_abs_fft_2signals_f(struct check_ctx_s *ctx){
+
+	size_t half = ctx->n/2+1;
+	float *X = (float*)malloc(2*half*sizeof(float));
+	size_t i;
+
+	if(X == NULL)
+		return 0;
+
+	load_complex_f(ctx);
+	if(!abs_fft_2signals_f(ctx->real_f, ctx->imag_f, X, X + half, ctx->n)){
+		free(X);
+		return 0;
+	}
+	for(i=0;i<half;i++)
+		ctx->out_real[i] = X[i];
+	free(X);
+	return 1;
+}
+
+int main(int argc, char **argv){
+
+	signal_rng_t rng;
+	int i, nb_failed = 0;
+
+	if(!parse_options(argc, argv)){
+		fprintf(stderr, "usage: %s [--sizes n1,n2,...] [--verbose]\n", argv[0]);
+		return 1;
+	}
+
+	signal_rng_seed(&rng, 2016);
+	for(i=0;i<nb_sizes;i++)
+		check_length(sizes[i], &rng);
+
+	printf("%-36s %-8s %6s %12s %8s %10s  %s\n",
+	       "case", "backend", "sizes", "max_error", "at_n", "tolerance", "status");
+	for(i=0;i<nb_results;i++){
+		struct check_result_s *r = results + i;
+		printf("%-36s %-8s %6d %12.3e %8zu %10.1e  %s\n",
+		       r->name, r->backend, r->nb_sizes, r->worst, r->worst_n, r->tolerance,
+		       r->nb_failed ? "FAIL" : "ok");
+		if(r->nb_failed)
+			nb_failed++;
+	}
+
+	if(nb_failed){
+		printf("%d case(s) over tolerance\n", nb_failed);
+		return 1;
+	}
+	printf("all %d cases within tolerance\n", nb_results);
+	return 0;
+}
+
+/*
+ * Computes the references of one length, then checks every case against them.
+ */
+static void check_length(size_t n, signal_rng_t *rng){
+
+	struct check_ctx_s ctx;
+	int kernel;
+
+	if(!ctx_init(&ctx, n, rng)){
+		fprintf(stderr, "out of memory for n = %zu\n", n);
+		exit(1);
+	}
+
+	/*one-shot legacy wrappers*/
+	check_case("transform", "default", &ctx, REF_FORWARD, CHECK_TOL_DOUBLE, run_transform);
+	check_case("inverse_transform", "default", &ctx, REF_INVERSE, CHECK_TOL_DOUBLE, run_inverse_transform);
+	check_case("transform_radix2", "scalar", &ctx, REF_FORWARD, CHECK_TOL_DOUBLE, run_transform_radix2);
+	check_case("transform_mixed_radix", "default", &ctx, REF_FORWARD, CHECK_TOL_DOUBLE, run_transform_mixed_radix);
+	check_case("transform_bluestein", "scalar", &ctx, REF_FORWARD, CHECK_TOL_DOUBLE, run_transform_bluestein);
+	check_case("transform_interleaved", "default", &ctx, REF_FORWARD, CHECK_TOL_DOUBLE, run_transform_interleaved);
+	check_case("inverse_transform_interleaved", "default", &ctx, REF_INVERSE, CHECK_TOL_DOUBLE, run_inverse_transform_interleaved);
+	check_case("fft_2signals", "default", &ctx, REF_2SIGNALS, CHECK_TOL_DOUBLE, run_fft_2signals);
+	check_case("abs_fft", "default", &ctx, REF_MAGNITUDE, CHECK_TOL_DOUBLE, run_abs_fft);
+	check_case("convolve_real", "default", &ctx, REF_CONVOLVE_REAL, CHECK_TOL_DOUBLE, run_convolve_real);
+	check_case("convolve_complex", "default", &ctx, REF_CONVOLVE, CHECK_TOL_DOUBLE, run_convolve_complex);
+	check_case("fft_2signals, abs_fft* (n = 0)", "default", &ctx, REF_STREAM, 0.0, run_empty_input);
+
+	/*plans, for every butterfly kernel of this CPU*/
+	for(kernel=FFT_KERNEL_SCALAR;kernel<=FFT_KERNEL_NEON;kernel++){
+
+		const char *backend = fft_kernel_name(kernel);
+
+		if(!fft_kernel_available(kernel))
+			continue;
+
+		fft_set_kernel(kernel);
+		fft_plan_destroy(ctx.plan);
+		fft_plan_destroy(ctx.plan_inverse);
+		fft_plan_destroy(ctx.plan_scaled);
+		ctx.plan = fft_plan_create(n, 0);
+		ctx.plan_inverse = fft_plan_create(n, 1);
+		ctx.plan_scaled = fft_plan_create(n, FFT_INVERSE_SCALED);
+		if(ctx.plan == NULL || ctx.plan_inverse == NULL || ctx.plan_scaled == NULL){
+			fprintf(stderr, "out of memory for the %s plans of n = %zu\n", backend, n);
+			exit(1);
+		}
+
+		check_case("transform_plan", backend, &ctx, REF_FORWARD, CHECK_TOL_DOUBLE, run_transform_plan);
+		check_case("transform_plan (inverse)", backend, &ctx, REF_INVERSE, CHECK_TOL_DOUBLE, run_transform_plan_inverse);
+		check_case("transform_plan (scaled inverse)", backend, &ctx, REF_INVERSE, CHECK_TOL_DOUBLE, run_transform_plan_scaled);
+		check_case("transform_interleaved_ws", backend, &ctx, REF_FORWARD, CHECK_TOL_DOUBLE, run_transform_interleaved_ws);
+		check_case("transform_interleaved_plan (inverse)", backend, &ctx, REF_INVERSE, CHECK_TOL_DOUBLE, run_transform_interleaved_plan_inverse);
+		check_case("fft_2signals_ws", backend, &ctx, REF_2SIGNALS, CHECK_TOL_DOUBLE, run_fft_2signals_ws);
+		check_case("spectrum_ws (complex)", backend, &ctx, REF_ONESIDED, CHECK_TOL_DOUBLE, run_spectrum_ws);
+		check_case("abs_fft_ws", backend, &ctx, REF_MAGNITUDE, CHECK_TOL_DOUBLE, run_abs_fft_ws);
+		check_case("convolve_real_ws", backend, &ctx, REF_CONVOLVE_REAL, CHECK_TOL_DOUBLE, run_convolve_real_ws);
+		check_case("convolve_complex_ws", backend, &ctx, REF_CONVOLVE, CHECK_TOL_DOUBLE, run_convolve_complex_ws);
+		check_case("convolve_complex_ws (out = x)", backend, &ctx, REF_CONVOLVE, CHECK_TOL_DOUBLE, run_convolve_complex_ws_out_x);
+		check_case("convolve_complex_ws (out = y)", backend, &ctx, REF_CONVOLVE, CHECK_TOL_DOUBLE, run_convolve_complex_ws_out_y);
+		check_case("convolve_complex_inplace_ws", backend, &ctx, REF_CONVOLVE, CHECK_TOL_DOUBLE, run_convolve_complex_inplace_ws);
+
+		/*the real-input plan does not keep a pointer to the kernel, it is rebuilt as well*/
+		rfft_plan_destroy(ctx.rplan);
+		ctx.rplan = rfft_plan_create(n);
+		if(ctx.rplan == NULL){
+			fprintf(stderr, "out of memory for the %s real plan of n = %zu\n", backend, n);
+			exit(1);
+		}
+		check_case("rfft_ws", backend, &ctx, REF_ONESIDED, CHECK_TOL_DOUBLE, run_rfft_ws);
+		check_case("irfft_ws", backend, &ctx, REF_SIGNAL, CHECK_TOL_DOUBLE, run_irfft_ws);
+	}
+	fft_set_kernel(FFT_KERNEL_AUTO);
+
+	/*spectral features, an odd number of channels so that one goes through the real-input path*/
+	check_case("fft_features", "default", &ctx, REF_FEATURES, CHECK_TOL_DOUBLE, run_fft_features);
+	check_case("fft_features_batch_ws", "chmajor", &ctx, REF_FEATURES, CHECK_TOL_DOUBLE, run_fft_features_batch_major);
+	check_case("fft_features_batch_ws", "interlvd", &ctx, REF_FEATURES, CHECK_TOL_DOUBLE, run_fft_features_batch_interleaved);
+
+	/*sliding band powers, pushed across the exact recomputations*/
+	check_case("band_power_push", "chmajor", &ctx, REF_BAND_POWER, CHECK_TOL_DOUBLE, run_band_power_major);
+	check_case("band_power_push", "interlvd", &ctx, REF_BAND_POWER, CHECK_TOL_DOUBLE, run_band_power_interleaved);
+
+	/*streaming modules, in chunks of random sizes, against their one-shot equivalents*/
+	check_case("stft_push", "hann", &ctx, REF_STREAM, CHECK_TOL_DOUBLE, run_stft);
+	check_case("fir_filter_process", "default", &ctx, REF_STREAM, CHECK_TOL_DOUBLE, run_fir_filter);
+	check_case("sliding_dft_push", "resync", &ctx, REF_STREAM, CHECK_TOL_SLIDING_DFT, run_sliding_dft);
+	check_case("signal_file", "mmap", &ctx, REF_STREAM, 0.0, run_signal_file);
+
+	/*asynchronous spectra, against spectrum_batch_ws on the same frame*/
+	check_case("fft_async_submit", "default", &ctx, REF_STREAM, CHECK_TOL_DOUBLE, run_fft_async);
+	check_case("fft_pool_abs_fft_batch", "chmajor", &ctx, REF_STREAM, 0.0, run_fft_pool_major);
+	check_case("fft_pool_abs_fft_batch", "interlvd", &ctx, REF_STREAM, 0.0, run_fft_pool_interleaved);
+
+	/*resampling of a passband tone, in chunks up to 2n samples*/
+	check_case("resampler_process", "1/4", &ctx, REF_STREAM, CHECK_TOL_RESAMPLER, run_resampler_1_4);
+	check_case("resampler_process", "3/2", &ctx, REF_STREAM, CHECK_TOL_RESAMPLER, run_resampler_3_2);
+	check_case("resampler_process", "2/3", &ctx, REF_STREAM, CHECK_TOL_RESAMPLER, run_resampler_2_3);
+
+	/*single precision*/
+	check_case("transform_f", "scalar", &ctx, REF_FORWARD, CHECK_TOL_FLOAT, run_transform_f);
+	check_case("transform_plan_f", "scalar", &ctx, REF_FORWARD, CHECK_TOL_FLOAT, run_transform_plan_f);
+	check_case("transform_plan_f (inverse)", "scalar", &ctx, REF_INVERSE, CHECK_TOL_FLOAT, run_transform_plan_f_inverse);
+	check_case("fft_2signals_plan_f", "scalar", &ctx, REF_2SIGNALS, CHECK_TOL_FLOAT, run_fft_2signals_plan_f);
+	check_case("abs_fft_plan_f", "scalar", &ctx, REF_MAGNITUDE, CHECK_TOL_FLOAT, run_abs_fft_plan_f);
+	check_case("fft_2signals_f", "scalar", &ctx, REF_2SIGNALS, CHECK_TOL_FLOAT, run_fft_2signals_f);
+	check_case("abs_fft_f", "scalar", &ctx, REF_MAGNITUDE, CHECK_TOL_FLOAT, run_abs_fft_f);
+	check_case("abs_fft_2signals_f", "scalar", &ctx, REF_MAGNITUDE, CHECK_TOL_FLOAT, run_abs_fft_2signals_f);
+
+	/*fixed point*/
+	check_case("abs_fft_q15", "fixed", &ctx, REF_MAGNITUDE, CHECK_TOL_Q15, run_abs_fft_q15);
+	check_case("abs_fft_q31", "fixed", &ctx, REF_MAGNITUDE, CHECK_TOL_Q31, run_abs_fft_q31);
+	check_case("abs_dft_interval_q15", "fixed", &ctx, REF_MAGNITUDE, CHECK_TOL_Q15, run_abs_dft_interval_q15);
+	check_case("abs_dft_interval_q31", "fixed", &ctx, REF_MAGNITUDE, CHECK_TOL_Q31, run_abs_dft_interval_q31);
+
+	/*generators, in chunks up to 2n samples*/
+	check_case("sinus_generator_next", "default", &ctx, REF_STREAM, CHECK_TOL_SINUS, run_sinus_generator);
+	check_case("pink_generator_next", "chunks", &ctx, REF_STREAM, 0.0, run_pink_generator);
+	check_case("pink_generator_next", "ran1f", &ctx, REF_STREAM, CHECK_TOL_DOUBLE, run_pink_generator_ran1f);
+	check_case("signal_mix_next_parallel", "default", &ctx, REF_STREAM, 0.0, run_signal_mix_parallel);
+
+	/*wavelets, the even lengths*/
+	check_case("dwt + idwt", "haar", &ctx, REF_SIGNAL, CHECK_TOL_DOUBLE, run_dwt_haar);
+	check_case("dwt + idwt", "db2", &ctx, REF_SIGNAL, CHECK_TOL_DOUBLE, run_dwt_db2);
+	check_case("dwt_stream_push", "haar", &ctx, REF_STREAM, CHECK_TOL_DOUBLE, run_dwt_stream_haar);
+	check_case("dwt_stream_push", "db2", &ctx, REF_STREAM, CHECK_TOL_DOUBLE, run_dwt_stream_db2);
+
+	ctx_free(&ctx);
+}
+
+/*
+ * Runs one case and keeps its worst error.
+ */
+static void check_case(const char *name, const char *backend, struct check_ctx_s *ctx,
+                       int reference, double tolerance, check_fn fn){
+
+	struct check_result_s *r = NULL;
+	double error;
+	int i, status;
+
+	for(i=0;i<nb_results;i++){
+		if(strcmp(results[i].name, name) == 0 && strcmp(results[i].backend, backend) == 0){
+			r = results + i;
+			break;
+		}
+	}
+
+	status = fn(ctx);
+	if(status == CHECK_SKIP)
+		return;
+
+	if(r == NULL){
+		if(nb_results == CHECK_MAX_CASES){
+			fprintf(stderr, "more than %d cases\n", CHECK_MAX_CASES);
+			exit(1);
+		}
+		r = results + nb_results++;
+		r->name = name;
+		r->backend = backend;
+		r->tolerance = tolerance;
+	}
+
+	/*a failed call counts as an infinite error*/
+	error = status ? relative_error(ctx, reference) : INFINITY;
+
+	r->nb_sizes++;
+	if(!(error <= tolerance)){
+		r->nb_failed++;
+		printf("FAIL %s (%s), n = %zu: relative error %.3e > %.1e\n",
+		       name, backend, ctx->n, error, tolerance);
+	}else if(verbose){
+		printf("%s (%s), n = %zu: relative error %.3e\n", name, backend, ctx->n, error);
+	}
+	if(r->nb_sizes == 1 || !(error <= r->worst)){
+		r->worst = error;
+		r->worst_n = ctx->n;
+	}
+}
+
+/*
+ * max_k |y(k) - ref(k)| / max_k |ref(k)| over the bins of the reference.
+ */
+static double relative_error(const struct check_ctx_s *ctx, int reference){
+
+	const double *ref_real, *ref_imag;
+	double max_diff = 0, max_ref = 0;
+	double scale = 1;
+	size_t count, k;
+	int modulus = 0, is_real = 0;
+
+	/*band powers, ratios, entropy and frequencies each to their own scale*/
+	if(reference == REF_FEATURES){
+		for(k=0;k<ctx->nb_features;k++){
+			double ref = fabs(ctx->features_ref[k]);
+			double diff = fabs(ctx->out_real[k] - ctx->features_ref[k]);
+			double error = (ref > 0) ? diff/ref : diff;
+			if(!(error <= max_diff))
+				max_diff = error;
+		}
+		return max_diff;
+	}
+	if(reference == REF_STREAM)
+		return ctx->stream_error;
+
+	switch(reference){
+		case REF_FORWARD:
+			ref_real = ctx->fwd_real;
+			ref_imag = ctx->fwd_imag;
+			count = ctx->n;
+			break;
+		case REF_INVERSE:
+			ref_real = ctx->inv_real;
+			ref_imag = ctx->inv_imag;
+			count = ctx->n;
+			break;
+		case REF_ONESIDED:
+			ref_real = ctx->real_real;
+			ref_imag = ctx->real_imag;
+			count = ctx->n/2+1;
+			break;
+		case REF_MAGNITUDE:
+			ref_real = ctx->real_real;
+			ref_imag = ctx->real_imag;
+			count = ctx->n/2+1;
+			modulus = 1;
+			scale = 2.0/ctx->n;
+			break;
+		case REF_SIGNAL:
+			ref_real = ctx->input_1;
+			ref_imag = NULL;
+			count = ctx->n;
+			is_real = 1;
+			scale = (double)ctx->n;
+			break;
+		case REF_CONVOLVE:
+			ref_real = ctx->conv_real;
+			ref_imag = ctx->conv_imag;
+			count = ctx->n;
+			break;
+		case REF_CONVOLVE_REAL:
+			ref_real = ctx->conv_signal;
+			ref_imag = NULL;
+			count = ctx->n;
+			is_real = 1;
+			break;
+		case REF_BAND_POWER:
+			ref_real = ctx->band_power_ref;
+			ref_imag = NULL;
+			count = CHECK_BAND_POWER_CHANNELS*CHECK_BAND_POWER_BANDS;
+			is_real = 1;
+			break;
+		default:
+			ref_real = ctx->real_real;
+			ref_imag = ctx->real_imag;
+			count = 2*ctx->n;
+			break;
+	}
+
+	for(k=0;k<count;k++){
+		double diff, ref;
+		if(modulus){
+			ref = scale*hypot(ref_real[k], ref_imag[k]);
+			diff = fabs(ctx->out_real[k] - ref);
+		}else if(is_real){
+			ref = scale*fabs(ref_real[k]);
+			diff = fabs(ctx->out_real[k] - scale*ref_real[k]);
+		}else{
+			ref = hypot(ref_real[k], ref_imag[k]);
+			diff = hypot(ctx->out_real[k] - ref_real[k], ctx->out_imag[k] - ref_imag[k]);
+		}
+		if(ref > max_ref)
+			max_ref = ref;
+		/*NaN compares false, it is carried over on purpose*/
+		if(!(diff <= max_diff))
+			max_diff = diff;
+	}
+
+	return (max_ref > 0) ? max_diff/max_ref : max_diff;
+}
+
+static int ctx_init(struct check_ctx_s *ctx, size_t n, signal_rng_t *rng){
+
+	size_t i, k;
+
+	memset(ctx, 0, sizeof(struct check_ctx_s));
+	ctx->n = n;
+	ctx->rng = rng;
+
+	ctx->input_1 = (double*)malloc(n*sizeof(double));
+	ctx->input_2 = (double*)malloc(n*sizeof(double));
+	ctx->fwd_real = (double*)malloc(n*sizeof(double));
+	ctx->fwd_imag = (double*)malloc(n*sizeof(double));
+	ctx->inv_real = (double*)malloc(n*sizeof(double));
+	ctx->inv_imag = (double*)malloc(n*sizeof(double));
+	ctx->real_real = (double*)malloc(2*n*sizeof(double));
+	ctx->real_imag = (double*)malloc(2*n*sizeof(double));
+	ctx->conv_real = (double*)malloc(n*sizeof(double));
+	ctx->conv_imag = (double*)malloc(n*sizeof(double));
+	ctx->conv_signal = (double*)malloc(n*sizeof(double));
+	ctx->out_real = (double*)malloc(2*n*sizeof(double));
+	ctx->out_imag = (double*)malloc(2*n*sizeof(double));
+	ctx->real_f = (float*)malloc(n*sizeof(float));
+	ctx->imag_f = (float*)malloc(n*sizeof(float));
+	ctx->plan_f = fft_plan_f_create(n, 0);
+	ctx->plan_f_inverse = fft_plan_f_create(n, 1);
+	ctx->workspace = malloc(fft_workspace_size(n));
+	ctx->rworkspace = malloc(rfft_workspace_size(n));
+	ctx->input_q15 = (int16_t*)malloc(n*sizeof(int16_t));
+	ctx->input_q31 = (int32_t*)malloc(n*sizeof(int32_t));
+	ctx->out_fixed = (int32_t*)malloc((n/2+1)*sizeof(int32_t));
+	ctx->plan_fixed = is_power_of_2(n) ? fft_fixed_plan_create(n) : NULL;
+	ctx->plan_goertzel = dft_interval_fixed_plan_create((int)n, 0, (int)(n/2+1));
+	if(ctx->input_1 == NULL || ctx->input_2 == NULL
+			|| ctx->fwd_real == NULL || ctx->fwd_imag == NULL
+			|| ctx->inv_real == NULL || ctx->inv_imag == NULL
+			|| ctx->real_real == NULL || ctx->real_imag == NULL
+			|| ctx->conv_real == NULL || ctx->conv_imag == NULL || ctx->conv_signal == NULL
+			|| ctx->out_real == NULL || ctx->out_imag == NULL
+			|| ctx->real_f == NULL || ctx->imag_f == NULL
+			|| ctx->plan_f == NULL || ctx->plan_f_inverse == NULL
+			|| ctx->workspace == NULL || ctx->rworkspace == NULL
+			|| ctx->input_q15 == NULL || ctx->input_q31 == NULL || ctx->out_fixed == NULL
+			|| (is_power_of_2(n) && ctx->plan_fixed == NULL) || ctx->plan_goertzel == NULL){
+		ctx_free(ctx);
+		return 0;
+	}
+
+	/*uniform in [-1, 1) and exact in single precision*/
+	for(i=0;i<n;i++){
+		ctx->input_1[i] = (float)(2*signal_rng_uniform(rng) - 1);
+		ctx->input_2[i] = (float)(2*signal_rng_uniform(rng) - 1);
+	}
+
+	/*input_1 < 1, the Q15 samples are clamped for the values rounded up to 2^15*/
+	for(i=0;i<n;i++){
+		double q15 = floor(ldexp(ctx->input_1[i], 15) + 0.5);
+		ctx->input_q15[i] = (int16_t)(q15 > 32767 ? 32767 : q15);
+		ctx->input_q31[i] = (int32_t)ldexp(ctx->input_1[i], 31);
+	}
+
+	naive_dft(ctx->input_1, ctx->input_2, ctx->fwd_real, ctx->fwd_imag, 0, (int)n);
+	naive_dft(ctx->input_1, ctx->input_2, ctx->inv_real, ctx->inv_imag, 1, (int)n);
+
+	/*transforms of the real signals, the zero imaginary part borrowed from out_imag*/
+	memset(ctx->out_imag, 0, n*sizeof(double));
+	naive_dft(ctx->input_1, ctx->out_imag, ctx->real_real, ctx->real_imag, 0, (int)n);
+	naive_dft(ctx->input_2, ctx->out_imag, ctx->real_real + n, ctx->real_imag + n, 0, (int)n);
+
+	/*convolutions by their definition, z(k) = sum x(j)*y(k-j mod n)*/
+	for(k=0;k<n;k++){
+		double zr = 0, zi = 0, z = 0;
+		for(i=0;i<n;i++){
+			size_t j = (k + n - i) % n;
+			zr += ctx->input_1[i]*ctx->input_2[j] - ctx->input_2[i]*ctx->input_1[j];
+			zi += ctx->input_1[i]*ctx->input_1[j] + ctx->input_2[i]*ctx->input_2[j];
+			z += ctx->input_1[i]*ctx->input_2[j];
+		}
+		ctx->conv_real[k] = zr;
+		ctx->conv_imag[k] = zi;
+		ctx->conv_signal[k] = z;
+	}
+
+	if(!features_init(ctx) || !band_power_init(ctx)){
+		ctx_free(ctx);
+		return 0;
+	}
+
+	return 1;
+}
+
+/*
+ * Creates the tracker of the bands [0, (n+1)/2), [n/4, n/2+1) and [n/3, n), overlapping
+ * for every n, and the stream of the streaming cases: noise, then input_1 and input_2
+ * as the last window. Their powers are the sums of (2*|X(k)|/n)^2 over the naive_dft.
+ */
+static int band_power_init(struct check_ctx_s *ctx){
+
+	int n = (int)ctx->n;
+	int band_start[CHECK_BAND_POWER_BANDS], band_stop[CHECK_BAND_POWER_BANDS];
+	size_t prefix = CHECK_STREAM_PREFIX*ctx->n;
+	size_t c, t;
+	int b, k;
+
+	band_start[0] = 0;
+	band_stop[0] = (n+1)/2;
+	band_start[1] = n/4;
+	band_stop[1] = n/2+1;
+	band_start[2] = n/3;
+	band_stop[2] = n;
+
+	ctx->band_power = band_power_create(n, CHECK_BAND_POWER_CHANNELS, CHECK_BAND_POWER_BANDS, band_start, band_stop);
+	ctx->stream = (double*)malloc(CHECK_BAND_POWER_CHANNELS*(prefix + ctx->n)*sizeof(double));
+	ctx->chunk = (double*)malloc(CHECK_BAND_POWER_CHANNELS*(prefix + ctx->n)*sizeof(double));
+	ctx->signal = (double*)malloc((prefix + ctx->n)*sizeof(double));
+	if(ctx->band_power == NULL || ctx->stream == NULL || ctx->chunk == NULL || ctx->signal == NULL)
+		return 0;
+
+	for(t=0;t<CHECK_BAND_POWER_CHANNELS*prefix;t++)
+		ctx->stream[t] = 2*signal_rng_uniform(ctx->rng) - 1;
+	for(t=0;t<ctx->n;t++){
+		ctx->stream[(prefix + t)*CHECK_BAND_POWER_CHANNELS] = ctx->input_1[t];
+		ctx->stream[(prefix + t)*CHECK_BAND_POWER_CHANNELS + 1] = ctx->input_2[t];
+	}
+	for(t=0;t<prefix + ctx->n;t++)
+		ctx->signal[t] = ctx->stream[t*CHECK_BAND_POWER_CHANNELS];
+
+	for(c=0;c<CHECK_BAND_POWER_CHANNELS;c++){
+		const double *X_real = ctx->real_real + c*ctx->n;
+		const double *X_imag = ctx->real_imag + c*ctx->n;
+		for(b=0;b<CHECK_BAND_POWER_BANDS;b++){
+			double power = 0;
+			for(k=band_start[b];k<band_stop[b];k++){
+				double magnitude = 2*hypot(X_real[k], X_imag[k])/n;
+				power += magnitude*magnitude;
+			}
+			ctx->band_power_ref[c*CHECK_BAND_POWER_BANDS + b] = power;
+		}
+	}
+
+	return 1;
+}
+
+static void ctx_free(struct check_ctx_s *ctx){
+
+	free(ctx->input_1);
+	free(ctx->input_2);
+	free(ctx->fwd_real);
+	free(ctx->fwd_imag);
+	free(ctx->inv_real);
+	free(ctx->inv_imag);
+	free(ctx->real_real);
+	free(ctx->real_imag);
+	free(ctx->conv_real);
+	free(ctx->conv_imag);
+	free(ctx->conv_signal);
+	free(ctx->out_real);
+	free(ctx->out_imag);
+	free(ctx->real_f);
+	free(ctx->imag_f);
+	fft_plan_destroy(ctx->plan);
+	fft_plan_destroy(ctx->plan_inverse);
+	fft_plan_destroy(ctx->plan_scaled);
+	fft_plan_f_destroy(ctx->plan_f);
+	fft_plan_f_destroy(ctx->plan_f_inverse);
+	rfft_plan_destroy(ctx->rplan);
+	free(ctx->workspace);
+	free(ctx->rworkspace);
+	free(ctx->input_q15);
+	free(ctx->input_q31);
+	free(ctx->out_fixed);
+	fft_fixed_plan_destroy(ctx->plan_fixed);
+	dft_interval_fixed_plan_destroy(ctx->plan_goertzel);
+	fft_features_destroy(ctx->features);
+	free(ctx->features_workspace);
+	free(ctx->frame);
+	free(ctx->frame_interleaved);
+	free(ctx->features_ref);
+	band_power_destroy(ctx->band_power);
+	free(ctx->stream);
+	free(ctx->signal);
+	free(ctx->chunk);
+}
+
+/*
+ * Creates the extractor of the feature cases and computes the features of the channels
+ * input_1, input_2, input_1 from their naive_dft, the bins of a band picked by their
+ * frequency. No extractor for the short lengths, where a band holds no bin or
+ * out_real cannot hold the features.
+ */
+static int features_init(struct check_ctx_s *ctx){
+
+	static const double band_low[CHECK_FEATURES_BANDS] = {47.3, 97.1, 211.9};
+	static const double band_high[CHECK_FEATURES_BANDS] = {131.7, 211.9, 497.3};
+	size_t n = ctx->n;
+	size_t half = n/2;
+	double df = CHECK_FEATURES_FS/n;
+	size_t nb_values, c, k, t;
+	double *out;
+	int b;
+
+	ctx->features = fft_features_create(n, CHECK_FEATURES_FS, CHECK_FEATURES_BANDS,
+	                                    band_low, band_high, FFT_FEATURE_ALL);
+	if(ctx->features == NULL)
+		return 1;
+	if(!fft_features_add_ratio(ctx->features, 1, 0))
+		return 0;
+
+	/*the features of all the channels are written to out_real*/
+	nb_values = CHECK_FEATURES_CHANNELS*fft_features_length(ctx->features);
+	if(nb_values > 2*n){
+		fft_features_destroy(ctx->features);
+		ctx->features = NULL;
+		return 1;
+	}
+	ctx->features_workspace = malloc(fft_features_workspace_size(ctx->features));
+	ctx->frame = (double*)malloc(CHECK_FEATURES_CHANNELS*n*sizeof(double));
+	ctx->frame_interleaved = (double*)malloc(CHECK_FEATURES_CHANNELS*n*sizeof(double));
+	ctx->features_ref = (double*)malloc(nb_values*sizeof(double));
+	if(ctx->features_workspace == NULL || ctx->frame == NULL || ctx->frame_interleaved == NULL
+			|| ctx->features_ref == NULL)
+		return 0;
+
+	out = ctx->features_ref;
+	for(c=0;c<CHECK_FEATURES_CHANNELS;c++){
+
+		const double *signal = (c % 2 == 0) ? ctx->input_1 : ctx->input_2;
+		const double *X_real = ctx->real_real + (c % 2)*n;
+		const double *X_imag = ctx->real_imag + (c % 2)*n;
+		double power[CHECK_FEATURES_BANDS];
+		double total = 0, entropy = 0, peak_power = -1;
+		size_t peak = 0;
+
+		for(t=0;t<n;t++){
+			ctx->frame[c*n + t] = signal[t];
+			ctx->frame_interleaved[t*CHECK_FEATURES_CHANNELS + c] = signal[t];
+		}
+
+		for(b=0;b<CHECK_FEATURES_BANDS;b++)
+			power[b] = 0;
+		for(k=0;k<=half;k++){
+			double magnitude = 2*hypot(X_real[k], X_imag[k])/n;
+			double p = magnitude*magnitude;
+			for(b=0;b<CHECK_FEATURES_BANDS;b++){
+				if(k*df >= band_low[b] && k*df < band_high[b])
+					power[b] += p;
+			}
+			if(k > 0){
+				total += p;
+				if(p > peak_power){
+					peak_power = p;
+					peak = k;
+				}
+			}
+		}
+
+		/*-sum q*log(q) over the bins 1..n/2, q = p/total*/
+		for(k=1;k<=half;k++){
+			double q = (X_real[k]*X_real[k] + X_imag[k]*X_imag[k])*4/((double)n*n)/total;
+			if(q > 0)
+				entropy -= q*log(q);
+		}
+
+		for(b=0;b<CHECK_FEATURES_BANDS;b++)
+			*out++ = power[b];
+		*out++ = (power[0] > 0) ? power[1]/power[0] : 0;
+		*out++ = (half > 1) ? entropy/log((double)half) : 0;
+		*out++ = peak*df;
+		*out++ = sqrt(peak_power);
+	}
+
+	return 1;
+}
+
+static int parse_options(int argc, char **argv){
+
+	const char *list = NULL;
+	int i;
+
+	for(i=1;i<argc;i++){
+		if(strcmp(argv[i], "--sizes") == 0 && i+1 < argc)
+			list = argv[++i];
+		else if(strcmp(argv[i], "--verbose") == 0)
+			verbose = 1;
+		else
+			return 0;
+	}
+
+	/*without --sizes, every length up to CHECK_ALL_SIZES_UP_TO comes first*/
+	if(list == NULL){
+		list = CHECK_DEFAULT_SIZES;
+		for(nb_sizes=0;nb_sizes<CHECK_ALL_SIZES_UP_TO;nb_sizes++)
+			sizes[nb_sizes] = nb_sizes+1;
+	}
+
+	while(*list != '\0'){
+		char *end;
+		long n = strtol(list, &end, 10);
+		if(end == list || n < 1 || nb_sizes == CHECK_MAX_SIZES)
+			return 0;
+		if(*end != ',' && *end != '\0')
+			return 0;
+		sizes[nb_sizes++] = (size_t)n;
+		list = (*end == ',') ? end + 1 : end;
+	}
+
+	return nb_sizes > 0;
+}
+
+static int is_power_of_2(size_t n){
+	return n > 0 && (n & (n - 1)) == 0;
+}
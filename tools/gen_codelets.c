@@ -0,0 +1,347 @@
+/**
+ * @file gen_codelets.c
+ * @brief Generator of the size-specialized transforms of libsignalproc, run by the
+ *        Makefile to produce src/fft_codelets.c for the lengths of CODELET_SIZES.
+ *
+ *        For each length, the generator factors n in radices 2, 4 and odd primes and
+ *        writes a function of straight-line code: the mixed-radix decimation in time
+ *        of fft_mixed_radix.c with all the loops unrolled, every index a constant and
+ *        every twiddle a literal. The first stage reads the input in digit-reversed
+ *        order, the stages then run in place on a local copy, and the last one writes
+ *        the caller's arrays. codelet_lookup returns the function of a length.
+ *
+ *        Usage: gen_codelets [-o output.c] n1 n2 ...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/*largest radix of a codelet, the butterflies of an odd prime p cost p^2 products*/
+#define CODELET_MAX_RADIX 13
+/*longest codelet, the code grows as n*log(n)*/
+#define CODELET_MAX_LENGTH 4096
+#define CODELET_MAX_SIZES 64
+#define CODELET_MAX_FACTORS 16
+
+#define PI_L 3.141592653589793238462643383279502884L
+
+static FILE *out;
+
+static int factorize(size_t n, size_t *factors);
+static void digit_reversal(const size_t *indices, size_t n, const size_t *factors, size_t nb_factors, size_t *order);
+static void emit_codelet(size_t n);
+static void emit_butterfly(size_t radix, size_t m, size_t base, size_t k,
+                           int first, int last, const size_t *order);
+static void emit_twiddle(int q, size_t e, size_t block);
+static void emit_dft(size_t radix);
+
+int main(int argc, char **argv){
+
+	const char *path = NULL;
+	size_t sizes[CODELET_MAX_SIZES];
+	size_t factors[CODELET_MAX_FACTORS];
+	int nb_sizes = 0;
+	int i, j;
+
+	for(i=1;i<argc;i++){
+		char *end;
+		unsigned long n;
+
+		if(strcmp(argv[i], "-o") == 0 && i+1 < argc){
+			path = argv[++i];
+			continue;
+		}
+
+		n = strtoul(argv[i], &end, 10);
+		if(*end != '\0' || n < 2 || n > CODELET_MAX_LENGTH){
+			fprintf(stderr, "gen_codelets: invalid length '%s' (2 to %d)\n", argv[i], CODELET_MAX_LENGTH);
+			return 1;
+		}
+		if(factorize(n, factors) == 0){
+			fprintf(stderr, "gen_codelets: %lu has a prime factor over %d\n", n, CODELET_MAX_RADIX);
+			return 1;
+		}
+		for(j=0;j<nb_sizes && sizes[j]!=n;j++);
+		if(j < nb_sizes)
+			continue;
+		if(nb_sizes == CODELET_MAX_SIZES){
+			fprintf(stderr, "gen_codelets: more than %d lengths\n", CODELET_MAX_SIZES);
+			return 1;
+		}
+		sizes[nb_sizes++] = n;
+	}
+
+	out = (path != NULL) ? fopen(path, "w") : stdout;
+	if(out == NULL){
+		fprintf(stderr, "gen_codelets: cannot write %s\n", path);
+		return 1;
+	}
+
+	fprintf(out, "/**\n");
+	fprintf(out, " * @file fft_codelets.c\n");
+	fprintf(out, " * @brief Straight-line forward transforms of the lengths");
+	for(i=0;i<nb_sizes;i++)
+		fprintf(out, " %zu", sizes[i]);
+	if(nb_sizes == 0)
+		fprintf(out, " (none)");
+	fprintf(out, ".\n");
+	fprintf(out, " *        Generated by tools/gen_codelets.c from CODELET_SIZES of the Makefile, do not edit.\n");
+	fprintf(out, " */\n\n");
+	fprintf(out, "#include <stddef.h>\n");
+	fprintf(out, "#include \"fft.h\"\n");
+	fprintf(out, "#include \"fft_internal.h\"\n\n");
+
+	for(i=0;i<nb_sizes;i++)
+		emit_codelet(sizes[i]);
+
+	fprintf(out, "codelet_fn codelet_lookup(size_t n){\n");
+	fprintf(out, "\tswitch(n){\n");
+	for(i=0;i<nb_sizes;i++)
+		fprintf(out, "\t\tcase %zu: return codelet_%zu;\n", sizes[i], sizes[i]);
+	fprintf(out, "\t\tdefault: return NULL;\n");
+	fprintf(out, "\t}\n");
+	fprintf(out, "}\n");
+
+	if(fflush(out) != 0 || ferror(out)){
+		fprintf(stderr, "gen_codelets: error while writing %s\n", path != NULL ? path : "stdout");
+		if(path != NULL){
+			fclose(out);
+			remove(path);
+		}
+		return 1;
+	}
+	if(path != NULL)
+		fclose(out);
+
+	return 0;
+}
+
+/*
+ * Radices of n, outermost stage first: a 2 if the power of 2 of n has an odd
+ * exponent, then 4s, then the odd primes in increasing order. The innermost
+ * stage has no twiddles, so it is given the largest radix. Returns the number
+ * of factors, 0 if a prime factor is over CODELET_MAX_RADIX.
+ */
+static int factorize(size_t n, size_t *factors){
+
+	int nb = 0;
+	int twos = 0;
+	size_t p;
+
+	while(n % 2 == 0){
+		twos++;
+		n /= 2;
+	}
+	if(twos % 2 == 1)
+		factors[nb++] = 2;
+	for(;twos>=2;twos-=2)
+		factors[nb++] = 4;
+	for(p=3;p<=CODELET_MAX_RADIX && n>1;p+=2){
+		while(n % p == 0){
+			factors[nb++] = p;
+			n /= p;
+		}
+	}
+
+	return (n == 1) ? nb : 0;
+}
+
+/*
+ * Input index read at each position of the in-place decimation in time: the
+ * outermost radix p splits the indices in p subsequences of stride p, each
+ * stored contiguously and ordered by the remaining radices.
+ */
+static void digit_reversal(const size_t *indices, size_t n, const size_t *factors, size_t nb_factors, size_t *order){
+
+	size_t p, m, q, i;
+	size_t *sub;
+
+	if(nb_factors == 0){
+		order[0] = indices[0];
+		return;
+	}
+
+	p = factors[0];
+	m = n / p;
+	sub = (size_t*)malloc(m*sizeof(size_t));
+	if(sub == NULL){
+		fprintf(stderr, "gen_codelets: out of memory\n");
+		exit(1);
+	}
+	for(q=0;q<p;q++){
+		for(i=0;i<m;i++)
+			sub[i] = indices[q + p*i];
+		digit_reversal(sub, m, factors + 1, nb_factors - 1, order + q*m);
+	}
+	free(sub);
+}
+
+/*
+ * static void codelet_<n>(double real[], double imag[])
+ */
+static void emit_codelet(size_t n){
+
+	size_t factors[CODELET_MAX_FACTORS];
+	size_t nb_factors = (size_t)factorize(n, factors);
+	size_t *indices = (size_t*)malloc(n*sizeof(size_t));
+	size_t *order = (size_t*)malloc(n*sizeof(size_t));
+	size_t i, s;
+
+	if(indices == NULL || order == NULL){
+		fprintf(stderr, "gen_codelets: out of memory\n");
+		exit(1);
+	}
+	for(i=0;i<n;i++)
+		indices[i] = i;
+	digit_reversal(indices, n, factors, nb_factors, order);
+
+	fprintf(out, "/*\n * Forward transform of length %zu in place, radices", n);
+	for(s=0;s<nb_factors;s++)
+		fprintf(out, " %zu", factors[s]);
+	fprintf(out, ".\n */\n");
+	fprintf(out, "static void codelet_%zu(double real[], double imag[]){\n\n", n);
+	if(nb_factors > 1)
+		fprintf(out, "\tdouble xr[%zu], xi[%zu];\n\n", n, n);
+
+	/*innermost stage first*/
+	for(s=nb_factors;s-->0;){
+		size_t radix = factors[s];
+		size_t m = 1, base, k, j;
+
+		for(j=s+1;j<nb_factors;j++)
+			m *= factors[j];
+
+		fprintf(out, "\t/*radix %zu, sub-transforms of length %zu*/\n", radix, m);
+		for(base=0;base<n;base+=radix*m){
+			for(k=0;k<m;k++)
+				emit_butterfly(radix, m, base, k, s == nb_factors-1, s == 0, order);
+		}
+		if(s > 0)
+			fprintf(out, "\n");
+	}
+
+	fprintf(out, "}\n\n");
+	free(indices);
+	free(order);
+}
+
+/*
+ * One butterfly of a stage: loads the radix values at base + k + q*m, the first stage
+ * from the input in digit-reversed order, applies the twiddles exp(-2*pi*j*q*k/(radix*m)),
+ * then the radix-point DFT, and stores the outputs back at the same positions, to the
+ * caller's arrays for the last stage. All the loads come before the stores.
+ */
+static void emit_butterfly(size_t radix, size_t m, size_t base, size_t k,
+                           int first, int last, const size_t *order){
+
+	const char *dst_r = last ? "real" : "xr";
+	const char *dst_i = last ? "imag" : "xi";
+	size_t q;
+
+	fprintf(out, "\t{\n");
+	for(q=0;q<radix;q++){
+		size_t pos = base + k + q*m;
+		if(first)
+			fprintf(out, "\t\tdouble a%zur = real[%zu], a%zui = imag[%zu];\n", q, order[pos], q, order[pos]);
+		else
+			fprintf(out, "\t\tdouble a%zur = xr[%zu], a%zui = xi[%zu];\n", q, pos, q, pos);
+	}
+	for(q=0;q<radix;q++)
+		emit_twiddle((int)q, (q*k) % (radix*m), radix*m);
+
+	emit_dft(radix);
+
+	for(q=0;q<radix;q++){
+		size_t pos = base + k + q*m;
+		fprintf(out, "\t\t%s[%zu] = y%zur; %s[%zu] = y%zui;\n", dst_r, pos, q, dst_i, pos, q);
+	}
+	fprintf(out, "\t}\n");
+}
+
+/*
+ * b = a*exp(-2*pi*j*e/block), the multiples of a quarter turn without products.
+ */
+static void emit_twiddle(int q, size_t e, size_t block){
+
+	long double angle;
+	double c, s;
+
+	if(e == 0){
+		fprintf(out, "\t\tdouble b%dr = a%dr, b%di = a%di;\n", q, q, q, q);
+		return;
+	}
+	if((4*e) % block == 0){
+		switch((4*e) / block){
+			case 1:  /*-j*/
+				fprintf(out, "\t\tdouble b%dr = a%di, b%di = -a%dr;\n", q, q, q, q);
+				return;
+			case 2:
+				fprintf(out, "\t\tdouble b%dr = -a%dr, b%di = -a%di;\n", q, q, q, q);
+				return;
+			default: /*j*/
+				fprintf(out, "\t\tdouble b%dr = -a%di, b%di = a%dr;\n", q, q, q, q);
+				return;
+		}
+	}
+
+	angle = 2*PI_L*(long double)e/(long double)block;
+	c = (double)cosl(angle);
+	s = (double)sinl(angle);
+	fprintf(out, "\t\tdouble b%dr = a%dr*(%.17g) + a%di*(%.17g), b%di = a%di*(%.17g) - a%dr*(%.17g);\n",
+	        q, q, c, q, s, q, q, c, q, s);
+}
+
+/*
+ * y = DFT of b over the radix points, forward. Odd radices pair the
+ * points q and radix-q: (b_q + b_{radix-q}) gets the cosines and
+ * (b_q - b_{radix-q}) the sines.
+ */
+static void emit_dft(size_t radix){
+
+	size_t h = radix/2;
+	size_t q, s;
+
+	if(radix == 2){
+		fprintf(out, "\t\tdouble y0r = b0r + b1r, y0i = b0i + b1i;\n");
+		fprintf(out, "\t\tdouble y1r = b0r - b1r, y1i = b0i - b1i;\n");
+		return;
+	}
+	if(radix == 4){
+		fprintf(out, "\t\tdouble s02r = b0r + b2r, s02i = b0i + b2i, d02r = b0r - b2r, d02i = b0i - b2i;\n");
+		fprintf(out, "\t\tdouble s13r = b1r + b3r, s13i = b1i + b3i, d13r = b1r - b3r, d13i = b1i - b3i;\n");
+		fprintf(out, "\t\tdouble y0r = s02r + s13r, y0i = s02i + s13i;\n");
+		fprintf(out, "\t\tdouble y1r = d02r + d13i, y1i = d02i - d13r;\n");
+		fprintf(out, "\t\tdouble y2r = s02r - s13r, y2i = s02i - s13i;\n");
+		fprintf(out, "\t\tdouble y3r = d02r - d13i, y3i = d02i + d13r;\n");
+		return;
+	}
+
+	for(q=1;q<=h;q++){
+		fprintf(out, "\t\tdouble s%zur = b%zur + b%zur, s%zui = b%zui + b%zui;\n", q, q, radix-q, q, q, radix-q);
+		fprintf(out, "\t\tdouble d%zur = b%zur - b%zur, d%zui = b%zui - b%zui;\n", q, q, radix-q, q, q, radix-q);
+	}
+
+	fprintf(out, "\t\tdouble y0r = b0r");
+	for(q=1;q<=h;q++)
+		fprintf(out, " + s%zur", q);
+	fprintf(out, ", y0i = b0i");
+	for(q=1;q<=h;q++)
+		fprintf(out, " + s%zui", q);
+	fprintf(out, ";\n");
+
+	for(s=1;s<=h;s++){
+		fprintf(out, "\t\tdouble ar%zu = b0r, ai%zu = b0i, br%zu = 0, bi%zu = 0;\n", s, s, s, s);
+		for(q=1;q<=h;q++){
+			long double angle = 2*PI_L*(long double)((q*s) % radix)/(long double)radix;
+			double c = (double)cosl(angle);
+			double sn = (double)sinl(angle);
+			fprintf(out, "\t\tar%zu += s%zur*(%.17g); ai%zu += s%zui*(%.17g);"
+			             " br%zu += d%zui*(%.17g); bi%zu += d%zur*(%.17g);\n",
+			        s, q, c, s, q, c, s, q, sn, s, q, sn);
+		}
+		fprintf(out, "\t\tdouble y%zur = ar%zu + br%zu, y%zui = ai%zu - bi%zu;\n", s, s, s, s, s, s);
+		fprintf(out, "\t\tdouble y%zur = ar%zu - br%zu, y%zui = ai%zu + bi%zu;\n", radix-s, s, s, radix-s, s, s);
+	}
+}